@@ -2,7 +2,7 @@
 # Compiler Options for GCC
 #############################
 
-add_compile_options("-std=c++11")
+add_compile_options("$<$<COMPILE_LANGUAGE:CXX>:-std=c++11>") # the C example of libpacsketch is built with the default C standard
 add_compile_options("-Wall")
 
 set(CMAKE_CXX_FLAGS_DEBUG "${CMAKE_CXX_FLAGS_DEBUG} -ggdb3")
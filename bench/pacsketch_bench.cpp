@@ -0,0 +1,597 @@
+/*
+ * Name: pacsketch_bench.cpp
+ * Description: Micro-benchmarks for the core operations of the sketches (inserting,
+ *              merging, estimating) along with the record hashing, k-mer encoding
+ *              and packet decoding that feed them. The inputs are synthetic, and are generated the same
+ *              way as the generate_fasta utility does. Results are reported in ns/op
+ *              and bytes/s, and can be written as JSON to be tracked across versions.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <pacsketch_bench.h>
+#include <hash.h>
+#include <minhash.h>
+#include <frac_minhash.h>
+#include <hll.h>
+#include <countmin.h>
+#include <pcap_reader.h>
+#include <columnar.h>
+#include <sketch_file.h>
+#include <parallel.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <numeric>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <new>
+
+#ifndef PACSKETCH_VERSION
+#define PACSKETCH_VERSION "unknown"
+#endif
+
+static volatile uint64_t benchmark_sink = 0; // keeps the results of timed code from being optimized out
+static std::atomic<uint64_t> num_heap_allocations (0); // counted by the operator new below
+
+/* Allocation-counting hooks: every heap allocation in the program goes through these (HLL registers through posix_memalign) */
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+    num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    *ptr = aligned_alloc(alignment, ((size ? size : 1) + alignment - 1) / alignment * alignment);
+    return (*ptr != NULL) ? 0 : ENOMEM;
+}
+void* operator new(size_t size) {
+    num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size ? size : 1);
+    if (ptr == NULL) {throw std::bad_alloc();}
+    return ptr;
+}
+void* operator new[](size_t size) {return operator new(size);}
+void operator delete(void* ptr) noexcept {std::free(ptr);}
+void operator delete[](void* ptr) noexcept {std::free(ptr);}
+
+template <typename Setup, typename Run>
+BenchResult run_benchmark(const std::string& name, const std::string& param, size_t ops_per_run,
+                          double bytes_per_run, size_t num_reps, Setup setup, Run run) {
+    /*
+     * Times run() num_reps times, calling setup() before each one outside of the timed
+     * region, and keeps the best time since it is the least affected by noise.
+     */
+    double best_ns = std::numeric_limits<double>::max();
+    uint64_t best_allocs = 0, max_allocs = 0;
+    for (size_t i = 0; i < num_reps; i++) {
+        setup();
+        uint64_t start_allocs = num_heap_allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        uint64_t run_allocs = num_heap_allocations.load() - start_allocs;
+
+        double run_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        if (run_ns < best_ns) {best_ns = run_ns; best_allocs = run_allocs;}
+        max_allocs = std::max(max_allocs, run_allocs);
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.param = param;
+    result.ops_per_run = ops_per_run;
+    result.ns_per_op = best_ns / ops_per_run;
+    result.bytes_per_sec = bytes_per_run / (best_ns / 1e9);
+    result.allocs_per_op = (best_allocs + 0.0) / ops_per_run;
+    result.max_allocs_per_run = max_allocs;
+    return result;
+}
+
+std::string generate_sequence(size_t seq_length) {
+    /* Generates a random DNA sequence, the same way generate_fasta does */
+    std::array<char, 4> alphabet = {'A', 'C', 'G', 'T'};
+    std::string curr_seq (seq_length, 'A');
+    for (size_t i = 0; i < seq_length; i++) {curr_seq[i] = alphabet[GET_RANDOM_INDEX(4)];}
+    return curr_seq;
+}
+
+std::vector<std::string> generate_records(size_t num_records, size_t num_distinct) {
+    /* Generates connection records that look like the discretized NSL-KDD records */
+    std::array<const char*, 3> protocols = {"tcp", "udp", "icmp"};
+    std::array<const char*, 4> services = {"http", "ftp_data", "private", "smtp"};
+    std::array<const char*, 2> labels = {"normal", "neptune"};
+
+    std::vector<std::string> distinct_records;
+    for (size_t i = 0; i < num_distinct; i++) {
+        std::string record = std::to_string(GET_RANDOM_INDEX(5));
+        record += std::string(",") + protocols[GET_RANDOM_INDEX(3)] + "," + services[GET_RANDOM_INDEX(4)] + ",SF";
+        for (size_t j = 4; j < NUM_RECORD_FIELDS; j++) {record += "," + std::to_string(GET_RANDOM_INDEX(5));}
+        record += std::string(",") + labels[GET_RANDOM_INDEX(2)];
+        distinct_records.push_back(record);
+    }
+
+    std::vector<std::string> records;
+    for (size_t i = 0; i < num_records; i++) {records.push_back(distinct_records[GET_RANDOM_INDEX(num_distinct)]);}
+    return records;
+}
+
+std::vector<uint64_t> generate_hashes(size_t num_hashes) {
+    /* Generates uniformly distributed 64-bit hash values */
+    std::vector<uint64_t> hash_vals (num_hashes);
+    uint64_t seed = rand();
+    for (size_t i = 0; i < num_hashes; i++) {hash_vals[i] = MurmurHash3(seed + i);}
+    return hash_vals;
+}
+
+void bench_hll(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks HyperLogLog insert, merge and cardinality across values of b */
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::unique_ptr<HyperLogLog> sketch;
+
+    for (uint8_t b: {4, 8, 12, 14, 16, 18, 20, 22}) {
+        std::string param = "b=" + std::to_string(b);
+        double register_bytes = TOTAL_REGISTER_SPACE((uint64_t) 1 << b);
+
+        results.push_back(run_benchmark("hll_insert", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {sketch.reset(new HyperLogLog(b, PACKET));},
+                                        [&] {for (uint64_t hash_val: hash_vals) {sketch->add_hash(hash_val);}}));
+
+        results.push_back(run_benchmark("hll_insert_batch", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {sketch.reset(new HyperLogLog(b, PACKET));},
+                                        [&] {sketch->add_hashes(hash_vals.data(), hash_vals.size());}));
+
+        // Merge and cardinality are repeated enough times to touch about num_items registers
+        HyperLogLog sketch_1 (b, PACKET), sketch_2 (b, PACKET);
+        sketch_1.add_hashes(hash_vals.data(), hash_vals.size()/2);
+        sketch_2.add_hashes(hash_vals.data() + hash_vals.size()/2, hash_vals.size()/2);
+        size_t num_calls = std::max(opts.num_items >> b, (size_t) 1);
+
+        results.push_back(run_benchmark("hll_merge", param, num_calls, num_calls * 2 * register_bytes, opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {
+                                                HyperLogLog union_sketch = sketch_1 + sketch_2;
+                                                benchmark_sink += union_sketch.compute_cardinality() & 1;}}));
+
+        results.push_back(run_benchmark("hll_merge_inplace", param, num_calls, num_calls * 2 * register_bytes, opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {sketch_1 += sketch_2;}}));
+
+        results.push_back(run_benchmark("hll_cardinality", param, num_calls, num_calls * register_bytes, opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {benchmark_sink += sketch_1.compute_cardinality();}}));
+    }
+}
+
+void bench_minhash(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks MinHash insert, jaccard and union across values of k */
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::unique_ptr<MinHash> sketch;
+
+    for (size_t k: {10, 100, 1000}) {
+        std::string param = "k=" + std::to_string(k);
+
+        results.push_back(run_benchmark("minhash_insert", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {sketch.reset(new MinHash(k, PACKET));},
+                                        [&] {for (uint64_t hash_val: hash_vals) {sketch->add_hash(hash_val);}}));
+
+        // Both sketches share half of their input, so the jaccard is around 1/3
+        MinHash sketch_1 (k, PACKET), sketch_2 (k, PACKET);
+        for (size_t i = 0; i < hash_vals.size()*2/3; i++) {sketch_1.add_hash(hash_vals[i]);}
+        for (size_t i = hash_vals.size()/3; i < hash_vals.size(); i++) {sketch_2.add_hash(hash_vals[i]);}
+        size_t num_calls = std::max(opts.num_items/(k * 100), (size_t) 1);
+
+        results.push_back(run_benchmark("minhash_jaccard", param, num_calls, num_calls * 2 * k * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {
+                                                benchmark_sink += MinHash::compute_jaccard(sketch_1, sketch_2) > 0.5;}}));
+
+        results.push_back(run_benchmark("minhash_union", param, num_calls, num_calls * 2 * k * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {
+                                                MinHash union_sketch = sketch_1 + sketch_2;
+                                                benchmark_sink += union_sketch.get_cardinality();}}));
+    }
+}
+
+void bench_frac_minhash(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* 
+     * Benchmarks FracMinHash insert across scales, against the bottom-k insert above, and the
+     * containment of a small window in a reference sketch built from all of the hashes
+     */
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::unique_ptr<FracMinHash> sketch;
+
+    for (uint64_t scale: {1, 100, 1000}) {
+        std::string param = "s=" + std::to_string(scale);
+
+        results.push_back(run_benchmark("frac_minhash_insert", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {sketch.reset(new FracMinHash(scale, PACKET));},
+                                        [&] {for (uint64_t hash_val: hash_vals) {sketch->add_hash(hash_val);}
+                                             benchmark_sink += sketch->get_num_hashes();}));
+
+        // The window is a slice of the reference, so the containment is close to 1
+        FracMinHash reference_sketch (scale, PACKET), window_sketch (scale, PACKET);
+        for (uint64_t hash_val: hash_vals) {reference_sketch.add_hash(hash_val);}
+        for (size_t i = 0; i < std::min(hash_vals.size(), (size_t) BENCH_WINDOW_SIZE); i++) {window_sketch.add_hash(hash_vals[i]);}
+        size_t num_calls = std::max(opts.num_items/(BENCH_WINDOW_SIZE * 10), (size_t) 1);
+
+        results.push_back(run_benchmark("frac_minhash_contain", param, num_calls, num_calls * window_sketch.get_num_hashes() * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {for (size_t i = 0; i < num_calls; i++) {
+                                                benchmark_sink += FracMinHash::compute_containment(window_sketch, reference_sketch) > 0.5;}}));
+    }
+}
+
+void bench_windows(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* 
+     * Benchmarks the window loops of the simulate and classify sub-commands: the window sketch is
+     * reset and refilled, then compared to the reference sketches. After the first (setup) window,
+     * this should not allocate any memory, which shows up as 0 allocs/op (and is what -c checks).
+     */
+    std::vector<std::string> records = generate_records(BENCH_WINDOW_SIZE * 4, 5000);
+    size_t num_windows = std::max(opts.num_items/BENCH_WINDOW_SIZE, (size_t) 1);
+    size_t curr_record = 0;
+
+    for (size_t k: {100, 1000}) {
+        MinHash normal_sketch (k, PACKET), attack_sketch (k, PACKET), window_sketch (k, PACKET);
+        for (size_t i = 0; i < records.size(); i++) {(i % 2 ? normal_sketch : attack_sketch).add_record(records[i].data(), records[i].length());}
+        ScratchArena window_scratch;
+
+        auto simulate_window = [&] {
+            window_sketch.reset();
+            window_scratch.reset();
+            for (size_t i = 0; i < BENCH_WINDOW_SIZE; i++) {
+                const std::string& record = records[curr_record++ % records.size()];
+                window_sketch.add_record(record.data(), record.length());
+            }
+            benchmark_sink += MinHash::compute_jaccard(window_sketch, normal_sketch, window_scratch) > 
+                              MinHash::compute_jaccard(window_sketch, attack_sketch, window_scratch);
+        };
+        results.push_back(run_benchmark("minhash_window", "k=" + std::to_string(k), num_windows, 0.0, opts.num_reps,
+                                        simulate_window, [&] {for (size_t i = 0; i < num_windows; i++) {simulate_window();}}));
+    }
+
+    // The HLL windows of classify write every union over one scratch sketch, the reference cardinalities are estimated once
+    for (uint8_t b: {10, 14}) {
+        HyperLogLog normal_sketch (b, PACKET), attack_sketch (b, PACKET), window_sketch (b, PACKET), union_sketch (b, PACKET);
+        for (size_t i = 0; i < records.size(); i++) {(i % 2 ? normal_sketch : attack_sketch).add_record(records[i].data(), records[i].length());}
+        uint64_t normal_cardinality = normal_sketch.compute_cardinality(), attack_cardinality = attack_sketch.compute_cardinality();
+
+        auto classify_window = [&] {
+            window_sketch.reset();
+            for (size_t i = 0; i < BENCH_WINDOW_SIZE; i++) {
+                const std::string& record = records[curr_record++ % records.size()];
+                window_sketch.add_record(record.data(), record.length());
+            }
+            uint64_t window_cardinality = window_sketch.compute_cardinality();
+            union_sketch.assign_union(window_sketch, normal_sketch);
+            double normal_jaccard = HyperLogLog::compute_jaccard(window_cardinality, normal_cardinality, union_sketch.compute_cardinality());
+            union_sketch.assign_union(window_sketch, attack_sketch);
+            double attack_jaccard = HyperLogLog::compute_jaccard(window_cardinality, attack_cardinality, union_sketch.compute_cardinality());
+            benchmark_sink += normal_jaccard > attack_jaccard;
+        };
+        results.push_back(run_benchmark("hll_window", "b=" + std::to_string(b), num_windows, 0.0, opts.num_reps,
+                                        classify_window, [&] {for (size_t i = 0; i < num_windows; i++) {classify_window();}}));
+    }
+}
+
+int check_window_allocations(const std::vector<BenchResult>& results) {
+    /* Checks that no timed run of a window loop allocated memory once it was warmed up, returns 1 if one did */
+    int check_failed = 0;
+    for (const BenchResult& result: results) {
+        bool is_window = result.name.length() > 7 && result.name.compare(result.name.length() - 7, 7, "_window") == 0;
+        if (!is_window) {continue;}
+
+        std::fprintf(stdout, "%-22s%-24s%s\n", result.name.data(), result.param.data(), (result.max_allocs_per_run) ? "FAILED" : "ok");
+        if (result.max_allocs_per_run) {
+            std::fprintf(stderr, "Error: %s (%s) made %llu heap allocations in a run of windows after the warm-up.\n",
+                         result.name.data(), result.param.data(), (unsigned long long) result.max_allocs_per_run);
+            check_failed = 1;
+        }
+    }
+    return check_failed;
+}
+
+void bench_records(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks splitting and hashing of connection records */
+    std::vector<std::string> records = generate_records(std::max(opts.num_items/10, (size_t) 1), 5000);
+    double total_bytes = 0.0;
+    for (const std::string& record: records) {total_bytes += record.length();}
+
+    results.push_back(run_benchmark("split", "", records.size(), total_bytes, opts.num_reps, [] {},
+                                    [&] {for (const std::string& record: records) {benchmark_sink += split(record, ',').size();}}));
+
+    results.push_back(run_benchmark("hash_record", "", records.size(), total_bytes, opts.num_reps, [] {},
+                                    [&] {for (const std::string& record: records) {
+                                            benchmark_sink += hash_record(record.data(), record.length());}}));
+
+    // One parse of each record feeds a HLL for every feature, and one for the whole feature vector
+    std::vector<RecordSpan> record_spans;
+    for (const std::string& record: records) {record_spans.push_back({record.data(), record.length()});}
+    std::vector<size_t> all_columns (NUM_RECORD_FIELDS);
+    std::iota(all_columns.begin(), all_columns.end(), 0);
+
+    results.push_back(run_benchmark("hll_columns", "cols=41", records.size(), total_bytes, opts.num_reps, [] {},
+                                    [&] {std::vector<HyperLogLog> sketches = build_column_sketches(record_spans, all_columns, 12);
+                                         benchmark_sink += sketches.back().compute_cardinality();}));
+
+    // Building a sketch from the records as text, and from the same records converted to the columnar format
+    char text_path[] = "/tmp/pacsketch_bench_XXXXXX";
+    char columnar_path[] = "/tmp/pacsketch_bench_XXXXXX";
+    int text_fd = mkstemp(text_path), columnar_fd = mkstemp(columnar_path);
+    if (text_fd < 0 || columnar_fd < 0) {THROW_EXCEPTION("Error occurred while creating the temporary record files.");}
+    close(text_fd);
+    close(columnar_fd);
+
+    std::ofstream text_file (text_path, std::ofstream::out);
+    for (const std::string& record: records) {text_file << record << "\n";}
+    text_file.close();
+    write_columnar_file(record_spans, columnar_path);
+
+    results.push_back(run_benchmark("text_build_hll", "b=12", records.size(), total_bytes, opts.num_reps, [] {},
+                                    [&] {HyperLogLog sketch (text_path, 12, PACKET); benchmark_sink += sketch.compute_cardinality();}));
+    results.push_back(run_benchmark("columnar_build_hll", "b=12", records.size(), records.size() * sizeof(uint64_t), opts.num_reps, [] {},
+                                    [&] {HyperLogLog sketch (columnar_path, 12, PACKET); benchmark_sink += sketch.compute_cardinality();}));
+    unlink(text_path);
+    unlink(columnar_path);
+}
+
+void bench_countmin(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks the Count-Min multi-row update, and counting records with heavy-hitter tracking */
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::vector<std::string> records = generate_records(std::max(opts.num_items/10, (size_t) 1), 5000);
+    double total_bytes = 0.0;
+    for (const std::string& record: records) {total_bytes += record.length();}
+
+    for (size_t width: {256, 2048, 65536}) {
+        std::string param = "w=" + std::to_string(width);
+        CountMin sketch (width, 10);
+
+        results.push_back(run_benchmark("countmin_update", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {sketch.reset();},
+                                        [&] {for (uint64_t hash_val: hash_vals) {benchmark_sink += sketch.add_hash(hash_val);}}));
+
+        results.push_back(run_benchmark("countmin_record", param, records.size(), total_bytes, opts.num_reps,
+                                        [&] {sketch.reset();},
+                                        [&] {for (const std::string& record: records) {sketch.add_record(record.data(), record.length());}}));
+    }
+}
+
+void bench_kmers(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks k-mer encoding, and building sketches from a FASTA file */
+    std::string curr_seq = generate_sequence(opts.num_items + FASTA_KMER_LENGTH - 1);
+    size_t num_kmers = opts.num_items;
+
+    results.push_back(run_benchmark("encode_string", "", num_kmers, num_kmers * FASTA_KMER_LENGTH, opts.num_reps, [] {},
+                                    [&] {char curr_kmer[FASTA_KMER_LENGTH + 1] = {0};
+                                         for (size_t i = 0; i < num_kmers; i++) {
+                                            memcpy(curr_kmer, &curr_seq[i], FASTA_KMER_LENGTH);
+                                            benchmark_sink += encode_string(curr_kmer);}}));
+
+    // Write the sequence out as FASTA, so the k-mer extraction in the sketches is timed as-is
+    char fasta_path[] = "/tmp/pacsketch_bench_XXXXXX";
+    int fasta_fd = mkstemp(fasta_path);
+    if (fasta_fd < 0) {THROW_EXCEPTION("Error occurred while creating the temporary FASTA file.");}
+    close(fasta_fd);
+
+    std::ofstream fasta_file (fasta_path, std::ofstream::out);
+    fasta_file << ">seq0\n";
+    for (size_t i = 0; i < curr_seq.length(); i += 60) {fasta_file << curr_seq.substr(i, 60) << "\n";}
+    fasta_file.close();
+
+    results.push_back(run_benchmark("fasta_build_hll", "b=12", num_kmers, curr_seq.length(), opts.num_reps, [] {},
+                                    [&] {HyperLogLog sketch (fasta_path, 12, FASTA); benchmark_sink += sketch.compute_cardinality();}));
+    results.push_back(run_benchmark("fasta_build_minhash", "k=100", num_kmers, curr_seq.length(), opts.num_reps, [] {},
+                                    [&] {MinHash sketch (fasta_path, 100, FASTA); benchmark_sink += sketch.get_cardinality();}));
+    unlink(fasta_path);
+}
+
+void bench_pcap(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks decoding the packets of a capture, and building a HLL from it */
+    size_t num_packets = opts.num_items;
+    std::vector<uint64_t> hash_vals = generate_hashes(num_packets);
+
+    // Write a classic pcap of Ethernet/IPv4/UDP frames, with addresses and ports taken from the hashes
+    char pcap_path[] = "/tmp/pacsketch_bench_XXXXXX";
+    int pcap_fd = mkstemp(pcap_path);
+    if (pcap_fd < 0) {THROW_EXCEPTION("Error occurred while creating the temporary pcap file.");}
+    close(pcap_fd);
+
+    std::ofstream pcap_file (pcap_path, std::ofstream::out | std::ofstream::binary);
+    const uint32_t file_header[6] = {PCAP_MAGIC_USEC, 0x00040002, 0, 0, 65535, LINKTYPE_ETHERNET};
+    pcap_file.write((const char*) file_header, sizeof(file_header));
+
+    uint8_t frame[42] = {0};
+    frame[12] = 0x08; frame[14] = 0x45; frame[17] = 28; frame[22] = 64; frame[23] = 17; frame[39] = 8;
+    for (size_t i = 0; i < num_packets; i++) {
+        const uint32_t record_header[4] = {(uint32_t) i, 0, sizeof(frame), sizeof(frame)};
+        std::memcpy(frame + 26, &hash_vals[i], 8); // source and destination addresses
+        std::memcpy(frame + 34, &hash_vals[i], 4); // source and destination ports
+        pcap_file.write((const char*) record_header, sizeof(record_header));
+        pcap_file.write((const char*) frame, sizeof(frame));
+    }
+    pcap_file.close();
+    size_t total_bytes = 24 + num_packets * (16 + sizeof(frame));
+
+    results.push_back(run_benchmark("pcap_decode", "5tuple", num_packets, total_bytes, opts.num_reps, [] {},
+                                    [&] {PcapReader reader (pcap_path);
+                                         PacketHeaders headers;
+                                         while (reader.next_packet(&headers)) {benchmark_sink += hash_packet_key(headers, FIVE_TUPLE_KEY);}}));
+    results.push_back(run_benchmark("pcap_build_hll", "b=12", num_packets, total_bytes, opts.num_reps, [] {},
+                                    [&] {HyperLogLog sketch (pcap_path, 12, PCAP); benchmark_sink += sketch.compute_cardinality();}));
+    unlink(pcap_path);
+}
+
+void bench_merge_files(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* Benchmarks the merge sub-command's parallel tree union of many HLL sketch files */
+    char dir_path[] = "/tmp/pacsketch_bench_XXXXXX";
+    if (mkdtemp(dir_path) == NULL) {THROW_EXCEPTION("Error occurred while creating the temporary sketch directory.");}
+
+    // Each sketch file gets a different slice of the hashes
+    const size_t num_files = 256;
+    const uint8_t b = 14;
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::vector<std::string> file_paths;
+    for (size_t i = 0; i < num_files; i++) {
+        HyperLogLog sketch (b, PACKET);
+        size_t start = i * hash_vals.size() / num_files, end = (i + 1) * hash_vals.size() / num_files;
+        sketch.add_hashes(hash_vals.data() + start, end - start);
+        file_paths.push_back(std::string(dir_path) + "/sketch_" + std::to_string(i) + ".hll");
+        sketch.write_to_file(file_paths.back());
+    }
+    double total_bytes = num_files * (sizeof(SketchFileHeader) + TOTAL_REGISTER_SPACE((uint64_t) 1 << b));
+
+    std::vector<size_t> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) {thread_counts.push_back(std::thread::hardware_concurrency());}
+    for (size_t num_threads: thread_counts) {
+        results.push_back(run_benchmark("merge_hll_files", "t=" + std::to_string(num_threads), num_files, total_bytes, opts.num_reps, [] {},
+                                        [&] {HyperLogLog union_sketch = merge_hll_files(file_paths, num_threads);
+                                             benchmark_sink += union_sketch.compute_cardinality();}));
+    }
+    for (const std::string& file_path: file_paths) {unlink(file_path.data());}
+    rmdir(dir_path);
+}
+
+void bench_concurrent_hll(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* 
+     * Benchmarks many threads inserting into one shared ConcurrentHyperLogLog, against each
+     * thread building its own HyperLogLog and merging them at the end. Each thread gets a
+     * contiguous slice of the hashes, and the thread start-up is part of both timings.
+     */
+    const uint8_t b = 14;
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+    std::unique_ptr<ConcurrentHyperLogLog> shared_sketch;
+
+    for (size_t num_threads: {1, 2, 4, 8, 16, 32}) {
+        std::string param = "b=14,t=" + std::to_string(num_threads);
+
+        results.push_back(run_benchmark("hll_concurrent", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps,
+                                        [&] {shared_sketch.reset(new ConcurrentHyperLogLog(b, PACKET));},
+                                        [&] {for_each_chunk(hash_vals.size(), num_threads, [&](size_t, size_t start, size_t end) {
+                                                 shared_sketch->add_hashes(hash_vals.data() + start, end - start);});
+                                             benchmark_sink += shared_sketch->snapshot().compute_cardinality();}));
+
+        results.push_back(run_benchmark("hll_thread_local", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {std::vector<std::unique_ptr<HyperLogLog>> local_sketches (num_threads);
+                                             for_each_chunk(hash_vals.size(), num_threads, [&](size_t thread_num, size_t start, size_t end) {
+                                                 local_sketches[thread_num].reset(new HyperLogLog(b, PACKET));
+                                                 local_sketches[thread_num]->add_hashes(hash_vals.data() + start, end - start);});
+                                             for (size_t i = 1; i < num_threads; i++) {if (local_sketches[i]) {*local_sketches[0] += *local_sketches[i];}}
+                                             benchmark_sink += local_sketches[0]->compute_cardinality();}));
+    }
+}
+
+void bench_concurrent_minhash(const PacsketchBenchOptions& opts, std::vector<BenchResult>& results) {
+    /* 
+     * Benchmarks threads inserting into a ConcurrentMinHash (local bottom-k behind a shared
+     * threshold), against each thread building its own MinHash and merging them. The share of
+     * hashes dropped by the shared threshold is reported as part of the parameter.
+     */
+    const size_t k = 1000;
+    std::vector<uint64_t> hash_vals = generate_hashes(opts.num_items);
+
+    for (size_t num_threads: {1, 2, 4, 8, 16, 32}) {
+        std::string param = "k=1000,t=" + std::to_string(num_threads);
+
+        double rejection_rate = 0.0;
+        BenchResult concurrent_result = run_benchmark("minhash_concurrent", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {ConcurrentMinHash shared_sketch (k, PACKET);
+                                             for_each_chunk(hash_vals.size(), num_threads, [&](size_t, size_t start, size_t end) {
+                                                 ConcurrentMinHash::LocalBuffer local_buffer (shared_sketch);
+                                                 local_buffer.add_hashes(hash_vals.data() + start, end - start);});
+                                             benchmark_sink += shared_sketch.snapshot().get_cardinality();
+                                             rejection_rate = (shared_sketch.get_num_threshold_rejected() + 0.0) / shared_sketch.get_num_inserted();});
+        concurrent_result.param += ",rej=" + std::to_string(rejection_rate * 100).substr(0, 5) + "%";
+        results.push_back(concurrent_result);
+
+        results.push_back(run_benchmark("minhash_thread_local", param, hash_vals.size(), hash_vals.size() * sizeof(uint64_t), opts.num_reps, [] {},
+                                        [&] {std::vector<std::unique_ptr<MinHash>> local_sketches (num_threads);
+                                             for_each_chunk(hash_vals.size(), num_threads, [&](size_t thread_num, size_t start, size_t end) {
+                                                 local_sketches[thread_num].reset(new MinHash(k, PACKET));
+                                                 for (size_t i = start; i < end; i++) {local_sketches[thread_num]->add_hash(hash_vals[i]);}});
+                                             for (size_t i = 1; i < num_threads; i++) {if (local_sketches[i]) {*local_sketches[0] += *local_sketches[i];}}
+                                             benchmark_sink += local_sketches[0]->get_cardinality();}));
+    }
+}
+
+void print_results(const std::vector<BenchResult>& results) {
+    /* Prints the results as a table to stdout */
+    std::fprintf(stdout, "%-22s%-24s%14s%14s%14s\n", "benchmark", "param", "ns/op", "MB/s", "allocs/op");
+    for (const BenchResult& result: results) {
+        std::fprintf(stdout, "%-22s%-24s%14.2f%14.1f%14.3f\n", result.name.data(), result.param.data(),
+                     result.ns_per_op, result.bytes_per_sec/1e6, result.allocs_per_op);
+    }
+}
+
+void write_json_report(const std::vector<BenchResult>& results, const PacsketchBenchOptions& opts) {
+    /* Writes the results to a JSON file, so they can be compared across versions */
+    FILE* json_out = std::fopen(opts.json_file.data(), "w");
+    if (json_out == NULL) {THROW_EXCEPTION(("Unable to open the JSON output file: " + opts.json_file).data());}
+
+    std::fprintf(json_out, "{\n  \"version\": \"%s\",\n  \"num_items\": %zu,\n  \"num_reps\": %zu,\n  \"benchmarks\": [\n",
+                 PACSKETCH_VERSION, opts.num_items, opts.num_reps);
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(json_out, "    {\"name\": \"%s\", \"param\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.4f, \"bytes_per_sec\": %.1f, \"allocs_per_op\": %.4f}%s\n",
+                     results[i].name.data(), results[i].param.data(), results[i].ops_per_run,
+                     results[i].ns_per_op, results[i].bytes_per_sec, results[i].allocs_per_op, (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(json_out, "  ]\n}\n");
+    std::fclose(json_out);
+}
+
+void parse_bench_options(int argc, char** argv, PacsketchBenchOptions* opts) {
+    /* Parses the command-line arguments */
+    for (int c; (c = getopt(argc, argv, "hn:r:j:c")) >= 0;){
+        switch (c) {
+            case 'h': pacsketch_bench_usage(); std::exit(1);
+            case 'n': opts->num_items = std::max(std::atol(optarg), 0L); break;
+            case 'r': opts->num_reps = std::max(std::atoi(optarg), 0); break;
+            case 'j': opts->json_file.assign(optarg); break;
+            case 'c': opts->check_allocations = true; break;
+            default: pacsketch_bench_usage(); std::exit(1);
+        }
+    }
+}
+
+int pacsketch_bench_usage() {
+    /* prints out the usage information for the benchmark program */
+    std::fprintf(stderr, "pacsketch_bench - times the core operations of the sketches on synthetic\n");
+    std::fprintf(stderr, "                  input, and reports ns/op and throughput for each one.\n");
+    std::fprintf(stderr, "Usage: pacsketch_bench [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10snumber of hashes/bases used as input (default: 1000000)\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10snumber of repetitions for each benchmark (default: 5)\n", "-r [arg]");
+    std::fprintf(stderr, "\t%-10spath to write the results as JSON\n", "-j [FILE]");
+    std::fprintf(stderr, "\t%-10sonly run the window loops, and exit with 1 if one allocates after its warm-up\n", "-c");
+    return 0;
+}
+
+int main (int argc, char ** argv) {
+    /* main method of the benchmark program */
+    PacsketchBenchOptions run_opts;
+    parse_bench_options(argc, argv, &run_opts);
+    run_opts.validate();
+    srand(time(NULL));
+
+    std::vector<BenchResult> results;
+    if (run_opts.check_allocations) {
+        bench_windows(run_opts, results);
+        return check_window_allocations(results);
+    }
+    bench_hll(run_opts, results);
+    bench_minhash(run_opts, results);
+    bench_frac_minhash(run_opts, results);
+    bench_windows(run_opts, results);
+    bench_records(run_opts, results);
+    bench_countmin(run_opts, results);
+    bench_kmers(run_opts, results);
+    bench_pcap(run_opts, results);
+    bench_merge_files(run_opts, results);
+    bench_concurrent_hll(run_opts, results);
+    bench_concurrent_minhash(run_opts, results);
+
+    print_results(results);
+    if (run_opts.json_file.length()) {write_json_report(results, run_opts);}
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Name: pacsketch_bench.h
+ * Description: Header file for pacsketch_bench.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _PACSKETCH_BENCH_H
+#define _PACSKETCH_BENCH_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pacsketch.h>
+
+// Define method to randomly choose index from array of length x
+#define GET_RANDOM_INDEX(x) (rand()%(x))
+
+#define NUM_RECORD_FIELDS 41 // number of features in a NSL-KDD connection record
+#define BENCH_WINDOW_SIZE 2000 // number of records in each simulated window
+
+struct BenchResult {
+    /* Timing summary for one benchmark at one parameter value */
+    std::string name; // operation that was timed
+    std::string param; // parameter of the sketch (k or b) if any
+    size_t ops_per_run = 0; // number of operations in one timed run
+    double ns_per_op = 0.0; // best time per operation across the repetitions
+    double bytes_per_sec = 0.0; // input bytes processed per second in the best run
+    double allocs_per_op = 0.0; // heap allocations per operation in the best run
+    uint64_t max_allocs_per_run = 0; // most heap allocations made by any of the timed runs
+};
+
+struct PacsketchBenchOptions {
+    size_t num_items = 1000000; // number of hashes/records/bases used as input
+    size_t num_reps = 5; // number of times each benchmark is repeated
+    std::string json_file = ""; // path to write the JSON report to
+    bool check_allocations = false; // only run the window loops, and fail if they allocate
+public:
+    void validate() {
+        if (num_items == 0) {FATAL_WARNING("The number of input items (-n) needs to be a positive number.");}
+        if (num_reps == 0) {FATAL_WARNING("The number of repetitions (-r) needs to be a positive number.");}
+    }
+};
+
+/* Function Declarations */
+void parse_bench_options(int argc, char** argv, PacsketchBenchOptions* opts);
+int pacsketch_bench_usage();
+std::string generate_sequence(size_t seq_length);
+std::vector<std::string> generate_records(size_t num_records, size_t num_distinct);
+std::vector<uint64_t> generate_hashes(size_t num_hashes);
+void print_results(const std::vector<BenchResult>& results);
+int check_window_allocations(const std::vector<BenchResult>& results);
+void write_json_report(const std::vector<BenchResult>& results, const PacsketchBenchOptions& opts);
+
+#endif /* end of _PACSKETCH_BENCH_H */
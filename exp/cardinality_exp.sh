@@ -5,7 +5,11 @@
 # cardinality_exp.sh -  Run the experiment to test the cardinality estimates for 
 #                       both the MinHash and HyperLogLog data-structure
 #
-#                       Usage: ./cardinality_exp.sh <output_dir>
+#                       Usage: ./cardinality_exp.sh <output_dir> [pacsketch_exp options]
+#
+#                       The datasets are generated and evaluated in-process by 
+#                       pacsketch_exp, extra options (e.g. -t threads, -s seed) are
+#                       passed along to it.
 #
 # Author: Omar Ahmed
 # Date: Oct. 20, 2021
@@ -15,10 +19,9 @@
 printf "[LOG] cardinality_exp.sh has started!\n"
 
 ## Load definitions, and make sure paths are valid
-fasta_generator="../build/generate_fasta"
-pacsketch="../build/pacsketch"
+pacsketch_exp="../build/pacsketch_exp"
 
-if [ ! -f $fasta_generator ] || [ ! -f $pacsketch ]; then
+if [ ! -f $pacsketch_exp ]; then
     printf "Error: Executables cannot be found, make sure they are built.\n"
     exit 1
 fi
@@ -31,69 +34,7 @@ if [ ! -d $output_dir ]; then
     exit 1
 fi
 
-if [ "${output_dir: -1}" != "/" ]; then
-  output_dir="${output_dir}/"
-fi
-
-num_datasets=1000
-
-## Generate various data-sets to use for cardinality test
-rm "${output_dir}true_cardinalities_all_datasets.txt"
-for i in $(seq 1 1 $num_datasets)
-do  
-    printf "${i} " >> "${output_dir}true_cardinalities_all_datasets.txt"
-    $fasta_generator -k 11 -n 1 -l 1000000 > "${output_dir}dataset_${i}.fa" 2>> "${output_dir}true_cardinalities_all_datasets.txt"
-done
-printf "[LOG] Finished generating various datasets to use for tests.\n"
-
-## Compute cardinalities when using MinHash
-rm "${output_dir}est_cardinalities_all_datasets_with_minhash.txt"
-for i in $(seq 1 1 $num_datasets)
-do
-    for k in 1 10 100 400
-    do
-        input_file="${output_dir}dataset_${i}.fa"
-        output=$($pacsketch build -i $input_file -f -M -c -k $k)
-        printf "${i} minhash_k${k} ${output}\n" >> "${output_dir}est_cardinalities_all_datasets_with_minhash.txt"
-    done
-done
-printf "[LOG] Finished generating cardinalities for all datasets using various MinHash settings.\n"
-
-## Compute cardinalities when using HLL
-rm "${output_dir}est_cardinalities_all_datasets_with_hll.txt"
-for i in $(seq 1 1 $num_datasets)
-do
-    for b in 3 6 9 12 
-    do
-        input_file="${output_dir}dataset_${i}.fa"
-        output=$($pacsketch build -i $input_file -f -H -c -b $b)
-        printf "${i} hll_b${b} ${output}\n" >> "${output_dir}est_cardinalities_all_datasets_with_hll.txt"
-    done
-done
-printf "[LOG] Finished generating cardinalities for all datasets using various HLL settings.\n"
-
-
-true_card_file="${output_dir}true_cardinalities_all_datasets.txt"
-est_card_file1="${output_dir}est_cardinalities_all_datasets_with_minhash.txt"
-est_card_file2="${output_dir}est_cardinalities_all_datasets_with_hll.txt"
-
-# Use join to combine these files
-join -j 1 -o 1.1,1.4,2.2,2.4  $true_card_file $est_card_file1 | awk '{printf("%s,%s,%s,%s\n", $1, $2, $3, $4)}' > "${output_dir}temp_output_file1.csv"
-join -j 1 -o 1.1,1.4,2.2,2.4  $true_card_file $est_card_file2 | awk '{printf("%s,%s,%s,%s\n", $1, $2, $3, $4)}' > "${output_dir}temp_output_file2.csv"
-cat "${output_dir}temp_output_file1.csv" "${output_dir}temp_output_file2.csv" > "${output_dir}output_file.csv"
-rm "${output_dir}temp_output_file1.csv" "${output_dir}temp_output_file2.csv"
-
-
-# Add the error rate to data-file
-awk -F ',' 'BEGIN {error=0.0} {error=(($4-$2)/$2 * 100); printf("%s,%s,%s,%s,%f\n",$1,$2,$3,$4,error);}' "${output_dir}output_file.csv" > "${output_dir}final_output_file.csv"
-rm "${output_dir}output_file.csv" 
-
-# Calculates the average error rate for each data-structure
-rm "${output_dir}final_averages_file.csv"
-for data_struct in "minhash_k1" "minhash_k10"  "minhash_k100" "minhash_k400" "hll_b3" "hll_b6" "hll_b9" "hll_b12"
-do
-    awk -F ',' -v var="${data_struct}" 'BEGIN{num=0; total=0.0} {if ($3 == var) {total +=sqrt($5*$5); num+=1;}} END{printf("%s,%d,%f,%f\n",var,num,total,(total/num));}'  \
-                        "${output_dir}final_output_file.csv" >> "${output_dir}final_averages_file.csv" 
-done
+## Produces final_output_file.csv and final_averages_file.csv
+$pacsketch_exp cardinality -o $output_dir -n 1000 -l 1000000 -K 1,10,100,400 -B 3,6,9,12 "${@:2}" || exit 1
 
-printf "[LOG] Finished analyzing the results.\n"
\ No newline at end of file
+printf "[LOG] Finished analyzing the results.\n"
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+#####################################################################################
+#
+# simulate_scaling_exp.sh -  Measures how the run-time of the simulate sub-command
+#                            scales with the window size, from 1,000 records up to
+#                            10,000,000 records per window.
+#
+#                            Usage: ./simulate_scaling_exp.sh <normal.csv> <attack.csv> <output_dir>
+#
+# Author: Omar Ahmed
+# Date: Oct. 18, 2026
+#
+#####################################################################################
+
+printf "[LOG] simulate_scaling_exp.sh has started!\n"
+
+## Load definitions, and make sure paths are valid
+pacsketch="../build/pacsketch"
+
+if [ ! -f $pacsketch ]; then
+    printf "Error: Executables cannot be found, make sure they are built.\n"
+    exit 1
+fi
+
+## Grab command-line arguments for input datasets and output directory
+normal_file="$1"
+attack_file="$2"
+output_dir="$3"
+
+if [ ! -f $normal_file ] || [ ! -f $attack_file ]; then
+    printf "Error: the normal and attack datasets need to be valid files.\n"
+    exit 1
+fi
+
+if [ ! -d $output_dir ]; then
+    printf "Error: ${output_dir} is not a valid directory.\n"
+    exit 1
+fi
+
+if [ "${output_dir: -1}" != "/" ]; then
+  output_dir="${output_dir}/"
+fi
+
+## Initialize the output file
+output_file="${output_dir}simulate_scaling_results.csv"
+printf "sketch,param,num_records,num_windows,seconds,records_per_sec\n" > $output_file
+
+## Time the simulation of a few windows at each window size, each window
+## inserts 3x the window size since it builds normal, attack and mixed sketches
+num_windows=5
+for num_records in 1000 10000 100000 1000000 10000000
+do
+    for k in 100 1000
+    do
+        start_time=$(date +%s.%N)
+        $pacsketch simulate -i $normal_file -i $attack_file -M -k $k \
+                            -n $num_records -w $num_windows -a 0.4 > /dev/null 2>&1
+        end_time=$(date +%s.%N)
+
+        seconds=$(awk -v s=$start_time -v e=$end_time 'BEGIN{printf("%.4f", e-s)}')
+        rate=$(awk -v t=$seconds -v n=$num_records -v w=$num_windows 'BEGIN{printf("%.1f", (3*n*w)/t)}')
+        printf "%s,%d,%d,%d,%s,%s\n" "minhash" $k $num_records $num_windows $seconds $rate >> $output_file
+    done
+    printf "[LOG] Finished timing windows with ${num_records} records.\n"
+done
+
+printf "[LOG] Finished saving results to ${output_file}.\n"
@@ -0,0 +1,54 @@
+/*
+ * Name: arena.h
+ * Description: Contains a small arena that hands out scratch space for the 
+ *              per-window work in simulate, so the memory is reused across
+ *              windows instead of being allocated and freed for each one.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARENA_MIN_BLOCK_WORDS 4096 // smallest block the arena allocates (32 KB)
+
+class ScratchArena {
+    /* 
+     * Bump allocator of uint64_t words. Memory from allocate() stays valid until reset(),
+     * which makes all the blocks available again without freeing them. Once the arena has
+     * grown to the size of the largest window, it no longer touches the heap.
+     */
+private:
+    std::vector<std::unique_ptr<uint64_t[]>> blocks; // blocks owned by the arena
+    std::vector<size_t> block_sizes; // number of words in each block
+    size_t curr_block = 0; // block that is currently being handed out
+    size_t curr_offset = 0; // words already used in the current block
+
+public:
+    uint64_t* allocate(size_t num_words) {
+        /* Returns space for num_words words, only going to the heap if no block has room */
+        while (curr_block < blocks.size() && curr_offset + num_words > block_sizes[curr_block]) {
+            curr_block++; curr_offset = 0;
+        }
+        if (curr_block == blocks.size()) {
+            size_t block_size = std::max(num_words, std::max((size_t) ARENA_MIN_BLOCK_WORDS, 2 * total_words()));
+            blocks.emplace_back(new uint64_t[block_size]);
+            block_sizes.push_back(block_size);
+        }
+        uint64_t* space = blocks[curr_block].get() + curr_offset;
+        curr_offset += num_words;
+        return space;
+    }
+    void reset() {curr_block = 0; curr_offset = 0;} // everything handed out so far can be reused
+    size_t total_words() const {size_t total = 0; for (size_t size: block_sizes) {total += size;} return total;}
+};
+
+#endif /* end of _ARENA_H */
@@ -0,0 +1,90 @@
+/*
+ * Name: columnar.h
+ * Description: Header file for columnar.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _COLUMNAR_H
+#define _COLUMNAR_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pacsketch.h>
+
+#define COLUMNAR_MAGIC "PKSCOL01" // first 8 bytes of a columnar record file
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_BYTE_ORDER 0x01020304 // written in host order, so a file from a host of the other endianness is rejected
+#define COLUMNAR_ALIGNMENT 64 // every column starts on a cache line
+
+enum column_type {CATEGORICAL_COLUMN, NUMERIC_COLUMN};
+
+struct ColumnarHeader {
+    /* 
+     * Fixed-size header at the start of a columnar file, followed by num_columns + 1 column
+     * descriptors (the features, then the label). The offsets are from the start of the file.
+     */
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_records;
+    uint32_t num_columns; // feature columns, every field of a record except the last one (the label)
+    uint32_t reserved;
+    uint64_t hash_offset; // hash_record() value of each record (uint64_t)
+};
+
+struct ColumnDescriptor {
+    /*
+     * Describes one column of the file. Categorical columns hold dictionary codes, and numeric
+     * columns hold the value minus base_value, both with the smallest width that fits. The
+     * largest value of the width means the field is missing from the record (short records).
+     */
+    uint32_t type;
+    uint32_t width; // bytes per value: 1, 2, 4 or 8
+    int64_t base_value; // added to the stored values of numeric columns
+    uint64_t data_offset;
+    uint64_t dict_offset; // dictionary of categorical columns: uint32_t offsets[dict_size+1], then the characters
+    uint32_t dict_size;
+    uint32_t reserved;
+};
+
+class ColumnarFile {
+    /*
+     * Read-only view of a columnar record file. The file is memory-mapped, so the record
+     * hashes can be inserted into the sketches straight from the mapping, and the text of
+     * a record is only rebuilt when a sub-command asks for it.
+     */
+private:
+    const uint8_t* file_data = NULL;
+    size_t file_size = 0;
+    const ColumnarHeader* header = NULL;
+    const ColumnDescriptor* columns = NULL;
+
+public:
+    ColumnarFile(const std::string& file_path);
+    ~ColumnarFile();
+    ColumnarFile(const ColumnarFile&) = delete;
+    ColumnarFile& operator=(const ColumnarFile&) = delete;
+
+    size_t get_num_records() const {return header->num_records;}
+    size_t get_num_columns() const {return header->num_columns;}
+    const uint64_t* get_record_hashes() const {return reinterpret_cast<const uint64_t*>(file_data + header->hash_offset);}
+    RecordSpan get_label(size_t record_num) const;
+    void append_record(size_t record_num, std::string& output) const;
+    std::string build_text() const;
+
+private:
+    void validate_range(uint64_t offset, uint64_t length) const;
+    uint64_t load_value(const ColumnDescriptor& column, size_t record_num) const;
+    bool append_field(const ColumnDescriptor& column, size_t record_num, std::string& output) const;
+
+}; // end of ColumnarFile class
+
+/* Function Declarations */
+bool is_columnar_file(const char* file_path);
+void write_columnar_file(const std::vector<RecordSpan>& records, const std::string& output_path);
+
+#endif /* end of _COLUMNAR_H */
@@ -0,0 +1,67 @@
+/*
+ * Name: countmin.h
+ * Description: Header file for countmin.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _COUNTMIN_H
+#define _COUNTMIN_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pacsketch.h>
+
+#define CM_DEPTH 4 // number of rows (hash functions), each row is updated in the same kernel call
+#define CM_MIN_WIDTH 16
+#define CM_MAX_WIDTH ((size_t) 1 << 24) // keeps every counter index within 32 bits
+#define CM_CANDIDATE_FACTOR 4 // heavy-hitter candidates kept for each of the top-N
+
+struct HeavyHitter {
+    /* Feature vector that is a candidate for the top-N, and its estimated count */
+    uint64_t hash_val = 0;
+    uint32_t estimated_count = 0;
+    std::string feature_vec; // fields of the record joined by '_' (same string that is hashed)
+};
+
+class CountMin {
+    /*
+     * Count-Min sketch over the feature vectors of connection records, with conservative
+     * update. Next to the counters it keeps a small table of heavy-hitter candidates, so
+     * the most frequent feature vectors can be reported. Memory only depends on the width
+     * and the value of N, not on the number of records.
+     */
+private:
+    size_t width = 0; // counters per row (power of 2)
+    uint32_t width_bits = 0; // log2 of width
+    size_t top_n = 0; // number of heavy-hitters that are reported
+    std::vector<uint32_t> counters; // CM_DEPTH rows of width counters, stored row after row
+    std::vector<HeavyHitter> candidates; // heavy-hitter candidates, only the first num_candidates are used
+    std::vector<uint64_t> candidate_hashes; // hash of each candidate, kept apart so lookups scan one array
+    size_t num_candidates = 0;
+    size_t min_candidate = 0; // index of the candidate with the smallest count
+    uint64_t total_count = 0; // number of records inserted
+    std::string feature_vec; // scratch space for the feature vector of the current record
+
+public:
+    CountMin(size_t width_val, size_t top_n_val);
+    void reset();
+    uint32_t add_hash(uint64_t hash_val);
+    void add_record(const char* record, size_t length);
+    uint32_t estimate_count(uint64_t hash_val) const;
+    uint64_t get_total_count() const {return total_count;}
+    std::vector<HeavyHitter> get_top_n() const;
+
+private:
+    void update_candidates(uint64_t hash_val, uint32_t estimated_count);
+    void find_min_candidate();
+
+}; // end of CountMin class
+
+uint32_t countmin_update_kernel(uint32_t* counters, uint32_t width_bits, uint64_t hash_val);
+uint32_t countmin_estimate_kernel(const uint32_t* counters, uint32_t width_bits, uint64_t hash_val);
+
+#endif /* end of _COUNTMIN_H */
@@ -0,0 +1,65 @@
+/*
+ * Name: discretize.h
+ * Description: Header file for discretize.cpp
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _DISCRETIZE_H
+#define _DISCRETIZE_H
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <string>
+#include <functional>
+#include <stdint.h>
+#include <pacsketch.h>
+
+#define NUM_KDD_FIELDS 42 // 41 features followed by the label, extra fields (e.g. difficulty) are dropped
+#define KDD_LABEL_FIELD 41
+#define NUM_NUMERIC_KDD_FEATURES 34
+
+#define DISCRETIZE_BATCH_SIZE 262144 // number of records binned in parallel before being passed on
+
+extern const std::array<size_t, NUM_NUMERIC_KDD_FEATURES> numeric_kdd_features; // indexes of numeric features
+extern const std::array<const char*, KDD_LABEL_FIELD> kdd_feature_names; // name of each feature (same as analyze_dataset.py)
+
+struct FeatureStats {
+    /* Running mean and variance of one feature, using Welford's method */
+    uint64_t count = 0;
+    double mean = 0.0;
+    double sum_sq_diffs = 0.0; // sum of squared differences from the current mean
+
+public:
+    void add(double value) {
+        count++;
+        double delta = value - mean;
+        mean += delta/count;
+        sum_sq_diffs += delta * (value - mean);
+    }
+    void merge(const FeatureStats& other) {
+        /* Combines the statistics of two disjoint sets of values (Chan et al.) */
+        if (other.count == 0) {return;}
+        uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count/total;
+        sum_sq_diffs += other.sum_sq_diffs + delta * delta * ((double) count * other.count/total);
+        count = total;
+    }
+    double stdev() const {return (count > 0) ? std::sqrt(sum_sq_diffs/count) : 0.0;} // population stdev
+};
+
+typedef std::function<void(const char* binned_record, size_t length, bool is_normal)> BinnedRecordCallback;
+
+/* Function Declarations */
+std::vector<FeatureStats> compute_feature_stats(const std::vector<RecordSpan>& records, size_t num_threads);
+uint8_t discretize_value(double value, const FeatureStats& stats);
+bool discretize_record(const RecordSpan& record, const std::vector<FeatureStats>& stats, std::string& output);
+std::vector<size_t> parse_kdd_columns(const std::string& column_list);
+void discretize_records(const std::vector<RecordSpan>& records, const std::vector<FeatureStats>& stats, 
+                        size_t num_threads, BinnedRecordCallback process_record);
+
+#endif /* end of _DISCRETIZE_H */
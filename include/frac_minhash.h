@@ -0,0 +1,81 @@
+/*
+ * Name: frac_minhash.h
+ * Description: Header file for frac_minhash.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _FRAC_MINHASH_H
+#define _FRAC_MINHASH_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include <pacsketch.h>
+#include <minhash.h>
+
+#define FRAC_MINHASH_MIN_COMPACT 1024 // buffered hashes before the first sort/deduplication
+
+class FracMinHash {
+    /*
+     * Scaled MinHash (FracMinHash): keeps every hash below MAX_HASH/s, so about 1 in s of the
+     * distinct items are kept and the sketch grows with the cardinality. Unlike a bottom-k
+     * MinHash, a small window can be compared to a huge reference without losing resolution,
+     * since both keep the same fraction of hash space.
+     *
+     * Inserting is a single compare and an append, the appended hashes are sorted and
+     * deduplicated lazily (when the buffer doubles, or before a query), so the queries are
+     * merges of two sorted lists.
+     */
+private:
+    std::string ref_file; // path to input data
+    data_type file_type; // tells us how to parse input
+    uint64_t scale = 1; // 1 in scale of the hash space is kept
+    uint64_t max_hash = MAX_HASH; // hashes below this value are kept
+    uint32_t hash_id = 0; // function used to hash the input (see sketch_file.h)
+    mutable std::vector<uint64_t> hashes; // kept hashes, [0, num_sorted) is sorted and distinct
+    mutable size_t num_sorted = 0;
+    mutable size_t compact_size = FRAC_MINHASH_MIN_COMPACT; // buffer size that triggers the next compact()
+
+public:
+    FracMinHash(std::string file_path, uint64_t scale_val, data_type input_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY); // Main constructor
+    FracMinHash(uint64_t scale_val, data_type input_type); // Used when creating union sketch
+
+    void reset();
+    void add_hash(uint64_t hash_val) {
+        /* Inserts a single hash value into the sketch, it is kept if it falls in the first 1/s of hash space */
+        if (hash_val < max_hash) {
+            hashes.push_back(hash_val);
+            if (hashes.size() >= compact_size) {compact();}
+        }
+    }
+    void add_record(const char* record, size_t length);
+    void add_sequence(const char* seq, size_t length);
+
+    size_t get_num_hashes() const;
+    uint64_t get_cardinality() const;
+    uint64_t get_memory_usage() const;
+    FracMinHash operator +(const FracMinHash& operand) const;
+    FracMinHash& operator +=(const FracMinHash& operand);
+    bool is_compatible(const FracMinHash& operand) const;
+    void write_to_file(const std::string& file_path, uint64_t input_offset = 0, uint64_t input_fingerprint = 0) const;
+    static FracMinHash read_from_file(const std::string& file_path);
+    static std::unique_ptr<FracMinHash> deserialize(const void* buffer, size_t buffer_size);
+
+    static size_t count_intersection(const FracMinHash& op1, const FracMinHash& op2);
+    static double compute_jaccard(const FracMinHash& op1, const FracMinHash& op2);
+    static double compute_containment(const FracMinHash& query, const FracMinHash& reference);
+
+private:
+    void compact() const;
+    bool accept_loaded_hashes();
+    void buildFromFASTA(std::string file_path);
+    void buildFromPackets(std::string file_path);
+    void buildFromPcap(std::string file_path, pcap_key_type pcap_key);
+
+}; // end of FracMinHash class
+
+#endif /* end of _FRAC_MINHASH_H */
@@ -11,8 +11,44 @@
 #define _HASH_FUN_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <string>
+#include <vector>
+#include <pacsketch.h>
 
 uint64_t MurmurHash3(uint64_t key);
+uint64_t hash_bytes(const void* data, size_t length, uint64_t seed);
 uint64_t encode_string(const char* input_str);
+uint64_t hash_record(const char* record, size_t length);
+void hash_records(const RecordSpan* records, size_t num_records, uint64_t* hash_vals);
+void build_feature_vector(const char* record, size_t length, std::string& feature_vec);
+uint64_t hash_field(const char* field, size_t length);
+uint64_t hash_record_columns(const char* record, size_t length, const std::vector<int>& column_slots, 
+                             size_t num_columns, uint64_t* column_hashes);
+
+extern const std::array<uint8_t, 256> dna_encoding; // 2-bit code of each base, anything besides ACGT is 0
+
+template <typename Callback>
+inline void for_each_kmer(const char* seq, size_t seq_length, size_t kmer_length, Callback process_kmer) {
+  /* 
+   * Encodes every k-mer in the sequence, it rolls the 2-bit encoding forward one base
+   * at a time so each k-mer gives the same value as encode_string() would.
+   */
+  if (seq_length < kmer_length) {return;}
+  uint64_t kmer_mask = (kmer_length < 32) ? (((uint64_t) 1 << (2 * kmer_length)) - 1) : ~((uint64_t) 0);
+  uint64_t encoded_kmer = 0;
+
+  for (size_t i = 0; i < seq_length; i++) {
+    encoded_kmer = ((encoded_kmer << 2) | dna_encoding[(uint8_t) seq[i]]) & kmer_mask;
+    if (i + 1 >= kmer_length) {process_kmer(encoded_kmer);}
+  }
+}
+
+template <typename Callback>
+inline void for_each_kmer_hash(const char* seq, size_t seq_length, size_t kmer_length, Callback process_hash) {
+  /* Hashes every k-mer in the sequence, these are the values inserted into the sketches */
+  for_each_kmer(seq, seq_length, kmer_length, [&](uint64_t encoded_kmer) {process_hash(MurmurHash3(encoded_kmer));});
+}
 
 #endif /* end of _HASH_FUN_H */
\ No newline at end of file
@@ -12,43 +12,60 @@
 
 #include <math.h>
 #include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <atomic>
 #include <stdint.h>
 #include <pacsketch.h>
 
 #define BITS_PER_BYTE 8
 #define HASH_SIZE 64
-#define REGISTER_BITS int(std::ceil(std::log2(HASH_SIZE)))
-
-#define TOTAL_REGISTER_SPACE(x) int(std::ceil((x * REGISTER_BITS)/BITS_PER_BYTE))
-
-#define GRAB_REGISTER_MASK(x) uint64_t (std::pow(2, x) - 1) << (HASH_SIZE-x)
-#define GRAB_REGISTER_NUM(x, y, z) (x & y) >> (HASH_SIZE - z)
-
-#define GRAB_REMAINING_BITS(x, y, z) (x & y) << (z)
-#define DETERMINE_LZC(x)  ({ \ 
-                             uint64_t probe = ((uint64_t) 0x1) << (HASH_SIZE - 1); \
-                             uint8_t lzc = 1; \
-                             for (size_t i = 0; i < HASH_SIZE; i++) { \
-                                if (probe & x) {break;} \
-                                probe >>= 1; lzc += 1;\
-                             } \
-                            lzc; \
-                            }) 
-
-#define GENERATE_LSB_BYTE(x, y) (x >> (REGISTER_BITS - y)) 
-#define GENERATE_MSB_BYTE(x, y) (x << (BITS_PER_BYTE - y)) 
-
-#define PUSH_TO_LEFT(x, y) (x << y)
-#define PUSH_TO_RIGHT(x, y) (x >> y)
-
-#define GRAB_LSB_REGISTER(x, y) (uint8_t)(x & (uint16_t) (std::pow(2, y) - 1))
-#define GRAB_MSB_REGISTER(x, y) x >> (BITS_PER_BYTE - y)
-#define COMBINE_LSB_MSB(x, y, z) (uint8_t) ((((uint16_t)x) << z) | y)
-
-#define CLEAR_LSB_REGISTER(x, y) ((x >> y) << y)
-#define CLEAR_MSB_REGISTER(x, y)  x & ~((uint16_t)(std::pow(2, y)-1) << (BITS_PER_BYTE-y))
-#define CLEAR_WITHIN_REGISTER(x, y) x & ~((uint8_t)(std::pow(2, REGISTER_BITS) - 1) << y)
-
+#define REGISTER_BITS 6 // ceil(log2(HASH_SIZE)), enough to hold any leading-zero count
+#define REGISTER_VALUE_MASK 0x3F
+
+// Registers are packed back-to-back, so every 4 registers occupy exactly 3 bytes
+#define REGISTERS_PER_GROUP 4
+#define BYTES_PER_GROUP 3
+#define TOTAL_REGISTER_SPACE(x) ((((x) + REGISTERS_PER_GROUP - 1)/REGISTERS_PER_GROUP) * BYTES_PER_GROUP)
+
+#define GRAB_REGISTER_MASK(x) ((((uint64_t) 1 << (x)) - 1) << (HASH_SIZE-(x)))
+#define GRAB_REGISTER_NUM(x, y, z) (((x) & (y)) >> (HASH_SIZE - (z)))
+
+#define GRAB_REMAINING_BITS(x, y, z) (((x) & (y)) << (z))
+#define DETERMINE_LZC(x, y) ((x) ? (uint8_t) (__builtin_clzll(x) + 1) : (uint8_t) (HASH_SIZE - (y) + 1))
+
+// Range of b values that get their own compile-time specialized kernels
+#define MIN_SPECIALIZED_PREFIX 4
+#define MAX_SPECIALIZED_PREFIX 18
+
+#define HLL_HASH_BATCH_SIZE 1024 // number of hashes buffered before updating registers
+#define HLL_PREFETCH_MIN_PREFIX 18 // smallest b whose registers (192 KB) are worth prefetching in batch inserts
+#define HLL_PREFETCH_DISTANCE 8 // hashes ahead whose register group is prefetched
+#define HLL_REGISTER_ALIGNMENT 64 // register arrays start on (and are padded to) a cache line
+
+struct HLLKernels {
+    /*
+     * Set of functions that operate on the register array for one value of b, they
+     * are picked once when the sketch is created so the hot loops never look at b.
+     * The b argument is only read by the generic kernels used outside of the
+     * specialized range.
+     */
+    void (*insert_hash)(uint8_t* registers, uint8_t b, uint64_t hash_val);
+    void (*insert_hashes)(uint8_t* registers, uint8_t b, const uint64_t* hash_vals, size_t num_hashes);
+    void (*merge)(uint8_t* dest, const uint8_t* op1, const uint8_t* op2, uint8_t b);
+    uint64_t (*cardinality)(const uint8_t* registers, uint8_t b);
+};
+
+const HLLKernels* select_hll_kernels(uint8_t b);
+
+struct SketchFileHeader;
+
+struct AlignedRegisterDeleter {
+    /* Frees register arrays that were allocated with posix_memalign */
+    void operator()(uint8_t* ptr) const {std::free(ptr);}
+};
+typedef std::unique_ptr<uint8_t[], AlignedRegisterDeleter> RegisterArray;
 
 class HyperLogLog {
 
@@ -56,25 +73,78 @@ private:
     std::string ref_file; // path to input data
     uint8_t prefix_bits = 0; // number of bits to use for bucket determination
     uint64_t num_registers = 0; // number of registers in HLL
-    uint64_t total_bytes_allocated = 0; // actual bytes allocated for registers
-    char* registers; // pointers to dynamically allocated memory of registers
+    uint64_t total_bytes_allocated = 0; // actual bytes allocated for registers (padded to the alignment)
+    RegisterArray registers; // aligned, zero-initialized register array owned by the sketch
     data_type input_type; // input data used to create sketch
+    uint32_t hash_id = 0; // function used to hash the input (see sketch_file.h)
+    const HLLKernels* kernels; // register kernels specialized for prefix_bits
 
 public:
-    HyperLogLog(std::string input_path, uint8_t b, data_type file_type);
-    HyperLogLog(uint8_t b, data_type file_type);
-    ~HyperLogLog();
-    uint64_t compute_cardinality();
-    HyperLogLog operator +(HyperLogLog& operand);
+    HyperLogLog(std::string input_path, uint8_t b, data_type file_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+    HyperLogLog(uint8_t b, data_type file_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+
+    // Copies have to be asked for with clone(), moves only hand over the registers
+    HyperLogLog(const HyperLogLog&) = delete;
+    HyperLogLog& operator=(const HyperLogLog&) = delete;
+    HyperLogLog(HyperLogLog&&) = default;
+    HyperLogLog& operator=(HyperLogLog&&) = default;
+
+    HyperLogLog clone() const;
+    void reset();
+    void add_hash(uint64_t hash_val);
+    void add_hashes(const uint64_t* hash_vals, size_t num_hashes);
+    void add_record(const char* record, size_t length);
+    void add_sequence(const char* seq, size_t length);
+    uint64_t compute_cardinality() const;
+    uint64_t get_memory_usage() const;
+    HyperLogLog operator +(const HyperLogLog& operand) const;
+    HyperLogLog& operator +=(const HyperLogLog& operand);
+    void assign_union(const HyperLogLog& op1, const HyperLogLog& op2);
+    bool is_compatible(const HyperLogLog& operand) const;
+    void write_to_file(const std::string& file_path, uint64_t input_offset = 0, uint64_t input_fingerprint = 0) const;
+    static HyperLogLog read_from_file(const std::string& file_path);
+    void serialize(std::vector<char>* buffer) const;
+    static std::unique_ptr<HyperLogLog> deserialize(const void* buffer, size_t buffer_size);
+    static double compute_jaccard(uint64_t card_a, uint64_t card_b, uint64_t card_union);
 
 private:
     void buildFromFASTA(std::string input_path, uint8_t m);
     void buildFromPackets(std::string input_path, uint8_t m);
+    void buildFromPcap(std::string input_path, pcap_key_type pcap_key);
+    void allocate_registers();
     void initialize_registers();
-    uint8_t grab_register(uint64_t register_num);
-    void clear_register(uint64_t register_num);
-    void set_register(uint64_t register_num, uint8_t new_val);
+    SketchFileHeader get_file_header() const;
+
+    friend class ConcurrentHyperLogLog;
 
 }; // end of HLL class
 
-#endif /* end of _HLL_H */
\ No newline at end of file
+class ConcurrentHyperLogLog {
+    /*
+     * HyperLogLog that many threads can insert into at the same time, so they can share one
+     * sketch instead of building one each and merging them. Every register is its own byte
+     * (instead of 6 packed bits), so it can be raised with an atomic compare-and-swap. An insert
+     * first reads the register, and skips the atomic when the register is already as large,
+     * which is what almost every insert sees once the sketch has warmed up.
+     */
+private:
+    uint8_t prefix_bits = 0; // number of bits to use for bucket determination
+    uint64_t num_registers = 0; // number of registers in HLL
+    data_type input_type; // input data used to create sketch
+    uint32_t hash_id = 0; // function used to hash the input (see sketch_file.h)
+    std::unique_ptr<std::atomic<uint8_t>[]> registers; // one register per byte
+
+public:
+    ConcurrentHyperLogLog(uint8_t b, data_type file_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+    ConcurrentHyperLogLog(const ConcurrentHyperLogLog&) = delete;
+    ConcurrentHyperLogLog& operator=(const ConcurrentHyperLogLog&) = delete;
+
+    void add_hash(uint64_t hash_val);
+    void add_hashes(const uint64_t* hash_vals, size_t num_hashes);
+    HyperLogLog snapshot() const;
+
+}; // end of ConcurrentHyperLogLog class
+
+std::vector<HyperLogLog> build_column_sketches(const std::vector<RecordSpan>& records, const std::vector<size_t>& columns, uint8_t b);
+
+#endif /* end of _HLL_H */
@@ -0,0 +1,92 @@
+/*
+ * Name: hll_pyramid.h
+ * Description: Header file for hll_pyramid.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _HLL_PYRAMID_H
+#define _HLL_PYRAMID_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+#include <pacsketch.h>
+#include <hll.h>
+
+#define PYRAMID_MANIFEST_NAME "pyramid.txt" // describes the pyramid, next to its window sketches
+#define PYRAMID_MANIFEST_MAGIC "pacsketch_pyramid"
+#define PYRAMID_MANIFEST_VERSION 1
+
+enum pyramid_window_unit {RECORD_WINDOWS, TIME_WINDOWS}; // the finest windows hold a number of records, or a duration of a capture
+
+struct PyramidLayout {
+    /*
+     * Describes a pyramid directory. Level 0 holds the finest windows, and a window of level i
+     * is the union of level_factors[i] consecutive windows of level i-1, so the default factors
+     * of 10,6,10 over 1 second windows give 1s, 10s, 1m and 10m windows.
+     */
+    uint8_t prefix_bits = 0; // b of every window sketch
+    data_type input_type = PACKET;
+    pyramid_window_unit window_unit = RECORD_WINDOWS;
+    uint64_t window_size = 0; // records (or nanoseconds) in each finest window
+    uint64_t first_window_start = 0; // 0 for record windows, the start time (ns) of the first window for time windows
+    std::vector<uint64_t> level_factors; // level_factors[0] is always 1
+    std::vector<uint64_t> num_windows; // windows completed at each level
+
+    uint64_t get_level_span(size_t level) const;
+};
+
+struct PyramidWindow {
+    /* One stored window sketch of a pyramid */
+    size_t level;
+    uint64_t window_num; // index among the windows of its level
+};
+
+class HLLPyramid {
+    /*
+     * Builds HyperLogLog windows at many resolutions from a single pass over a stream. Only the
+     * finest windows are filled with hashes, each coarser window is the register-max merge of the
+     * windows below it, done as soon as the last of them completes. Completed windows are written
+     * to the pyramid directory (and dropped), so memory holds one open window per level. A range of
+     * finest windows is answered by merging the few stored windows that exactly cover it.
+     */
+public:
+    typedef std::function<void(size_t level, uint64_t window_num, const HyperLogLog& window_sketch)> WindowCallback;
+
+private:
+    std::string pyramid_dir; // directory holding the manifest and the window sketches
+    PyramidLayout layout;
+    std::vector<HyperLogLog> open_windows; // window in progress at each level
+    std::vector<uint64_t> num_merged; // windows of the level below already merged into each open window
+    std::vector<uint64_t> pending_hashes; // hashes of the finest window, inserted in batches
+    WindowCallback on_window_closed; // called with each completed window, before it is dropped
+
+public:
+    HLLPyramid(const std::string& dir_path, const PyramidLayout& pyramid_layout, pcap_key_type pcap_key, WindowCallback callback);
+    HLLPyramid(const HLLPyramid&) = delete;
+    HLLPyramid& operator=(const HLLPyramid&) = delete;
+
+    void add_hash(uint64_t hash_val);
+    void close_window();
+    const PyramidLayout& get_layout() const {return layout;}
+
+    static std::vector<PyramidWindow> cover_range(const PyramidLayout& pyramid_layout, uint64_t range_start, uint64_t range_end);
+    static HyperLogLog query_range(const std::string& dir_path, const PyramidLayout& pyramid_layout,
+                                   uint64_t range_start, uint64_t range_end, size_t* num_sketches);
+
+private:
+    void flush_hashes();
+    void close_level(size_t level);
+    void write_layout() const;
+
+}; // end of HLLPyramid class
+
+/* Function Declarations */
+std::string get_pyramid_window_path(const std::string& dir_path, size_t level, uint64_t window_num);
+PyramidLayout read_pyramid_layout(const std::string& dir_path);
+
+#endif /* end of _HLL_PYRAMID_H */
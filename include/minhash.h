@@ -10,37 +10,111 @@
 #ifndef _MINHASH_H
 #define _MINHASH_H
 
-#include <queue>
 #include <vector>
+#include <memory>
 #include <limits>
+#include <atomic>
+#include <mutex>
 #include <stdint.h>
 #include <pacsketch.h>
+#include <arena.h>
 
 #define MAX_HASH std::numeric_limits<uint64_t>::max()
 
+struct SketchFileHeader;
+
 class MinHash {
 
 private:
     std::string ref_file; // path to input data
     data_type file_type; // tells us how to parse input
-    std::priority_queue<uint64_t, std::vector<uint64_t>> max_heap_k; // holds lowest k values, in max heap
+    std::vector<uint64_t> max_heap_k; // holds lowest k values, in max heap (std::push_heap/pop_heap)
     std::vector<uint64_t> elements_in_queue; // Keeps track of values in max-heap in order to ensure there are no duplicates
     size_t k; // number of items kept
+    uint32_t hash_id = 0; // function used to hash the input (see sketch_file.h)
 
 public:
-    MinHash(std::string file_path, size_t k_val, data_type file_type); // Main constructor
+    MinHash(std::string file_path, size_t k_val, data_type file_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY); // Main constructor
     MinHash(size_t k_val, data_type file_type); // Used when creating union sketch
     MinHash(std::vector<std::string> records, size_t k_val, data_type file_type); // Used when simulating from dataset
-    uint64_t get_cardinality();
-    MinHash operator +(MinHash& operand);
-    static double compute_jaccard(MinHash op1, MinHash op2);
+    void reset();
+    void add_hash(uint64_t hash_val);
+    void add_record(const char* record, size_t length);
+    void add_sequence(const char* seq, size_t length);
+    uint64_t get_cardinality() const;
+    uint64_t get_memory_usage() const;
+    MinHash operator +(const MinHash& operand) const;
+    MinHash& operator +=(const MinHash& operand);
+    bool is_compatible(const MinHash& operand) const;
+    void write_to_file(const std::string& file_path, uint64_t input_offset = 0, uint64_t input_fingerprint = 0) const;
+    static MinHash read_from_file(const std::string& file_path);
+    void serialize(std::vector<char>* buffer) const;
+    static std::unique_ptr<MinHash> deserialize(const void* buffer, size_t buffer_size);
+    static double compute_jaccard(const MinHash& op1, const MinHash& op2);
+    static double compute_jaccard(const MinHash& op1, const MinHash& op2, ScratchArena& scratch);
 
 private:
+    void assign_hashes(std::vector<uint64_t>& sorted_hashes);
+    SketchFileHeader get_file_header(std::vector<uint64_t>* sorted_hashes) const;
     void buildFromFASTA(std::string file_path, size_t k_val);
     void buildFromPackets(std::string file_path, size_t k_val);
+    void buildFromPcap(std::string file_path, pcap_key_type pcap_key);
+
+    friend class ConcurrentMinHash;
 
 }; // end of MinHash class
 
+class ConcurrentMinHash {
+    /*
+     * MinHash that many threads can insert into at the same time. Each thread keeps its own
+     * bottom-k in a LocalBuffer, and publishes its k-th smallest hash to a shared threshold,
+     * which holds the smallest one published by any thread. No hash above that threshold can be
+     * in the bottom-k of the union, so it is dropped before any heap or duplicate work. The
+     * buffers are merged into the shared sketch when they are flushed.
+     */
+private:
+    size_t k; // number of items kept
+    data_type file_type; // input data used to create sketch
+    uint32_t hash_id = 0; // function used to hash the input (see sketch_file.h)
+    std::atomic<uint64_t> shared_threshold; // smallest k-th smallest hash of any buffer
+    std::mutex merge_lock; // guards merged_hashes and the counters below
+    std::vector<uint64_t> merged_hashes; // sorted k smallest distinct hashes of the flushed buffers
+    uint64_t num_inserted = 0; // hashes passed to every buffer
+    uint64_t num_accepted = 0; // hashes that entered a buffer's bottom-k
+    uint64_t num_threshold_rejected = 0; // hashes dropped by the shared threshold
+
+public:
+    class LocalBuffer {
+        /* Bottom-k of a single thread, it is merged into the shared sketch by flush() or when it is destroyed */
+    private:
+        ConcurrentMinHash& shared_sketch;
+        std::vector<uint64_t> max_heap_k; // holds lowest k values of this thread, in max heap
+        uint64_t num_inserted = 0;
+        uint64_t num_accepted = 0;
+        uint64_t num_threshold_rejected = 0;
+
+    public:
+        explicit LocalBuffer(ConcurrentMinHash& sketch);
+        LocalBuffer(const LocalBuffer&) = delete;
+        LocalBuffer& operator=(const LocalBuffer&) = delete;
+        ~LocalBuffer();
+
+        void add_hash(uint64_t hash_val);
+        void add_hashes(const uint64_t* hash_vals, size_t num_hashes);
+        void flush();
+    };
+
+    ConcurrentMinHash(size_t k_val, data_type input_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+    ConcurrentMinHash(const ConcurrentMinHash&) = delete;
+    ConcurrentMinHash& operator=(const ConcurrentMinHash&) = delete;
+
+    MinHash snapshot();
+    uint64_t get_num_inserted();
+    uint64_t get_num_accepted();
+    uint64_t get_num_threshold_rejected();
+
+}; // end of ConcurrentMinHash class
+
 std::vector<std::string> split(std::string input, char delim);
 
 #endif /* end of _MINHASH_H */
\ No newline at end of file
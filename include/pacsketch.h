@@ -13,6 +13,8 @@
 #include <unistd.h>
 #include <fstream>
 #include <vector>
+#include <thread>
+#include <stdint.h>
 
 /* Useful Macros */
 #define NOT_IMPL(x) do { std::fprintf(stderr, "%s() is not implemented: %s\n", __func__, x); std::exit(1);} while (0)
@@ -22,12 +24,50 @@
                     std::fprintf(stderr, "\n");} while(0)
 
 #define SAMPLING_RATE 0.0039 // Represents 1 in 256, based on a literature value
+#define APPEND_FINGERPRINT_SIZE 65536 // bytes at each end of the input that identify it for build -a
+#define FASTA_KMER_LENGTH 11 // length of k-mers inserted into sketches from FASTA input
+
+// Range of precisions considered when a sketch is sized from a memory budget (-m) or a target error (-e)
+#define MIN_AUTO_PREFIX 4
+#define MAX_AUTO_PREFIX 24
+#define MIN_AUTO_K 16
+#define MAX_AUTO_K 65536 // inserts into a MinHash check the k kept hashes for a repeat, so k stays moderate
+
+#define DEFAULT_PYRAMID_FACTORS "10,6,10" // levels of the pyramid sub-command, 1 second windows become 10s, 1m and 10m windows
+#define MAX_PYRAMID_LEVELS 16
+#define MAX_PYRAMID_GAP_WINDOWS 100000 // empty finest windows a single time jump may close, about a day of 1 second windows
+
+enum sketch_type {MINHASH, HLL, NOT_CHOSEN, FRAC_MINHASH}; // stored in sketch files, so new types go at the end
+enum data_type {PACKET, FASTA, PCAP};
+enum pcap_key_type {FIVE_TUPLE_KEY, SRC_DST_KEY, SRC_KEY, DST_KEY, DST_SERVICE_KEY}; // header fields hashed for each packet
+
+struct RecordSpan {
+    /* Points at one record (line) inside of a memory-mapped input file */
+    const char* start;
+    size_t length;
+};
+
+enum sizing_goal {CARDINALITY_ERROR, JACCARD_ERROR}; // estimate whose error a memory budget or target error refers to
 
-enum sketch_type {MINHASH, HLL, NOT_CHOSEN};
-enum data_type {PACKET, FASTA};
+struct SketchSizing {
+    /* Sketch chosen from a memory budget or a target error, instead of -M/-H with -k/-b */
+    bool is_automatic = false; // set when -m or -e was used
+    sketch_type sketch = NOT_CHOSEN;
+    uint64_t parameter = 0; // k for MinHash, b for HyperLogLog
+    double expected_error = 0.0; // relative standard error of the cardinality, or standard error of the jaccard
+    uint64_t expected_bytes = 0; // memory used by one sketch
+};
 
 /* Function Declarations */
 bool is_file(const char* file_path);
+bool parse_memory_size(const std::string& value, uint64_t* num_bytes);
+bool choose_sketch_size(sizing_goal goal, sketch_type allowed_sketch, uint64_t memory_budget, double target_error, SketchSizing* sizing);
+void choose_automatic_size(sizing_goal goal, const std::string& memory_budget_name, double target_error, bool use_frac_minhash,
+                           bool* use_minhash, bool* use_hll, size_t* k_size, uint8_t* bit_prefix, uint64_t* memory_budget, SketchSizing* sizing);
+bool parse_pcap_key(const std::string& key_name, pcap_key_type* pcap_key);
+bool parse_udp_endpoint(const std::string& endpoint, std::string* address, uint16_t* port);
+bool parse_pyramid_factors(const std::string& factor_list, std::vector<uint64_t>* level_factors);
+bool parse_window_range(const std::string& range, uint64_t* range_start, uint64_t* range_end);
 
 struct PacsketchBuildOptions {
     /* struct to build the command-line arguments */
@@ -37,9 +77,21 @@ struct PacsketchBuildOptions {
     sketch_type curr_sketch = NOT_CHOSEN; // sketch type we are building
     bool use_minhash = false; // Records whether user uses -M 
     bool use_hll = false; // Records whether user uses -H
+    bool use_frac_minhash = false; // Records whether user uses -F
     bool print_cardinality = false; // output cardinality after building
     bool input_fasta = false; // input data is a FASTA file (for development)
+    bool input_pcap = false; // input data is a pcap/pcapng capture
     data_type input_data_type = PACKET; // input data are packets by default
+    std::string pcap_key_name = "5tuple"; // header fields that identify a packet in a capture
+    pcap_key_type pcap_key = FIVE_TUPLE_KEY;
+    std::string column_list = ""; // features to build per-column sketches for (names or indexes)
+    std::string output_file = ""; // path to write the sketch to (for merge)
+    bool append_input = false; // only add the input appended since the sketch in output_file was written
+    size_t num_threads = 1; // threads inserting connection records into one sketch
+    std::string memory_budget_name = ""; // bytes per sketch (e.g. 16K), the sketch type and k/b are chosen from it
+    uint64_t memory_budget = 0;
+    double target_error = 0.0; // relative standard error of the cardinality, the smallest sketch that meets it is chosen
+    SketchSizing sizing;
 
     // MinHash specific values
     size_t k_size = 0; // number of hashes to keep
@@ -47,20 +99,43 @@ struct PacsketchBuildOptions {
     // HLL specific values
     uint8_t bit_prefix = 0;
 
+    // FracMinHash specific values
+    uint64_t scale = 0; // 1 in scale of the hash space is kept
+
 public:
     void validate() {    
         /* Validates and finalizes the command-line options */
         if (!is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
-
-        if (use_minhash && use_hll) {FATAL_WARNING("Both -M and -H cannot be specified at same time, please re-run with a single one of those options.\n");}
-        if (!use_minhash && !use_hll) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash or HLL.\n");}
+        if (column_list != "" && (!use_hll || input_fasta || input_pcap)) {FATAL_WARNING("Per-column sketches (-C) can only be built as HLLs (-H) of connection records.");}
+        if (column_list != "" && output_file != "") {FATAL_WARNING("Per-column sketches (-C) cannot be written to a sketch file (-o).");}
+        if (num_threads == 0) {FATAL_WARNING("The number of threads (-t) needs to be at least 1.");}
+        if (num_threads > 1 && (input_fasta || input_pcap || column_list != "" || use_frac_minhash)) {
+            FATAL_WARNING("Multi-threaded builds (-t) are only supported for MinHash and HLL sketches of connection records.");
+        }
+        if (append_input && output_file == "") {FATAL_WARNING("Appending to a sketch (-a) needs the sketch file to update (-o).");}
+        if (append_input && (input_fasta || input_pcap || column_list != "" || num_threads > 1)) {
+            FATAL_WARNING("Appending to a sketch (-a) is only supported for single-threaded builds from connection records.");
+        }
+        if (memory_budget_name != "" || target_error != 0.0) {
+            choose_automatic_size(CARDINALITY_ERROR, memory_budget_name, target_error, use_frac_minhash, &use_minhash, &use_hll, &k_size, &bit_prefix, &memory_budget, &sizing);
+        }
+
+        if (use_minhash + use_hll + use_frac_minhash > 1) {FATAL_WARNING("Only one of -M, -H and -F can be specified at a time, please re-run with a single one of those options.\n");}
+        if (!use_minhash && !use_hll && !use_frac_minhash) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash, FracMinHash or HLL.\n");}
     
         if (use_minhash) {curr_sketch=MINHASH;}
         if (use_hll) {curr_sketch=HLL;}
+        if (use_frac_minhash) {curr_sketch=FRAC_MINHASH;}
 
         if (curr_sketch == MINHASH && k_size == 0) {FATAL_WARNING("Please specify a value of k since you requested to build a MinHash sketch.\n");}
         if (curr_sketch == HLL && bit_prefix == 0) {FATAL_WARNING("Please specify a value for b since you requested to build a HLL.\n");}
+        if (curr_sketch == FRAC_MINHASH && (scale == 0 || scale > UINT32_MAX)) {
+            FATAL_WARNING("Please specify a scale (-s) between 1 and 4294967295 since you requested to build a FracMinHash sketch.\n");
+        }
+        if (input_fasta && input_pcap) {FATAL_WARNING("Both -f and -p cannot be specified at same time, please re-run with a single one of those options.\n");}
+        if (!parse_pcap_key(pcap_key_name, &pcap_key)) {FATAL_WARNING("The packet key (-K) needs to be one of: 5tuple, srcdst, src, dst, dstport.\n");}
         if (input_fasta) {input_data_type=FASTA;}
+        if (input_pcap) {input_data_type=PCAP;}
     }
 };
 
@@ -72,8 +147,16 @@ struct PacsketchDistOptions {
     sketch_type curr_sketch = NOT_CHOSEN; // sketch type we are building
     bool use_minhash = false; // Records whether user uses -M 
     bool use_hll = false; // Records whether user uses -H
+    bool use_frac_minhash = false; // Records whether user uses -F
     bool input_fasta = false; // input data is a FASTA file (for development)
+    bool input_pcap = false; // input data are pcap/pcapng captures
     data_type input_data_type = PACKET; // input data are packets by default
+    std::string pcap_key_name = "5tuple"; // header fields that identify a packet in a capture
+    pcap_key_type pcap_key = FIVE_TUPLE_KEY;
+    std::string memory_budget_name = ""; // bytes per sketch (e.g. 16K), the sketch type and k/b are chosen from it
+    uint64_t memory_budget = 0;
+    double target_error = 0.0; // standard error of the jaccard, the smallest sketch that meets it is chosen
+    SketchSizing sizing;
 
     // MinHash specific values
     size_t k_size = 0; // number of hashes to keep
@@ -81,6 +164,9 @@ struct PacsketchDistOptions {
     // HLL specific values
     uint8_t bit_prefix = 0;
 
+    // FracMinHash specific values
+    uint64_t scale = 0; // 1 in scale of the hash space is kept
+
 public:
     void validate() {    
         /* Validates and finalizes the command-line options */
@@ -88,16 +174,26 @@ public:
         
         if (!is_file(input_files[0].data())) {THROW_EXCEPTION(("The following path is not valid: " + input_files[0]).data());}
         if (!is_file(input_files[1].data())) {THROW_EXCEPTION(("The following path is not valid: " + input_files[1]).data());}
+        if (memory_budget_name != "" || target_error != 0.0) {
+            choose_automatic_size(JACCARD_ERROR, memory_budget_name, target_error, use_frac_minhash, &use_minhash, &use_hll, &k_size, &bit_prefix, &memory_budget, &sizing);
+        }
 
-        if (use_minhash && use_hll) {FATAL_WARNING("Both -M and -H cannot be specified at same time, please re-run with a single one of those options.\n");}
-        if (!use_minhash && !use_hll) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash or HLL.\n");}
+        if (use_minhash + use_hll + use_frac_minhash > 1) {FATAL_WARNING("Only one of -M, -H and -F can be specified at a time, please re-run with a single one of those options.\n");}
+        if (!use_minhash && !use_hll && !use_frac_minhash) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash, FracMinHash or HLL.\n");}
     
         if (use_minhash) {curr_sketch=MINHASH;}
         if (use_hll) {curr_sketch=HLL;}
+        if (use_frac_minhash) {curr_sketch=FRAC_MINHASH;}
 
         if (curr_sketch == MINHASH && k_size == 0) {FATAL_WARNING("Please specify a value of k since you requested to build a MinHash sketch.\n");}
         if (curr_sketch == HLL && bit_prefix == 0) {FATAL_WARNING("Please specify a value for b since you requested to build a HLL.\n");}
+        if (curr_sketch == FRAC_MINHASH && (scale == 0 || scale > UINT32_MAX)) {
+            FATAL_WARNING("Please specify a scale (-s) between 1 and 4294967295 since you requested to build a FracMinHash sketch.\n");
+        }
+        if (input_fasta && input_pcap) {FATAL_WARNING("Both -f and -p cannot be specified at same time, please re-run with a single one of those options.\n");}
+        if (!parse_pcap_key(pcap_key_name, &pcap_key)) {FATAL_WARNING("The packet key (-K) needs to be one of: 5tuple, srcdst, src, dst, dstport.\n");}
         if (input_fasta) {input_data_type=FASTA;}
+        if (input_pcap) {input_data_type=PCAP;}
     }
 };
 
@@ -109,6 +205,7 @@ struct PacsketchSimulateOptions {
     sketch_type curr_sketch = NOT_CHOSEN; // sketch type we are building
     bool use_minhash = false; // Records whether user uses -M 
     bool use_hll = false; // Records whether user uses -H
+    bool use_frac_minhash = false; // Records whether user uses -F
     bool input_fasta = false; // input data is a FASTA file (for development)
     data_type input_data_type = PACKET; // input data are packets by default
     size_t num_windows = 0; // number of windows to simulate
@@ -123,6 +220,9 @@ struct PacsketchSimulateOptions {
     // HLL specific values
     uint8_t bit_prefix = 0;
 
+    // FracMinHash specific values
+    uint64_t scale = 0; // 1 in scale of the hash space is kept
+
 public:
     void validate() {    
         /* Validates and finalizes the command-line options */
@@ -131,18 +231,22 @@ public:
         if (!is_file(input_files[0].data())) {THROW_EXCEPTION(("The following path is not valid: " + input_files[0]).data());}
         if (!is_file(input_files[1].data())) {THROW_EXCEPTION(("The following path is not valid: " + input_files[1]).data());}
 
-        if (use_minhash && use_hll) {FATAL_WARNING("Both -M and -H cannot be specified at same time, please re-run with a single one of those options.");}
-        if (!use_minhash && !use_hll) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash or HLL.");}
+        if (use_minhash + use_hll + use_frac_minhash > 1) {FATAL_WARNING("Only one of -M, -H and -F can be specified at a time, please re-run with a single one of those options.");}
+        if (!use_minhash && !use_hll && !use_frac_minhash) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash, FracMinHash or HLL.");}
     
         if (use_minhash) {curr_sketch=MINHASH;}
         if (use_hll) {curr_sketch=HLL;}
+        if (use_frac_minhash) {curr_sketch=FRAC_MINHASH;}
 
         if (curr_sketch == MINHASH && k_size == 0) {FATAL_WARNING("Please specify a value of k since you requested to build a MinHash sketch.");}
         if (curr_sketch == HLL && bit_prefix == 0) {FATAL_WARNING("Please specify a value for b since you requested to build a HLL.");}
+        if (curr_sketch == FRAC_MINHASH && (scale == 0 || scale > UINT32_MAX)) {
+            FATAL_WARNING("Please specify a scale (-s) between 1 and 4294967295 since you requested to build a FracMinHash sketch.");
+        }
         if (input_fasta) {FATAL_WARNING("The simulation sub-command can only be run with network data.");}
 
-        if (num_records > 50000 || num_records == 0) {FATAL_WARNING("The number of records per window (n) needs to be 0 < x < 50,000");}
-        if (num_windows > 10000 || num_windows == 0) {FATAL_WARNING("The number of windows (w) needs to be 0 < w < 10,000");}
+        if (num_records == 0) {FATAL_WARNING("The number of records per window (n) needs to be a positive number.");}
+        if (num_windows == 0) {FATAL_WARNING("The number of windows (w) needs to be a positive number.");}
 
         if ((attack_percent < 0.0 || attack_percent > 1.0) && !test_mode) {FATAL_WARNING("Make sure to set the attack ratio (-a). The attack percentage (a) needs to be a number between 0.0 <= a <= 1.0.");}
         if (use_minhash && k_size > num_records) {FATAL_WARNING("The window size is too small, it must be larger than value of k for MinHash sketches.");}
@@ -150,30 +254,255 @@ public:
         if (test_mode && test_files.size() != 2) {FATAL_WARNING("To use test_mode, you have to provide exactly two file paths: normal, then attack.");}
         if (test_mode && !is_file(test_files[0].data())) {FATAL_WARNING("The first provided test file is not a valid path.");}
         if (test_mode && !is_file(test_files[1].data())) {FATAL_WARNING("The second provided test file is not a valid path.");}
+    }
+};
+
+struct PacsketchDiscretizeOptions {
+    /* struct for discretize sub-command command-line arguments */
+
+    // General values
+    std::string input_file = ""; // training dataset, used for the feature statistics
+    std::string test_file = ""; // test dataset binned with the training statistics
+    std::string output_prefix = ""; // prefix for the converted datasets
+    size_t num_threads = std::thread::hardware_concurrency(); // number of threads to use
+    sketch_type curr_sketch = NOT_CHOSEN; // sketch type to build from binned records
+    bool use_minhash = false; // Records whether user uses -M 
+    bool use_hll = false; // Records whether user uses -H
+
+    // MinHash specific values
+    size_t k_size = 0; // number of hashes to keep
+
+    // HLL specific values
+    uint8_t bit_prefix = 0;
+
+public:
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (!is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
+        if (test_file != "" && !is_file(test_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + test_file).data());}
+        if (num_threads == 0) {num_threads = 1;}
 
-        if (test_mode && num_records > 9700) {FATAL_WARNING("For test mode, you must make sure window size is less than 9,700 records.");}
+        if (use_minhash && use_hll) {FATAL_WARNING("Both -M and -H cannot be specified at same time, please re-run with a single one of those options.");}
+        if (use_minhash) {curr_sketch=MINHASH;}
+        if (use_hll) {curr_sketch=HLL;}
+
+        if (output_prefix == "" && curr_sketch == NOT_CHOSEN) {FATAL_WARNING("Please specify an output prefix (-o), and/or a sketch to build (-M or -H).");}
+        if (curr_sketch == MINHASH && k_size == 0) {FATAL_WARNING("Please specify a value of k since you requested to build a MinHash sketch.");}
+        if (curr_sketch == HLL && bit_prefix == 0) {FATAL_WARNING("Please specify a value for b since you requested to build a HLL.");}
     }
 };
 
+struct PacsketchClassifyOptions {
+    /* struct for classify sub-command command-line arguments */
+
+    // General values
+    std::string input_file = "-"; // records to classify, "-" reads them from stdin
+    std::string udp_endpoint = ""; // [address:]port to receive the records on over UDP, instead of input_file
+    std::string udp_address = "";
+    uint16_t udp_port = 0;
+    std::string normal_file = ""; // reference records for normal traffic
+    std::vector<std::string> attack_files; // reference records for each attack class
+    std::vector<std::string> class_names; // name of each attack class
+    sketch_type curr_sketch = NOT_CHOSEN; // sketch type we are building
+    bool use_minhash = false; // Records whether user uses -M 
+    bool use_hll = false; // Records whether user uses -H
+    size_t num_records = 0; // number of records in each window
+
+    // MinHash specific values
+    size_t k_size = 0; // number of hashes to keep
+
+    // HLL specific values
+    uint8_t bit_prefix = 0;
+
+public:
+    void add_attack_class(const std::string& class_arg) {
+        /* Adds an attack class given as name:path, or just the path (then its file name is the class name) */
+        size_t split_pos = class_arg.find(':');
+        std::string file_path = (split_pos == std::string::npos) ? class_arg : class_arg.substr(split_pos + 1);
+        std::string class_name = (split_pos == std::string::npos) ? "" : class_arg.substr(0, split_pos);
+
+        if (class_name == "") {
+            class_name = file_path.substr(file_path.find_last_of('/') + 1);
+            class_name = class_name.substr(0, class_name.find('.'));
+        }
+        attack_files.push_back(file_path);
+        class_names.push_back(class_name);
+    }
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (input_file != "-" && !is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
+        if (udp_endpoint != "" && input_file != "-") {FATAL_WARNING("Both -i and -u cannot be specified at same time, please re-run with a single one of those options.");}
+        if (udp_endpoint != "" && !parse_udp_endpoint(udp_endpoint, &udp_address, &udp_port)) {
+            FATAL_WARNING("The UDP endpoint (-u) needs to be [address:]port, with an IPv4 address and a port between 1 and 65535.");
+        }
+        if (!is_file(normal_file.data())) {FATAL_WARNING("Please provide a valid file of normal reference records (-N).");}
+        if (attack_files.empty()) {FATAL_WARNING("Please provide at least one file of attack reference records (-A).");}
+        for (const std::string& file_path: attack_files) {
+            if (!is_file(file_path.data())) {THROW_EXCEPTION(("The following path is not valid: " + file_path).data());}
+        }
+
+        if (use_minhash && use_hll) {FATAL_WARNING("Both -M and -H cannot be specified at same time, please re-run with a single one of those options.");}
+        if (!use_minhash && !use_hll) {FATAL_WARNING("Please specify the type of sketch to build, either MinHash or HLL.");}
+    
+        if (use_minhash) {curr_sketch=MINHASH;}
+        if (use_hll) {curr_sketch=HLL;}
+
+        if (curr_sketch == MINHASH && k_size == 0) {FATAL_WARNING("Please specify a value of k since you requested to build a MinHash sketch.");}
+        if (curr_sketch == HLL && bit_prefix == 0) {FATAL_WARNING("Please specify a value for b since you requested to build a HLL.");}
+        if (num_records == 0) {FATAL_WARNING("The number of records per window (n) needs to be a positive number.");}
+    }
+};
+
+struct PacsketchTopNOptions {
+    /* struct for topn sub-command command-line arguments */
+
+    // General values
+    std::string input_file = ""; // input dataset
+    size_t num_records = 0; // number of records in each window (0 means the whole file is one window)
+    size_t top_n = 10; // number of heavy-hitters to report per window
+
+    // Count-Min specific values
+    size_t width = 2048; // number of counters in each row
+
+public:
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (!is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
+        if (top_n == 0) {FATAL_WARNING("The number of heavy-hitters to report (-N) needs to be a positive number.");}
+        if (width < 16 || width > ((size_t) 1 << 24) || (width & (width - 1))) {
+            FATAL_WARNING("The width of the Count-Min sketch (-W) needs to be a power of 2 between 16 and 16777216.");
+        }
+    }
+};
+
+struct PacsketchConvertOptions {
+    /* struct for convert sub-command command-line arguments */
+
+    // General values
+    std::string input_file = ""; // connection records to convert
+    std::string output_file = ""; // path of the columnar file to write
+
+public:
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (!is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
+        if (output_file == "") {FATAL_WARNING("Please specify the path of the columnar file to write (-o).");}
+        if (output_file == input_file) {FATAL_WARNING("The output file (-o) cannot be the same as the input file.");}
+    }
+};
+
+struct PacsketchMergeOptions {
+    /* struct for merge sub-command command-line arguments */
+
+    // General values
+    std::vector<std::string> input_paths; // sketch files, or directories of sketch files
+    std::string output_file = ""; // path of the union sketch to write
+    size_t num_threads = std::thread::hardware_concurrency(); // number of threads to use
+    bool print_cardinality = false; // output cardinality of the union sketch
+
+public:
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (input_paths.empty()) {FATAL_WARNING("Please specify the sketch files, or directories of sketch files, to merge.");}
+        if (output_file == "" && !print_cardinality) {FATAL_WARNING("Please specify the path of the union sketch to write (-o), and/or print its cardinality (-c).");}
+        if (num_threads == 0) {num_threads = 1;}
+    }
+};
+
+struct PacsketchPyramidOptions {
+    /* struct for pyramid sub-command command-line arguments */
+
+    // General values
+    std::string input_file = ""; // records (or a capture) to build the pyramid from, "-" reads records from stdin
+    std::string pyramid_dir = ""; // directory of the window sketches, written by a build and read by queries
+    bool input_pcap = false; // input data is a pcap/pcapng capture
+    data_type input_data_type = PACKET;
+    std::string pcap_key_name = "5tuple"; // header fields that identify a packet in a capture
+    pcap_key_type pcap_key = FIVE_TUPLE_KEY;
+    size_t num_records = 0; // records (or packets) in each finest window
+    double window_seconds = 0.0; // duration of each finest window of a capture
+    uint64_t window_ns = 0;
+    std::string factor_list = DEFAULT_PYRAMID_FACTORS; // windows of each level in a window of the next one
+    std::vector<uint64_t> level_factors;
+    std::vector<std::string> query_ranges; // START:END ranges of finest windows to estimate
+    std::vector<std::pair<uint64_t, uint64_t>> parsed_ranges;
+
+    // HLL specific values
+    uint8_t bit_prefix = 0;
+
+public:
+    void validate() {    
+        /* Validates and finalizes the command-line options */
+        if (pyramid_dir == "") {FATAL_WARNING("Please specify the directory of the pyramid (-o).");}
+        if (input_file == "" && query_ranges.empty()) {FATAL_WARNING("Please specify an input to build the pyramid from (-i), and/or ranges to estimate (-q).");}
+        for (const std::string& range: query_ranges) {
+            uint64_t range_start = 0, range_end = 0;
+            if (!parse_window_range(range, &range_start, &range_end)) {FATAL_WARNING(("The range (-q) needs to be START:END, with START < END: " + range).data());}
+            parsed_ranges.emplace_back(range_start, range_end);
+        }
+        if (input_file == "") {return;}
+
+        if (input_file != "-" && !is_file(input_file.data())) {THROW_EXCEPTION(("The following path is not valid: " + input_file).data());}
+        if (input_pcap && input_file == "-") {FATAL_WARNING("Captures (-p) cannot be read from stdin, please give the path of the capture.");}
+        if (bit_prefix == 0) {FATAL_WARNING("Please specify a value for b, the window sketches are HLLs.");}
+        if ((num_records != 0) + (window_seconds > 0.0) != 1) {FATAL_WARNING("Please specify the size of the finest windows, either in records (-n) or in seconds (-s).");}
+        if (window_seconds > 0.0 && !input_pcap) {FATAL_WARNING("Windows in seconds (-s) need the timestamps of a capture (-p), records are windowed with -n.");}
+        if (window_seconds > 0.0) {
+            window_ns = (uint64_t) (window_seconds * 1e9 + 0.5);
+            if (window_ns == 0) {FATAL_WARNING("The duration of the finest windows (-s) needs to be at least 1 nanosecond.");}
+        }
+        if (!parse_pyramid_factors(factor_list, &level_factors)) {
+            FATAL_WARNING("The levels (-l) need to be a comma-separated list of factors of at least 2, with at most 15 levels.");
+        }
+        if (!parse_pcap_key(pcap_key_name, &pcap_key)) {FATAL_WARNING("The packet key (-K) needs to be one of: 5tuple, srcdst, src, dst, dstport.\n");}
+        if (input_pcap) {input_data_type=PCAP;}
+    }
+};
 
 /* Function Declarations */
 int pacsketch_build_usage();
 int pacsketch_dist_usage();
 int pacsketch_simulate_usage();
+int pacsketch_discretize_usage();
+int pacsketch_topn_usage();
+int pacsketch_classify_usage();
+int pacsketch_convert_usage();
+int pacsketch_merge_usage();
+int pacsketch_pyramid_usage();
 void parse_build_options(int argc, char** argv, PacsketchBuildOptions* opts);
 void parse_dist_options(int argc, char** argv, PacsketchDistOptions* opts);
 void parse_simulate_options(int argc, char** argv, PacsketchSimulateOptions* opts);
+void parse_discretize_options(int argc, char** argv, PacsketchDiscretizeOptions* opts);
+void parse_topn_options(int argc, char** argv, PacsketchTopNOptions* opts);
+void parse_classify_options(int argc, char** argv, PacsketchClassifyOptions* opts);
+void parse_convert_options(int argc, char** argv, PacsketchConvertOptions* opts);
+void parse_merge_options(int argc, char** argv, PacsketchMergeOptions* opts);
+void parse_pyramid_options(int argc, char** argv, PacsketchPyramidOptions* opts);
 int build_main(int argc, char** argv); 
+int build_column_main(const PacsketchBuildOptions& build_opts);
+int build_concurrent_main(const PacsketchBuildOptions& build_opts);
 int dist_main(int argc, char** argv); 
 int simulate_main(int argc, char** argv); 
-char* cgets(char* buf, int max, char** data);
-std::vector<std::string> sample_records_at_indexes(std::vector<std::string> dataset_vecs, std::vector<size_t> index_list);
-std::vector<std::string> sample_mixed_records_at_indexes(std::vector<std::string> dataset_1_vecs, size_t num_dataset_1,
-                                                         std::vector<std::string> dataset_2_vecs, size_t num_dataset_2,
-                                                         std::vector<size_t> index_list);
+int discretize_main(int argc, char** argv);
+int topn_main(int argc, char** argv);
+int classify_main(int argc, char** argv);
+int convert_main(int argc, char** argv);
+int merge_main(int argc, char** argv);
+int pyramid_main(int argc, char** argv);
+int run_sub_command(int argc, char** argv);
+void print_dist_results(sketch_type curr_sketch, uint64_t card_a, uint64_t card_b, uint64_t card_union, double jaccard, double containment = -1.0);
+char* map_input_file(const char* file_path, size_t* file_size);
+void unmap_input_file(char* data, size_t file_size);
+std::vector<RecordSpan> index_records(const char* data, size_t data_size);
+std::vector<uint64_t> load_record_hashes(const char* file_path, std::vector<uint8_t>* normal_labels);
 inline std::tuple<size_t, size_t> determine_window_breakdown(size_t total_num, double attack_ratio); 
-int simulate_test_main(std::vector<std::string> normal_records, std::vector<std::string> attack_records, PacsketchSimulateOptions sim_opts);
-std::tuple<double, double> analyze_record_labels_in_window(std::vector<std::string> window_records);
-double estimate_attack_ratio_with_sampling(std::vector<std::string> window_records);
+template <typename Sketch>
+int simulate_windows_main(const std::vector<uint64_t>& input_1_hashes, const std::vector<uint64_t>& input_2_hashes,
+                          const PacsketchSimulateOptions& sim_opts, const Sketch& empty_sketch);
+template <typename Sketch>
+int simulate_test_main(const Sketch& normal_sketch, const Sketch& attack_sketch, const PacsketchSimulateOptions& sim_opts,
+                       const Sketch& empty_sketch);
+bool is_normal_record(const RecordSpan& record);
+std::tuple<double, double> compute_label_ratios(size_t num_normal, size_t num_records);
 
 #endif /* end of _PACSKETCH_H header */
\ No newline at end of file
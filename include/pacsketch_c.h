@@ -0,0 +1,96 @@
+/*
+ * Name: pacsketch_c.h
+ * Description: C interface of libpacsketch, so the MinHash and HyperLogLog sketches can be
+ *              embedded in programs that are not written in C++ (e.g. packet capture agents).
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _PACSKETCH_C_H
+#define _PACSKETCH_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The sketches are opaque handles that are created and freed through this interface. Every
+ * function (besides the free, hash and version functions) returns one of the status codes
+ * below, and the results are passed back through pointer arguments. No C++ exception or
+ * internal error crosses this interface, and nothing is printed.
+ *
+ * The inserts read the caller's buffers in place, and nothing of them is kept after the call
+ * returns, so a record can be inserted straight out of a receive buffer or a memory mapping.
+ * A sketch is not thread-safe, but different sketches can be used from different threads.
+ *
+ * The serialized bytes are the sketch file format of build -o, so a sketch built through this
+ * interface can be merged, compared or used by classify on the command-line, and the other way
+ * around. The sketches are created for connection records, records inserted with
+ * insert_record() give the same hashes as the command-line does.
+ */
+
+#define PACSKETCH_API_VERSION 1 // bumped when a function or status code changes, new functions do not bump it
+
+#if defined(__GNUC__)
+#define PACSKETCH_EXPORT __attribute__((visibility("default")))
+#else
+#define PACSKETCH_EXPORT
+#endif
+
+#define PACSKETCH_OK 0
+#define PACSKETCH_ERROR_INVALID_ARGUMENT -1 // a NULL handle/pointer, or a parameter out of range
+#define PACSKETCH_ERROR_INCOMPATIBLE -2 // the sketches differ in k/b, or in the hashes that were inserted
+#define PACSKETCH_ERROR_CORRUPT -3 // the bytes are not a serialized sketch of the requested type
+#define PACSKETCH_ERROR_NO_MEMORY -4
+#define PACSKETCH_ERROR_BUFFER_TOO_SMALL -5 // the needed size is still written to the size argument
+#define PACSKETCH_ERROR_INTERNAL -6
+
+#define PACSKETCH_HLL_MIN_PREFIX 1 // range of b accepted by pacsketch_hll_create()
+#define PACSKETCH_HLL_MAX_PREFIX 28
+
+typedef struct pacsketch_minhash pacsketch_minhash_t;
+typedef struct pacsketch_hll pacsketch_hll_t;
+
+PACSKETCH_EXPORT int pacsketch_api_version(void);
+PACSKETCH_EXPORT const char* pacsketch_status_string(int status);
+PACSKETCH_EXPORT uint64_t pacsketch_hash_bytes(const void* data, size_t length);
+PACSKETCH_EXPORT uint64_t pacsketch_hash_record(const char* record, size_t length);
+
+/* MinHash (bottom-k) sketch */
+PACSKETCH_EXPORT int pacsketch_minhash_create(size_t k, pacsketch_minhash_t** sketch);
+PACSKETCH_EXPORT void pacsketch_minhash_free(pacsketch_minhash_t* sketch);
+PACSKETCH_EXPORT int pacsketch_minhash_reset(pacsketch_minhash_t* sketch);
+PACSKETCH_EXPORT int pacsketch_minhash_insert_bytes(pacsketch_minhash_t* sketch, const void* data, size_t length);
+PACSKETCH_EXPORT int pacsketch_minhash_insert_record(pacsketch_minhash_t* sketch, const char* record, size_t length);
+PACSKETCH_EXPORT int pacsketch_minhash_insert_hash(pacsketch_minhash_t* sketch, uint64_t hash_val);
+PACSKETCH_EXPORT int pacsketch_minhash_insert_hashes(pacsketch_minhash_t* sketch, const uint64_t* hash_vals, size_t num_hashes);
+PACSKETCH_EXPORT int pacsketch_minhash_merge(pacsketch_minhash_t* dest, const pacsketch_minhash_t* src);
+PACSKETCH_EXPORT int pacsketch_minhash_cardinality(const pacsketch_minhash_t* sketch, uint64_t* cardinality);
+PACSKETCH_EXPORT int pacsketch_minhash_jaccard(const pacsketch_minhash_t* sketch_1, const pacsketch_minhash_t* sketch_2, double* jaccard);
+PACSKETCH_EXPORT int pacsketch_minhash_serialize(const pacsketch_minhash_t* sketch, void* buffer, size_t capacity, size_t* size);
+PACSKETCH_EXPORT int pacsketch_minhash_deserialize(const void* buffer, size_t size, pacsketch_minhash_t** sketch);
+
+/* HyperLogLog sketch */
+PACSKETCH_EXPORT int pacsketch_hll_create(unsigned int b, pacsketch_hll_t** sketch);
+PACSKETCH_EXPORT void pacsketch_hll_free(pacsketch_hll_t* sketch);
+PACSKETCH_EXPORT int pacsketch_hll_reset(pacsketch_hll_t* sketch);
+PACSKETCH_EXPORT int pacsketch_hll_insert_bytes(pacsketch_hll_t* sketch, const void* data, size_t length);
+PACSKETCH_EXPORT int pacsketch_hll_insert_record(pacsketch_hll_t* sketch, const char* record, size_t length);
+PACSKETCH_EXPORT int pacsketch_hll_insert_hash(pacsketch_hll_t* sketch, uint64_t hash_val);
+PACSKETCH_EXPORT int pacsketch_hll_insert_hashes(pacsketch_hll_t* sketch, const uint64_t* hash_vals, size_t num_hashes);
+PACSKETCH_EXPORT int pacsketch_hll_merge(pacsketch_hll_t* dest, const pacsketch_hll_t* src);
+PACSKETCH_EXPORT int pacsketch_hll_cardinality(const pacsketch_hll_t* sketch, uint64_t* cardinality);
+PACSKETCH_EXPORT int pacsketch_hll_jaccard(const pacsketch_hll_t* sketch_1, const pacsketch_hll_t* sketch_2, double* jaccard);
+PACSKETCH_EXPORT int pacsketch_hll_serialize(const pacsketch_hll_t* sketch, void* buffer, size_t capacity, size_t* size);
+PACSKETCH_EXPORT int pacsketch_hll_deserialize(const void* buffer, size_t size, pacsketch_hll_t** sketch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of _PACSKETCH_C_H */
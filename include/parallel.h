@@ -0,0 +1,36 @@
+/*
+ * Name: parallel.h
+ * Description: Contains the helper that splits a range of items into one contiguous
+ *              chunk per worker thread, shared by the multi-threaded parts of pacsketch
+ *              (discretize, merge, build -t) and by the benchmark and experiment programs.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+template <typename Task>
+void for_each_chunk(size_t num_items, size_t num_threads, Task process_chunk) {
+    /*
+     * Splits [0, num_items) into contiguous chunks, runs process_chunk(thread_num, start, end) on each
+     * in its own thread, and returns once they have all finished. There are at most num_items chunks
+     * (at least 1), and their sizes differ by at most one item.
+     */
+    num_threads = std::max((size_t) 1, std::min(num_threads, num_items));
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_threads; i++) {
+        workers.emplace_back(process_chunk, i, i * num_items / num_threads, (i + 1) * num_items / num_threads);
+    }
+    for (std::thread& worker: workers) {worker.join();}
+}
+
+#endif /* end of _PARALLEL_H */
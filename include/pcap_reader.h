@@ -0,0 +1,104 @@
+/*
+ * Name: pcap_reader.h
+ * Description: Header file for pcap_reader.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _PCAP_READER_H
+#define _PCAP_READER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pacsketch.h>
+
+// Magic numbers at the start of a capture file (as read on a little-endian host)
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+// pcapng block types that hold packets, or describe interfaces
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_PB 0x00000002
+#define PCAPNG_BLOCK_SPB 0x00000003
+#define PCAPNG_BLOCK_EPB 0x00000006
+
+#define PCAPNG_OPTION_TSRESOL 9 // interface option giving the resolution of its timestamps
+#define PCAPNG_DEFAULT_TSRESOL 6 // microseconds, when an interface has no resolution option
+
+// Link-layer types that can be decoded
+#define LINKTYPE_NULL 0
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_LINUX_SLL 113
+#define LINKTYPE_IPV4 228
+#define LINKTYPE_IPV6 229
+#define LINKTYPE_LINUX_SLL2 276
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86DD
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_QINQ 0x88A8
+
+#define MAX_IPV6_EXT_HEADERS 8 // extension headers skipped before giving up on the ports
+
+struct PacketHeaders {
+    /* Fields of the IP and transport headers of one packet, IPv4 addresses only use the first word */
+    uint64_t src_addr[2] = {0, 0};
+    uint64_t dst_addr[2] = {0, 0};
+    uint16_t src_port = 0; // 0 for protocols without ports, and non-first fragments
+    uint16_t dst_port = 0;
+    uint8_t protocol = 0;
+    uint8_t ip_version = 0;
+    uint64_t timestamp_ns = 0; // capture time of the frame, in nanoseconds since the epoch
+};
+
+class PcapReader {
+    /*
+     * Reads the packets of a classic pcap or a pcapng file without copying them, the whole
+     * file is memory-mapped and each frame is decoded where it sits. Frames that are not
+     * IPv4/IPv6 (or are cut short) are skipped and counted.
+     */
+private:
+    const uint8_t* file_data = NULL; // start of the memory-mapped file
+    size_t file_size = 0;
+    size_t curr_offset = 0; // offset of the next record/block
+    bool is_pcapng = false;
+    bool swap_bytes = false; // the file (or current pcapng section) has the other endianness
+    uint32_t link_type = 0; // link type of a classic pcap file
+    bool nanosecond_timestamps = false; // the classic pcap file stores nanoseconds instead of microseconds
+    std::vector<uint32_t> interface_link_types; // link type of each interface in the current pcapng section
+    std::vector<uint32_t> interface_snap_lengths; // snap length of each interface in the current pcapng section
+    std::vector<uint8_t> interface_ts_resolutions; // timestamp resolution (if_tsresol) of each interface in the current pcapng section
+    uint64_t frame_timestamp = 0; // capture time of the last frame returned, in nanoseconds (simple packet blocks keep the previous one)
+    uint64_t num_packets = 0; // packets that were decoded
+    uint64_t num_skipped = 0; // frames that could not be decoded
+
+public:
+    PcapReader(const std::string& file_path);
+    ~PcapReader();
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+    bool next_packet(PacketHeaders* headers);
+    uint64_t get_num_packets() const {return num_packets;}
+    uint64_t get_num_skipped() const {return num_skipped;}
+
+private:
+    bool next_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type);
+    bool next_pcap_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type);
+    bool next_pcapng_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type);
+    uint32_t read_u32(size_t offset) const;
+    uint16_t read_u16(size_t offset) const;
+    uint8_t read_ts_resolution(size_t options_offset, size_t options_end) const;
+
+}; // end of PcapReader class
+
+/* Function Declarations */
+bool decode_packet(const uint8_t* frame, uint32_t frame_length, uint32_t frame_link_type, PacketHeaders* headers);
+uint64_t hash_packet_key(const PacketHeaders& headers, pcap_key_type pcap_key);
+
+#endif /* end of _PCAP_READER_H */
@@ -0,0 +1,45 @@
+/*
+ * Name: record_reader.h
+ * Description: Header file for record_reader.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _RECORD_READER_H
+#define _RECORD_READER_H
+
+#include <string>
+#include <vector>
+#include <pacsketch.h>
+
+#define RECORD_READER_BUFFER_SIZE (1 << 20) // bytes read from the input at a time (grows for longer lines)
+
+class RecordReader {
+    /*
+     * Reads connection records (lines) from a file or from stdin ("-"), one block at a time,
+     * so the input can be a stream that never ends. Each record points into the reader's
+     * buffer, and is only valid until the next call to next_record().
+     */
+private:
+    int input_fd = -1; // file descriptor being read
+    bool owns_fd = false; // whether the file descriptor is closed by the reader
+    std::vector<char> buffer; // holds the data that has been read, but not returned yet
+    size_t data_start = 0; // start of the data that has not been returned
+    size_t data_end = 0; // end of the data that has been read
+    bool at_eof = false; // no more data can be read
+
+public:
+    RecordReader(const std::string& file_path);
+    ~RecordReader();
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+    bool next_record(RecordSpan* record);
+
+private:
+    bool fill_buffer();
+
+}; // end of RecordReader class
+
+#endif /* end of _RECORD_READER_H */
@@ -0,0 +1,40 @@
+/*
+ * Name: sketch_cache.h
+ * Description: Header file for sketch_cache.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _SKETCH_CACHE_H
+#define _SKETCH_CACHE_H
+
+#include <string>
+#include <stdint.h>
+#include <pacsketch.h>
+
+#define SKETCH_CACHE_ENV "PACSKETCH_CACHE_DIR" // used when --cache is not given
+#define SKETCH_CACHE_NUM_SAMPLES 16 // blocks of an input that go into its fingerprint
+#define SKETCH_CACHE_SAMPLE_SIZE 65536 // bytes in each block, smaller inputs are fingerprinted whole
+
+class HyperLogLog;
+class MinHash;
+class FracMinHash;
+
+/*
+ * The sketch cache keeps the sketch of each input file in a directory, so the reference
+ * sketches of repeated runs are loaded instead of parsing the input again. An entry is
+ * named after a hash of the input's path, size, mtime and a fingerprint of its content,
+ * along with the type, parameter (k/b/scale) and hash id of the sketch, so a changed
+ * input or other options simply miss. Entries use the format of build -o.
+ */
+
+/* Function Declarations */
+void extract_cache_option(int* argc, char** argv);
+bool is_sketch_cache_enabled();
+MinHash get_cached_minhash(const std::string& file_path, size_t k_size, data_type input_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+HyperLogLog get_cached_hll(const std::string& file_path, uint8_t bit_prefix, data_type input_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+FracMinHash get_cached_frac_minhash(const std::string& file_path, uint64_t scale, data_type input_type, pcap_key_type pcap_key = FIVE_TUPLE_KEY);
+
+#endif /* end of _SKETCH_CACHE_H */
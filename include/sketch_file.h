@@ -0,0 +1,71 @@
+/*
+ * Name: sketch_file.h
+ * Description: Header file for sketch_file.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _SKETCH_FILE_H
+#define _SKETCH_FILE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include <pacsketch.h>
+
+#define SKETCH_FILE_MAGIC "PKSKETCH" // first 8 bytes of a serialized sketch
+#define SKETCH_FILE_VERSION 2
+#define SKETCH_FILE_V1_HEADER_SIZE 40 // version 1 headers end after payload_size, they are still read
+#define SKETCH_FILE_BYTE_ORDER 0x01020304 // written in host order, so a file from a host of the other endianness is rejected
+
+// Identifies the function that turned the input into 64-bit hashes, sketches can only be merged if they match
+#define RECORD_HASH_ID 1 // hash_record() of connection records
+#define KMER_HASH_ID 2 // MurmurHash3 of the 2-bit encoded k-mers of FASTA input
+#define PACKET_KEY_HASH_ID 16 // hash_packet_key(), plus the pcap_key_type of the capture
+
+class HyperLogLog;
+class MinHash;
+class FracMinHash;
+
+struct SketchFileHeader {
+    /*
+     * Fixed-size header at the start of a sketch file, followed by the payload: the packed
+     * register array of a HyperLogLog, the k hashes of a MinHash in ascending order, or the
+     * kept hashes of a FracMinHash in ascending order. A sketch built with build -a also records
+     * how far into its input it got, so the next run only reads what was appended since.
+     */
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t sketch; // sketch_type
+    uint32_t input_type; // data_type the sketch was built from
+    uint32_t hash_id; // see compute_hash_id()
+    uint32_t parameter; // k for MinHash, b for HyperLogLog, the scale for FracMinHash
+    uint64_t payload_size; // bytes after the header
+    uint64_t input_offset; // bytes of the input in the sketch, 0 if it was not built with build -a
+    uint64_t input_fingerprint; // hash of the first and last blocks of those bytes (see build -a)
+};
+
+/* Function Declarations */
+uint32_t compute_hash_id(data_type input_type, pcap_key_type pcap_key);
+size_t get_sketch_header_size(uint32_t version);
+bool is_sketch_file(const char* file_path);
+SketchFileHeader read_sketch_header(const std::string& file_path);
+int open_sketch_file(const std::string& file_path, sketch_type expected_sketch, SketchFileHeader* header);
+void read_sketch_payload(int input_fd, const std::string& file_path, void* payload, size_t payload_size);
+void write_sketch_file(const std::string& file_path, const SketchFileHeader& header, const void* payload);
+void write_sketch_buffer(const SketchFileHeader& header, const void* payload, std::vector<char>* buffer);
+const char* parse_sketch_buffer(const void* buffer, size_t buffer_size, sketch_type expected_sketch, SketchFileHeader* header);
+bool map_sketch_file(const std::string& file_path, const char** file_data, size_t* file_size);
+void unmap_sketch_file(const char* file_data, size_t file_size);
+template <typename Sketch>
+std::unique_ptr<Sketch> load_sketch_file(const std::string& file_path, sketch_type expected_sketch, std::string* error_message);
+std::vector<std::string> list_sketch_files(const std::vector<std::string>& input_paths);
+HyperLogLog merge_hll_files(const std::vector<std::string>& file_paths, size_t num_threads);
+MinHash merge_minhash_files(const std::vector<std::string>& file_paths, size_t num_threads);
+FracMinHash merge_frac_minhash_files(const std::vector<std::string>& file_paths, size_t num_threads);
+
+#endif /* end of _SKETCH_FILE_H */
@@ -0,0 +1,80 @@
+/*
+ * Name: spsc_ring.h
+ * Description: Contains a lock-free ring buffer that passes items from one
+ *              producer thread to one consumer thread, such as datagrams from
+ *              the UDP receive thread to the thread that updates the sketches.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _SPSC_RING_H
+#define _SPSC_RING_H
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+#define SPSC_CACHE_LINE 64 // padding between the two indexes, so they never share a cache line
+
+template <typename T>
+class SPSCRing {
+    /*
+     * Single-producer/single-consumer ring of preallocated slots. The producer fills the slot
+     * from begin_write() in place, and publishes it with end_write(). The consumer reads the
+     * slot from begin_read(), and hands it back with end_read(). Each side only writes its own
+     * index, and keeps a cached copy of the other one so it rarely touches the shared line.
+     */
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // The padding keeps each side on its own cache line (alignas would need C++17 for heap objects)
+    char producer_padding[SPSC_CACHE_LINE];
+    std::atomic<size_t> head; // next slot to be written, only stored by the producer
+    size_t cached_tail = 0; // producer's last view of tail
+
+    char consumer_padding[SPSC_CACHE_LINE];
+    std::atomic<size_t> tail; // next slot to be read, only stored by the consumer
+    size_t cached_head = 0; // consumer's last view of head
+    char end_padding[SPSC_CACHE_LINE];
+
+public:
+    SPSCRing(size_t capacity): slots(capacity), mask(capacity - 1), head(0), tail(0) {
+        /* Constructor for the ring, the capacity needs to be a power of 2 */
+    }
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    T* begin_write() {
+        /* Returns the next free slot for the producer, or NULL if the ring is full */
+        size_t curr_head = head.load(std::memory_order_relaxed);
+        if (curr_head - cached_tail == slots.size()) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (curr_head - cached_tail == slots.size()) {return NULL;}
+        }
+        return &slots[curr_head & mask];
+    }
+    void end_write() {
+        /* Publishes the slot from begin_write() to the consumer */
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    T* begin_read() {
+        /* Returns the oldest published slot for the consumer, or NULL if the ring is empty */
+        size_t curr_tail = tail.load(std::memory_order_relaxed);
+        if (curr_tail == cached_head) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (curr_tail == cached_head) {return NULL;}
+        }
+        return &slots[curr_tail & mask];
+    }
+    void end_read() {
+        /* Hands the slot from begin_read() back to the producer */
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    size_t capacity() const {return slots.size();}
+
+}; // end of SPSCRing class
+
+#endif /* end of _SPSC_RING_H */
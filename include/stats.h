@@ -0,0 +1,106 @@
+/*
+ * Name: stats.h
+ * Description: Header file for stats.cpp, contains the macros used to 
+ *              instrument the hot paths of pacsketch.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <stdio.h>
+
+/* 
+ * Instrumentation macros: the counters are only touched when --stats is given, and the check is
+ * marked as unlikely so the disabled path is a single predicted branch. Building with 
+ * PACSKETCH_DISABLE_STATS removes the instrumentation completely.
+ */
+#ifdef PACSKETCH_DISABLE_STATS
+#define STATS_ENABLED() (false)
+#else
+#define STATS_ENABLED() (__builtin_expect(pacsketch_stats.enabled, 0))
+#endif
+
+#define STATS_ADD(counter, x) do {if (STATS_ENABLED()) {pacsketch_stats.counter += (x);}} while (0)
+
+#define STATS_CONCAT_INNER(x, y) x##y
+#define STATS_CONCAT(x, y) STATS_CONCAT_INNER(x, y)
+#define STATS_TIME_STAGE(name) StageTimer STATS_CONCAT(stage_timer_, __LINE__) (name) // times until end of scope
+#define STATS_TIME_WINDOW() WindowTimer STATS_CONCAT(window_timer_, __LINE__) // latency of one simulated window
+
+typedef std::chrono::steady_clock stats_clock;
+
+struct PacsketchStats {
+    /* 
+     * Counters for a single run of pacsketch, they are not atomic so they should only be
+     * updated from the main thread (the worker threads in discretize are not counted).
+     */
+    bool enabled = false; // set by the --stats option
+    std::string output_path = ""; // where the JSON report goes ("-" for stderr)
+    std::string command = ""; // sub-command that was run
+    stats_clock::time_point start_time;
+
+    uint64_t bytes_read = 0; // bytes read or memory-mapped from input files
+    uint64_t records_parsed = 0; // connection records hashed
+    uint64_t kmers_parsed = 0; // k-mers hashed from FASTA input
+    uint64_t register_updates_accepted = 0; // HLL inserts that raised a register
+    uint64_t register_updates_rejected = 0; // HLL inserts that left a register unchanged
+    uint64_t heap_updates_accepted = 0; // MinHash inserts that entered the bottom-k
+    uint64_t heap_updates_rejected = 0; // MinHash inserts that were too large or duplicates
+    uint64_t heap_threshold_rejections = 0; // rejected MinHash inserts dropped by the shared threshold (build -M -t)
+    uint64_t sketch_cache_hits = 0; // input sketches loaded from the sketch cache (--cache)
+    uint64_t sketch_cache_misses = 0; // input sketches built and added to the sketch cache
+    uint64_t udp_datagrams_received = 0; // datagrams read by the UDP listener (classify -u)
+    uint64_t udp_datagrams_dropped = 0; // datagrams lost to a full ring, truncation or the socket buffer
+
+    std::vector<std::pair<std::string, double>> stage_seconds; // wall time of each stage, in order
+    std::vector<double> window_micros; // latency of each simulated window
+
+public:
+    void add_stage_time(const char* stage_name, double seconds);
+    void write_json() const;
+};
+
+extern PacsketchStats pacsketch_stats;
+
+class StageTimer {
+    /* Adds the wall time between construction and stop() (or destruction) to a named stage */
+private:
+    const char* stage_name;
+    stats_clock::time_point start;
+    bool running = true;
+
+public:
+    StageTimer(const char* name): stage_name(name) {if (STATS_ENABLED()) {start = stats_clock::now();}}
+    ~StageTimer() {stop();}
+    void stop() {
+        if (STATS_ENABLED() && running) {pacsketch_stats.add_stage_time(stage_name, std::chrono::duration<double>(stats_clock::now() - start).count());}
+        running = false;
+    }
+};
+
+class WindowTimer {
+    /* Records the latency of one simulated window */
+private:
+    stats_clock::time_point start;
+
+public:
+    WindowTimer() {if (STATS_ENABLED()) {start = stats_clock::now();}}
+    ~WindowTimer() {
+        if (STATS_ENABLED()) {pacsketch_stats.window_micros.push_back(std::chrono::duration<double, std::micro>(stats_clock::now() - start).count());}
+    }
+};
+
+/* Function Declarations */
+void extract_stats_option(int* argc, char** argv);
+double compute_percentile(std::vector<double> values, double percentile);
+
+#endif /* end of _STATS_H */
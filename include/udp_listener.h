@@ -0,0 +1,74 @@
+/*
+ * Name: udp_listener.h
+ * Description: Header file for udp_listener.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _UDP_LISTENER_H
+#define _UDP_LISTENER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+#include <pacsketch.h>
+#include <spsc_ring.h>
+
+#define UDP_MAX_DATAGRAM 9216 // largest datagram kept (jumbo frame), larger ones are truncated and dropped
+#define UDP_RING_SLOTS 1024 // datagrams buffered between the receive thread and the sketches
+#define UDP_SOCKET_BUFFER (8 << 20) // receive buffer requested from the kernel (capped by net.core.rmem_max)
+#define UDP_RECEIVE_TIMEOUT_MS 100 // how often the receive thread checks whether it should stop
+#define UDP_IDLE_SLEEP_US 50 // how long the consumer sleeps when the ring is empty
+
+struct Datagram {
+    /* One slot of the ring, holding the records of a datagram (separated by newlines) */
+    uint32_t length = 0;
+    char data[UDP_MAX_DATAGRAM];
+};
+
+class UDPListener {
+    /*
+     * Receives connection records on a UDP socket. A receive thread writes each datagram straight
+     * into a slot of a single-producer/single-consumer ring, and the thread that calls next_record()
+     * reads the records out of the slot. When the ring is full the datagram is still read from the
+     * socket (so the kernel buffer keeps draining), and it is counted as dropped.
+     */
+private:
+    int socket_fd = -1;
+    SPSCRing<Datagram> ring;
+    std::thread receive_thread;
+    std::atomic<bool> stop_requested;
+    std::atomic<bool> receiver_done;
+
+    // Counters, written by the receive thread
+    std::atomic<uint64_t> datagrams_received;
+    std::atomic<uint64_t> datagrams_dropped; // the ring was full
+    std::atomic<uint64_t> datagrams_truncated; // larger than UDP_MAX_DATAGRAM
+    std::atomic<uint64_t> kernel_drops; // dropped by the socket before being read (Linux only)
+
+    // Consumer position, only used by the thread that calls next_record()
+    Datagram* curr_datagram = NULL;
+    size_t curr_offset = 0;
+
+public:
+    UDPListener(const std::string& address, uint16_t port);
+    ~UDPListener();
+    UDPListener(const UDPListener&) = delete;
+    UDPListener& operator=(const UDPListener&) = delete;
+
+    bool next_record(RecordSpan* record);
+    void stop() {stop_requested.store(true, std::memory_order_relaxed);}
+    uint64_t get_datagrams_received() const {return datagrams_received.load(std::memory_order_relaxed);}
+    uint64_t get_datagrams_dropped() const {return datagrams_dropped.load(std::memory_order_relaxed);}
+    uint64_t get_datagrams_truncated() const {return datagrams_truncated.load(std::memory_order_relaxed);}
+    uint64_t get_kernel_drops() const {return kernel_drops.load(std::memory_order_relaxed);}
+
+private:
+    void receive_loop();
+
+}; // end of UDPListener class
+
+#endif /* end of _UDP_LISTENER_H */
@@ -0,0 +1,340 @@
+/*
+ * Name: columnar.cpp
+ * Description: Contains the writer and the memory-mapped reader of the binary columnar
+ *              record format (made by the convert sub-command). Each feature column is
+ *              either dictionary-encoded or a fixed-width integer, and the label and the
+ *              hash_record() value of every record are stored in their own columns.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <columnar.h>
+#include <hash.h>
+#include <stats.h>
+
+static inline uint64_t missing_value(uint32_t width) {
+    /* Largest value that can be stored with a width, it marks a missing field */
+    return (width == 8) ? std::numeric_limits<uint64_t>::max() : ((uint64_t) 1 << (8 * width)) - 1;
+}
+
+static uint32_t choose_width(uint64_t max_value) {
+    /* Smallest width that stores values up to max_value, while keeping the missing marker free */
+    for (uint32_t width: {1, 2, 4}) {
+        if (max_value < missing_value(width)) {return width;}
+    }
+    return 8;
+}
+
+static bool parse_integer(const char* field, size_t length, int64_t* value) {
+    /* Parses a field written as a plain decimal integer, fields that would not print back the same way are rejected */
+    bool is_negative = (length > 0 && field[0] == '-');
+    size_t num_digits = length - is_negative;
+    if (num_digits == 0 || num_digits > 18) {return false;}
+    if (field[is_negative] == '0' && (num_digits > 1 || is_negative)) {return false;}
+
+    int64_t curr_value = 0;
+    for (size_t i = is_negative; i < length; i++) {
+        if (field[i] < '0' || field[i] > '9') {return false;}
+        curr_value = curr_value * 10 + (field[i] - '0');
+    }
+    *value = is_negative ? -curr_value : curr_value;
+    return true;
+}
+
+template <typename FieldCallback>
+static inline void for_each_field(const RecordSpan& record, FieldCallback process_field) {
+    /* Passes each comma-separated field to process_field(field_num, start, length) */
+    size_t field_start = 0, field_num = 0;
+    for (size_t i = 0; i <= record.length; i++) {
+        if (i == record.length || record.start[i] == ',') {
+            process_field(field_num++, record.start + field_start, i - field_start);
+            field_start = i + 1;
+        }
+    }
+}
+
+struct ColumnBuilder {
+    /* Holds what the writer learns about a column, before the column is written */
+    bool is_numeric = true;
+    int64_t min_value = std::numeric_limits<int64_t>::max();
+    int64_t max_value = std::numeric_limits<int64_t>::min();
+    std::unordered_map<std::string, uint64_t> dict_codes;
+    std::vector<std::string> dict_entries; // in the order of their codes
+    ColumnDescriptor descriptor = ColumnDescriptor(); // filled in once the column has been scanned
+    std::vector<uint8_t> data;
+
+    uint64_t encode(const char* field, size_t length) {
+        /* Returns the value stored for a field, categorical codes are given out in order of first appearance */
+        if (is_numeric) {
+            int64_t value = 0;
+            parse_integer(field, length, &value);
+            return (uint64_t) value - (uint64_t) descriptor.base_value;
+        }
+        auto code = dict_codes.emplace(std::string(field, length), dict_entries.size());
+        if (code.second) {dict_entries.emplace_back(field, length);}
+        return code.first->second;
+    }
+    void store(size_t record_num, uint64_t value) {
+        /* Writes the low bytes of a value into the column (the file is in host byte order) */
+        std::memcpy(data.data() + record_num * descriptor.width, &value, descriptor.width);
+    }
+};
+
+static void write_padding(FILE* output, uint64_t* curr_offset) {
+    /* Pads the output with zeros up to the next multiple of COLUMNAR_ALIGNMENT */
+    static const char zeros[COLUMNAR_ALIGNMENT] = {0};
+    size_t padding = (COLUMNAR_ALIGNMENT - *curr_offset % COLUMNAR_ALIGNMENT) % COLUMNAR_ALIGNMENT;
+    std::fwrite(zeros, 1, padding, output);
+    *curr_offset += padding;
+}
+
+void write_columnar_file(const std::vector<RecordSpan>& records, const std::string& output_path) {
+    /*
+     * Writes the records as a columnar file. The first pass finds the columns that only hold
+     * integers and their range, the second pass builds the dictionaries of the others (and of
+     * the label), and the last pass stores the value of every field with the chosen width.
+     */
+    size_t num_columns = 0, min_features = std::numeric_limits<size_t>::max();
+    std::vector<ColumnBuilder> columns;
+    auto count_features = [](const RecordSpan& record) {return (size_t) std::count(record.start, record.start + record.length, ',');};
+
+    for (const RecordSpan& record: records) {
+        size_t num_features = count_features(record);
+        num_columns = std::max(num_columns, num_features);
+        min_features = std::min(min_features, num_features);
+        if (columns.size() < num_columns) {columns.resize(num_columns);}
+
+        for_each_field(record, [&](size_t field_num, const char* field, size_t length) {
+            if (field_num == num_features) {return;}
+            ColumnBuilder& column = columns[field_num];
+            int64_t value = 0;
+            if (column.is_numeric && parse_integer(field, length, &value)) {
+                column.min_value = std::min(column.min_value, value);
+                column.max_value = std::max(column.max_value, value);
+            } else {column.is_numeric = false;}
+        });
+    }
+
+    // Columns that are missing from some records, or whose range does not fit, are stored as categorical
+    for (size_t i = 0; i < num_columns; i++) {
+        ColumnBuilder& column = columns[i];
+        if (i >= min_features) {column.is_numeric = false;}
+        if (column.is_numeric && (uint64_t) column.max_value - (uint64_t) column.min_value == std::numeric_limits<uint64_t>::max()) {
+            column.is_numeric = false;
+        }
+    }
+
+    // The label is the last field of each record, so it gets its own column after the features
+    columns.resize(num_columns + 1);
+    columns[num_columns].is_numeric = false;
+
+    for (const RecordSpan& record: records) {
+        size_t num_features = count_features(record);
+        for_each_field(record, [&](size_t field_num, const char* field, size_t length) {
+            size_t column_num = (field_num == num_features) ? num_columns : field_num;
+            if (!columns[column_num].is_numeric) {columns[column_num].encode(field, length);}
+        });
+    }
+
+    for (ColumnBuilder& column: columns) {
+        std::memset(&column.descriptor, 0, sizeof(ColumnDescriptor));
+        column.descriptor.type = column.is_numeric ? NUMERIC_COLUMN : CATEGORICAL_COLUMN;
+        if (column.is_numeric) {
+            column.descriptor.base_value = column.min_value;
+            column.descriptor.width = choose_width((uint64_t) column.max_value - (uint64_t) column.min_value);
+        } else {
+            column.descriptor.dict_size = column.dict_entries.size();
+            column.descriptor.width = choose_width(column.dict_entries.empty() ? 0 : column.dict_entries.size() - 1);
+        }
+        column.data.assign(records.size() * column.descriptor.width, 0xFF); // fields start out missing
+    }
+
+    std::vector<uint64_t> record_hashes (records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        size_t num_features = count_features(records[i]);
+        for_each_field(records[i], [&](size_t field_num, const char* field, size_t length) {
+            size_t column_num = (field_num == num_features) ? num_columns : field_num;
+            columns[column_num].store(i, columns[column_num].encode(field, length));
+        });
+        record_hashes[i] = hash_record(records[i].start, records[i].length);
+    }
+
+    // Lay out the file: header and descriptors, then the column data, the dictionaries and the hashes
+    uint64_t curr_offset = sizeof(ColumnarHeader) + columns.size() * sizeof(ColumnDescriptor);
+    auto align_offset = [](uint64_t offset) {return (offset + COLUMNAR_ALIGNMENT - 1) / COLUMNAR_ALIGNMENT * COLUMNAR_ALIGNMENT;};
+    for (ColumnBuilder& column: columns) {
+        column.descriptor.data_offset = curr_offset = align_offset(curr_offset);
+        curr_offset += column.data.size();
+    }
+    for (ColumnBuilder& column: columns) {
+        if (column.is_numeric) {continue;}
+        column.descriptor.dict_offset = curr_offset = align_offset(curr_offset);
+        curr_offset += (column.dict_entries.size() + 1) * sizeof(uint32_t);
+        for (const std::string& entry: column.dict_entries) {curr_offset += entry.length();}
+    }
+
+    ColumnarHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+    header.version = COLUMNAR_VERSION;
+    header.byte_order = COLUMNAR_BYTE_ORDER;
+    header.num_records = records.size();
+    header.num_columns = num_columns;
+    header.hash_offset = align_offset(curr_offset);
+
+    FILE* output = std::fopen(output_path.data(), "wb");
+    if (output == NULL) {THROW_EXCEPTION(("Unable to open output file: " + output_path).data());}
+
+    curr_offset = 0;
+    curr_offset += std::fwrite(&header, 1, sizeof(header), output);
+    for (const ColumnBuilder& column: columns) {curr_offset += std::fwrite(&column.descriptor, 1, sizeof(ColumnDescriptor), output);}
+    for (const ColumnBuilder& column: columns) {
+        write_padding(output, &curr_offset);
+        curr_offset += std::fwrite(column.data.data(), 1, column.data.size(), output);
+    }
+    for (const ColumnBuilder& column: columns) {
+        if (column.is_numeric) {continue;}
+        write_padding(output, &curr_offset);
+        uint32_t entry_offset = 0;
+        for (size_t i = 0; i <= column.dict_entries.size(); i++) {
+            curr_offset += std::fwrite(&entry_offset, 1, sizeof(uint32_t), output);
+            if (i < column.dict_entries.size()) {entry_offset += column.dict_entries[i].length();}
+        }
+        for (const std::string& entry: column.dict_entries) {curr_offset += std::fwrite(entry.data(), 1, entry.length(), output);}
+    }
+    write_padding(output, &curr_offset);
+    curr_offset += std::fwrite(record_hashes.data(), 1, record_hashes.size() * sizeof(uint64_t), output);
+
+    if (std::fclose(output) != 0 || curr_offset != header.hash_offset + record_hashes.size() * sizeof(uint64_t)) {
+        THROW_EXCEPTION(("Error occurred while writing the columnar file: " + output_path).data());
+    }
+}
+
+bool is_columnar_file(const char* file_path) {
+    /* Checks whether a file starts with the magic number of the columnar format */
+    int input_fd = open(file_path, O_RDONLY);
+    if (input_fd < 0) {return false;}
+
+    char magic[sizeof(COLUMNAR_MAGIC) - 1];
+    bool is_columnar = (read(input_fd, magic, sizeof(magic)) == (ssize_t) sizeof(magic) &&
+                        !std::memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)));
+    close(input_fd);
+    return is_columnar;
+}
+
+ColumnarFile::ColumnarFile(const std::string& file_path) {
+    /* Constructor for the reader - memory-maps the file, and checks that every column is inside of it */
+    int input_fd = open(file_path.data(), O_RDONLY);
+    struct stat s;
+    if (input_fd < 0 || fstat(input_fd, &s) < 0) {THROW_EXCEPTION(("The following path could not be opened: " + file_path).data());}
+    file_size = s.st_size;
+    if (file_size < sizeof(ColumnarHeader)) {THROW_EXCEPTION(("The following file is too small to be a columnar file: " + file_path).data());}
+
+    void* mapped_data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, input_fd, 0);
+    close(input_fd);
+    if (mapped_data == MAP_FAILED) {THROW_EXCEPTION("Error occurred, while memory-mapping the columnar file.");}
+    file_data = static_cast<const uint8_t*>(mapped_data);
+    STATS_ADD(bytes_read, file_size);
+
+    header = reinterpret_cast<const ColumnarHeader*>(file_data);
+    if (std::memcmp(header->magic, COLUMNAR_MAGIC, sizeof(header->magic))) {THROW_EXCEPTION(("The following file is not a columnar file: " + file_path).data());}
+    if (header->version != COLUMNAR_VERSION) {THROW_EXCEPTION(("The following columnar file has an unsupported version: " + file_path).data());}
+    if (header->byte_order != COLUMNAR_BYTE_ORDER) {THROW_EXCEPTION(("The following columnar file was written on a host with another byte order: " + file_path).data());}
+
+    if (header->num_records > file_size / sizeof(uint64_t)) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+    validate_range(header->hash_offset, header->num_records * sizeof(uint64_t));
+    validate_range(sizeof(ColumnarHeader), ((uint64_t) header->num_columns + 1) * sizeof(ColumnDescriptor));
+    columns = reinterpret_cast<const ColumnDescriptor*>(file_data + sizeof(ColumnarHeader));
+
+    for (size_t i = 0; i <= header->num_columns; i++) {
+        const ColumnDescriptor& column = columns[i];
+        if (column.width != 1 && column.width != 2 && column.width != 4 && column.width != 8) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+        if (column.type != NUMERIC_COLUMN && column.type != CATEGORICAL_COLUMN) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+        validate_range(column.data_offset, header->num_records * column.width);
+
+        if (column.type == CATEGORICAL_COLUMN) {
+            validate_range(column.dict_offset, ((uint64_t) column.dict_size + 1) * sizeof(uint32_t));
+            const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(file_data + column.dict_offset);
+            for (size_t j = 0; j < column.dict_size; j++) {
+                if (entry_offsets[j] > entry_offsets[j+1]) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+            }
+            validate_range(column.dict_offset + ((uint64_t) column.dict_size + 1) * sizeof(uint32_t), entry_offsets[column.dict_size]);
+        }
+    }
+}
+
+ColumnarFile::~ColumnarFile() {
+    /* Deconstructor for the reader - unmaps the file */
+    if (file_data != NULL) {munmap(const_cast<uint8_t*>(file_data), file_size);}
+}
+
+void ColumnarFile::validate_range(uint64_t offset, uint64_t length) const {
+    /* Stops if a section of the file does not fit inside of it */
+    if (offset > file_size || length > file_size - offset) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+}
+
+uint64_t ColumnarFile::load_value(const ColumnDescriptor& column, size_t record_num) const {
+    /* Loads the stored value of a record in a column */
+    uint64_t value = 0;
+    std::memcpy(&value, file_data + column.data_offset + record_num * column.width, column.width);
+    return value;
+}
+
+bool ColumnarFile::append_field(const ColumnDescriptor& column, size_t record_num, std::string& output) const {
+    /* Appends the text of a field to the output, and returns false if the record does not have the field */
+    uint64_t value = load_value(column, record_num);
+    if (value == missing_value(column.width)) {return false;}
+
+    if (column.type == NUMERIC_COLUMN) {
+        char field[24];
+        int length = std::snprintf(field, sizeof(field), "%lld", (long long) (value + (uint64_t) column.base_value));
+        output.append(field, length);
+    } else {
+        if (value >= column.dict_size) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+        const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(file_data + column.dict_offset);
+        const char* entries = reinterpret_cast<const char*>(entry_offsets + column.dict_size + 1);
+        output.append(entries + entry_offsets[value], entry_offsets[value+1] - entry_offsets[value]);
+    }
+    return true;
+}
+
+RecordSpan ColumnarFile::get_label(size_t record_num) const {
+    /* Returns the label of a record, it points into the dictionary of the label column */
+    const ColumnDescriptor& label_column = columns[header->num_columns];
+    uint64_t code = load_value(label_column, record_num);
+    if (code >= label_column.dict_size) {THROW_EXCEPTION("The columnar file is truncated or corrupt.");}
+
+    const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(file_data + label_column.dict_offset);
+    const char* entries = reinterpret_cast<const char*>(entry_offsets + label_column.dict_size + 1);
+    return {entries + entry_offsets[code], entry_offsets[code+1] - entry_offsets[code]};
+}
+
+void ColumnarFile::append_record(size_t record_num, std::string& output) const {
+    /* Appends the text of a record (without a newline), it is the same as the line it was converted from */
+    for (size_t i = 0; i < header->num_columns; i++) {
+        if (!append_field(columns[i], record_num, output)) {break;}
+        output += ',';
+    }
+    append_field(columns[header->num_columns], record_num, output);
+}
+
+std::string ColumnarFile::build_text() const {
+    /* Rebuilds the text of every record, one per line, for the sub-commands that parse the fields */
+    std::string text;
+    for (size_t i = 0; i < header->num_records; i++) {
+        append_record(i, text);
+        text += '\n';
+    }
+    return text;
+}
@@ -0,0 +1,186 @@
+/*
+ * Name: countmin.cpp
+ * Description: Contains the implementation of the Count-Min sketch, which is used to
+ *              find the most frequent feature vectors (heavy-hitters) in a window.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <countmin.h>
+#include <hash.h>
+#include <pacsketch.h>
+#include <functional>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static_assert(CM_DEPTH == 4, "The Count-Min kernels update exactly 4 rows, one per 32-bit lane.");
+
+/* Multi-row kernels: every row uses h1 + row*h2 (double hashing) as its column */
+
+#if defined(__AVX2__)
+
+static inline __m128i countmin_indexes(uint32_t width_bits, uint64_t hash_val) {
+    /* Computes the counter index in each of the 4 rows at once */
+    const __m128i rows = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i h1 = _mm_set1_epi32((int) (uint32_t) hash_val);
+    __m128i h2 = _mm_set1_epi32((int) ((uint32_t) (hash_val >> 32) | 1));
+    __m128i col_mask = _mm_set1_epi32((int) ((1u << width_bits) - 1));
+
+    __m128i cols = _mm_and_si128(_mm_add_epi32(h1, _mm_mullo_epi32(rows, h2)), col_mask);
+    return _mm_add_epi32(cols, _mm_sll_epi32(rows, _mm_cvtsi32_si128(width_bits)));
+}
+
+static inline uint32_t horizontal_min(__m128i vals) {
+    /* Returns the smallest of the 4 unsigned lanes */
+    vals = _mm_min_epu32(vals, _mm_shuffle_epi32(vals, _MM_SHUFFLE(1, 0, 3, 2)));
+    vals = _mm_min_epu32(vals, _mm_shuffle_epi32(vals, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t) _mm_cvtsi128_si32(vals);
+}
+
+uint32_t countmin_update_kernel(uint32_t* counters, uint32_t width_bits, uint64_t hash_val) {
+    /*
+     * Conservative update: gathers the 4 counters, and raises each of them to (min + 1) if it is
+     * below that. Returns the new estimate. AVX2 has no scatter, so the 4 stores are scalar.
+     */
+    __m128i indexes = countmin_indexes(width_bits, hash_val);
+    __m128i curr_vals = _mm_i32gather_epi32((const int*) counters, indexes, 4);
+    uint32_t new_count = horizontal_min(curr_vals) + 1;
+    __m128i new_vals = _mm_max_epu32(curr_vals, _mm_set1_epi32((int) new_count));
+
+    alignas(16) uint32_t index_arr[CM_DEPTH], val_arr[CM_DEPTH];
+    _mm_store_si128((__m128i*) index_arr, indexes);
+    _mm_store_si128((__m128i*) val_arr, new_vals);
+    for (size_t row = 0; row < CM_DEPTH; row++) {counters[index_arr[row]] = val_arr[row];}
+    return new_count;
+}
+
+uint32_t countmin_estimate_kernel(const uint32_t* counters, uint32_t width_bits, uint64_t hash_val) {
+    /* Returns the smallest of the 4 counters for a hash value */
+    __m128i curr_vals = _mm_i32gather_epi32((const int*) counters, countmin_indexes(width_bits, hash_val), 4);
+    return horizontal_min(curr_vals);
+}
+
+#else
+
+static inline void countmin_indexes(uint32_t width_bits, uint64_t hash_val, uint32_t* indexes) {
+    /* Computes the counter index in each of the 4 rows */
+    uint32_t h1 = (uint32_t) hash_val;
+    uint32_t h2 = (uint32_t) (hash_val >> 32) | 1;
+    uint32_t col_mask = (1u << width_bits) - 1;
+    for (uint32_t row = 0; row < CM_DEPTH; row++) {indexes[row] = ((h1 + row * h2) & col_mask) + (row << width_bits);}
+}
+
+uint32_t countmin_update_kernel(uint32_t* counters, uint32_t width_bits, uint64_t hash_val) {
+    /* Conservative update: raises each of the 4 counters to (min + 1) if it is below that, and returns the new estimate */
+    uint32_t indexes[CM_DEPTH];
+    countmin_indexes(width_bits, hash_val, indexes);
+
+    uint32_t new_count = std::min(std::min(counters[indexes[0]], counters[indexes[1]]),
+                                  std::min(counters[indexes[2]], counters[indexes[3]])) + 1;
+    for (size_t row = 0; row < CM_DEPTH; row++) {counters[indexes[row]] = std::max(counters[indexes[row]], new_count);}
+    return new_count;
+}
+
+uint32_t countmin_estimate_kernel(const uint32_t* counters, uint32_t width_bits, uint64_t hash_val) {
+    /* Returns the smallest of the 4 counters for a hash value */
+    uint32_t indexes[CM_DEPTH];
+    countmin_indexes(width_bits, hash_val, indexes);
+    return std::min(std::min(counters[indexes[0]], counters[indexes[1]]),
+                    std::min(counters[indexes[2]], counters[indexes[3]]));
+}
+
+#endif
+
+CountMin::CountMin(size_t width_val, size_t top_n_val) {
+    /* Constructor for Count-Min sketch, all the memory it will use is allocated here */
+    if (width_val < CM_MIN_WIDTH || width_val > CM_MAX_WIDTH || (width_val & (width_val - 1))) {
+        THROW_EXCEPTION("The width of the Count-Min sketch has to be a power of 2 between 16 and 2^24.");
+    }
+    width = width_val;
+    width_bits = __builtin_ctzll(width);
+    top_n = std::max(top_n_val, (size_t) 1);
+
+    counters.assign(CM_DEPTH * width, 0);
+    candidates.resize(top_n * CM_CANDIDATE_FACTOR);
+    candidate_hashes.assign(top_n * CM_CANDIDATE_FACTOR, 0);
+    reset();
+}
+
+void CountMin::reset() {
+    /* Empties the sketch so it can be reused for the next window, the memory is kept */
+    std::fill(counters.begin(), counters.end(), 0);
+    num_candidates = 0;
+    min_candidate = 0;
+    total_count = 0;
+}
+
+uint32_t CountMin::add_hash(uint64_t hash_val) {
+    /* Counts one occurrence of a hash value (the heavy-hitter candidates are only updated by add_record) */
+    total_count++;
+    return countmin_update_kernel(counters.data(), width_bits, hash_val);
+}
+
+void CountMin::add_record(const char* record, size_t length) {
+    /* Counts the feature vector of a connection record, hashed the same way as hash_record() */
+    build_feature_vector(record, length, feature_vec);
+    uint64_t hash_val = std::hash<std::string>()(feature_vec);
+    update_candidates(hash_val, add_hash(hash_val));
+}
+
+uint32_t CountMin::estimate_count(uint64_t hash_val) const {
+    /* Returns the estimated number of times a hash value was added (never an underestimate) */
+    return countmin_estimate_kernel(counters.data(), width_bits, hash_val);
+}
+
+void CountMin::update_candidates(uint64_t hash_val, uint32_t estimated_count) {
+    /*
+     * Updates the count of a candidate, or adds it to the table. When the table is full,
+     * the new feature vector replaces the candidate with the smallest count if it is larger.
+     */
+    for (size_t i = 0; i < num_candidates; i++) {
+        if (candidate_hashes[i] == hash_val) {
+            candidates[i].estimated_count = estimated_count;
+            if (i == min_candidate) {find_min_candidate();}
+            return;
+        }
+    }
+
+    size_t slot = num_candidates;
+    if (num_candidates == candidates.size()) {
+        if (estimated_count <= candidates[min_candidate].estimated_count) {return;}
+        slot = min_candidate;
+    } else {
+        num_candidates++;
+    }
+
+    // The strings keep their capacity, so the table stops allocating once it has warmed up
+    candidate_hashes[slot] = hash_val;
+    candidates[slot].hash_val = hash_val;
+    candidates[slot].estimated_count = estimated_count;
+    candidates[slot].feature_vec.assign(feature_vec);
+    find_min_candidate();
+}
+
+void CountMin::find_min_candidate() {
+    /* Finds the candidate with the smallest count, it is the one that gets replaced next */
+    min_candidate = 0;
+    for (size_t i = 1; i < num_candidates; i++) {
+        if (candidates[i].estimated_count < candidates[min_candidate].estimated_count) {min_candidate = i;}
+    }
+}
+
+std::vector<HeavyHitter> CountMin::get_top_n() const {
+    /* Returns the top-N candidates, sorted by decreasing count (ties are broken by the feature vector) */
+    std::vector<HeavyHitter> top_hitters (candidates.begin(), candidates.begin() + num_candidates);
+    std::sort(top_hitters.begin(), top_hitters.end(), [](const HeavyHitter& a, const HeavyHitter& b) {
+        return (a.estimated_count != b.estimated_count) ? (a.estimated_count > b.estimated_count) : (a.feature_vec < b.feature_vec);
+    });
+    if (top_hitters.size() > top_n) {top_hitters.resize(top_n);}
+    return top_hitters;
+}
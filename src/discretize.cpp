@@ -0,0 +1,199 @@
+/*
+ * Name: discretize.cpp
+ * Description: Converts the numeric features of KDD records into discrete 
+ *              labels based on how many standard deviations they are from the 
+ *              mean of the normal records. This is the same binning done by
+ *              convert_real_to_discrete_label() in util/analyze_dataset.py, 
+ *              but it works on memory-mapped records across multiple threads.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <discretize.h>
+#include <parallel.h>
+
+const std::array<size_t, NUM_NUMERIC_KDD_FEATURES> numeric_kdd_features = {0, 4, 5, 7, 8, 9, 10, 
+                                                                            12, 13, 14, 15, 16, 17, 18,
+                                                                            19, 22, 23, 24, 25, 26, 27,
+                                                                            28, 29, 30, 31, 32, 33, 34,
+                                                                            35, 36, 37, 38, 39, 40};
+
+const std::array<const char*, KDD_LABEL_FIELD> kdd_feature_names = {
+    "duration", "protocol_type", "service", "flag", "src_bytes", "dst_bytes",
+    "land", "wrong_fragments", "urgent", "hot", "num_failed_logins", "logged_in",
+    "num_compromised",  "root_shell", "su_attempted", "num_root", "num_file_creations", "num_shells",
+    "num_access_files", "num_outbound_cmds", "is_host_login", "is_guest_login", "count", "srv_count",
+    "serror_rate", "srv_serror_rate", "rerror_rate", "srv_rerror_rate", "same_srv_rate", "diff_srv_rate",
+    "srv_diff_host_rate", "dst_host_count", "dst_host_srv_count", "dst_host_same_srv_rate", "dst_host_diff_srv_rate", "dst_host_same_src_port_rate",
+    "dst_host_srv_diff_host_rate", "dst_host_serror_rate", "dst_host_srv_serror_rate", "dst_host_rerror_rate", "dst_host_srv_rerror_rate"};
+
+static size_t find_fields(const RecordSpan& record, std::array<const char*, NUM_KDD_FIELDS + 1>& field_starts) {
+    /* 
+     * Records where each of the first NUM_KDD_FIELDS fields begin, field_starts[i+1]-1 is the end of
+     * field i. Returns the number of fields found (up to NUM_KDD_FIELDS).
+     */
+    const char* curr_pos = record.start;
+    const char* record_end = record.start + record.length;
+    size_t num_fields = 0;
+
+    while (num_fields < NUM_KDD_FIELDS) {
+        field_starts[num_fields++] = curr_pos;
+        const char* comma = static_cast<const char*>(std::memchr(curr_pos, ',', record_end - curr_pos));
+        if (comma == NULL) {curr_pos = record_end + 1; break;}
+        curr_pos = comma + 1;
+    }
+    field_starts[num_fields] = curr_pos;
+    return num_fields;
+}
+
+static bool is_normal_label(const char* label_start, const char* label_end) {
+    /* Checks if the label field is "normal", ignoring surrounding whitespace */
+    while (label_start < label_end && std::isspace(*label_start)) {label_start++;}
+    while (label_end > label_start && std::isspace(label_end[-1])) {label_end--;}
+    return (label_end - label_start) == 6 && !std::memcmp(label_start, "normal", 6);
+}
+
+std::vector<FeatureStats> compute_feature_stats(const std::vector<RecordSpan>& records, size_t num_threads) {
+    /* 
+     * Computes the mean and stdev of each numeric feature over the normal records, each thread 
+     * keeps its own running statistics for a chunk of the records, and these are merged at the end.
+     */
+    std::vector<std::vector<FeatureStats>> thread_stats (std::max((size_t) 1, num_threads), std::vector<FeatureStats>(NUM_KDD_FIELDS));
+
+    for_each_chunk(records.size(), num_threads, [&](size_t thread_num, size_t start, size_t end) {
+        std::array<const char*, NUM_KDD_FIELDS + 1> field_starts;
+        std::vector<FeatureStats>& curr_stats = thread_stats[thread_num];
+
+        for (size_t i = start; i < end; i++) {
+            if (find_fields(records[i], field_starts) < NUM_KDD_FIELDS) {continue;}
+            if (!is_normal_label(field_starts[KDD_LABEL_FIELD], field_starts[KDD_LABEL_FIELD+1]-1)) {continue;}
+
+            for (size_t feature: numeric_kdd_features) {curr_stats[feature].add(std::strtod(field_starts[feature], NULL));}
+        }
+    });
+
+    std::vector<FeatureStats> total_stats (NUM_KDD_FIELDS);
+    for (const std::vector<FeatureStats>& curr_stats: thread_stats) {
+        for (size_t feature: numeric_kdd_features) {total_stats[feature].merge(curr_stats[feature]);}
+    }
+    return total_stats;
+}
+
+uint8_t discretize_value(double value, const FeatureStats& stats) {
+    /* 
+     * Converts a real value into one of eight labels (1-8) based on its z-score, the cut-offs are 
+     * at -1, -0.5, -0.25, 0, 0.25, 0.5 and 1 stdevs. A feature with no variance always gets label 0.
+     */
+    double stdev = stats.stdev();
+    if (stdev == 0) {return 0;}
+
+    double z_score = (value - stats.mean)/stdev;
+    if (z_score < -1.0) {return 1;}
+    else if (z_score < -0.5) {return 2;}
+    else if (z_score < -0.25) {return 3;}
+    else if (z_score < 0.0) {return 4;}
+    else if (z_score < 0.25) {return 5;}
+    else if (z_score < 0.5) {return 6;}
+    else if (z_score < 1.0) {return 7;}
+    return 8;
+}
+
+bool discretize_record(const RecordSpan& record, const std::vector<FeatureStats>& stats, std::string& output) {
+    /* 
+     * Appends the binned version of a record (with a newline) to output, and returns whether 
+     * it is a normal record. Records without all the KDD fields are a fatal error.
+     */
+    std::array<const char*, NUM_KDD_FIELDS + 1> field_starts;
+    if (find_fields(record, field_starts) < NUM_KDD_FIELDS) {
+        THROW_EXCEPTION(("Found a record without all the KDD fields: " + std::string(record.start, record.length)).data());
+    }
+
+    size_t curr_numeric = 0;
+    for (size_t i = 0; i < NUM_KDD_FIELDS; i++) {
+        if (curr_numeric < NUM_NUMERIC_KDD_FEATURES && numeric_kdd_features[curr_numeric] == i) {
+            output += (char) ('0' + discretize_value(std::strtod(field_starts[i], NULL), stats[i]));
+            curr_numeric++;
+        } else {
+            output.append(field_starts[i], field_starts[i+1] - 1 - field_starts[i]);
+        }
+        output += (i == KDD_LABEL_FIELD) ? '\n' : ',';
+    }
+    return is_normal_label(field_starts[KDD_LABEL_FIELD], field_starts[KDD_LABEL_FIELD+1]-1);
+}
+
+std::vector<size_t> parse_kdd_columns(const std::string& column_list) {
+    /* 
+     * Converts a comma-separated list of KDD feature names and/or 0-based indexes into
+     * column indexes, "all" selects every feature (the label is not included).
+     */
+    std::vector<size_t> columns;
+    size_t token_start = 0;
+    while (token_start <= column_list.length()) {
+        size_t token_end = std::min(column_list.find(',', token_start), column_list.length());
+        std::string token = column_list.substr(token_start, token_end - token_start);
+        token_start = token_end + 1;
+        if (token.empty()) {continue;}
+
+        if (token == "all") {
+            for (size_t i = 0; i < KDD_LABEL_FIELD; i++) {columns.push_back(i);}
+        } else if (std::all_of(token.begin(), token.end(), ::isdigit)) {
+            size_t column = std::strtoul(token.data(), NULL, 10);
+            if (column >= KDD_LABEL_FIELD) {FATAL_WARNING(("The column index is out of range (0 to 40): " + token).data());}
+            columns.push_back(column);
+        } else {
+            auto name_pos = std::find_if(kdd_feature_names.begin(), kdd_feature_names.end(), 
+                                         [&](const char* name) {return token == name;});
+            if (name_pos == kdd_feature_names.end()) {FATAL_WARNING(("The following column is not a KDD feature: " + token).data());}
+            columns.push_back(name_pos - kdd_feature_names.begin());
+        }
+    }
+    if (columns.empty()) {FATAL_WARNING("At least one column needs to be selected.");}
+
+    // Columns that were selected more than once are only kept the first time
+    std::vector<size_t> unique_columns;
+    for (size_t column: columns) {
+        if (std::find(unique_columns.begin(), unique_columns.end(), column) == unique_columns.end()) {unique_columns.push_back(column);}
+    }
+    return unique_columns;
+}
+
+void discretize_records(const std::vector<RecordSpan>& records, const std::vector<FeatureStats>& stats, 
+                        size_t num_threads, BinnedRecordCallback process_record) {
+    /* 
+     * Bins every record, and passes them to process_record (without the newline) in their original 
+     * order. Each batch of records is split across the threads, which bin into their own buffers.
+     */
+    struct BinnedChunk {
+        std::string data;
+        std::vector<size_t> ends; // end of each binned record in data (including newline)
+        std::vector<bool> is_normal;
+    };
+    std::vector<BinnedChunk> chunks (std::max((size_t) 1, num_threads));
+
+    for (size_t batch_start = 0; batch_start < records.size(); batch_start += DISCRETIZE_BATCH_SIZE) {
+        size_t batch_size = std::min((size_t) DISCRETIZE_BATCH_SIZE, records.size() - batch_start);
+
+        for (BinnedChunk& chunk: chunks) {chunk.data.clear(); chunk.ends.clear(); chunk.is_normal.clear();}
+        for_each_chunk(batch_size, num_threads, [&](size_t thread_num, size_t start, size_t end) {
+            BinnedChunk& chunk = chunks[thread_num];
+            for (size_t i = batch_start + start; i < batch_start + end; i++) {
+                chunk.is_normal.push_back(discretize_record(records[i], stats, chunk.data));
+                chunk.ends.push_back(chunk.data.length());
+            }
+        });
+
+        for (const BinnedChunk& chunk: chunks) {
+            size_t record_start = 0;
+            for (size_t i = 0; i < chunk.ends.size(); i++) {
+                process_record(chunk.data.data() + record_start, chunk.ends[i] - record_start - 1, chunk.is_normal[i]);
+                record_start = chunk.ends[i];
+            }
+        }
+    }
+}
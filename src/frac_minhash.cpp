@@ -0,0 +1,264 @@
+/*
+ * Name: frac_minhash.cpp
+ * Description: Contains the implementation of the FracMinHash (scaled MinHash) data-structure,
+ *              which keeps a fixed fraction of the hash space instead of a fixed number of hashes.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <frac_minhash.h>
+#include <iostream>
+#include <kseq.h>
+#include <zlib.h>
+#include <hash.h>
+#include <stats.h>
+#include <pcap_reader.h>
+#include <columnar.h>
+#include <sketch_file.h>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <cstring>
+
+KSEQ_INIT(gzFile, gzread)
+
+FracMinHash::FracMinHash(std::string file_path, uint64_t scale_val, data_type input_type, pcap_key_type pcap_key) {
+    /* constructor for FracMinHash class, it builds based on data_type */
+    ref_file.assign(file_path);
+    scale = scale_val;
+    max_hash = MAX_HASH / scale;
+    file_type = input_type;
+    hash_id = compute_hash_id(input_type, pcap_key);
+
+    switch(file_type) {
+        case FASTA: buildFromFASTA(file_path); break;
+        case PACKET: buildFromPackets(file_path); break;
+        case PCAP: buildFromPcap(file_path, pcap_key); break;
+        default: FATAL_WARNING("There appears to be a bug in the code in FracMinHash constructor.\n"); std::exit(1);
+    }
+    compact();
+}
+
+FracMinHash::FracMinHash(uint64_t scale_val, data_type input_type) {
+    /* Constructor for FracMinHash - used when unioning sketches, or building them one hash at a time */
+    ref_file.assign("");
+    scale = scale_val;
+    max_hash = MAX_HASH / scale;
+    file_type = input_type;
+    hash_id = compute_hash_id(input_type, FIVE_TUPLE_KEY);
+}
+
+void FracMinHash::buildFromFASTA(std::string file_path) {
+    /* Constructs the FracMinHash data-structure for the scenario where input is a FASTA file */
+    gzFile fp = gzopen(file_path.data(), "r");
+    kseq_t* ks = kseq_init(fp);
+
+    while (kseq_read(ks) >= 0) {
+        STATS_ADD(bytes_read, ks->seq.l);
+        add_sequence(ks->seq.s, ks->seq.l);
+    }
+    kseq_destroy(ks);
+    gzclose(fp);
+}
+
+void FracMinHash::buildFromPackets(std::string file_path) {
+    /* Builds the FracMinHash sketch from a Packet Trace, the hashes of a columnar file are inserted straight from the mapping */
+    if (is_columnar_file(file_path.data())) {
+        ColumnarFile columnar_input (file_path);
+        const uint64_t* record_hashes = columnar_input.get_record_hashes();
+        for (size_t i = 0; i < columnar_input.get_num_records(); i++) {add_hash(record_hashes[i]);}
+        return;
+    }
+    std::ifstream input_data (file_path, std::ifstream::in);
+
+    for (std::string line; std::getline(input_data, line);) {
+        STATS_ADD(bytes_read, line.length() + 1);
+        size_t length = line.length() - (!line.empty() && line.back() == '\r');
+        if (length) {add_record(line.data(), length);} // empty lines are skipped, like index_records()
+    }
+}
+
+void FracMinHash::buildFromPcap(std::string file_path, pcap_key_type pcap_key) {
+    /* Builds the FracMinHash sketch from the packets of a pcap/pcapng capture */
+    PcapReader pcap_reader (file_path);
+    PacketHeaders headers;
+    while (pcap_reader.next_packet(&headers)) {add_hash(hash_packet_key(headers, pcap_key));}
+}
+
+void FracMinHash::add_record(const char* record, size_t length) {
+    /* Inserts a connection record (one line of packet data) into the sketch */
+    add_hash(hash_record(record, length));
+}
+
+void FracMinHash::add_sequence(const char* seq, size_t length) {
+    /* Inserts every k-mer of a DNA sequence into the sketch */
+    STATS_ADD(kmers_parsed, (length >= FASTA_KMER_LENGTH) ? length - FASTA_KMER_LENGTH + 1 : 0);
+    for_each_kmer_hash(seq, length, FASTA_KMER_LENGTH, [&](uint64_t hash_val) {add_hash(hash_val);});
+}
+
+void FracMinHash::reset() {
+    /* Empties the sketch so it can be reused, the buffer keeps its capacity so no memory is allocated after the first use */
+    hashes.clear();
+    num_sorted = 0;
+    compact_size = FRAC_MINHASH_MIN_COMPACT;
+}
+
+void FracMinHash::compact() const {
+    /*
+     * Sorts the hashes appended since the last call, merges them into the sorted prefix and drops
+     * the duplicates. The next call happens once the buffer has doubled, so inserts stay amortized
+     * O(log n) even when most of the stream are repeats.
+     */
+    if (num_sorted == hashes.size()) {return;}
+    std::sort(hashes.begin() + num_sorted, hashes.end());
+    std::inplace_merge(hashes.begin(), hashes.begin() + num_sorted, hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    num_sorted = hashes.size();
+    compact_size = std::max(2 * num_sorted, (size_t) FRAC_MINHASH_MIN_COMPACT);
+}
+
+size_t FracMinHash::get_num_hashes() const {
+    /* Returns the number of distinct hashes that are kept */
+    compact();
+    return num_sorted;
+}
+
+uint64_t FracMinHash::get_cardinality() const {
+    /* Estimates the cardinality, each kept hash stands for scale distinct items */
+    return get_num_hashes() * scale;
+}
+
+uint64_t FracMinHash::get_memory_usage() const {
+    /* Returns the bytes allocated for the kept hashes, it grows with the cardinality of the input */
+    return hashes.capacity() * sizeof(uint64_t);
+}
+
+FracMinHash FracMinHash::operator +(const FracMinHash& operand) const {
+    /* Creates the union sketch from two sketches */
+    FracMinHash union_sketch (*this);
+    union_sketch += operand;
+    return union_sketch;
+}
+
+FracMinHash& FracMinHash::operator +=(const FracMinHash& operand) {
+    /* Unions another sketch into this one in place, the union keeps every hash of both */
+    if (!is_compatible(operand)) {THROW_EXCEPTION("FracMinHash sketches with different scales, or different input hashes, cannot be merged.");}
+    operand.compact();
+    hashes.insert(hashes.end(), operand.hashes.begin(), operand.hashes.end());
+    compact();
+    return *this;
+}
+
+bool FracMinHash::is_compatible(const FracMinHash& operand) const {
+    /* Checks whether two sketches keep the same fraction of the same kind of hashes */
+    return scale == operand.scale && hash_id == operand.hash_id;
+}
+
+void FracMinHash::write_to_file(const std::string& file_path, uint64_t input_offset, uint64_t input_fingerprint) const {
+    /* Serializes the sketch, the payload is the kept hashes in ascending order */
+    compact();
+    SketchFileHeader header = SketchFileHeader();
+    header.sketch = FRAC_MINHASH;
+    header.input_type = file_type;
+    header.hash_id = hash_id;
+    header.parameter = scale;
+    header.input_offset = input_offset;
+    header.input_fingerprint = input_fingerprint;
+    header.payload_size = hashes.size() * sizeof(uint64_t);
+    write_sketch_file(file_path, header, hashes.data());
+}
+
+FracMinHash FracMinHash::read_from_file(const std::string& file_path) {
+    /* Loads a sketch written by write_to_file() */
+    SketchFileHeader header;
+    int input_fd = open_sketch_file(file_path, FRAC_MINHASH, &header);
+    if (header.parameter == 0 || header.payload_size % sizeof(uint64_t)) {
+        THROW_EXCEPTION(("The following FracMinHash sketch file is truncated or corrupt: " + file_path).data());
+    }
+
+    FracMinHash loaded_sketch (header.parameter, (data_type) header.input_type);
+    loaded_sketch.ref_file = file_path;
+    loaded_sketch.hash_id = header.hash_id;
+    loaded_sketch.hashes.resize(header.payload_size / sizeof(uint64_t));
+    read_sketch_payload(input_fd, file_path, loaded_sketch.hashes.data(), header.payload_size);
+
+    if (!loaded_sketch.accept_loaded_hashes()) {
+        THROW_EXCEPTION(("The following FracMinHash sketch file is truncated or corrupt: " + file_path).data());
+    }
+    return loaded_sketch;
+}
+
+std::unique_ptr<FracMinHash> FracMinHash::deserialize(const void* buffer, size_t buffer_size) {
+    /* Loads a sketch from memory, in the format of write_to_file(), it returns an empty pointer if the bytes are not a valid sketch */
+    SketchFileHeader header;
+    const char* payload = parse_sketch_buffer(buffer, buffer_size, FRAC_MINHASH, &header);
+    if (payload == NULL || header.parameter == 0 || header.payload_size % sizeof(uint64_t)) {return nullptr;}
+
+    std::unique_ptr<FracMinHash> loaded_sketch (new FracMinHash(header.parameter, (data_type) header.input_type));
+    loaded_sketch->hash_id = header.hash_id;
+    loaded_sketch->hashes.resize(header.payload_size / sizeof(uint64_t));
+    std::memcpy(loaded_sketch->hashes.data(), payload, header.payload_size);
+    if (!loaded_sketch->accept_loaded_hashes()) {return nullptr;}
+    return loaded_sketch;
+}
+
+bool FracMinHash::accept_loaded_hashes() {
+    /* Checks that the hashes read from a payload are ascending, distinct and in the kept fraction, and marks them as sorted */
+    if (std::adjacent_find(hashes.begin(), hashes.end(), std::greater_equal<uint64_t>()) != hashes.end() ||
+        (!hashes.empty() && hashes.back() >= max_hash)) {
+        return false;
+    }
+    num_sorted = hashes.size();
+    compact_size = std::max(2 * hashes.size(), (size_t) FRAC_MINHASH_MIN_COMPACT);
+    return true;
+}
+
+size_t FracMinHash::count_intersection(const FracMinHash& op1, const FracMinHash& op2) {
+    /*
+     * Counts the hashes that are in both sketches by merging the two sorted lists. When one list is
+     * much shorter (a window against a large reference), each of its hashes is found by galloping
+     * forward in the longer list (doubling steps, then a binary search) instead.
+     */
+    if (!op1.is_compatible(op2)) {THROW_EXCEPTION("FracMinHash sketches with different scales, or different input hashes, cannot be compared.");}
+    op1.compact();
+    op2.compact();
+    const std::vector<uint64_t>& small = (op1.num_sorted <= op2.num_sorted) ? op1.hashes : op2.hashes;
+    const std::vector<uint64_t>& large = (op1.num_sorted <= op2.num_sorted) ? op2.hashes : op1.hashes;
+
+    size_t intersection_count = 0;
+    if (small.size() * 16 < large.size()) {
+        auto search_start = large.begin();
+        for (uint64_t hash_val: small) {
+            size_t step = 1, remaining = large.end() - search_start;
+            while (step < remaining && search_start[step] < hash_val) {step *= 2;}
+            search_start = std::lower_bound(search_start + step/2, search_start + std::min(step + 1, remaining), hash_val);
+            if (search_start == large.end()) {break;}
+            intersection_count += (*search_start == hash_val);
+        }
+        return intersection_count;
+    }
+
+    size_t i = 0, j = 0;
+    while (i < small.size() && j < large.size()) {
+        if (small[i] < large[j]) {i++;}
+        else if (large[j] < small[i]) {j++;}
+        else {intersection_count++; i++; j++;}
+    }
+    return intersection_count;
+}
+
+double FracMinHash::compute_jaccard(const FracMinHash& op1, const FracMinHash& op2) {
+    /* Computes jaccard between two sketches: the shared hashes over the distinct hashes in both */
+    size_t intersection_count = count_intersection(op1, op2);
+    size_t union_size = op1.num_sorted + op2.num_sorted - intersection_count;
+    return (union_size) ? (intersection_count + 0.0)/union_size : 0.0;
+}
+
+double FracMinHash::compute_containment(const FracMinHash& query, const FracMinHash& reference) {
+    /* Estimates the fraction of the query (e.g. a window) that is contained in the reference */
+    size_t intersection_count = count_intersection(query, reference);
+    return (query.num_sorted) ? (intersection_count + 0.0)/query.num_sorted : 0.0;
+}
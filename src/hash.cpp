@@ -11,9 +11,15 @@
  */ 
 
 #include <hash.h>
+#include <stats.h>
 #include <iostream>
 #include <cstring>
 #include <map>
+#include <array>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <vector>
 #include <stdint.h>
 
 
@@ -27,6 +33,29 @@ uint64_t MurmurHash3(uint64_t key) {
   return k;
 }
 
+uint64_t hash_bytes(const void* data, size_t length, uint64_t seed) {
+  /* Folds a buffer into a 64-bit hash, 8 bytes at a time through the MurmurHash3 finalizer (used to fingerprint files) */
+  const char* bytes = static_cast<const char*>(data);
+  uint64_t hash_val = MurmurHash3(seed ^ (length * 0x9e3779b97f4a7c15ULL));
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, 8);
+    hash_val = MurmurHash3(hash_val ^ word) + i;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, length - i);
+  return MurmurHash3(hash_val ^ tail);
+}
+
+const std::array<uint8_t, 256> dna_encoding = [] {
+  /* Lookup table for the 2-bit encoding used by encode_string() */
+  std::array<uint8_t, 256> table;
+  table.fill(0x00);
+  table['A'] = 0x00; table['C'] = 0x01; table['G'] = 0x02; table['T'] = 0x03;
+  return table;
+}();
+
 uint64_t encode_string(const char* input_str) {
   /* Takes a string (assuming DNA) and encodes it to a uint64_t */
   std::map<char, uint64_t> encode_dna = {{'A', 0x00}, {'C', 0x01},{'G', 0x02},{'T', 0x03}};
@@ -39,6 +68,85 @@ uint64_t encode_string(const char* input_str) {
   return enc_str;
 }
 
+uint64_t hash_record(const char* record, size_t length) {
+  /* 
+   * Hashes the feature vector of a connection record, which is every non-empty
+   * comma-separated field except the last one (the label). It gives the same value
+   * as joining the fields with '_' (plus a trailing '_') and hashing that string.
+   */
+  static thread_local std::string feature_vec;
+  build_feature_vector(record, length, feature_vec);
+  return std::hash<std::string>()(feature_vec);
+}
+
+template <typename FieldCallback>
+static inline void scan_record(const char* record, size_t length, std::string& feature_vec, FieldCallback process_field) {
+  /* 
+   * Builds the feature vector of a record in feature_vec, and passes every comma-separated
+   * field (including empty ones and the label) to process_field(field_num, start, length).
+   */
+  feature_vec.clear();
+
+  size_t label_start = 0;
+  size_t field_start = 0;
+  size_t field_num = 0;
+  for (size_t i = 0; i <= length; i++) {
+    if (i == length || record[i] == ',') {
+      process_field(field_num++, record + field_start, i - field_start);
+      if (i > field_start) {
+        label_start = feature_vec.length();
+        feature_vec.append(record + field_start, i - field_start);
+        feature_vec += '_';
+      }
+      field_start = i + 1;
+    }
+  }
+  feature_vec.resize(label_start); // Removes the label
+}
+
+void build_feature_vector(const char* record, size_t length, std::string& feature_vec) {
+  /* Joins the non-empty fields of a record (without its label) with '_', this is the string hash_record() hashes */
+  STATS_ADD(records_parsed, 1);
+  scan_record(record, length, feature_vec, [](size_t, const char*, size_t) {});
+}
 
+void hash_records(const RecordSpan* records, size_t num_records, uint64_t* hash_vals) {
+  /* 
+   * Hashes a batch of records the same way as hash_record(), but without updating the stats
+   * counters (they are not atomic), so worker threads can call it. The caller counts the records.
+   */
+  static thread_local std::string feature_vec;
+  for (size_t i = 0; i < num_records; i++) {
+    scan_record(records[i].start, records[i].length, feature_vec, [](size_t, const char*, size_t) {});
+    hash_vals[i] = std::hash<std::string>()(feature_vec);
+  }
+}
 
+uint64_t hash_field(const char* field, size_t length) {
+  /* Hashes the value of a single field (FNV-1a, followed by the MurmurHash3 finalizer to mix the bits) */
+  uint64_t hash_val = 0xcbf29ce484222325;
+  for (size_t i = 0; i < length; i++) {
+    hash_val ^= (uint8_t) field[i];
+    hash_val *= 0x100000001b3;
+  }
+  return MurmurHash3(hash_val);
+}
 
+uint64_t hash_record_columns(const char* record, size_t length, const std::vector<int>& column_slots, 
+                             size_t num_columns, uint64_t* column_hashes) {
+  /* 
+   * Hashes the feature vector of a record (the same value as hash_record()), and in the same pass over
+   * the line hashes each selected column on its own. column_slots maps a field number to its slot in 
+   * column_hashes (-1 if the field is not selected), fields missing from the record count as empty.
+   */
+  static thread_local std::string feature_vec;
+  std::fill(column_hashes, column_hashes + num_columns, hash_field(record, 0));
+  STATS_ADD(records_parsed, 1);
+
+  scan_record(record, length, feature_vec, [&](size_t field_num, const char* field, size_t field_length) {
+    if (field_num < column_slots.size() && column_slots[field_num] >= 0) {
+      column_hashes[column_slots[field_num]] = hash_field(field, field_length);
+    }
+  });
+  return std::hash<std::string>()(feature_vec);
+}
@@ -13,195 +13,324 @@
 #include <zlib.h>
 #include <hash.h>
 #include <pacsketch.h>
+#include <stats.h>
+#include <pcap_reader.h>
+#include <columnar.h>
+#include <sketch_file.h>
 #include <minhash.h> 
 #include <cmath>
 #include <numeric>
 #include <functional>
+#include <array>
+#include <vector>
 
 KSEQ_INIT(gzFile, gzread)
 
-HyperLogLog::HyperLogLog(std::string input_path, uint8_t b, data_type file_type) {
-    /* Constructor for HLL data-structure */
-    
-    // Initialize attributes
-    ref_file.assign(input_path);
-    prefix_bits = b;
-    num_registers = std::pow(2, prefix_bits);
-    input_type = file_type;
-    
-    total_bytes_allocated = TOTAL_REGISTER_SPACE(num_registers);
-    registers = new char[TOTAL_REGISTER_SPACE(num_registers)];
-    initialize_registers();
+/* Register access helpers shared by all the kernels */
+
+static const std::array<double, HASH_SIZE + 1> inverse_powers = [] {
+    // Holds 2^(-x) for every value a register can hold
+    std::array<double, HASH_SIZE + 1> table;
+    for (size_t i = 0; i <= HASH_SIZE; i++) {table[i] = 1.0/std::pow(2, i);}
+    return table;
+}();
+
+static inline uint8_t load_register(const uint8_t* registers, uint64_t register_num) {
+    /* Grabs the value in a specific register, every group of 4 registers shares 3 bytes */
+    const uint8_t* group = registers + (register_num / REGISTERS_PER_GROUP) * BYTES_PER_GROUP;
+    uint32_t packed = ((uint32_t) group[0] << 16) | ((uint32_t) group[1] << 8) | group[2];
+    uint8_t shift = (REGISTERS_PER_GROUP - 1 - (register_num % REGISTERS_PER_GROUP)) * REGISTER_BITS;
+    return (packed >> shift) & REGISTER_VALUE_MASK;
+}
 
-    // Build actual data-structure based on input file
-    switch(file_type) {
-        case FASTA: buildFromFASTA(ref_file, prefix_bits); break;
-        case PACKET: buildFromPackets(ref_file, prefix_bits); break;
-        default: FATAL_WARNING("There appears to be a bug in the code in HLL constructor.\n"); std::exit(1);
-    }
+static inline void store_register(uint8_t* registers, uint64_t register_num, uint8_t new_val) {
+    /* Replaces the value in a specific register, without touching its neighbors */
+    uint8_t* group = registers + (register_num / REGISTERS_PER_GROUP) * BYTES_PER_GROUP;
+    uint32_t packed = ((uint32_t) group[0] << 16) | ((uint32_t) group[1] << 8) | group[2];
+    uint8_t shift = (REGISTERS_PER_GROUP - 1 - (register_num % REGISTERS_PER_GROUP)) * REGISTER_BITS;
+
+    packed = (packed & ~((uint32_t) REGISTER_VALUE_MASK << shift)) | ((uint32_t) new_val << shift);
+    group[0] = packed >> 16; group[1] = packed >> 8; group[2] = packed;
 }
 
-HyperLogLog::HyperLogLog(uint8_t b, data_type file_type) {
-    /* Constructor for HLL data-structure -> used when building union sketch */
+static inline void update_register(uint8_t* registers, uint64_t register_num, uint8_t lzc) {
+    /* Update register number if the current LZC is larger than register */
+    if (lzc > load_register(registers, register_num)) {
+        store_register(registers, register_num, lzc);
+        STATS_ADD(register_updates_accepted, 1);
+    } else {STATS_ADD(register_updates_rejected, 1);}
+}
 
-    // Initialize attributes
-    ref_file.assign("");
-    prefix_bits = b;
-    num_registers = std::pow(2, prefix_bits);
-    input_type = file_type;
-    
-    total_bytes_allocated = TOTAL_REGISTER_SPACE(num_registers);
-    registers = new char[TOTAL_REGISTER_SPACE(num_registers)];
-    initialize_registers();
+// Masks for merging 8 packed registers (6 bytes) at a time, the even and odd registers are handled
+// separately so the empty space between them can hold the borrow bit of each comparison
+#define EVEN_REGISTER_MASK 0x03F03F03F03FULL
+#define EVEN_GUARD_BITS 0x040040040040ULL
+
+static inline uint64_t load_register_chunk(const uint8_t* registers, size_t num_bytes) {
+    /* Loads packed registers as a big-endian value, so every register sits on a multiple of 6 bits */
+    uint64_t chunk = 0;
+    for (size_t i = 0; i < num_bytes; i++) {chunk = (chunk << BITS_PER_BYTE) | registers[i];}
+    return chunk;
 }
 
-HyperLogLog::~HyperLogLog() {
-    /* Deconstructor for HyperLogLog - frees space for HLL */
-    delete registers;
+static inline void store_register_chunk(uint8_t* registers, size_t num_bytes, uint64_t chunk) {
+    /* Stores a value from load_register_chunk() back into the packed registers */
+    for (size_t i = num_bytes; i > 0; i--) {registers[i-1] = chunk; chunk >>= BITS_PER_BYTE;}
 }
 
-void HyperLogLog::initialize_registers() {
-    /* Initializes all the registers to zero */
-    for (size_t i = 0; i < total_bytes_allocated; i++) {
-        registers[i] |= 0x00;
+static inline uint64_t load_register_word(const uint8_t* registers) {
+    /* Loads 8 bytes of packed registers as a big-endian value */
+    uint64_t word;
+    std::memcpy(&word, registers, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static inline void store_register_word(uint8_t* registers, uint64_t word) {
+    /* Stores a value from load_register_word() back into the packed registers */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    std::memcpy(registers, &word, sizeof(word));
+}
+
+static inline uint64_t max_register_lanes(uint64_t op1, uint64_t op2, uint64_t lane_mask, uint64_t guard_bits) {
+    /* Takes the max of every register selected by lane_mask, the registers have an empty register between them */
+    uint64_t lanes_1 = op1 & lane_mask, lanes_2 = op2 & lane_mask;
+    uint64_t is_larger = ((lanes_1 | guard_bits) - lanes_2) & guard_bits; // guard bit survives where op1 >= op2
+    uint64_t take_op1 = is_larger - (is_larger >> REGISTER_BITS); // widens each guard bit to the register below it
+    return (lanes_1 & take_op1) | (lanes_2 & ~take_op1);
+}
+
+static inline void merge_register_bytes(uint8_t* dest, const uint8_t* op1, const uint8_t* op2, size_t num_bytes) {
+    /* 
+     * Takes the max of each pair of packed registers, dest can be one of the operands. Blocks of 32
+     * registers (3 words) are split into four 48-bit chunks of 8 registers, which are merged with SWAR.
+     */
+    auto merge_chunk = [](uint64_t chunk_1, uint64_t chunk_2) {
+        return max_register_lanes(chunk_1, chunk_2, EVEN_REGISTER_MASK, EVEN_GUARD_BITS) |
+               max_register_lanes(chunk_1, chunk_2, EVEN_REGISTER_MASK << REGISTER_BITS, EVEN_GUARD_BITS << REGISTER_BITS);
+    };
+    auto split_block = [](const uint8_t* registers, uint64_t* chunks) {
+        uint64_t word_0 = load_register_word(registers), word_1 = load_register_word(registers + 8), word_2 = load_register_word(registers + 16);
+        chunks[0] = word_0 >> 16;
+        chunks[1] = ((word_0 & 0xFFFF) << 32) | (word_1 >> 32);
+        chunks[2] = ((word_1 & 0xFFFFFFFF) << 16) | (word_2 >> 48);
+        chunks[3] = word_2 & 0xFFFFFFFFFFFF;
+    };
+
+    const size_t block_bytes = 3 * sizeof(uint64_t);
+    size_t offset = 0;
+    for (; offset + block_bytes <= num_bytes; offset += block_bytes) {
+        uint64_t chunks_1[4], chunks_2[4], merged[4];
+        split_block(op1 + offset, chunks_1);
+        split_block(op2 + offset, chunks_2);
+        for (size_t i = 0; i < 4; i++) {merged[i] = merge_chunk(chunks_1[i], chunks_2[i]);}
+
+        store_register_word(dest + offset, (merged[0] << 16) | (merged[1] >> 32));
+        store_register_word(dest + offset + 8, (merged[1] << 32) | (merged[2] >> 16));
+        store_register_word(dest + offset + 16, (merged[2] << 48) | merged[3]);
+    }
+
+    // Sketches with fewer than 32 registers are merged one group of 4 registers at a time
+    for (; offset < num_bytes; offset += BYTES_PER_GROUP) {
+        uint64_t merged = merge_chunk(load_register_chunk(op1 + offset, BYTES_PER_GROUP), load_register_chunk(op2 + offset, BYTES_PER_GROUP));
+        store_register_chunk(dest + offset, BYTES_PER_GROUP, merged);
     }
 }
 
-uint8_t HyperLogLog::grab_register(uint64_t register_num) {
-    /* Grabs the value in a specific register, the complexity comes from the
-       fact the register can span byte boundaries */
-    
-    // Determine where in the memory registers we need to check
-    uint64_t start_bit = register_num * REGISTER_BITS;
-    uint64_t end_bit = (register_num+1) * REGISTER_BITS;
+static inline void prefetch_register(const uint8_t* registers, uint64_t register_num) {
+    /* Brings the group holding a register into cache ahead of its update */
+    __builtin_prefetch(registers + (register_num / REGISTERS_PER_GROUP) * BYTES_PER_GROUP, 1);
+}
 
-    uint64_t start_byte = start_bit/BITS_PER_BYTE;
-    uint64_t end_byte = end_bit/BITS_PER_BYTE;
+static inline uint64_t finalize_cardinality(double z, size_t num_zero, size_t m, double alpha) {
+    /* Applies the bias factor and range corrections from the HLL paper */
+    size_t cardinality = alpha * m * m * (1/z);
 
-    // Extract register from memory, approach depends if it spans byte
-    // boundary or not.
-    if (start_byte != end_byte && (end_bit % BITS_PER_BYTE != 0)) { 
+    // Now, lets check if any of the corrections apply ...
+    if (cardinality <= 2.5 * m && num_zero) {cardinality = m * std::log((double) m/num_zero);} // linear counting
+    if (cardinality > (1/30.0) * std::pow(2, 32)) {cardinality = -1 * std::pow(2, 32) * std::log2(1 - (cardinality/std::pow(2, 32)));}
+    return cardinality;
+}
 
-        // I added second condition, because it technically spaces byte
-        // boundaries, but it completely fits in one byte, it is just the
-        // fact that the end_bit is not-inclusive is why it appears that
-        // it spans boundaries.
+constexpr double hll_alpha(uint64_t m) {
+    /* Determine the bias factor (alpha) based on m */
+    return (m <= 16) ? 0.673 : (m == 32) ? 0.697 : (m == 64) ? 0.709 : (0.7213/(1 + (1.079/m)));
+}
 
-        uint8_t curr_lsb_byte = registers[start_byte];
-        uint8_t curr_msb_byte = registers[end_byte];
+/* Specialized kernels: every constant that depends on b is known at compile-time */
+
+template <uint8_t B>
+struct HLLPrecision {
+    static constexpr uint64_t num_registers = (uint64_t) 1 << B;
+    static constexpr uint64_t num_groups = num_registers / REGISTERS_PER_GROUP;
+    static constexpr uint64_t register_mask = GRAB_REGISTER_MASK(B);
+    static constexpr uint64_t remaining_mask = ~register_mask;
+    static constexpr double alpha = hll_alpha(num_registers);
+};
+
+template <uint8_t B>
+inline void insert_hash_kernel(uint8_t* registers, uint8_t, uint64_t hash_val) {
+    /* Parse the hash value to get register num, and lead zero count (lzc) */
+    uint64_t register_num = GRAB_REGISTER_NUM(HLLPrecision<B>::register_mask, hash_val, B);
+    uint64_t remaining_bits = GRAB_REMAINING_BITS(hash_val, HLLPrecision<B>::remaining_mask, B);
+    update_register(registers, register_num, DETERMINE_LZC(remaining_bits, B));
+}
 
-        uint8_t num_lsb = 0;
-        for (size_t i = start_bit; i < end_bit; i++) {
-            if (i % BITS_PER_BYTE == 0) {break;}
-            num_lsb++;
+template <uint8_t B>
+void insert_hashes_kernel(uint8_t* registers, uint8_t b, const uint64_t* hash_vals, size_t num_hashes) {
+    /* 
+     * Inserts a batch of hashes, the per-hash kernel is inlined into this loop. Once the registers
+     * outgrow L1, the register of a hash a few positions ahead is prefetched, so the misses overlap.
+     */
+    for (size_t i = 0; i < num_hashes; i++) {
+        if (B >= HLL_PREFETCH_MIN_PREFIX && i + HLL_PREFETCH_DISTANCE < num_hashes) {
+            prefetch_register(registers, GRAB_REGISTER_NUM(HLLPrecision<B>::register_mask, hash_vals[i + HLL_PREFETCH_DISTANCE], B));
         }
-        uint8_t num_msb = REGISTER_BITS - num_lsb;
-        
-        uint8_t grabbed_lsb = GRAB_LSB_REGISTER(curr_lsb_byte, num_lsb);
-        uint8_t grabbed_msb = GRAB_MSB_REGISTER(curr_msb_byte, num_msb);
-        uint8_t curr_register = COMBINE_LSB_MSB(grabbed_lsb, grabbed_msb, num_msb);
-        return curr_register;
-        
-    } else {
-        uint8_t curr_full_byte = registers[start_byte];
-        uint8_t bits_to_right = 0;
-        size_t i = end_bit;
-
-        while (i % BITS_PER_BYTE != 0) {i++; bits_to_right++;}
-        uint8_t bits_to_left = (BITS_PER_BYTE - bits_to_right - REGISTER_BITS);
-
-        // Move to left to drop MSB, and then shift to right to align to left.
-        uint8_t curr_register = PUSH_TO_LEFT(curr_full_byte, bits_to_left);
-        curr_register = PUSH_TO_RIGHT(curr_register, bits_to_left+bits_to_right);
-        return curr_register;
+        insert_hash_kernel<B>(registers, b, hash_vals[i]);
     }
 }
 
-void HyperLogLog::clear_register(uint64_t register_num) {
-    /* Clear the register to all zeros to be able to set the value */
+template <uint8_t B>
+void merge_kernel(uint8_t* dest, const uint8_t* op1, const uint8_t* op2, uint8_t) {
+    /* Takes the max of each pair of registers, and stores it in dest */
+    merge_register_bytes(dest, op1, op2, TOTAL_REGISTER_SPACE(HLLPrecision<B>::num_registers));
+}
 
-    // Determine where in the memory registers we need to check
-    uint64_t start_bit = register_num * REGISTER_BITS;
-    uint64_t end_bit = (register_num+1) * REGISTER_BITS;
+template <uint8_t B>
+uint64_t cardinality_kernel(const uint8_t* registers, uint8_t) {
+    /* Computes the Z value from the HLL paper, and applies the corrections */
+    double z = 0.0;
+    size_t num_zero = 0;
+    for (uint64_t i = 0; i < HLLPrecision<B>::num_registers; i++) {
+        uint8_t curr_lzc = load_register(registers, i);
+        num_zero += (curr_lzc == 0);
+        z += inverse_powers[curr_lzc];
+    }
+    return finalize_cardinality(z, num_zero, HLLPrecision<B>::num_registers, HLLPrecision<B>::alpha);
+}
 
-    uint64_t start_byte = start_bit/BITS_PER_BYTE;
-    uint64_t end_byte = end_bit/BITS_PER_BYTE;
+/* Generic kernels: used for values of b outside of the specialized range */
 
-    // Extract register from memory, approach depends if it spans byte
-    // boundary or not.
-    if (start_byte != end_byte && (end_bit % BITS_PER_BYTE != 0)) { 
+static void insert_hash_generic(uint8_t* registers, uint8_t b, uint64_t hash_val) {
+    uint64_t mask = GRAB_REGISTER_MASK(b);
+    uint64_t register_num = GRAB_REGISTER_NUM(mask, hash_val, b);
+    uint64_t remaining_bits = GRAB_REMAINING_BITS(hash_val, ~mask, b);
+    update_register(registers, register_num, DETERMINE_LZC(remaining_bits, b));
+}
 
-        // I added second condition, because it technically spaces byte
-        // boundaries, but it completely fits in one byte, it is just the
-        // fact that the end_bit is not-inclusive is why it appears that
-        // it spans boundaries.
+static void insert_hashes_generic(uint8_t* registers, uint8_t b, const uint64_t* hash_vals, size_t num_hashes) {
+    uint64_t mask = GRAB_REGISTER_MASK(b);
+    for (size_t i = 0; i < num_hashes; i++) {
+        if (b >= HLL_PREFETCH_MIN_PREFIX && i + HLL_PREFETCH_DISTANCE < num_hashes) {
+            prefetch_register(registers, GRAB_REGISTER_NUM(mask, hash_vals[i + HLL_PREFETCH_DISTANCE], b));
+        }
+        insert_hash_generic(registers, b, hash_vals[i]);
+    }
+}
 
-        uint8_t curr_lsb_byte = registers[start_byte];
-        uint8_t curr_msb_byte = registers[end_byte];
+static void merge_generic(uint8_t* dest, const uint8_t* op1, const uint8_t* op2, uint8_t b) {
+    merge_register_bytes(dest, op1, op2, TOTAL_REGISTER_SPACE((uint64_t) 1 << b));
+}
 
-        uint8_t num_lsb = 0;
-        for (size_t i = start_bit; i < end_bit; i++) {
-            if (i % BITS_PER_BYTE == 0) {break;}
-            num_lsb++;
-        }
-        uint8_t num_msb = REGISTER_BITS - num_lsb;
-        
-        uint8_t new_lsb_byte = CLEAR_LSB_REGISTER(curr_lsb_byte, num_lsb);
-        uint8_t new_msb_byte = CLEAR_MSB_REGISTER(curr_msb_byte, num_msb);
-
-        registers[start_byte] = new_lsb_byte;
-        registers[end_byte] = new_msb_byte;     
-    } else {
-        uint8_t curr_full_byte = registers[start_byte];
-        uint8_t bits_to_right = 0;
-        size_t i = end_bit;
-
-        while (i % BITS_PER_BYTE != 0) {i++; bits_to_right++;}
-        uint8_t bits_to_left = (BITS_PER_BYTE - bits_to_right - REGISTER_BITS);
-
-        // Clear the register within this byte, and replace it
-        uint8_t new_curr_register = CLEAR_WITHIN_REGISTER(curr_full_byte, bits_to_right);
-        registers[start_byte] = new_curr_register;
+static uint64_t cardinality_generic(const uint8_t* registers, uint8_t b) {
+    uint64_t m = (uint64_t) 1 << b;
+    double z = 0.0;
+    size_t num_zero = 0;
+    for (uint64_t i = 0; i < m; i++) {
+        uint8_t curr_lzc = load_register(registers, i);
+        num_zero += (curr_lzc == 0);
+        z += inverse_powers[curr_lzc];
     }
+    return finalize_cardinality(z, num_zero, m, hll_alpha(m));
+}
 
+#define SPECIALIZED_KERNELS(x) {insert_hash_kernel<x>, insert_hashes_kernel<x>, merge_kernel<x>, cardinality_kernel<x>}
+
+static const HLLKernels specialized_kernels[] = {
+    SPECIALIZED_KERNELS(4),  SPECIALIZED_KERNELS(5),  SPECIALIZED_KERNELS(6),  SPECIALIZED_KERNELS(7),
+    SPECIALIZED_KERNELS(8),  SPECIALIZED_KERNELS(9),  SPECIALIZED_KERNELS(10), SPECIALIZED_KERNELS(11),
+    SPECIALIZED_KERNELS(12), SPECIALIZED_KERNELS(13), SPECIALIZED_KERNELS(14), SPECIALIZED_KERNELS(15),
+    SPECIALIZED_KERNELS(16), SPECIALIZED_KERNELS(17), SPECIALIZED_KERNELS(18)
+};
+static const HLLKernels generic_kernels = {insert_hash_generic, insert_hashes_generic, merge_generic, cardinality_generic};
+
+static_assert(sizeof(specialized_kernels)/sizeof(HLLKernels) == MAX_SPECIALIZED_PREFIX - MIN_SPECIALIZED_PREFIX + 1,
+              "there should be one set of kernels for each specialized value of b");
+
+const HLLKernels* select_hll_kernels(uint8_t b) {
+    /* Returns the kernels to use for a given b, this is the only place b is checked */
+    if (b >= MIN_SPECIALIZED_PREFIX && b <= MAX_SPECIALIZED_PREFIX) {
+        return &specialized_kernels[b - MIN_SPECIALIZED_PREFIX];
+    }
+    return &generic_kernels;
 }
 
-void HyperLogLog::set_register(uint64_t register_num, uint8_t lzc) {
-    /* Replaces register with value of new largest LZC for that bucket */
+HyperLogLog::HyperLogLog(std::string input_path, uint8_t b, data_type file_type, pcap_key_type pcap_key) {
+    /* Constructor for HLL data-structure */
+    
+    // Initialize attributes
+    ref_file.assign(input_path);
+    prefix_bits = b;
+    num_registers = (uint64_t) 1 << prefix_bits;
+    input_type = file_type;
+    hash_id = compute_hash_id(file_type, pcap_key);
+    kernels = select_hll_kernels(prefix_bits);
+    allocate_registers();
 
-    // Determine where in the memory registers we need to check
-    uint64_t start_bit = register_num * REGISTER_BITS;
-    uint64_t end_bit = (register_num+1) * REGISTER_BITS;
+    // Build actual data-structure based on input file
+    switch(file_type) {
+        case FASTA: buildFromFASTA(ref_file, prefix_bits); break;
+        case PACKET: buildFromPackets(ref_file, prefix_bits); break;
+        case PCAP: buildFromPcap(ref_file, pcap_key); break;
+        default: FATAL_WARNING("There appears to be a bug in the code in HLL constructor.\n"); std::exit(1);
+    }
+}
 
-    uint64_t start_byte = start_bit/BITS_PER_BYTE;
-    uint64_t end_byte = end_bit/BITS_PER_BYTE;
+HyperLogLog::HyperLogLog(uint8_t b, data_type file_type, pcap_key_type pcap_key) {
+    /* Constructor for HLL data-structure -> used when building union sketch, or one hash at a time */
+
+    // Initialize attributes
+    ref_file.assign("");
+    prefix_bits = b;
+    num_registers = (uint64_t) 1 << prefix_bits;
+    input_type = file_type;
+    hash_id = compute_hash_id(file_type, pcap_key);
+    kernels = select_hll_kernels(prefix_bits);
+    allocate_registers();
+}
 
-    if (start_byte != end_byte && (end_bit % BITS_PER_BYTE != 0)) { // register traverses byte boundaries
-        // I added second condition, because it technically spaces byte
-        // boundaries, but it completely fits in one byte, it is just the
-        // fact that the end_bit is not-inclusive is why it appears that
-        // it spans boundaries.
+void HyperLogLog::allocate_registers() {
+    /* Allocates the register array on a cache line boundary, and zeroes it */
+    total_bytes_allocated = TOTAL_REGISTER_SPACE(num_registers);
+    total_bytes_allocated = ((total_bytes_allocated + HLL_REGISTER_ALIGNMENT - 1)/HLL_REGISTER_ALIGNMENT) * HLL_REGISTER_ALIGNMENT;
 
-        uint8_t num_lsb = 0;
-        for (size_t i = start_bit; i < end_bit; i++) {
-            if (i % BITS_PER_BYTE == 0) {break;}
-            num_lsb++;
-        }
-        uint8_t num_msb = REGISTER_BITS - num_lsb;
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, HLL_REGISTER_ALIGNMENT, total_bytes_allocated) != 0) {throw std::bad_alloc();}
+    registers.reset(static_cast<uint8_t*>(ptr));
+    initialize_registers();
+}
 
-        uint8_t lsb_byte = GENERATE_LSB_BYTE(lzc, num_lsb);
-        uint8_t msb_byte = GENERATE_MSB_BYTE(lzc, num_msb);
+void HyperLogLog::initialize_registers() {
+    /* Initializes all the registers (and the padding after them) to zero */
+    std::memset(registers.get(), 0x00, total_bytes_allocated);
+}
 
-        registers[start_byte] |= lsb_byte;
-        registers[end_byte] |= msb_byte;        
-    } else {
-        uint8_t bits_to_right = 0;
-        size_t i = end_bit;
-        while (i % BITS_PER_BYTE != 0) {i++; bits_to_right++;}
+HyperLogLog HyperLogLog::clone() const {
+    /* Returns a deep copy of the sketch, with its own register array */
+    HyperLogLog copy_sketch (this->prefix_bits, this->input_type);
+    copy_sketch.ref_file = this->ref_file;
+    copy_sketch.hash_id = this->hash_id;
+    std::memcpy(copy_sketch.registers.get(), this->registers.get(), total_bytes_allocated);
+    return copy_sketch;
+}
 
-        uint8_t byte_val = PUSH_TO_LEFT(lzc, bits_to_right);
-        registers[start_byte] |= byte_val;
-    }
+void HyperLogLog::reset() {
+    /* Empties the sketch so it can be reused, the register array is kept */
+    initialize_registers();
 }
 
 void HyperLogLog::buildFromFASTA(std::string input_path, uint8_t m) {
@@ -210,104 +339,256 @@ void HyperLogLog::buildFromFASTA(std::string input_path, uint8_t m) {
     kseq_t* ks = kseq_init(fp);
     
     while (kseq_read(ks) >= 0) {
-        size_t kmer_length = 11;
-        char curr_kmer[kmer_length + 1];
-        for (size_t i = 0; i <= ks->seq.l-kmer_length; i++) {
-            // Grab and encode kmer, and hash it
-            memcpy(curr_kmer, &ks->seq.s[i], kmer_length);
-            uint64_t encoded_kmer = encode_string(curr_kmer);
-            uint64_t curr_kmer_hash = MurmurHash3(encoded_kmer);
-
-            // Parse the hash value to get register num, and lead zero count (lzc)
-            uint64_t mask = GRAB_REGISTER_MASK(prefix_bits);
-            uint64_t register_num = GRAB_REGISTER_NUM(mask, curr_kmer_hash, prefix_bits);
-
-            uint64_t remaining_mask = ~mask;
-            uint64_t remaining_bits = GRAB_REMAINING_BITS(curr_kmer_hash, remaining_mask, prefix_bits);
-            uint8_t  lzc = DETERMINE_LZC(remaining_bits);
-
-            // Update register number if the current LZC is larger than register
-            uint8_t register_value = grab_register(register_num);
-            if (lzc > register_value) {
-                clear_register(register_num);
-                set_register(register_num, lzc);
-            }
-        }
+        STATS_ADD(bytes_read, ks->seq.l);
+        add_sequence(ks->seq.s, ks->seq.l);
     }
+    kseq_destroy(ks);
+    gzclose(fp);
 }
 
-uint64_t HyperLogLog::compute_cardinality() {
-    /* Computes cardinality of HLL sketch and returns it */
+void HyperLogLog::add_hash(uint64_t hash_val) {
+    /* Inserts a single hash value into the sketch */
+    kernels->insert_hash(registers.get(), prefix_bits, hash_val);
+}
 
-    // Start by calculating the Z value from the HLL paper
-    double z = 0.0;
-    size_t num_zero = 0;
-    for (size_t i = 0; i < num_registers; i++) {
-        uint8_t curr_lzc = grab_register(i);
-        if (curr_lzc == 0) {num_zero++;}
-        z += (1.0/std::pow(2, curr_lzc));
-    }
+void HyperLogLog::add_hashes(const uint64_t* hash_vals, size_t num_hashes) {
+    /* Inserts a batch of hash values into the sketch */
+    kernels->insert_hashes(registers.get(), prefix_bits, hash_vals, num_hashes);
+}
 
-    // Determine the bias factor (alpha) based on m
-    size_t m = std::pow(2, prefix_bits);
-    double alpha = 0.0;
-    if (m <= 16) {alpha = 0.673;}
-    else if (m == 32) {alpha = 0.697;}
-    else if (m == 64) {alpha = 0.709;}
-    else {alpha = (0.7213/(1 + (1.079/m)));}
+void HyperLogLog::add_record(const char* record, size_t length) {
+    /* Inserts a connection record (one line of packet data) into the sketch */
+    kernels->insert_hash(registers.get(), prefix_bits, hash_record(record, length));
+}
 
-    // Put together the final factors
-    size_t cardinality = alpha * m * m * (1/z);
+void HyperLogLog::add_sequence(const char* seq, size_t length) {
+    /* Inserts every k-mer of a DNA sequence into the sketch */
+    STATS_ADD(kmers_parsed, (length >= FASTA_KMER_LENGTH) ? length - FASTA_KMER_LENGTH + 1 : 0);
+
+    // Hashes are inserted in batches, so the register updates run in a tight loop
+    uint64_t hash_batch[HLL_HASH_BATCH_SIZE];
+    size_t batch_size = 0;
+    for_each_kmer_hash(seq, length, FASTA_KMER_LENGTH, [&](uint64_t hash_val) {
+        hash_batch[batch_size++] = hash_val;
+        if (batch_size == HLL_HASH_BATCH_SIZE) {add_hashes(hash_batch, batch_size); batch_size = 0;}
+    });
+    add_hashes(hash_batch, batch_size);
+}
 
-    // Now, lets check if any of the corrections apply ...
-    if (cardinality <= 2.5 * m && num_zero) {cardinality = m * std::log2(m/num_zero);}
-    if (cardinality > (1/30.0) * std::pow(2, 32)) {cardinality = -1 * std::pow(2, 32) * std::log2(1 - (cardinality/std::pow(2, 32)));}
-    return cardinality;
+uint64_t HyperLogLog::compute_cardinality() const {
+    /* Computes cardinality of HLL sketch and returns it */
+    return kernels->cardinality(registers.get(), prefix_bits);
+}
+
+uint64_t HyperLogLog::get_memory_usage() const {
+    /* Returns the bytes allocated for the registers (including the padding to a cache line) */
+    return total_bytes_allocated;
 }
 
 void HyperLogLog::buildFromPackets(std::string input_path, uint8_t m) {
-    /* Builds the HLL from a Packet Data */
+    /* 
+     * Builds the HLL from a Packet Data, the hashes of a columnar file are inserted straight from the
+     * mapping, and text records are hashed into batches so the register updates can be prefetched.
+     */
+    if (is_columnar_file(input_path.data())) {
+        ColumnarFile columnar_input (input_path);
+        add_hashes(columnar_input.get_record_hashes(), columnar_input.get_num_records());
+        return;
+    }
     std::ifstream input_data (input_path, std::ifstream::in);
-    std::hash<std::string> hasher;
+    uint64_t hash_batch[HLL_HASH_BATCH_SIZE];
+    size_t batch_size = 0;
      
     for (std::string line; std::getline(input_data, line);) {
-        auto word_list = split(line, ',');
-        word_list.pop_back(); // Removes the label
-
-        std::string feature_vec = "";
-        std::for_each(word_list.begin(), word_list.end(), [&](const std::string &word){feature_vec += word + "_";});
-        auto hash_val = hasher(feature_vec);
-
-        // Parse the hash value to get register num, and lead zero count (lzc)
-        uint64_t mask = GRAB_REGISTER_MASK(prefix_bits);
-        uint64_t register_num = GRAB_REGISTER_NUM(mask, hash_val, prefix_bits);
-
-        uint64_t remaining_mask = ~mask;
-        uint64_t remaining_bits = GRAB_REMAINING_BITS(hash_val, remaining_mask, prefix_bits);
-        uint8_t  lzc = DETERMINE_LZC(remaining_bits);
-
-        // Update register number if the current LZC is larger than register
-        uint8_t register_value = grab_register(register_num);
-        if (lzc > register_value) {
-            clear_register(register_num);
-            set_register(register_num, lzc);
-        }
+        STATS_ADD(bytes_read, line.length() + 1);
+        size_t length = line.length() - (!line.empty() && line.back() == '\r');
+        if (!length) {continue;} // empty lines are skipped, like index_records()
+        hash_batch[batch_size++] = hash_record(line.data(), length);
+        if (batch_size == HLL_HASH_BATCH_SIZE) {add_hashes(hash_batch, batch_size); batch_size = 0;}
+    }
+    add_hashes(hash_batch, batch_size);
+}
+
+void HyperLogLog::buildFromPcap(std::string input_path, pcap_key_type pcap_key) {
+    /* Builds the HLL from the packets of a pcap/pcapng capture, the keys are inserted in batches */
+    PcapReader pcap_reader (input_path);
+    PacketHeaders headers;
+    uint64_t hash_batch[HLL_HASH_BATCH_SIZE];
+    size_t batch_size = 0;
+
+    while (pcap_reader.next_packet(&headers)) {
+        hash_batch[batch_size++] = hash_packet_key(headers, pcap_key);
+        if (batch_size == HLL_HASH_BATCH_SIZE) {add_hashes(hash_batch, batch_size); batch_size = 0;}
     }
+    add_hashes(hash_batch, batch_size);
 }
 
-HyperLogLog HyperLogLog::operator +(HyperLogLog& operand) {
+double HyperLogLog::compute_jaccard(uint64_t card_a, uint64_t card_b, uint64_t card_union) {
+    /* Estimates the jaccard from the cardinalities of two HLLs and their union (inclusion-exclusion) */
+    auto jaccard = std::max(card_a + card_b - card_union + 0.0, 0.0)/(card_union);
+    if (card_union > (card_a + card_b)) {jaccard = 0.0;} // Check for overflow
+    return jaccard;
+}
+
+HyperLogLog HyperLogLog::operator +(const HyperLogLog& operand) const {
     /* Creates the union HLL from two HLLs */
+    if (!is_compatible(operand)) {THROW_EXCEPTION("HyperLogLog sketches with different values of b, or different input hashes, cannot be merged.");}
     HyperLogLog union_sketch (this->prefix_bits, this->input_type);
+    union_sketch.hash_id = this->hash_id;
     
-    // Build actual sketch by iterating through registers and getting max
-    for (size_t i = 0; i < num_registers; i++) {
-        uint8_t val1 = this->grab_register(i);
-        uint8_t val2 = operand.grab_register(i);
+    // Build actual sketch by taking the max of each pair of registers
+    kernels->merge(union_sketch.registers.get(), this->registers.get(), operand.registers.get(), prefix_bits);
+    return union_sketch;
+}
 
-        uint8_t max = std::max(val1, val2);
-        union_sketch.set_register(i, max); // This is how to union-ize two HLL sketches
+HyperLogLog& HyperLogLog::operator +=(const HyperLogLog& operand) {
+    /* Unions another HLL into this one, in place */
+    if (!is_compatible(operand)) {THROW_EXCEPTION("HyperLogLog sketches with different values of b, or different input hashes, cannot be merged.");}
+    kernels->merge(registers.get(), registers.get(), operand.registers.get(), prefix_bits);
+    return *this;
+}
+
+void HyperLogLog::assign_union(const HyperLogLog& op1, const HyperLogLog& op2) {
+    /* Overwrites this HLL with the union of two HLLs, so a sketch can be reused for many unions without allocating */
+    if (!is_compatible(op1) || !is_compatible(op2)) {THROW_EXCEPTION("HyperLogLog sketches with different values of b, or different input hashes, cannot be merged.");}
+    kernels->merge(registers.get(), op1.registers.get(), op2.registers.get(), prefix_bits);
+}
+
+bool HyperLogLog::is_compatible(const HyperLogLog& operand) const {
+    /* Checks whether two HLLs hold registers of the same size, filled from the same kind of hashes */
+    return prefix_bits == operand.prefix_bits && hash_id == operand.hash_id;
+}
+
+SketchFileHeader HyperLogLog::get_file_header() const {
+    /* Fills in the header of the serialized sketch, the payload is the packed register array */
+    SketchFileHeader header = SketchFileHeader();
+    header.sketch = HLL;
+    header.input_type = input_type;
+    header.hash_id = hash_id;
+    header.parameter = prefix_bits;
+    header.payload_size = TOTAL_REGISTER_SPACE(num_registers);
+    return header;
+}
+
+static bool is_valid_hll_header(const SketchFileHeader& header) {
+    /* Checks that the payload of a serialized sketch is the register array of a supported value of b */
+    return header.parameter > 0 && header.parameter < HASH_SIZE && header.payload_size == TOTAL_REGISTER_SPACE((uint64_t) 1 << header.parameter);
+}
+
+void HyperLogLog::write_to_file(const std::string& file_path, uint64_t input_offset, uint64_t input_fingerprint) const {
+    /* Serializes the sketch to a file */
+    SketchFileHeader header = get_file_header();
+    header.input_offset = input_offset;
+    header.input_fingerprint = input_fingerprint;
+    write_sketch_file(file_path, header, registers.get());
+}
+
+void HyperLogLog::serialize(std::vector<char>* buffer) const {
+    /* Serializes the sketch into memory, in the same format as write_to_file() */
+    write_sketch_buffer(get_file_header(), registers.get(), buffer);
+}
+
+HyperLogLog HyperLogLog::read_from_file(const std::string& file_path) {
+    /* Loads a sketch written by write_to_file(), the registers are read straight into the aligned array */
+    SketchFileHeader header;
+    int input_fd = open_sketch_file(file_path, HLL, &header);
+    if (!is_valid_hll_header(header)) {
+        THROW_EXCEPTION(("The following HyperLogLog sketch file is truncated or corrupt: " + file_path).data());
     }
-    return union_sketch;
+
+    HyperLogLog loaded_sketch (header.parameter, (data_type) header.input_type);
+    loaded_sketch.ref_file = file_path;
+    loaded_sketch.hash_id = header.hash_id;
+    read_sketch_payload(input_fd, file_path, loaded_sketch.registers.get(), header.payload_size);
+    return loaded_sketch;
+}
+
+std::unique_ptr<HyperLogLog> HyperLogLog::deserialize(const void* buffer, size_t buffer_size) {
+    /* Loads a sketch from memory, written by serialize() or read from a sketch file, it returns an empty pointer if the bytes are not a valid sketch */
+    SketchFileHeader header;
+    const char* payload = parse_sketch_buffer(buffer, buffer_size, HLL, &header);
+    if (payload == NULL || !is_valid_hll_header(header)) {return nullptr;}
+
+    std::unique_ptr<HyperLogLog> loaded_sketch (new HyperLogLog(header.parameter, (data_type) header.input_type));
+    loaded_sketch->hash_id = header.hash_id;
+    std::memcpy(loaded_sketch->registers.get(), payload, header.payload_size);
+    return loaded_sketch;
+}
+
+ConcurrentHyperLogLog::ConcurrentHyperLogLog(uint8_t b, data_type file_type, pcap_key_type pcap_key) {
+    /* Constructor for the concurrent HLL, every register starts at zero */
+    prefix_bits = b;
+    num_registers = (uint64_t) 1 << prefix_bits;
+    input_type = file_type;
+    hash_id = compute_hash_id(file_type, pcap_key);
+
+    registers.reset(new std::atomic<uint8_t>[num_registers]);
+    for (uint64_t i = 0; i < num_registers; i++) {registers[i].store(0, std::memory_order_relaxed);}
+}
+
+void ConcurrentHyperLogLog::add_hash(uint64_t hash_val) {
+    /* 
+     * Inserts a single hash value, it can be called from any number of threads. The updates are
+     * relaxed, since a register only ever grows, and the threads are joined before snapshot().
+     */
+    uint64_t register_mask = GRAB_REGISTER_MASK(prefix_bits);
+    uint64_t register_num = GRAB_REGISTER_NUM(register_mask, hash_val, prefix_bits);
+    uint8_t lzc = DETERMINE_LZC(GRAB_REMAINING_BITS(hash_val, ~register_mask, prefix_bits), prefix_bits);
+
+    std::atomic<uint8_t>& curr_register = registers[register_num];
+    uint8_t curr_val = curr_register.load(std::memory_order_relaxed);
+    while (lzc > curr_val && !curr_register.compare_exchange_weak(curr_val, lzc, std::memory_order_relaxed)) {}
+}
+
+void ConcurrentHyperLogLog::add_hashes(const uint64_t* hash_vals, size_t num_hashes) {
+    /* Inserts a batch of hash values, it can be called from any number of threads */
+    for (size_t i = 0; i < num_hashes; i++) {add_hash(hash_vals[i]);}
+}
+
+HyperLogLog ConcurrentHyperLogLog::snapshot() const {
+    /* Packs the registers into a regular HLL, to estimate the cardinality, merge or write it to a file */
+    HyperLogLog packed_sketch (prefix_bits, input_type);
+    packed_sketch.hash_id = hash_id;
+    for (uint64_t i = 0; i < num_registers; i++) {
+        store_register(packed_sketch.registers.get(), i, registers[i].load(std::memory_order_relaxed));
+    }
+    return packed_sketch;
+}
+
+
+std::vector<HyperLogLog> build_column_sketches(const std::vector<RecordSpan>& records, const std::vector<size_t>& columns, uint8_t b) {
+    /* 
+     * Builds one HLL per selected column, plus one more (the last one) for the whole feature 
+     * vector, parsing each record only once. The hashes are buffered per sketch, and inserted 
+     * in batches so the register updates still run in a tight loop.
+     */
+    size_t num_columns = columns.size();
+    std::vector<int> column_slots;
+    for (size_t i = 0; i < num_columns; i++) {
+        if (columns[i] >= column_slots.size()) {column_slots.resize(columns[i] + 1, -1);}
+        column_slots[columns[i]] = i;
+    }
+
+    std::vector<HyperLogLog> sketches;
+    for (size_t i = 0; i <= num_columns; i++) {sketches.emplace_back(b, PACKET);}
+
+    // Batches are stored as [sketch][batch position], the record hashes go in the last batch
+    std::vector<uint64_t> hash_batches ((num_columns + 1) * HLL_HASH_BATCH_SIZE);
+    size_t batch_size = 0;
+    auto flush_batches = [&]() {
+        for (size_t i = 0; i <= num_columns; i++) {sketches[i].add_hashes(&hash_batches[i * HLL_HASH_BATCH_SIZE], batch_size);}
+        batch_size = 0;
+    };
+
+    std::vector<uint64_t> column_hashes (num_columns);
+    for (const RecordSpan& record: records) {
+        uint64_t record_hash = hash_record_columns(record.start, record.length, column_slots, num_columns, column_hashes.data());
+        for (size_t i = 0; i < num_columns; i++) {hash_batches[i * HLL_HASH_BATCH_SIZE + batch_size] = column_hashes[i];}
+        hash_batches[num_columns * HLL_HASH_BATCH_SIZE + batch_size] = record_hash;
+        if (++batch_size == HLL_HASH_BATCH_SIZE) {flush_batches();}
+    }
+    flush_batches();
+    return sketches;
 }
 
 
@@ -321,4 +602,3 @@ int main (int argc, char** argv) {
     std::cout << curr_sketch.compute_cardinality() << std::endl;
 }
 */
-
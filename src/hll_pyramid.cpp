@@ -0,0 +1,228 @@
+/*
+ * Name: hll_pyramid.cpp
+ * Description: Contains the multi-resolution window pyramid of HyperLogLog sketches, where the
+ *              coarser windows are merged from the finer ones as they complete, and any range of
+ *              windows is answered by merging a few stored sketches instead of re-reading records.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <hll_pyramid.h>
+
+static bool parse_number_list(const std::string& number_list, std::vector<uint64_t>* numbers) {
+    /* Parses a comma-separated list of non-negative numbers */
+    numbers->clear();
+    size_t token_start = 0;
+    while (token_start <= number_list.length()) {
+        size_t token_end = std::min(number_list.find(',', token_start), number_list.length());
+        std::string token = number_list.substr(token_start, token_end - token_start);
+        token_start = token_end + 1;
+        if (token.empty() || !std::all_of(token.begin(), token.end(), ::isdigit)) {return false;}
+        numbers->push_back(std::strtoull(token.data(), NULL, 10));
+    }
+    return true;
+}
+
+bool parse_pyramid_factors(const std::string& factor_list, std::vector<uint64_t>* level_factors) {
+    /* Parses the windows of each level that make up one window of the next level (e.g. 10,6,10), level 0 gets a factor of 1 */
+    std::vector<uint64_t> factors;
+    if (!parse_number_list(factor_list, &factors) || factors.size() > MAX_PYRAMID_LEVELS - 1) {return false;}
+
+    uint64_t level_span = 1;
+    for (uint64_t factor: factors) {
+        if (factor < 2 || level_span > UINT32_MAX / factor) {return false;} // keeps the span of the top level small
+        level_span *= factor;
+    }
+    level_factors->assign(1, 1);
+    level_factors->insert(level_factors->end(), factors.begin(), factors.end());
+    return true;
+}
+
+bool parse_window_range(const std::string& range, uint64_t* range_start, uint64_t* range_end) {
+    /* Parses a START:END range of finest windows, the end is exclusive */
+    size_t split_pos = range.find(':');
+    std::vector<uint64_t> start_value, end_value;
+    if (split_pos == std::string::npos || !parse_number_list(range.substr(0, split_pos), &start_value) ||
+        !parse_number_list(range.substr(split_pos + 1), &end_value) || start_value.size() != 1 || end_value.size() != 1) {
+        return false;
+    }
+    *range_start = start_value[0];
+    *range_end = end_value[0];
+    return *range_start < *range_end;
+}
+
+uint64_t PyramidLayout::get_level_span(size_t level) const {
+    /* Returns the number of finest windows that make up one window of a level */
+    uint64_t level_span = 1;
+    for (size_t i = 1; i <= level; i++) {level_span *= level_factors[i];}
+    return level_span;
+}
+
+std::string get_pyramid_window_path(const std::string& dir_path, size_t level, uint64_t window_num) {
+    /* Returns the path of the sketch file of a window */
+    return dir_path + "/L" + std::to_string(level) + "_" + std::to_string(window_num) + ".hll";
+}
+
+static std::string join_numbers(const std::vector<uint64_t>& numbers) {
+    /* Formats numbers as a comma-separated list */
+    std::string number_list;
+    for (size_t i = 0; i < numbers.size(); i++) {number_list += ((i) ? "," : "") + std::to_string(numbers[i]);}
+    return number_list;
+}
+
+PyramidLayout read_pyramid_layout(const std::string& dir_path) {
+    /* Loads the manifest of a pyramid directory, written as one "key value" pair per line */
+    std::string manifest_path = dir_path + "/" + PYRAMID_MANIFEST_NAME;
+    std::ifstream manifest_file (manifest_path, std::ifstream::in);
+    if (manifest_file.fail()) {THROW_EXCEPTION(("The following directory does not hold a pyramid: " + dir_path).data());}
+
+    PyramidLayout layout;
+    std::string key, value;
+    bool is_valid = (manifest_file >> key >> value) && key == PYRAMID_MANIFEST_MAGIC && value == std::to_string(PYRAMID_MANIFEST_VERSION);
+    while (is_valid && manifest_file >> key >> value) {
+        if (key == "prefix_bits") {layout.prefix_bits = std::atoi(value.data());}
+        else if (key == "input_type") {layout.input_type = (value == "pcap") ? PCAP : PACKET;}
+        else if (key == "window_unit") {layout.window_unit = (value == "ns") ? TIME_WINDOWS : RECORD_WINDOWS;}
+        else if (key == "window_size") {layout.window_size = std::strtoull(value.data(), NULL, 10);}
+        else if (key == "first_window_start") {layout.first_window_start = std::strtoull(value.data(), NULL, 10);}
+        else if (key == "level_factors") {is_valid = parse_number_list(value, &layout.level_factors);}
+        else if (key == "num_windows") {is_valid = parse_number_list(value, &layout.num_windows);}
+    }
+
+    is_valid = is_valid && layout.prefix_bits != 0 && layout.window_size != 0 && !layout.level_factors.empty() &&
+               layout.level_factors[0] == 1 && layout.num_windows.size() == layout.level_factors.size();
+    for (size_t i = 1; is_valid && i < layout.level_factors.size(); i++) {
+        is_valid = layout.level_factors[i] >= 2 && layout.num_windows[i] <= layout.num_windows[i-1] / layout.level_factors[i];
+    }
+    if (!is_valid) {THROW_EXCEPTION(("The following pyramid manifest is truncated or corrupt: " + manifest_path).data());}
+    return layout;
+}
+
+HLLPyramid::HLLPyramid(const std::string& dir_path, const PyramidLayout& pyramid_layout, pcap_key_type pcap_key, WindowCallback callback) {
+    /* Constructor for the pyramid - creates the directory, and an empty open window at each level */
+    pyramid_dir = dir_path;
+    layout = pyramid_layout;
+    layout.num_windows.assign(layout.level_factors.size(), 0);
+    on_window_closed = callback;
+
+    mkdir(pyramid_dir.data(), 0755);
+    struct stat s;
+    if (stat(pyramid_dir.data(), &s) < 0 || !S_ISDIR(s.st_mode) || access(pyramid_dir.data(), W_OK) < 0) {
+        FATAL_WARNING(("The pyramid directory could not be created, or is not writable: " + pyramid_dir).data());
+    }
+
+    for (size_t i = 0; i < layout.level_factors.size(); i++) {open_windows.emplace_back(layout.prefix_bits, layout.input_type, pcap_key);}
+    num_merged.assign(layout.level_factors.size(), 0);
+    pending_hashes.reserve(HLL_HASH_BATCH_SIZE);
+    write_layout();
+}
+
+void HLLPyramid::add_hash(uint64_t hash_val) {
+    /* Inserts a hash into the finest open window */
+    pending_hashes.push_back(hash_val);
+    if (pending_hashes.size() == HLL_HASH_BATCH_SIZE) {flush_hashes();}
+}
+
+void HLLPyramid::flush_hashes() {
+    /* Inserts the buffered hashes into the finest open window */
+    open_windows[0].add_hashes(pending_hashes.data(), pending_hashes.size());
+    pending_hashes.clear();
+}
+
+void HLLPyramid::close_window() {
+    /* Completes the finest open window, along with every coarser window that it completes */
+    flush_hashes();
+    close_level(0);
+    write_layout();
+}
+
+void HLLPyramid::close_level(size_t level) {
+    /*
+     * Writes the open window of a level, and merges it into the open window of the next level
+     * (register-wise max). Once the next level has all of its windows, it is closed the same way.
+     */
+    HyperLogLog& window_sketch = open_windows[level];
+    window_sketch.write_to_file(get_pyramid_window_path(pyramid_dir, level, layout.num_windows[level]));
+    if (on_window_closed) {on_window_closed(level, layout.num_windows[level], window_sketch);}
+    layout.num_windows[level]++;
+
+    if (level + 1 < open_windows.size()) {
+        open_windows[level + 1] += window_sketch;
+        if (++num_merged[level + 1] == layout.level_factors[level + 1]) {
+            num_merged[level + 1] = 0;
+            close_level(level + 1);
+        }
+    }
+    window_sketch.reset();
+}
+
+void HLLPyramid::write_layout() const {
+    /* Writes the manifest to a temporary file and renames it, so a query that runs during the build never sees a partial one */
+    std::string manifest_path = pyramid_dir + "/" + PYRAMID_MANIFEST_NAME;
+    std::string temp_path = manifest_path + ".tmp." + std::to_string(getpid());
+    std::FILE* manifest_file = std::fopen(temp_path.data(), "w");
+    if (manifest_file == NULL) {THROW_EXCEPTION(("The following path could not be opened for writing: " + temp_path).data());}
+
+    std::fprintf(manifest_file, "%s %d\n", PYRAMID_MANIFEST_MAGIC, PYRAMID_MANIFEST_VERSION);
+    std::fprintf(manifest_file, "prefix_bits %u\n", (unsigned) layout.prefix_bits);
+    std::fprintf(manifest_file, "input_type %s\n", (layout.input_type == PCAP) ? "pcap" : "records");
+    std::fprintf(manifest_file, "window_unit %s\n", (layout.window_unit == TIME_WINDOWS) ? "ns" : "records");
+    std::fprintf(manifest_file, "window_size %llu\n", (unsigned long long) layout.window_size);
+    std::fprintf(manifest_file, "first_window_start %llu\n", (unsigned long long) layout.first_window_start);
+    std::fprintf(manifest_file, "level_factors %s\n", join_numbers(layout.level_factors).data());
+    std::fprintf(manifest_file, "num_windows %s\n", join_numbers(layout.num_windows).data());
+
+    if (std::fclose(manifest_file) != 0 || std::rename(temp_path.data(), manifest_path.data()) != 0) {
+        unlink(temp_path.data());
+        THROW_EXCEPTION(("The following pyramid manifest could not be written: " + manifest_path).data());
+    }
+}
+
+std::vector<PyramidWindow> HLLPyramid::cover_range(const PyramidLayout& pyramid_layout, uint64_t range_start, uint64_t range_end) {
+    /*
+     * Finds the fewest stored windows that exactly cover [range_start, range_end) of the finest
+     * windows. Going left to right, the coarsest window that starts at the current position and
+     * ends within the range is taken, so each level contributes fewer than 2*factor windows, and a
+     * range needs O(factor * levels) sketches, which is O(log n) of the finest windows it spans.
+     */
+    std::vector<PyramidWindow> cover;
+    for (uint64_t curr_pos = range_start; curr_pos < range_end;) {
+        size_t level = pyramid_layout.level_factors.size() - 1;
+        for (; level > 0; level--) {
+            uint64_t level_span = pyramid_layout.get_level_span(level);
+            if (curr_pos % level_span == 0 && range_end - curr_pos >= level_span &&
+                curr_pos / level_span < pyramid_layout.num_windows[level]) {break;}
+        }
+        uint64_t level_span = pyramid_layout.get_level_span(level);
+        cover.push_back({level, curr_pos / level_span});
+        curr_pos += level_span;
+    }
+    return cover;
+}
+
+HyperLogLog HLLPyramid::query_range(const std::string& dir_path, const PyramidLayout& pyramid_layout,
+                                    uint64_t range_start, uint64_t range_end, size_t* num_sketches) {
+    /* Estimates a range of finest windows by merging the stored windows that cover it */
+    if (range_start >= range_end || range_end > pyramid_layout.num_windows[0]) {
+        FATAL_WARNING(("The range " + std::to_string(range_start) + ":" + std::to_string(range_end) +
+                       " is not within the " + std::to_string(pyramid_layout.num_windows[0]) + " windows of the pyramid.").data());
+    }
+    std::vector<PyramidWindow> cover = cover_range(pyramid_layout, range_start, range_end);
+    *num_sketches = cover.size();
+
+    HyperLogLog union_sketch = HyperLogLog::read_from_file(get_pyramid_window_path(dir_path, cover[0].level, cover[0].window_num));
+    for (size_t i = 1; i < cover.size(); i++) {
+        union_sketch += HyperLogLog::read_from_file(get_pyramid_window_path(dir_path, cover[i].level, cover[i].window_num));
+    }
+    return union_sketch;
+}
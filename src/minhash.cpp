@@ -13,7 +13,13 @@
 #include <zlib.h>
 #include <hash.h>
 #include <pacsketch.h>
-#include <set>
+#include <stats.h>
+#include <pcap_reader.h>
+#include <columnar.h>
+#include <sketch_file.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <numeric>
@@ -22,44 +28,25 @@
 
 KSEQ_INIT(gzFile, gzread)
 
-template<typename T>
-void print_queue(T q) { 
-    // From C++ website for priority queues
-    while(!q.empty()) {
-        std::cout << q.top() << ' ';
-        q.pop();
-    }
-    std::cout << '\n';
-}
-
 void MinHash::buildFromFASTA(std::string file_path, size_t k_val) {
     /* Constructs the MinHash data-structure for the scenario where input is a FASTA file */
     gzFile fp = gzopen(file_path.data(), "r"); 
     kseq_t* ks = kseq_init(fp);
 
     while (kseq_read(ks) >= 0) {
-        size_t kmer_length = 11;
-        char curr_kmer[kmer_length + 1];
-        for (size_t i = 0; i <= ks->seq.l-kmer_length; i++) {
-            // Grab and encode kmer, and hash it
-            memcpy(curr_kmer, &ks->seq.s[i], kmer_length);
-            uint64_t encoded_kmer = encode_string(curr_kmer);
-            uint64_t curr_kmer_hash = MurmurHash3(encoded_kmer);
-
-            // Check if it is one of the min-hashes, and it is unique
-            if (curr_kmer_hash < max_heap_k.top() && !std::count(elements_in_queue.begin(), elements_in_queue.end(), curr_kmer_hash)) {
-                auto removed_value = max_heap_k.top();
-                max_heap_k.pop();
-                max_heap_k.push(curr_kmer_hash);
-                
-                // Adds new value, and removes old value
-                elements_in_queue.push_back(curr_kmer_hash);
-                elements_in_queue.erase(std::remove(elements_in_queue.begin(), elements_in_queue.end(), removed_value), elements_in_queue.end());
-            }
-        }
+        STATS_ADD(bytes_read, ks->seq.l);
+        add_sequence(ks->seq.s, ks->seq.l);
     }
+    kseq_destroy(ks);
+    gzclose(fp);
 } 
 
+void MinHash::add_sequence(const char* seq, size_t length) {
+    /* Inserts every k-mer of a DNA sequence into the sketch */
+    STATS_ADD(kmers_parsed, (length >= FASTA_KMER_LENGTH) ? length - FASTA_KMER_LENGTH + 1 : 0);
+    for_each_kmer_hash(seq, length, FASTA_KMER_LENGTH, [&](uint64_t hash_val) {add_hash(hash_val);});
+}
+
 std::vector<std::string> split(std::string input, char delim) {
     /* Takes in a string, and splits it based on delimiters */
     std::vector<std::string> word_list;
@@ -74,47 +61,65 @@ std::vector<std::string> split(std::string input, char delim) {
 }
 
 void MinHash::buildFromPackets(std::string file_path, size_t k_val) {
-    /* Builds the MinHash sketch from a Packet Trace */
+    /* Builds the MinHash sketch from a Packet Trace, the hashes of a columnar file are inserted straight from the mapping */
+    if (is_columnar_file(file_path.data())) {
+        ColumnarFile columnar_input (file_path);
+        const uint64_t* record_hashes = columnar_input.get_record_hashes();
+        for (size_t i = 0; i < columnar_input.get_num_records(); i++) {add_hash(record_hashes[i]);}
+        return;
+    }
     std::ifstream input_data (file_path, std::ifstream::in);
-    std::hash<std::string> hasher;
      
     for (std::string line; std::getline(input_data, line);) {
-        auto word_list = split(line, ',');
-        word_list.pop_back(); // Removes the label
-
-        std::string feature_vec = "";
-        std::for_each(word_list.begin(), word_list.end(), [&](const std::string &word){feature_vec += word + "_";});
-        auto hash_val = hasher(feature_vec);
-
-        // Check if it is one of the min-hashes, and it is unique
-        if (hash_val < max_heap_k.top() && !std::count(elements_in_queue.begin(), elements_in_queue.end(), hash_val)) {
-            auto removed_value = max_heap_k.top();
-            max_heap_k.pop();
-            max_heap_k.push(hash_val);
-            
-            // Adds new value, and removes old value
-            elements_in_queue.push_back(hash_val);
-            elements_in_queue.erase(std::remove(elements_in_queue.begin(), elements_in_queue.end(), removed_value), elements_in_queue.end());
-        }
+        STATS_ADD(bytes_read, line.length() + 1);
+        size_t length = line.length() - (!line.empty() && line.back() == '\r');
+        if (length) {add_record(line.data(), length);} // empty lines are skipped, like index_records()
     }
+}
+
+void MinHash::buildFromPcap(std::string file_path, pcap_key_type pcap_key) {
+    /* Builds the MinHash sketch from the packets of a pcap/pcapng capture */
+    PcapReader pcap_reader (file_path);
+    PacketHeaders headers;
+    while (pcap_reader.next_packet(&headers)) {add_hash(hash_packet_key(headers, pcap_key));}
+}
 
+void MinHash::add_hash(uint64_t hash_val) {
+    /* Inserts a single hash value into the sketch */
+
+    // Check if it is one of the min-hashes, and it is unique
+    if (hash_val < max_heap_k.front() && !std::count(elements_in_queue.begin(), elements_in_queue.end(), hash_val)) {
+        auto removed_value = max_heap_k.front();
+        std::pop_heap(max_heap_k.begin(), max_heap_k.end());
+        max_heap_k.back() = hash_val;
+        std::push_heap(max_heap_k.begin(), max_heap_k.end());
+        
+        // Adds new value, and removes old value
+        elements_in_queue.push_back(hash_val);
+        elements_in_queue.erase(std::remove(elements_in_queue.begin(), elements_in_queue.end(), removed_value), elements_in_queue.end());
+        STATS_ADD(heap_updates_accepted, 1);
+    } else {STATS_ADD(heap_updates_rejected, 1);}
 }
 
-MinHash::MinHash(std::string file_path, size_t k_val, data_type input_type) {
+void MinHash::add_record(const char* record, size_t length) {
+    /* Inserts a connection record (one line of packet data) into the sketch */
+    add_hash(hash_record(record, length));
+}
+
+MinHash::MinHash(std::string file_path, size_t k_val, data_type input_type, pcap_key_type pcap_key) {
     /* constructor for MinHash class, it builds based on data_type*/
     ref_file.assign(file_path);
     k = k_val;
     file_type = input_type;
+    hash_id = compute_hash_id(input_type, pcap_key);
 
     // Initialize the max-heap for the k-smallest hashes
-    for (size_t i = 0; i < k_val; i++) {
-        max_heap_k.push(MAX_HASH); // Could also use UINT64_MAX
-    }
-    elements_in_queue.push_back(MAX_HASH);
+    reset();
 
     switch(file_type) {
         case FASTA: buildFromFASTA(file_path, k_val); break;
         case PACKET: buildFromPackets(file_path, k_val); break;
+        case PCAP: buildFromPcap(file_path, pcap_key); break;
         default: FATAL_WARNING("There appears to be a bug in the code in MinHash constructor.\n"); std::exit(1);
     }
 }
@@ -124,12 +129,10 @@ MinHash::MinHash(size_t k_val, data_type input_type) {
     ref_file.assign("");
     k = k_val;
     file_type = input_type;
+    hash_id = compute_hash_id(input_type, FIVE_TUPLE_KEY);
 
     // Initialize the max-heap for the k-smallest hashes
-    for (size_t i = 0; i < k_val; i++) {
-        max_heap_k.push(MAX_HASH); // Could also use UINT64_MAX
-    }
-    elements_in_queue.push_back(MAX_HASH);
+    reset();
 }
 
 MinHash::MinHash(std::vector<std::string> records, size_t k_val, data_type input_type = PACKET) {
@@ -137,39 +140,30 @@ MinHash::MinHash(std::vector<std::string> records, size_t k_val, data_type input
     ref_file.assign("");
     k = k_val;
     file_type = input_type;
+    hash_id = compute_hash_id(input_type, FIVE_TUPLE_KEY);
 
     // Initialize the max-heap for the k-smallest hashes
-    for (size_t i = 0; i < k_val; i++) {
-        max_heap_k.push(MAX_HASH); // Could also use UINT64_MAX
-    }
-    elements_in_queue.push_back(MAX_HASH);
+    reset();
 
     // Go through each record, and insert it into the MinHash
-    std::hash<std::string> hasher;
-    for (std::string line: records) {
-        auto word_list = split(line, ',');
-        word_list.pop_back(); // Removes the label
-
-        std::string feature_vec = "";
-        std::for_each(word_list.begin(), word_list.end(), [&](const std::string &word){feature_vec += word + "_";});
-        auto hash_val = hasher(feature_vec);
-
-        // Check if it is one of the min-hashes, and it is unique
-        if (hash_val < max_heap_k.top() && !std::count(elements_in_queue.begin(), elements_in_queue.end(), hash_val)) {
-            auto removed_value = max_heap_k.top();
-            max_heap_k.pop();
-            max_heap_k.push(hash_val);
-            
-            // Adds new value, and removes old value
-            elements_in_queue.push_back(hash_val);
-            elements_in_queue.erase(std::remove(elements_in_queue.begin(), elements_in_queue.end(), removed_value), elements_in_queue.end());
-        }
+    for (const std::string& line: records) {
+        add_record(line.data(), line.length());
     }
 }
 
-uint64_t MinHash::get_cardinality() {
+void MinHash::reset() {
+    /* 
+     * Empties the sketch so it can be reused, every slot goes back to MAX_HASH (which is a valid 
+     * max-heap), and the vectors keep their capacity so no memory is allocated after the first use.
+     */
+    max_heap_k.assign(k, MAX_HASH); // Could also use UINT64_MAX
+    elements_in_queue.assign(1, MAX_HASH);
+    elements_in_queue.reserve(k + 1);
+}
+
+uint64_t MinHash::get_cardinality() const {
     /* Computes the cardinality based the MinHash sketch */
-    uint64_t k_min_hash = max_heap_k.top();
+    uint64_t k_min_hash = max_heap_k.front();
     if (k_min_hash == 0) {k_min_hash = 1000000;} // Just to avoid an error
 
     uint64_t cardinality = (MAX_HASH/k_min_hash);
@@ -177,52 +171,257 @@ uint64_t MinHash::get_cardinality() {
     return cardinality;
 }
 
-MinHash MinHash::operator +(MinHash& operand) {
+uint64_t MinHash::get_memory_usage() const {
+    /* Returns the bytes allocated for the hashes of the sketch */
+    return (max_heap_k.capacity() + elements_in_queue.capacity()) * sizeof(uint64_t);
+}
+
+MinHash MinHash::operator +(const MinHash& operand) const {
     /* Creates the union minhash from two minhashes */
     MinHash union_sketch (this->k, this->file_type);
+    union_sketch.hash_id = this->hash_id;
+    union_sketch.max_heap_k = this->max_heap_k;
+    union_sketch += operand;
+    return union_sketch;
+}
+
+MinHash& MinHash::operator +=(const MinHash& operand) {
+    /* 
+     * Unions another MinHash into this one, in place: the k smallest distinct hashes of both
+     * sketches are kept, so a hash that is in both sketches only takes up one slot.
+     */
+    if (!is_compatible(operand)) {THROW_EXCEPTION("MinHash sketches with different values of k, or different input hashes, cannot be merged.");}
+    std::vector<uint64_t> hashes_1 (max_heap_k), hashes_2 (operand.max_heap_k);
+    std::sort(hashes_1.begin(), hashes_1.end());
+    std::sort(hashes_2.begin(), hashes_2.end());
+
+    std::vector<uint64_t> union_hashes;
+    union_hashes.reserve(2 * k);
+    std::set_union(hashes_1.begin(), hashes_1.end(), hashes_2.begin(), hashes_2.end(), std::back_inserter(union_hashes));
+    union_hashes.erase(std::unique(union_hashes.begin(), union_hashes.end()), union_hashes.end());
+    assign_hashes(union_hashes);
+    return *this;
+}
+
+void MinHash::assign_hashes(std::vector<uint64_t>& sorted_hashes) {
+    /* Replaces the contents of the sketch with the k smallest of a sorted list of distinct hashes */
+    sorted_hashes.resize(k, MAX_HASH);
+    elements_in_queue.assign(sorted_hashes.begin(), std::find(sorted_hashes.begin(), sorted_hashes.end(), MAX_HASH));
+
+    max_heap_k.assign(sorted_hashes.begin(), sorted_hashes.end());
+    std::make_heap(max_heap_k.begin(), max_heap_k.end());
+}
+
+bool MinHash::is_compatible(const MinHash& operand) const {
+    /* Checks whether two MinHash sketches keep the same number of hashes, from the same kind of hashes */
+    return k == operand.k && hash_id == operand.hash_id;
+}
+
+SketchFileHeader MinHash::get_file_header(std::vector<uint64_t>* sorted_hashes) const {
+    /* Fills in the header of the serialized sketch, and its payload: the k hashes in ascending order (empty slots are MAX_HASH) */
+    sorted_hashes->assign(max_heap_k.begin(), max_heap_k.end());
+    std::sort(sorted_hashes->begin(), sorted_hashes->end());
+
+    SketchFileHeader header = SketchFileHeader();
+    header.sketch = MINHASH;
+    header.input_type = file_type;
+    header.hash_id = hash_id;
+    header.parameter = k;
+    header.payload_size = k * sizeof(uint64_t);
+    return header;
+}
+
+static bool is_valid_minhash(const SketchFileHeader& header, const std::vector<uint64_t>& sorted_hashes) {
+    /* Checks the payload of a serialized sketch: sorted, with no repeats besides the empty (MAX_HASH) slots */
+    if (header.parameter == 0 || sorted_hashes.size() != header.parameter || !std::is_sorted(sorted_hashes.begin(), sorted_hashes.end())) {return false;}
+    auto filled_end = std::find(sorted_hashes.begin(), sorted_hashes.end(), MAX_HASH); // a sketch of fewer than k items ends in empty slots
+    return std::adjacent_find(sorted_hashes.begin(), filled_end) == filled_end;
+}
+
+void MinHash::write_to_file(const std::string& file_path, uint64_t input_offset, uint64_t input_fingerprint) const {
+    /* Serializes the sketch to a file */
+    std::vector<uint64_t> sorted_hashes;
+    SketchFileHeader header = get_file_header(&sorted_hashes);
+    header.input_offset = input_offset;
+    header.input_fingerprint = input_fingerprint;
+    write_sketch_file(file_path, header, sorted_hashes.data());
+}
 
-    auto add_to_max_heap = [&] (uint64_t curr_kmer_hash) {
-        // Check if it is one of the min-hashes
-        if (curr_kmer_hash < union_sketch.max_heap_k.top()) {
-            union_sketch.max_heap_k.pop();
-            union_sketch.max_heap_k.push(curr_kmer_hash);
-        }
-    };
-
-    while (!this->max_heap_k.empty()) { // Add operand1 hashes
-        add_to_max_heap(this->max_heap_k.top());
-        this->max_heap_k.pop();
+void MinHash::serialize(std::vector<char>* buffer) const {
+    /* Serializes the sketch into memory, in the same format as write_to_file() */
+    std::vector<uint64_t> sorted_hashes;
+    SketchFileHeader header = get_file_header(&sorted_hashes);
+    write_sketch_buffer(header, sorted_hashes.data(), buffer);
+}
+
+MinHash MinHash::read_from_file(const std::string& file_path) {
+    /* Loads a sketch written by write_to_file() */
+    SketchFileHeader header;
+    int input_fd = open_sketch_file(file_path, MINHASH, &header);
+    if (header.parameter == 0 || header.payload_size != (uint64_t) header.parameter * sizeof(uint64_t)) {
+        THROW_EXCEPTION(("The following MinHash sketch file is truncated or corrupt: " + file_path).data());
     }
 
-    while (!operand.max_heap_k.empty()) { // Add operand2 hashes
-        add_to_max_heap(operand.max_heap_k.top());
-        operand.max_heap_k.pop();
+    std::vector<uint64_t> sorted_hashes (header.parameter);
+    read_sketch_payload(input_fd, file_path, sorted_hashes.data(), header.payload_size);
+    if (!is_valid_minhash(header, sorted_hashes)) {
+        THROW_EXCEPTION(("The following MinHash sketch file is truncated or corrupt: " + file_path).data());
     }
-    uint64_t union_card = union_sketch.get_cardinality();
-    return union_sketch;
+
+    MinHash loaded_sketch (header.parameter, (data_type) header.input_type);
+    loaded_sketch.ref_file = file_path;
+    loaded_sketch.hash_id = header.hash_id;
+    loaded_sketch.assign_hashes(sorted_hashes);
+    return loaded_sketch;
 }
 
-double MinHash::compute_jaccard(MinHash op1, MinHash op2) {
-    /* Computes jaccard between two MinHash sketches */
-    std::set<uint64_t> hash_set;
-    std::vector<uint64_t> op2_vec;
+std::unique_ptr<MinHash> MinHash::deserialize(const void* buffer, size_t buffer_size) {
+    /* Loads a sketch from memory, written by serialize() or read from a sketch file, it returns an empty pointer if the bytes are not a valid sketch */
+    SketchFileHeader header;
+    const char* payload = parse_sketch_buffer(buffer, buffer_size, MINHASH, &header);
+    if (payload == NULL || header.parameter == 0 || header.payload_size != (uint64_t) header.parameter * sizeof(uint64_t)) {return nullptr;}
 
-    while (!op1.max_heap_k.empty()) { 
-        hash_set.insert(op1.max_heap_k.top()); // Add operand1 hashes to set
-        op1.max_heap_k.pop();
+    std::vector<uint64_t> sorted_hashes (header.parameter);
+    std::memcpy(sorted_hashes.data(), payload, header.payload_size);
+    if (!is_valid_minhash(header, sorted_hashes)) {return nullptr;}
 
-        op2_vec.push_back(op2.max_heap_k.top()); // Add operand2 hashes to vector
-        op2.max_heap_k.pop();
+    std::unique_ptr<MinHash> loaded_sketch (new MinHash(header.parameter, (data_type) header.input_type));
+    loaded_sketch->hash_id = header.hash_id;
+    loaded_sketch->assign_hashes(sorted_hashes);
+    return loaded_sketch;
+}
+
+ConcurrentMinHash::ConcurrentMinHash(size_t k_val, data_type input_type, pcap_key_type pcap_key): shared_threshold(MAX_HASH) {
+    /* Constructor for the concurrent MinHash, it starts out empty */
+    k = k_val;
+    file_type = input_type;
+    hash_id = compute_hash_id(input_type, pcap_key);
+    merged_hashes.reserve(k);
+}
+
+ConcurrentMinHash::LocalBuffer::LocalBuffer(ConcurrentMinHash& sketch): shared_sketch(sketch) {
+    /* Constructor for a thread's buffer, every slot starts at MAX_HASH like an empty MinHash */
+    max_heap_k.assign(shared_sketch.k, MAX_HASH);
+}
+
+ConcurrentMinHash::LocalBuffer::~LocalBuffer() {
+    /* Merges whatever has not been flushed yet */
+    flush();
+}
+
+void ConcurrentMinHash::LocalBuffer::add_hash(uint64_t hash_val) {
+    /* 
+     * Inserts a single hash value, the shared threshold is never above this buffer's k-th smallest
+     * hash, so checking it also covers the local bottom-k. It is read relaxed, since it only ever
+     * goes down and a stale value just lets a few more hashes through to the heap.
+     */
+    num_inserted++;
+    if (hash_val >= shared_sketch.shared_threshold.load(std::memory_order_relaxed)) {num_threshold_rejected++; return;}
+    if (hash_val >= max_heap_k.front() || std::find(max_heap_k.begin(), max_heap_k.end(), hash_val) != max_heap_k.end()) {return;}
+
+    std::pop_heap(max_heap_k.begin(), max_heap_k.end());
+    max_heap_k.back() = hash_val;
+    std::push_heap(max_heap_k.begin(), max_heap_k.end());
+    num_accepted++;
+
+    // Publish the new k-th smallest hash if it lowers the shared threshold
+    uint64_t local_threshold = max_heap_k.front();
+    uint64_t curr_threshold = shared_sketch.shared_threshold.load(std::memory_order_relaxed);
+    while (local_threshold < curr_threshold && 
+           !shared_sketch.shared_threshold.compare_exchange_weak(curr_threshold, local_threshold, std::memory_order_relaxed)) {}
+}
+
+void ConcurrentMinHash::LocalBuffer::add_hashes(const uint64_t* hash_vals, size_t num_hashes) {
+    /* Inserts a batch of hash values */
+    for (size_t i = 0; i < num_hashes; i++) {add_hash(hash_vals[i]);}
+}
+
+void ConcurrentMinHash::LocalBuffer::flush() {
+    /* Merges the buffer into the k smallest distinct hashes of the shared sketch, and empties it */
+    std::sort(max_heap_k.begin(), max_heap_k.end());
+    std::vector<uint64_t> union_hashes;
+    union_hashes.reserve(2 * shared_sketch.k);
+    {
+        std::lock_guard<std::mutex> lock (shared_sketch.merge_lock);
+        std::set_union(shared_sketch.merged_hashes.begin(), shared_sketch.merged_hashes.end(), max_heap_k.begin(),
+                       std::find(max_heap_k.begin(), max_heap_k.end(), MAX_HASH), std::back_inserter(union_hashes));
+        union_hashes.erase(std::unique(union_hashes.begin(), union_hashes.end()), union_hashes.end());
+        if (union_hashes.size() > shared_sketch.k) {union_hashes.resize(shared_sketch.k);}
+        shared_sketch.merged_hashes.swap(union_hashes);
+
+        shared_sketch.num_inserted += num_inserted;
+        shared_sketch.num_accepted += num_accepted;
+        shared_sketch.num_threshold_rejected += num_threshold_rejected;
     }
+    max_heap_k.assign(shared_sketch.k, MAX_HASH);
+    num_inserted = num_accepted = num_threshold_rejected = 0;
+}
+
+MinHash ConcurrentMinHash::snapshot() {
+    /* Returns the union of the flushed buffers as a regular MinHash */
+    MinHash union_sketch (k, file_type);
+    union_sketch.hash_id = hash_id;
+
+    std::lock_guard<std::mutex> lock (merge_lock);
+    std::vector<uint64_t> sorted_hashes (merged_hashes);
+    union_sketch.assign_hashes(sorted_hashes);
+    return union_sketch;
+}
+
+uint64_t ConcurrentMinHash::get_num_inserted() {
+    /* Returns the number of hashes inserted into the flushed buffers */
+    std::lock_guard<std::mutex> lock (merge_lock);
+    return num_inserted;
+}
 
-    // Find number of overlapping hashes
+uint64_t ConcurrentMinHash::get_num_accepted() {
+    /* Returns the number of hashes that entered the bottom-k of a flushed buffer */
+    std::lock_guard<std::mutex> lock (merge_lock);
+    return num_accepted;
+}
+
+uint64_t ConcurrentMinHash::get_num_threshold_rejected() {
+    /* Returns the number of hashes that the flushed buffers dropped by the shared threshold */
+    std::lock_guard<std::mutex> lock (merge_lock);
+    return num_threshold_rejected;
+}
+
+double MinHash::compute_jaccard(const MinHash& op1, const MinHash& op2) {
+    /* Computes jaccard between two MinHash sketches, using a per-thread scratch arena */
+    static thread_local ScratchArena scratch;
+    scratch.reset();
+    return compute_jaccard(op1, op2, scratch);
+}
+
+double MinHash::compute_jaccard(const MinHash& op1, const MinHash& op2, ScratchArena& scratch) {
+    /* 
+     * Computes jaccard between two MinHash sketches: the number of op2 hashes that are in op1,
+     * over the number of distinct hashes in both. The hashes are sorted in scratch space so
+     * that neither sketch is copied or modified.
+     */
+    size_t num_hashes_1 = op1.max_heap_k.size(), num_hashes_2 = op2.max_heap_k.size();
+    uint64_t* hashes_1 = scratch.allocate(num_hashes_1);
+    uint64_t* hashes_2 = scratch.allocate(num_hashes_2);
+
+    std::copy(op1.max_heap_k.begin(), op1.max_heap_k.end(), hashes_1);
+    std::copy(op2.max_heap_k.begin(), op2.max_heap_k.end(), hashes_2);
+    std::sort(hashes_1, hashes_1 + num_hashes_1);
+    std::sort(hashes_2, hashes_2 + num_hashes_2);
+
+    // Find number of overlapping hashes (op2 hashes are counted with their repeats)
     size_t intersection_count = 0;
-    for(auto itr = std::begin(op2_vec); itr != std::end(op2_vec); ++itr) {
-        if (hash_set.find(*itr) != hash_set.end()) {intersection_count++;}
+    for (size_t i = 0; i < num_hashes_2; i++) {
+        intersection_count += std::binary_search(hashes_1, hashes_1 + num_hashes_1, hashes_2[i]);
+    }
+
+    // Count the distinct hashes across both sketches
+    size_t union_size = 0, i = 0, j = 0;
+    uint64_t last_hash = 0;
+    while (i < num_hashes_1 || j < num_hashes_2) {
+        uint64_t curr_hash = (j == num_hashes_2 || (i < num_hashes_1 && hashes_1[i] <= hashes_2[j])) ? hashes_1[i++] : hashes_2[j++];
+        if (union_size == 0 || curr_hash != last_hash) {union_size++; last_hash = curr_hash;}
     }
 
-    // Add operand2 hashes to set
-    std::for_each(std::begin(op2_vec), std::end(op2_vec), [&](uint64_t& hash_value) {hash_set.insert(hash_value);});
-    auto jaccard = (intersection_count + 0.0)/(hash_set.size());
+    auto jaccard = (intersection_count + 0.0)/(union_size);
     return jaccard;
 }
@@ -10,11 +10,24 @@
 #include <iostream>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <unistd.h>
 #include <pacsketch.h>
 #include <hash.h>
 #include <minhash.h>
+#include <frac_minhash.h>
+#include <sketch_cache.h>
 #include <hll.h>
+#include <discretize.h>
+#include <countmin.h>
+#include <record_reader.h>
+#include <columnar.h>
+#include <sketch_file.h>
+#include <udp_listener.h>
+#include <pcap_reader.h>
+#include <hll_pyramid.h>
+#include <stats.h>
+#include <parallel.h>
 #include <unistd.h>
 #include <time.h>
 #include <fcntl.h>
@@ -27,6 +40,9 @@
 #include <random>
 #include <tuple>
 #include <array>
+#include <cctype>
+#include <memory>
+#include <csignal>
 
 bool is_file(const char* file_path) {
     /* Checks if the path is a valid file-path */
@@ -45,7 +61,18 @@ int pacsketch_usage() {
     std::fprintf(stderr, "Commands:\n");
     std::fprintf(stderr, "\t%-12sbuilds the sketches for packet traces (different sketches can be used)\n", "build");
     std::fprintf(stderr, "\t%-12scompares sketches and computes similarity measures between them\n", "dist");
-    std::fprintf(stderr, "\t%-12ssimulate windows of packets from two sources and compare them\n\n", "simulate");
+    std::fprintf(stderr, "\t%-12ssimulate windows of packets from two sources and compare them\n", "simulate");
+    std::fprintf(stderr, "\t%-12sbins the numeric features of KDD records into discrete labels\n", "discretize");
+    std::fprintf(stderr, "\t%-12sreports the most frequent feature vectors in each window of records\n", "topn");
+    std::fprintf(stderr, "\t%-12sestimates the attack ratio of each window of a stream of records\n", "classify");
+    std::fprintf(stderr, "\t%-12sconverts records into a binary columnar file, accepted by every command\n", "convert");
+    std::fprintf(stderr, "\t%-12sunions many sketch files (from build -o) into a single sketch\n", "merge");
+    std::fprintf(stderr, "\t%-12sbuilds HLL windows at many resolutions, and estimates any range of them\n\n", "pyramid");
+
+    std::fprintf(stderr, "Global options:\n");
+    std::fprintf(stderr, "\t%-12swrite timings and counters of the run as JSON to FILE (- for stderr)\n", "--stats FILE");
+    std::fprintf(stderr, "\t%-12skeep the sketches of input files in DIR, and load them on later runs\n", "--cache DIR");
+    std::fprintf(stderr, "\t%-12s(the %s variable can be used instead)\n\n", "", SKETCH_CACHE_ENV);
     return 1;
 }
 
@@ -58,15 +85,30 @@ int pacsketch_build_usage() {
     std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
     std::fprintf(stderr, "\t%-10spath to input file that has index built for it\n", "-i [FILE]");
     std::fprintf(stderr, "\t%-10sinput data is in FASTA format (used for dev)\n", "-f");
+    std::fprintf(stderr, "\t%-10sinput data is a pcap/pcapng capture\n", "-p");
+    std::fprintf(stderr, "\t%-10spacket key for captures: 5tuple (default), srcdst, src, dst, dstport\n", "-K [arg]");
     std::fprintf(stderr, "\t%-10sbuild a MinHash sketch from input data\n", "-M");
     std::fprintf(stderr, "\t%-10sbuild a HyperLogLog sketch from input data\n", "-H");
-    std::fprintf(stderr, "\t%-10soutput the cardinality of the sketch after building\n\n", "-c");
+    std::fprintf(stderr, "\t%-10sbuild a FracMinHash (scaled MinHash) sketch from input data\n", "-F");
+    std::fprintf(stderr, "\t%-10soutput the cardinality of the sketch after building\n", "-c");
+    std::fprintf(stderr, "\t%-10swrite the sketch to a file, which can be unioned with merge\n", "-o [FILE]");
+    std::fprintf(stderr, "\t%-10sonly add the records appended to the input since the sketch in -o was written\n", "-a");
+    std::fprintf(stderr, "\t%-10s(it is rebuilt if the input was truncated or rotated)\n", "");
+    std::fprintf(stderr, "\t%-10snumber of threads inserting connection records (default: 1)\n", "-t [arg]");
+    std::fprintf(stderr, "\t%-10smemory budget per sketch in bytes (suffix K/M/G), the sketch type and k/b are chosen\n", "-m [arg]");
+    std::fprintf(stderr, "\t%-10sfor the lowest expected error, -M/-H restrict it to one type\n", "");
+    std::fprintf(stderr, "\t%-10starget relative error of the cardinality (e.g. 0.01), instead of -m or -k/-b\n\n", "-e [arg]");
 
     std::fprintf(stderr, "MinHash specific options:\n");
     std::fprintf(stderr, "\t%-10snumber of hashes to keep in sketch\n\n", "-k [arg]");
 
     std::fprintf(stderr, "HyperLogLog specific options:\n");
-    std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
+    std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n", "-b [arg]");
+    std::fprintf(stderr, "\t%-10salso build one HLL per column, comma-separated KDD feature names,\n", "-C [arg]");
+    std::fprintf(stderr, "\t%-10s0-based indexes or \"all\" (reports every cardinality)\n\n", "");
+
+    std::fprintf(stderr, "FracMinHash specific options:\n");
+    std::fprintf(stderr, "\t%-10skeep the hashes in the first 1/s of hash space\n\n", "-s [arg]");
     return 1;
 }
 
@@ -79,14 +121,23 @@ int pacsketch_dist_usage() {
     std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
     std::fprintf(stderr, "\t%-10spath to input file that has index built for it\n", "-i [FILE]");
     std::fprintf(stderr, "\t%-10sinput data is in FASTA format (used for dev)\n", "-f");
+    std::fprintf(stderr, "\t%-10sinput data is a pcap/pcapng capture\n", "-p");
+    std::fprintf(stderr, "\t%-10spacket key for captures: 5tuple (default), srcdst, src, dst, dstport\n", "-K [arg]");
     std::fprintf(stderr, "\t%-10sbuild a MinHash sketch from input data\n", "-M");
-    std::fprintf(stderr, "\t%-10sbuild a HyperLogLog sketch from input data\n\n", "-H");
+    std::fprintf(stderr, "\t%-10sbuild a HyperLogLog sketch from input data\n", "-H");
+    std::fprintf(stderr, "\t%-10sbuild a FracMinHash sketch from input data (also reports containment)\n", "-F");
+    std::fprintf(stderr, "\t%-10smemory budget per sketch in bytes (suffix K/M/G), the sketch type and k/b are chosen\n", "-m [arg]");
+    std::fprintf(stderr, "\t%-10sfor the lowest expected error, -M/-H restrict it to one type\n", "");
+    std::fprintf(stderr, "\t%-10starget standard error of the jaccard (e.g. 0.02), instead of -m or -k/-b\n\n", "-e [arg]");
 
     std::fprintf(stderr, "MinHash specific options:\n");
     std::fprintf(stderr, "\t%-10snumber of hashes to keep in sketch\n\n", "-k [arg]");
 
     std::fprintf(stderr, "HyperLogLog specific options:\n");
     std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
+
+    std::fprintf(stderr, "FracMinHash specific options:\n");
+    std::fprintf(stderr, "\t%-10skeep the hashes in the first 1/s of hash space\n\n", "-s [arg]");
     return 1;
 }
 
@@ -103,6 +154,7 @@ int pacsketch_simulate_usage() {
     std::fprintf(stderr, "\t%-10sinput data is in FASTA format (used for dev)\n", "-f");
     std::fprintf(stderr, "\t%-10sbuild a MinHash sketch from input data\n", "-M");
     std::fprintf(stderr, "\t%-10sbuild a HyperLogLog sketch from input data\n", "-H");
+    std::fprintf(stderr, "\t%-10sbuild a FracMinHash sketch from input data\n", "-F");
     std::fprintf(stderr, "\t%-10snumber of records to include in time window\n", "-n [arg]");
     std::fprintf(stderr, "\t%-10snumber of windows to simulate\n", "-w [arg]");
     std::fprintf(stderr, "\t%-10sratio of simulated window that are attack records (0.0 <= x <= 1.0)\n", "-a [arg]");
@@ -111,6 +163,128 @@ int pacsketch_simulate_usage() {
     std::fprintf(stderr, "MinHash specific options:\n");
     std::fprintf(stderr, "\t%-10snumber of hashes to keep in sketch\n\n", "-k [arg]");
 
+    std::fprintf(stderr, "HyperLogLog specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
+
+    std::fprintf(stderr, "FracMinHash specific options (compares windows to the test references with containment):\n");
+    std::fprintf(stderr, "\t%-10skeep the hashes in the first 1/s of hash space\n\n", "-s [arg]");
+    return 1;
+}
+
+int pacsketch_discretize_usage() {
+    /* Prints out the usage information for pacsketch discretize sub-command */
+    std::fprintf(stderr, "\npacsketch discretize - bins the numeric features of KDD records based on their z-score\n");
+    std::fprintf(stderr, "with respect to the normal records in the training data (same as analyze_dataset.py).\n");
+    std::fprintf(stderr, "\nUsage: pacsketch discretize -i train_file [-t test_file] -o output_prefix [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10spath to training dataset, used to compute the feature statistics\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10spath to test dataset, binned using the training statistics\n", "-t [FILE]");
+    std::fprintf(stderr, "\t%-10soutput prefix for the converted datasets\n", "-o [arg]");
+    std::fprintf(stderr, "\t%-10snumber of threads to use (default: all cores)\n", "-p [arg]");
+    std::fprintf(stderr, "\t%-10sbuild MinHash sketches of binned normal/attack records, and compare them\n", "-M");
+    std::fprintf(stderr, "\t%-10sbuild HyperLogLog sketches of binned normal/attack records, and compare them\n\n", "-H");
+
+    std::fprintf(stderr, "MinHash specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of hashes to keep in sketch\n\n", "-k [arg]");
+
+    std::fprintf(stderr, "HyperLogLog specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
+    return 1;
+}
+
+int pacsketch_topn_usage() {
+    /* Prints out the usage information for pacsketch topn sub-command */
+    std::fprintf(stderr, "\npacsketch topn - splits the records into consecutive windows, and reports the most frequent\n");
+    std::fprintf(stderr, "feature vectors (heavy-hitters) of each window using a Count-Min sketch.\n");
+    std::fprintf(stderr, "\nUsage: pacsketch topn -i file [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10spath to input file of connection records\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10snumber of records in each window (default: whole file)\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10snumber of heavy-hitters to report per window (default: 10)\n\n", "-N [arg]");
+
+    std::fprintf(stderr, "Count-Min specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of counters per row, a power of 2 (default: 2048)\n\n", "-W [arg]");
+    return 1;
+}
+
+int pacsketch_classify_usage() {
+    /* Prints out the usage information for pacsketch classify sub-command */
+    std::fprintf(stderr, "\npacsketch classify - compares consecutive windows of a stream of records with the normal\n");
+    std::fprintf(stderr, "and attack reference sketches, and estimates the ratio of attack records in each window.\n");
+    std::fprintf(stderr, "\nUsage: pacsketch classify -N normal_file -A attack_file [-A attack_file ...] -i input [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10srecords to classify, - reads them from stdin (default: -)\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10sreceive the records over UDP on [address:]port (default address: 127.0.0.1),\n", "-u [arg]");
+    std::fprintf(stderr, "\t%-10suntil SIGINT/SIGTERM, one or more newline-separated records per datagram\n", "");
+    std::fprintf(stderr, "\t%-10sreference records of normal traffic\n", "-N [FILE]");
+    std::fprintf(stderr, "\t%-10sreference records of an attack class, as name:path or path (can be repeated)\n", "-A [arg]");
+    std::fprintf(stderr, "\t%-10snumber of records in each window\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10sbuild MinHash sketches\n", "-M");
+    std::fprintf(stderr, "\t%-10sbuild HyperLogLog sketches\n\n", "-H");
+
+    std::fprintf(stderr, "MinHash specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of hashes to keep in sketch\n\n", "-k [arg]");
+
+    std::fprintf(stderr, "HyperLogLog specific options:\n");
+    std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
+    return 1;
+}
+
+int pacsketch_convert_usage() {
+    /* Prints out the usage information for pacsketch convert sub-command */
+    std::fprintf(stderr, "\npacsketch convert - converts connection records into a binary columnar file, with the\n");
+    std::fprintf(stderr, "record hashes precomputed. The file can be used in place of the records by every command.\n");
+    std::fprintf(stderr, "\nUsage: pacsketch convert -i file -o output_file\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10spath to input file of connection records\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10spath of the columnar file to write\n\n", "-o [FILE]");
+    return 1;
+}
+
+int pacsketch_merge_usage() {
+    /* Prints out the usage information for pacsketch merge sub-command */
+    std::fprintf(stderr, "\npacsketch merge - unions sketch files written by build -o into a single sketch. The files\n");
+    std::fprintf(stderr, "are merged in a parallel tree, and they need to be the same type of sketch with the same\n");
+    std::fprintf(stderr, "value of k, b or scale, built from the same kind of input.\n");
+    std::fprintf(stderr, "\nUsage: pacsketch merge -o output_file [options] [sketch files or directories ...]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10ssketch file, or directory of sketch files, to merge (can be repeated)\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10spath of the union sketch to write\n", "-o [FILE]");
+    std::fprintf(stderr, "\t%-10snumber of threads to use (default: all cores)\n", "-t [arg]");
+    std::fprintf(stderr, "\t%-10soutput the cardinality of the union sketch\n\n", "-c");
+    return 1;
+}
+
+int pacsketch_pyramid_usage() {
+    /* Prints out the usage information for pacsketch pyramid sub-command */
+    std::fprintf(stderr, "\npacsketch pyramid - builds HyperLogLog sketches of consecutive windows of a stream at many\n");
+    std::fprintf(stderr, "resolutions. Only the finest windows read the input, each coarser window is merged from the\n");
+    std::fprintf(stderr, "windows below it as they complete. The windows are kept in a directory, and any range of the\n");
+    std::fprintf(stderr, "finest windows is estimated by merging the few stored windows that cover it.\n");
+    std::fprintf(stderr, "\nUsage: pacsketch pyramid -i input -o dir -b [arg] (-n [arg] | -s [arg]) [options]\n");
+    std::fprintf(stderr, "       pacsketch pyramid -o dir -q START:END [-q START:END ...]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10srecords (or a capture) to build the pyramid from, - reads records from stdin\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10sdirectory of the pyramid, written by a build and read by the ranges\n", "-o [DIR]");
+    std::fprintf(stderr, "\t%-10sinput data is a pcap/pcapng capture\n", "-p");
+    std::fprintf(stderr, "\t%-10spacket key for captures: 5tuple (default), srcdst, src, dst, dstport\n", "-K [arg]");
+    std::fprintf(stderr, "\t%-10snumber of records (or packets) in each finest window\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10sseconds in each finest window of a capture, from the packet timestamps\n", "-s [arg]");
+    std::fprintf(stderr, "\t%-10swindows of each level in a window of the next level (default: %s)\n", "-l [LIST]", DEFAULT_PYRAMID_FACTORS);
+    std::fprintf(stderr, "\t%-10sestimate the cardinality of finest windows START to END-1 (can be repeated)\n\n", "-q [arg]");
+
     std::fprintf(stderr, "HyperLogLog specific options:\n");
     std::fprintf(stderr, "\t%-10snumber of bits to use for choosing registers\n\n", "-b [arg]");
     return 1;
@@ -118,16 +292,26 @@ int pacsketch_simulate_usage() {
 
 void parse_build_options(int argc, char** argv, PacsketchBuildOptions* opts) {
     /* Parses the command-line options for build sub-command */
-    for (int c; (c=getopt(argc, argv, "hi:fMHck:b:")) >= 0;) {
+    for (int c; (c=getopt(argc, argv, "hi:o:afpK:MHFck:b:s:C:t:m:e:")) >= 0;) {
         switch (c) {
             case 'h': pacsketch_build_usage(); std::exit(1);
             case 'i': opts->input_file.assign(optarg); break;
+            case 'o': opts->output_file.assign(optarg); break;
+            case 'a': opts->append_input = true; break;
+            case 'C': opts->column_list.assign(optarg); break;
             case 'f': opts->input_fasta = true; break;
+            case 'p': opts->input_pcap = true; break;
+            case 'K': opts->pcap_key_name.assign(optarg); break;
             case 'M': opts->use_minhash = true; break;
             case 'H': opts->use_hll = true; break;
+            case 'F': opts->use_frac_minhash = true; break;
             case 'c': opts->print_cardinality = true; break;
             case 'k': opts->k_size = std::max(std::atoi(optarg), 0); break;
             case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            case 's': opts->scale = std::max(std::atoll(optarg), 0LL); break;
+            case 't': opts->num_threads = std::max(std::atoi(optarg), 0); break;
+            case 'm': opts->memory_budget_name.assign(optarg); break;
+            case 'e': opts->target_error = std::atof(optarg); break;
             default:  std::exit(1);
         }
     }
@@ -135,15 +319,21 @@ void parse_build_options(int argc, char** argv, PacsketchBuildOptions* opts) {
 
 void parse_dist_options(int argc, char** argv, PacsketchDistOptions* opts) {
     /* Parses the command-line options for dist sub-command */
-    for (int c; (c=getopt(argc, argv, "hi:fMHk:b:")) >= 0;) {
+    for (int c; (c=getopt(argc, argv, "hi:fpK:MHFk:b:s:m:e:")) >= 0;) {
         switch (c) {
             case 'h': pacsketch_build_usage(); std::exit(1);
             case 'i': opts->input_files.push_back(optarg); break;
             case 'f': opts->input_fasta = true; break;
+            case 'p': opts->input_pcap = true; break;
+            case 'K': opts->pcap_key_name.assign(optarg); break;
             case 'M': opts->use_minhash = true; break;
             case 'H': opts->use_hll = true; break;
+            case 'F': opts->use_frac_minhash = true; break;
             case 'k': opts->k_size = std::max(std::atoi(optarg), 0); break;
             case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            case 's': opts->scale = std::max(std::atoll(optarg), 0LL); break;
+            case 'm': opts->memory_budget_name.assign(optarg); break;
+            case 'e': opts->target_error = std::atof(optarg); break;
             default:  std::exit(1);
         }
     }
@@ -151,15 +341,17 @@ void parse_dist_options(int argc, char** argv, PacsketchDistOptions* opts) {
 
 void parse_simulate_options(int argc, char** argv, PacsketchSimulateOptions* opts) {
     /* Parses the command-line options for simulate sub-command */
-    for (int c; (c=getopt(argc, argv, "hi:fMHk:b:n:w:a:t:")) >= 0;) {
+    for (int c; (c=getopt(argc, argv, "hi:fMHFk:b:s:n:w:a:t:")) >= 0;) {
         switch (c) {
             case 'h': pacsketch_build_usage(); std::exit(1);
             case 'i': opts->input_files.push_back(optarg); break;
             case 'f': opts->input_fasta = true; break;
             case 'M': opts->use_minhash = true; break;
             case 'H': opts->use_hll = true; break;
+            case 'F': opts->use_frac_minhash = true; break;
             case 'k': opts->k_size = std::max(std::atoi(optarg), 0); break;
             case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            case 's': opts->scale = std::max(std::atoll(optarg), 0LL); break;
             case 'n': opts->num_records = std::max(0, std::atoi(optarg)); break;
             case 'w': opts->num_windows = std::max(0, std::atoi(optarg)); break;
             case 'a': opts->attack_percent = std::atof(optarg); break;
@@ -169,6 +361,194 @@ void parse_simulate_options(int argc, char** argv, PacsketchSimulateOptions* opt
     }
 }
 
+void parse_discretize_options(int argc, char** argv, PacsketchDiscretizeOptions* opts) {
+    /* Parses the command-line options for discretize sub-command */
+    for (int c; (c=getopt(argc, argv, "hi:t:o:p:MHk:b:")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_discretize_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 't': opts->test_file.assign(optarg); break;
+            case 'o': opts->output_prefix.assign(optarg); break;
+            case 'p': opts->num_threads = std::max(std::atoi(optarg), 0); break;
+            case 'M': opts->use_minhash = true; break;
+            case 'H': opts->use_hll = true; break;
+            case 'k': opts->k_size = std::max(std::atoi(optarg), 0); break;
+            case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            default:  std::exit(1);
+        }
+    }
+}
+
+void parse_topn_options(int argc, char** argv, PacsketchTopNOptions* opts) {
+    /* Parses the command-line options for topn sub-command */
+    for (int c; (c=getopt(argc, argv, "hi:n:N:W:")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_topn_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 'n': opts->num_records = std::max(0, std::atoi(optarg)); break;
+            case 'N': opts->top_n = std::max(0, std::atoi(optarg)); break;
+            case 'W': opts->width = std::max(0, std::atoi(optarg)); break;
+            default:  std::exit(1);
+        }
+    }
+}
+
+void parse_classify_options(int argc, char** argv, PacsketchClassifyOptions* opts) {
+    /* Parses the command-line options for classify sub-command */
+    for (int c; (c=getopt(argc, argv, "hi:u:N:A:n:MHk:b:")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_classify_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 'u': opts->udp_endpoint.assign(optarg); break;
+            case 'N': opts->normal_file.assign(optarg); break;
+            case 'A': opts->add_attack_class(optarg); break;
+            case 'n': opts->num_records = std::max(0, std::atoi(optarg)); break;
+            case 'M': opts->use_minhash = true; break;
+            case 'H': opts->use_hll = true; break;
+            case 'k': opts->k_size = std::max(std::atoi(optarg), 0); break;
+            case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            default:  std::exit(1);
+        }
+    }
+}
+
+void parse_convert_options(int argc, char** argv, PacsketchConvertOptions* opts) {
+    /* Parses the command-line options for convert sub-command */
+    for (int c; (c=getopt(argc, argv, "hi:o:")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_convert_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 'o': opts->output_file.assign(optarg); break;
+            default:  std::exit(1);
+        }
+    }
+}
+
+void parse_merge_options(int argc, char** argv, PacsketchMergeOptions* opts) {
+    /* Parses the command-line options for merge sub-command, the paths after the options are inputs too */
+    for (int c; (c=getopt(argc, argv, "hi:o:t:c")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_merge_usage(); std::exit(1);
+            case 'i': opts->input_paths.push_back(optarg); break;
+            case 'o': opts->output_file.assign(optarg); break;
+            case 't': opts->num_threads = std::max(std::atoi(optarg), 0); break;
+            case 'c': opts->print_cardinality = true; break;
+            default:  std::exit(1);
+        }
+    }
+    for (int i = optind; i < argc; i++) {opts->input_paths.push_back(argv[i]);}
+}
+
+void parse_pyramid_options(int argc, char** argv, PacsketchPyramidOptions* opts) {
+    /* Parses the command-line options for pyramid sub-command */
+    for (int c; (c=getopt(argc, argv, "hi:o:pK:n:s:l:q:b:")) >= 0;) {
+        switch (c) {
+            case 'h': pacsketch_pyramid_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 'o': opts->pyramid_dir.assign(optarg); break;
+            case 'p': opts->input_pcap = true; break;
+            case 'K': opts->pcap_key_name.assign(optarg); break;
+            case 'n': opts->num_records = std::max(0, std::atoi(optarg)); break;
+            case 's': opts->window_seconds = std::atof(optarg); break;
+            case 'l': opts->factor_list.assign(optarg); break;
+            case 'q': opts->query_ranges.push_back(optarg); break;
+            case 'b': opts->bit_prefix = std::max(std::atoi(optarg), 0); break;
+            default:  std::exit(1);
+        }
+    }
+}
+
+static uint64_t sketch_cardinality(MinHash& sketch) {return sketch.get_cardinality();}
+static uint64_t sketch_cardinality(HyperLogLog& sketch) {return sketch.compute_cardinality();}
+static uint64_t sketch_cardinality(FracMinHash& sketch) {return sketch.get_cardinality();}
+
+static void print_sketch_sizing(const SketchSizing& sizing, uint64_t sketch_bytes) {
+    /* Reports the sketch that was chosen from a memory budget or target error, its expected error, and the bytes it uses */
+    if (!sizing.is_automatic) {return;}
+    std::fprintf(stdout, "Chosen_Sketch: %s (%s=%llu)\n", (sizing.sketch == MINHASH) ? "MinHash" : "HyperLogLog",
+                 (sizing.sketch == MINHASH) ? "k" : "b", (unsigned long long) sizing.parameter);
+    std::fprintf(stdout, "Expected_Error: %.4f\n", sizing.expected_error);
+    std::fprintf(stdout, "Sketch_Bytes: %llu\n", (unsigned long long) sketch_bytes);
+}
+
+static uint64_t fingerprint_input_prefix(const char* input_data, uint64_t input_offset) {
+    /* Hashes the first and last blocks of the input that a sketch was built from, so a rotated or rewritten input is noticed */
+    uint64_t block_size = std::min(input_offset, (uint64_t) APPEND_FINGERPRINT_SIZE);
+    uint64_t fingerprint = hash_bytes(input_data, block_size, input_offset);
+    return hash_bytes(input_data + input_offset - block_size, block_size, fingerprint);
+}
+
+template <typename Sketch>
+static int build_append_main(const PacsketchBuildOptions& build_opts, Sketch input_sketch) {
+    /*
+     * Adds the records appended to the input since the sketch in the output file was written, and writes
+     * it back along with the new end of the input. The sketch is rebuilt from the start of the input if it
+     * cannot be resumed (it was not built with -a, or the input was truncated or rotated since). Only complete
+     * lines are added, so a record that is still being written is picked up by the next run.
+     */
+    StageTimer load_timer ("load_input");
+    size_t input_size = 0;
+    char* input_data = map_input_file(build_opts.input_file.data(), &input_size);
+
+    uint64_t start_offset = 0;
+    if (is_file(build_opts.output_file.data())) {
+        // A file that is not a sketch of this type is never overwritten, a damaged payload is rebuilt like a rotated input
+        SketchFileHeader header = read_sketch_header(build_opts.output_file);
+        if (header.sketch != (uint32_t) build_opts.curr_sketch) {
+            FATAL_WARNING(("The sketch to append to holds a different type of sketch: " + build_opts.output_file).data());
+        }
+        std::string load_error;
+        std::unique_ptr<Sketch> saved_sketch = load_sketch_file<Sketch>(build_opts.output_file, build_opts.curr_sketch, &load_error);
+        if (saved_sketch && !saved_sketch->is_compatible(input_sketch)) {
+            FATAL_WARNING(("The sketch to append to was built with a different k/b/scale or input: " + build_opts.output_file).data());
+        }
+
+        if (!saved_sketch) {
+            LOG("%s is truncated or corrupt, rebuilding it.", build_opts.output_file.data());
+        } else if (header.input_offset == 0) {
+            LOG("%s does not record how much of the input it holds (built without -a), rebuilding it.", build_opts.output_file.data());
+        } else if (header.input_offset > input_size) {
+            LOG("the input is shorter than when %s was written (truncated or rotated), rebuilding it.", build_opts.output_file.data());
+        } else if (fingerprint_input_prefix(input_data, header.input_offset) != header.input_fingerprint) {
+            LOG("the input has changed since %s was written (rotated or rewritten), rebuilding it.", build_opts.output_file.data());
+        } else {
+            input_sketch = std::move(*saved_sketch);
+            start_offset = header.input_offset;
+        }
+    }
+    load_timer.stop();
+
+    StageTimer build_timer ("build_sketch");
+    uint64_t end_offset = start_offset;
+    while (end_offset < input_size) {
+        const char* line_start = input_data + end_offset;
+        const char* newline = static_cast<const char*>(std::memchr(line_start, '\n', input_size - end_offset));
+        if (newline == NULL) {break;}
+
+        STATS_ADD(bytes_read, newline - line_start + 1);
+        input_sketch.add_record(line_start, newline - line_start);
+        end_offset += newline - line_start + 1;
+    }
+    build_timer.stop();
+
+    // The new sketch replaces the old one in a single rename, so an interrupted run leaves the old one intact
+    std::string temp_path = build_opts.output_file + ".tmp." + std::to_string(getpid());
+    input_sketch.write_to_file(temp_path, end_offset, fingerprint_input_prefix(input_data, end_offset));
+    if (std::rename(temp_path.data(), build_opts.output_file.data()) != 0) {
+        unlink(temp_path.data());
+        THROW_EXCEPTION(("Error occurred while replacing the sketch file: " + build_opts.output_file).data());
+    }
+    LOG("added bytes %lu to %lu of the input to %s", start_offset, end_offset, build_opts.output_file.data());
+
+    STATS_TIME_STAGE("estimate_cardinality");
+    print_sketch_sizing(build_opts.sizing, input_sketch.get_memory_usage());
+    if (build_opts.print_cardinality) {
+        std::fprintf(stdout, "Estimated_Cardinality: %lld\n", (long long) sketch_cardinality(input_sketch));
+    }
+    unmap_input_file(input_data, input_size);
+    return 1;
+}
+
 int build_main(int argc, char** argv) {
     /* main method for build sub-command */
     if (argc == 1) {return pacsketch_build_usage();}
@@ -179,16 +559,155 @@ int build_main(int argc, char** argv) {
     build_opts.validate();
 
     // Build the sketch
+    if (build_opts.column_list != "") {return build_column_main(build_opts);}
+    if (build_opts.num_threads > 1) {return build_concurrent_main(build_opts);}
+    if (build_opts.append_input) {
+        if (is_columnar_file(build_opts.input_file.data())) {FATAL_WARNING("Appending to a sketch (-a) needs a text file of connection records, columnar files cannot grow.");}
+        if (build_opts.curr_sketch == MINHASH) {return build_append_main(build_opts, MinHash(build_opts.k_size, PACKET));}
+        if (build_opts.curr_sketch == HLL) {return build_append_main(build_opts, HyperLogLog(build_opts.bit_prefix, PACKET));}
+        return build_append_main(build_opts, FracMinHash(build_opts.scale, PACKET));
+    }
     if (build_opts.curr_sketch == MINHASH) {
-        MinHash data_sketch (build_opts.input_file, build_opts.k_size, build_opts.input_data_type);
+        StageTimer build_timer ("build_sketch");
+        MinHash data_sketch = get_cached_minhash(build_opts.input_file, build_opts.k_size, build_opts.input_data_type, build_opts.pcap_key);
+        build_timer.stop();
+
+        if (build_opts.output_file != "") {data_sketch.write_to_file(build_opts.output_file);}
+        STATS_TIME_STAGE("estimate_cardinality");
+        print_sketch_sizing(build_opts.sizing, data_sketch.get_memory_usage());
         if (build_opts.print_cardinality) {
             std::fprintf(stdout, "Estimated_Cardinality: %lld\n", data_sketch.get_cardinality());
         }
     } else if (build_opts.curr_sketch == HLL) {
-        HyperLogLog data_sketch (build_opts.input_file, build_opts.bit_prefix, build_opts.input_data_type);
+        StageTimer build_timer ("build_sketch");
+        HyperLogLog data_sketch = get_cached_hll(build_opts.input_file, build_opts.bit_prefix, build_opts.input_data_type, build_opts.pcap_key);
+        build_timer.stop();
+
+        if (build_opts.output_file != "") {data_sketch.write_to_file(build_opts.output_file);}
+        STATS_TIME_STAGE("estimate_cardinality");
+        print_sketch_sizing(build_opts.sizing, data_sketch.get_memory_usage());
         if (build_opts.print_cardinality) {
             std::fprintf(stdout, "Estimated_Cardinality: %lld\n", data_sketch.compute_cardinality());
         }
+    } else if (build_opts.curr_sketch == FRAC_MINHASH) {
+        StageTimer build_timer ("build_sketch");
+        FracMinHash data_sketch = get_cached_frac_minhash(build_opts.input_file, build_opts.scale, build_opts.input_data_type, build_opts.pcap_key);
+        build_timer.stop();
+
+        if (build_opts.output_file != "") {data_sketch.write_to_file(build_opts.output_file);}
+        STATS_TIME_STAGE("estimate_cardinality");
+        print_sketch_sizing(build_opts.sizing, data_sketch.get_memory_usage());
+        if (build_opts.print_cardinality) {
+            std::fprintf(stdout, "Estimated_Cardinality: %llu\n", (unsigned long long) data_sketch.get_cardinality());
+        }
+    }
+    return 1;
+}
+
+int build_column_main(const PacsketchBuildOptions& build_opts) {
+    /* Builds a HLL for each selected column and the whole feature vector in one pass, and reports their cardinalities */
+    std::vector<size_t> columns = parse_kdd_columns(build_opts.column_list);
+
+    StageTimer load_timer ("load_input");
+    size_t input_size = 0;
+    char* input_data = map_input_file(build_opts.input_file.data(), &input_size);
+    std::vector<RecordSpan> input_records = index_records(input_data, input_size);
+    load_timer.stop();
+
+    StageTimer build_timer ("build_sketch");
+    std::vector<HyperLogLog> column_sketches = build_column_sketches(input_records, columns, build_opts.bit_prefix);
+    build_timer.stop();
+
+    STATS_TIME_STAGE("estimate_cardinality");
+    print_sketch_sizing(build_opts.sizing, column_sketches.back().get_memory_usage());
+    std::fprintf(stdout, "column,feature,estimated_cardinality\n");
+    std::fprintf(stdout, "all,feature_vector,%llu\n", (unsigned long long) column_sketches.back().compute_cardinality());
+    for (size_t i = 0; i < columns.size(); i++) {
+        std::fprintf(stdout, "%zu,%s,%llu\n", columns[i], kdd_feature_names[columns[i]], 
+                     (unsigned long long) column_sketches[i].compute_cardinality());
+    }
+
+    unmap_input_file(input_data, input_size);
+    return 1;
+}
+
+template <typename InsertBatch>
+static void insert_records_in_parallel(const PacsketchBuildOptions& build_opts, InsertBatch insert_batch) {
+    /* 
+     * Splits the connection records of the input into one contiguous slice per thread, and each thread
+     * calls insert_batch(thread_num, hashes, num_hashes) on the hashes of its slice. A columnar file
+     * already holds the hashes, and text records are hashed in batches by the threads.
+     */
+    if (is_columnar_file(build_opts.input_file.data())) {
+        ColumnarFile columnar_input (build_opts.input_file);
+        const uint64_t* record_hashes = columnar_input.get_record_hashes();
+        for_each_chunk(columnar_input.get_num_records(), build_opts.num_threads, [&](size_t thread_num, size_t start, size_t end) {
+            insert_batch(thread_num, record_hashes + start, end - start);
+        });
+        return;
+    }
+
+    size_t input_size = 0;
+    char* input_data = map_input_file(build_opts.input_file.data(), &input_size);
+    std::vector<RecordSpan> input_records = index_records(input_data, input_size);
+    STATS_ADD(bytes_read, input_size);
+
+    for_each_chunk(input_records.size(), build_opts.num_threads, [&](size_t thread_num, size_t start, size_t end) {
+        uint64_t hash_batch[HLL_HASH_BATCH_SIZE];
+        for (size_t i = start; i < end; i += HLL_HASH_BATCH_SIZE) {
+            size_t batch_size = std::min(end - i, (size_t) HLL_HASH_BATCH_SIZE);
+            hash_records(&input_records[i], batch_size, hash_batch);
+            insert_batch(thread_num, hash_batch, batch_size);
+        }
+    });
+    STATS_ADD(records_parsed, input_records.size()); // the workers leave the (non-atomic) counters alone
+    unmap_input_file(input_data, input_size);
+}
+
+int build_concurrent_main(const PacsketchBuildOptions& build_opts) {
+    /* 
+     * Builds a sketch of connection records with several threads: a HLL is shared by all of them,
+     * and for a MinHash each thread keeps its own bottom-k behind a shared rejection threshold.
+     */
+    if (build_opts.curr_sketch == MINHASH) {
+        StageTimer build_timer ("build_sketch");
+        ConcurrentMinHash shared_sketch (build_opts.k_size, build_opts.input_data_type, build_opts.pcap_key);
+        std::vector<std::unique_ptr<ConcurrentMinHash::LocalBuffer>> local_buffers (build_opts.num_threads);
+        for (auto& local_buffer: local_buffers) {local_buffer.reset(new ConcurrentMinHash::LocalBuffer(shared_sketch));}
+
+        insert_records_in_parallel(build_opts, [&](size_t thread_num, const uint64_t* hash_vals, size_t num_hashes) {
+            local_buffers[thread_num]->add_hashes(hash_vals, num_hashes);
+        });
+        local_buffers.clear();
+        MinHash data_sketch = shared_sketch.snapshot();
+        build_timer.stop();
+
+        uint64_t num_accepted = shared_sketch.get_num_accepted();
+        STATS_ADD(heap_updates_accepted, num_accepted);
+        STATS_ADD(heap_updates_rejected, shared_sketch.get_num_inserted() - num_accepted);
+        STATS_ADD(heap_threshold_rejections, shared_sketch.get_num_threshold_rejected());
+
+        if (build_opts.output_file != "") {data_sketch.write_to_file(build_opts.output_file);}
+        STATS_TIME_STAGE("estimate_cardinality");
+        print_sketch_sizing(build_opts.sizing, data_sketch.get_memory_usage());
+        if (build_opts.print_cardinality) {
+            std::fprintf(stdout, "Estimated_Cardinality: %llu\n", (unsigned long long) data_sketch.get_cardinality());
+        }
+    } else if (build_opts.curr_sketch == HLL) {
+        StageTimer build_timer ("build_sketch");
+        ConcurrentHyperLogLog shared_sketch (build_opts.bit_prefix, build_opts.input_data_type, build_opts.pcap_key);
+        insert_records_in_parallel(build_opts, [&](size_t, const uint64_t* hash_vals, size_t num_hashes) {
+            shared_sketch.add_hashes(hash_vals, num_hashes);
+        });
+        HyperLogLog data_sketch = shared_sketch.snapshot();
+        build_timer.stop();
+
+        if (build_opts.output_file != "") {data_sketch.write_to_file(build_opts.output_file);}
+        STATS_TIME_STAGE("estimate_cardinality");
+        print_sketch_sizing(build_opts.sizing, data_sketch.get_memory_usage());
+        if (build_opts.print_cardinality) {
+            std::fprintf(stdout, "Estimated_Cardinality: %llu\n", (unsigned long long) data_sketch.compute_cardinality());
+        }
     }
     return 1;
 }
@@ -204,27 +723,28 @@ int dist_main(int argc, char** argv) {
 
     // Build the sketches for each input file
     if (dist_opts.curr_sketch == MINHASH) {
-        MinHash data_sketch_1 (dist_opts.input_files[0], dist_opts.k_size, dist_opts.input_data_type);
-        MinHash data_sketch_2 (dist_opts.input_files[1], dist_opts.k_size, dist_opts.input_data_type);
+        StageTimer build_timer ("build_sketches");
+        MinHash data_sketch_1 = get_cached_minhash(dist_opts.input_files[0], dist_opts.k_size, dist_opts.input_data_type, dist_opts.pcap_key);
+        MinHash data_sketch_2 = get_cached_minhash(dist_opts.input_files[1], dist_opts.k_size, dist_opts.input_data_type, dist_opts.pcap_key);
+        build_timer.stop();
+
+        STATS_TIME_STAGE("estimate_jaccard");
 
+        print_sketch_sizing(dist_opts.sizing, data_sketch_1.get_memory_usage());
         uint64_t card_a = data_sketch_1.get_cardinality();
         uint64_t card_b = data_sketch_2.get_cardinality();
         auto jaccard = MinHash::compute_jaccard(data_sketch_1, data_sketch_2);
-
-        std::cout << "Estimated values based on MinHash sketches ...\n";
-        std::cout << std::right << std::setw(10) << "|SET(A)|" <<
-                     std::right << std::setw(10) << "|SET(B)|" <<
-                     std::right << std::setw(15) << "|SET(AUB)|"  <<
-                     std::right << std::setw(10) << "J(A,B)" << std::endl;
-        std::cout << std::right << std::setw(10) << card_a <<
-                     std::right << std::setw(10) << card_b <<
-                     std::right << std::setw(15) << "N/A" <<
-                     std::right << std::setw(10) << std::setprecision(4) << jaccard << std::endl;
+        print_dist_results(MINHASH, card_a, card_b, 0, jaccard);
 
     } else if (dist_opts.curr_sketch == HLL) {
-        HyperLogLog data_sketch_1 (dist_opts.input_files[0], dist_opts.bit_prefix, dist_opts.input_data_type);
-        HyperLogLog data_sketch_2 (dist_opts.input_files[1], dist_opts.bit_prefix, dist_opts.input_data_type);
+        StageTimer build_timer ("build_sketches");
+        HyperLogLog data_sketch_1 = get_cached_hll(dist_opts.input_files[0], dist_opts.bit_prefix, dist_opts.input_data_type, dist_opts.pcap_key);
+        HyperLogLog data_sketch_2 = get_cached_hll(dist_opts.input_files[1], dist_opts.bit_prefix, dist_opts.input_data_type, dist_opts.pcap_key);
+        build_timer.stop();
 
+        STATS_TIME_STAGE("estimate_jaccard");
+
+        print_sketch_sizing(dist_opts.sizing, data_sketch_1.get_memory_usage());
         uint64_t card_a = data_sketch_1.compute_cardinality();
         uint64_t card_b = data_sketch_2.compute_cardinality();
 
@@ -232,24 +752,570 @@ int dist_main(int argc, char** argv) {
         HyperLogLog union_sketch = data_sketch_1 + data_sketch_2;
         uint64_t card_union = union_sketch.compute_cardinality();
 
-        auto jaccard = std::max(card_a + card_b - card_union + 0.0, 0.0)/(card_union);
-        if (card_union > (card_a + card_b)) {jaccard = 0.0;} // Check for overflow
+        auto jaccard = HyperLogLog::compute_jaccard(card_a, card_b, card_union);
+        print_dist_results(HLL, card_a, card_b, card_union, jaccard);
+
+    } else if (dist_opts.curr_sketch == FRAC_MINHASH) {
+        StageTimer build_timer ("build_sketches");
+        FracMinHash data_sketch_1 = get_cached_frac_minhash(dist_opts.input_files[0], dist_opts.scale, dist_opts.input_data_type, dist_opts.pcap_key);
+        FracMinHash data_sketch_2 = get_cached_frac_minhash(dist_opts.input_files[1], dist_opts.scale, dist_opts.input_data_type, dist_opts.pcap_key);
+        build_timer.stop();
 
-        std::cout << "Estimated values based on HyperLogLog sketches ...\n";
-        std::cout << std::right << std::setw(10) << "|SET(A)|" <<
-                     std::right << std::setw(10) << "|SET(B)|" <<
-                     std::right << std::setw(15) << "|SET(AUB)|"  <<
-                     std::right << std::setw(10) << "J(A,B)" << std::endl;
-        std::cout << std::right << std::setw(10) << card_a <<
-                     std::right << std::setw(10) << card_b <<
-                     std::right << std::setw(15) << card_union <<
-                     std::right << std::setw(10) << std::setprecision(4) << jaccard << std::endl;
+        STATS_TIME_STAGE("estimate_jaccard");
+
+        // Both sketches keep the same fraction of hash space, so the union is estimated from the shared hashes
+        size_t shared_hashes = FracMinHash::count_intersection(data_sketch_1, data_sketch_2);
+        uint64_t card_union = (data_sketch_1.get_num_hashes() + data_sketch_2.get_num_hashes() - shared_hashes) * dist_opts.scale;
+
+        auto jaccard = FracMinHash::compute_jaccard(data_sketch_1, data_sketch_2);
+        auto containment = FracMinHash::compute_containment(data_sketch_1, data_sketch_2);
+        print_dist_results(FRAC_MINHASH, data_sketch_1.get_cardinality(), data_sketch_2.get_cardinality(), card_union, jaccard, containment);
     }
 
     
     return 1;
 }
 
+void print_dist_results(sketch_type curr_sketch, uint64_t card_a, uint64_t card_b, uint64_t card_union, double jaccard, double containment) {
+    /* 
+     * Prints the estimated cardinalities and jaccard of two sketches, the union is not available for MinHash,
+     * and the containment of A in B is only printed when it is given (FracMinHash)
+     */
+    const char* sketch_name = (curr_sketch == MINHASH) ? "MinHash" : (curr_sketch == FRAC_MINHASH) ? "FracMinHash" : "HyperLogLog";
+    std::cout << "Estimated values based on " << sketch_name << " sketches ...\n";
+    std::cout << std::right << std::setw(10) << "|SET(A)|" <<
+                 std::right << std::setw(10) << "|SET(B)|" <<
+                 std::right << std::setw(15) << "|SET(AUB)|"  <<
+                 std::right << std::setw(10) << "J(A,B)";
+    if (containment >= 0.0) {std::cout << std::right << std::setw(10) << "C(A,B)";}
+    std::cout << std::endl;
+
+    std::cout << std::right << std::setw(10) << card_a <<
+                 std::right << std::setw(10) << card_b <<
+                 std::right << std::setw(15) << ((curr_sketch == MINHASH) ? "N/A" : std::to_string(card_union)) <<
+                 std::right << std::setw(10) << std::setprecision(4) << jaccard;
+    if (containment >= 0.0) {std::cout << std::right << std::setw(10) << std::setprecision(4) << containment;}
+    std::cout << std::endl;
+}
+
+int discretize_main(int argc, char** argv) {
+    /* main method for discretize sub-command */
+    if (argc == 1) {return pacsketch_discretize_usage();}
+
+    PacsketchDiscretizeOptions disc_opts;
+    parse_discretize_options(argc, argv, &disc_opts);
+    disc_opts.validate();
+
+    // First pass: feature statistics over the normal training records
+    StageTimer stats_timer ("feature_stats");
+    size_t train_size = 0;
+    char* train_data = map_input_file(disc_opts.input_file.data(), &train_size);
+    std::vector<RecordSpan> train_records = index_records(train_data, train_size);
+    std::vector<FeatureStats> feature_stats = compute_feature_stats(train_records, disc_opts.num_threads);
+    stats_timer.stop();
+
+    if (feature_stats[numeric_kdd_features[0]].count == 0) {FATAL_WARNING("The training data does not contain any normal records.");}
+    LOG("computed feature statistics from %lu normal records.", feature_stats[numeric_kdd_features[0]].count);
+
+    // Sketches are built directly from the binned records, if requested
+    std::unique_ptr<MinHash> minhash_sketches[2];
+    std::unique_ptr<HyperLogLog> hll_sketches[2];
+    for (size_t i = 0; i < 2; i++) {
+        if (disc_opts.curr_sketch == MINHASH) {minhash_sketches[i].reset(new MinHash(disc_opts.k_size, PACKET));}
+        if (disc_opts.curr_sketch == HLL) {hll_sketches[i].reset(new HyperLogLog(disc_opts.bit_prefix, PACKET));}
+    }
+
+    // Second pass: write the binned training records, split into all, normal and attack files
+    StageTimer binning_timer ("discretize_records");
+    FILE* output_files[3] = {NULL, NULL, NULL};
+    if (disc_opts.output_prefix != "") {
+        std::array<std::string, 3> file_suffixes = {"_converted_dataset.csv", "_converted_normal_dataset.csv", "_converted_attack_dataset.csv"};
+        for (size_t i = 0; i < 3; i++) {
+            output_files[i] = std::fopen((disc_opts.output_prefix + file_suffixes[i]).data(), "w");
+            if (output_files[i] == NULL) {THROW_EXCEPTION(("Unable to open output file: " + disc_opts.output_prefix + file_suffixes[i]).data());}
+        }
+    }
+    discretize_records(train_records, feature_stats, disc_opts.num_threads, [&](const char* record, size_t length, bool is_normal) {
+        if (output_files[0] != NULL) {
+            for (FILE* curr_file: {output_files[0], output_files[is_normal ? 1 : 2]}) {
+                std::fwrite(record, 1, length, curr_file);
+                std::fputc('\n', curr_file);
+            }
+        }
+        if (minhash_sketches[0]) {minhash_sketches[is_normal ? 0 : 1]->add_record(record, length);}
+        if (hll_sketches[0]) {hll_sketches[is_normal ? 0 : 1]->add_record(record, length);}
+    });
+    for (FILE* curr_file: output_files) {if (curr_file != NULL) {std::fclose(curr_file);}}
+    unmap_input_file(train_data, train_size);
+
+    // Bin the test records with the training statistics, into normal and attack files
+    if (disc_opts.test_file != "" && disc_opts.output_prefix != "") {
+        size_t test_size = 0;
+        char* test_data = map_input_file(disc_opts.test_file.data(), &test_size);
+        std::vector<RecordSpan> test_records = index_records(test_data, test_size);
+
+        FILE* test_files[2];
+        std::array<std::string, 2> file_suffixes = {"_converted_test_normal_dataset.csv", "_converted_test_attack_dataset.csv"};
+        for (size_t i = 0; i < 2; i++) {
+            test_files[i] = std::fopen((disc_opts.output_prefix + file_suffixes[i]).data(), "w");
+            if (test_files[i] == NULL) {THROW_EXCEPTION(("Unable to open output file: " + disc_opts.output_prefix + file_suffixes[i]).data());}
+        }
+        discretize_records(test_records, feature_stats, disc_opts.num_threads, [&](const char* record, size_t length, bool is_normal) {
+            std::fwrite(record, 1, length, test_files[is_normal ? 0 : 1]);
+            std::fputc('\n', test_files[is_normal ? 0 : 1]);
+        });
+        std::fclose(test_files[0]);
+        std::fclose(test_files[1]);
+        unmap_input_file(test_data, test_size);
+    }
+
+    binning_timer.stop();
+
+    // Compare the sketches of the binned normal (A) and attack (B) records
+    STATS_TIME_STAGE("estimate_jaccard");
+    if (disc_opts.curr_sketch == MINHASH) {
+        uint64_t card_a = minhash_sketches[0]->get_cardinality();
+        uint64_t card_b = minhash_sketches[1]->get_cardinality();
+        print_dist_results(MINHASH, card_a, card_b, 0, MinHash::compute_jaccard(*minhash_sketches[0], *minhash_sketches[1]));
+    } else if (disc_opts.curr_sketch == HLL) {
+        uint64_t card_a = hll_sketches[0]->compute_cardinality();
+        uint64_t card_b = hll_sketches[1]->compute_cardinality();
+        HyperLogLog union_sketch = *hll_sketches[0] + *hll_sketches[1];
+        uint64_t card_union = union_sketch.compute_cardinality();
+        print_dist_results(HLL, card_a, card_b, card_union, HyperLogLog::compute_jaccard(card_a, card_b, card_union));
+    }
+    return 1;
+}
+
+template <typename Callback>
+void for_each_sampled_record(std::vector<size_t>& index_range, size_t num_samples, std::mt19937& rng, Callback process_record) {
+    /* 
+     * Streams num_samples random indexes from index_range into the callback, so windows never
+     * have to be materialized. When there are enough indexes, it samples without replacement
+     * using a partial Fisher-Yates shuffle (only the sampled positions are touched), otherwise
+     * the window is larger than the dataset and it samples with replacement.
+     */
+    size_t num_indexes = index_range.size();
+    if (num_samples <= num_indexes) {
+        for (size_t i = 0; i < num_samples; i++) {
+            std::uniform_int_distribution<size_t> pick_index (i, num_indexes - 1);
+            std::swap(index_range[i], index_range[pick_index(rng)]);
+            process_record(index_range[i]);
+        }
+    } else {
+        std::uniform_int_distribution<size_t> pick_index (0, num_indexes - 1);
+        for (size_t i = 0; i < num_samples; i++) {process_record(index_range[pick_index(rng)]);}
+    }
+}
+
+int topn_main(int argc, char** argv) {
+    /* main method for topn sub-command */
+    if (argc == 1) {return pacsketch_topn_usage();}
+
+    PacsketchTopNOptions topn_opts;
+    parse_topn_options(argc, argv, &topn_opts);
+    topn_opts.validate();
+
+    StageTimer load_timer ("load_input");
+    size_t input_size = 0;
+    char* input_data = map_input_file(topn_opts.input_file.data(), &input_size);
+    std::vector<RecordSpan> input_records = index_records(input_data, input_size);
+    load_timer.stop();
+
+    size_t window_size = (topn_opts.num_records) ? topn_opts.num_records : std::max(input_records.size(), (size_t) 1);
+    CountMin window_sketch (topn_opts.width, topn_opts.top_n);
+    std::fprintf(stdout, "window,rank,estimated_count,feature_vector\n");
+
+    // Each window is a run of consecutive records, like a stream would deliver them
+    STATS_TIME_STAGE("topn_windows");
+    for (size_t window_start = 0, curr_window = 0; window_start < input_records.size(); window_start += window_size, curr_window++) {
+        STATS_TIME_WINDOW();
+        window_sketch.reset();
+
+        size_t window_end = std::min(window_start + window_size, input_records.size());
+        for (size_t i = window_start; i < window_end; i++) {window_sketch.add_record(input_records[i].start, input_records[i].length);}
+
+        size_t rank = 1;
+        for (const HeavyHitter& hitter: window_sketch.get_top_n()) {
+            size_t vec_length = hitter.feature_vec.length() - (!hitter.feature_vec.empty() && hitter.feature_vec.back() == '_');
+            std::fprintf(stdout, "%zu,%zu,%u,%.*s\n", curr_window, rank++, hitter.estimated_count, 
+                         (int) vec_length, hitter.feature_vec.data());
+        }
+    }
+
+    unmap_input_file(input_data, input_size);
+    return 1;
+}
+
+static void window_jaccards(const MinHash& window_sketch, const std::vector<MinHash>& ref_sketches,
+                            ScratchArena& scratch, std::vector<double>* jaccards) {
+    /* Jaccard between a window and each reference, computed from the bottom-k hashes */
+    for (size_t i = 0; i < ref_sketches.size(); i++) {(*jaccards)[i] = MinHash::compute_jaccard(window_sketch, ref_sketches[i], scratch);}
+    scratch.reset();
+}
+
+struct HLLWindowScratch {
+    /* 
+     * Kept for a whole HLL classify run, the union of a window and a reference is written over the
+     * same sketch, and the cardinalities of the references are only estimated once.
+     */
+    HyperLogLog union_sketch;
+    std::vector<uint64_t> ref_cardinalities;
+
+    HLLWindowScratch(const std::vector<HyperLogLog>& ref_sketches, uint8_t bit_prefix): union_sketch(bit_prefix, PACKET) {
+        for (const HyperLogLog& ref_sketch: ref_sketches) {ref_cardinalities.push_back(ref_sketch.compute_cardinality());}
+    }
+};
+
+static void window_jaccards(const HyperLogLog& window_sketch, const std::vector<HyperLogLog>& ref_sketches,
+                            HLLWindowScratch& scratch, std::vector<double>* jaccards) {
+    /* Jaccard between a window and each reference, computed from the cardinalities (inclusion-exclusion) */
+    uint64_t window_cardinality = window_sketch.compute_cardinality();
+    for (size_t i = 0; i < ref_sketches.size(); i++) {
+        scratch.union_sketch.assign_union(window_sketch, ref_sketches[i]);
+        (*jaccards)[i] = HyperLogLog::compute_jaccard(window_cardinality, scratch.ref_cardinalities[i], 
+                                                      scratch.union_sketch.compute_cardinality());
+    }
+}
+
+static UDPListener* active_listener = NULL; // listener stopped by SIGINT/SIGTERM
+
+static void stop_active_listener(int) {
+    /* Signal handler, lets the listener finish the records it has already received */
+    if (active_listener != NULL) {active_listener->stop();}
+}
+
+template <typename Sketch, typename Scratch>
+static void classify_windows(const PacsketchClassifyOptions& classify_opts, const std::vector<Sketch>& ref_sketches, 
+                             Sketch& window_sketch, Scratch& window_scratch) {
+    /*
+     * Fills the window sketch with consecutive records of the input, and compares it with each
+     * reference (normal first, then the attack classes). The estimated attack ratio follows the
+     * rule of simulate: sum(J_attack) / (J_normal + sum(J_attack)). The window is called normal
+     * if the ratio is below 0.5, and otherwise the attack class with the largest jaccard is picked.
+     */
+    std::unique_ptr<ColumnarFile> columnar_input;
+    std::unique_ptr<RecordReader> input_reader;
+    std::unique_ptr<UDPListener> udp_listener;
+    if (classify_opts.udp_endpoint != "") {
+        udp_listener.reset(new UDPListener(classify_opts.udp_address, classify_opts.udp_port));
+        active_listener = udp_listener.get();
+        std::signal(SIGINT, stop_active_listener);
+        std::signal(SIGTERM, stop_active_listener);
+        LOG("listening for records on %s:%u (udp)", classify_opts.udp_address.data(), classify_opts.udp_port);
+    } else if (classify_opts.input_file != "-" && is_columnar_file(classify_opts.input_file.data())) {
+        columnar_input.reset(new ColumnarFile(classify_opts.input_file));
+    } else {
+        input_reader.reset(new RecordReader(classify_opts.input_file));
+    }
+
+    // Records come from the stream or the UDP listener (and are hashed here), or straight from the hashes of a columnar file
+    size_t next_columnar_record = 0;
+    auto next_record_hash = [&](uint64_t* hash_val) {
+        if (columnar_input) {
+            if (next_columnar_record == columnar_input->get_num_records()) {return false;}
+            *hash_val = columnar_input->get_record_hashes()[next_columnar_record++];
+            return true;
+        }
+        RecordSpan record;
+        if (!(udp_listener ? udp_listener->next_record(&record) : input_reader->next_record(&record))) {return false;}
+        *hash_val = hash_record(record.start, record.length);
+        return true;
+    };
+    uint64_t reported_drops = 0;
+    std::vector<double> jaccards (ref_sketches.size());
+
+    std::fprintf(stdout, "window,num_records,jaccard_normal");
+    for (const std::string& class_name: classify_opts.class_names) {std::fprintf(stdout, ",jaccard_%s", class_name.data());}
+    std::fprintf(stdout, ",est_attack_ratio,predicted_class\n");
+
+    STATS_TIME_STAGE("classify_windows");
+    uint64_t hash_val = 0;
+    bool more_records = true;
+    for (size_t curr_window = 0; more_records; curr_window++) {
+        STATS_TIME_WINDOW();
+        size_t window_records = 0;
+        while (window_records < classify_opts.num_records && (more_records = next_record_hash(&hash_val))) {
+            window_sketch.add_hash(hash_val);
+            window_records++;
+        }
+        if (window_records == 0) {break;}
+
+        double attack_jaccard = 0.0;
+        size_t best_class = 0;
+        window_jaccards(window_sketch, ref_sketches, window_scratch, &jaccards);
+        for (size_t i = 1; i < ref_sketches.size(); i++) {
+            attack_jaccard += jaccards[i];
+            if (best_class == 0 || jaccards[i] > jaccards[best_class]) {best_class = i;}
+        }
+        double total_jaccard = jaccards[0] + attack_jaccard;
+        double est_attack_ratio = (total_jaccard > 0.0) ? attack_jaccard/total_jaccard : 0.0;
+
+        const char* predicted_class = "unknown";
+        if (total_jaccard > 0.0) {predicted_class = (est_attack_ratio < 0.50) ? "normal" : classify_opts.class_names[best_class-1].data();}
+
+        std::fprintf(stdout, "%zu,%zu", curr_window, window_records);
+        for (double jaccard: jaccards) {std::fprintf(stdout, ",%6.4f", jaccard);}
+        std::fprintf(stdout, ",%6.4f,%s\n", est_attack_ratio, predicted_class);
+        std::fflush(stdout);
+
+        // Datagrams lost since the last window are reported at the window boundary
+        if (udp_listener) {
+            uint64_t curr_drops = udp_listener->get_datagrams_dropped() + udp_listener->get_datagrams_truncated() + udp_listener->get_kernel_drops();
+            if (curr_drops > reported_drops) {LOG("window %zu: %lu datagrams dropped so far", curr_window, curr_drops);}
+            reported_drops = curr_drops;
+        }
+
+        window_sketch.reset();
+    }
+
+    if (udp_listener) {
+        LOG("received %lu datagrams, dropped %lu (ring full), %lu (larger than %d bytes), %lu (socket buffer)",
+            udp_listener->get_datagrams_received(), udp_listener->get_datagrams_dropped(), 
+            udp_listener->get_datagrams_truncated(), UDP_MAX_DATAGRAM, udp_listener->get_kernel_drops());
+        pacsketch_stats.udp_datagrams_received = udp_listener->get_datagrams_received();
+        pacsketch_stats.udp_datagrams_dropped = udp_listener->get_datagrams_dropped() + udp_listener->get_datagrams_truncated() + 
+                                                udp_listener->get_kernel_drops();
+        active_listener = NULL;
+    }
+}
+
+int classify_main(int argc, char** argv) {
+    /* main method for classify sub-command */
+    if (argc == 1) {return pacsketch_classify_usage();}
+
+    PacsketchClassifyOptions classify_opts;
+    parse_classify_options(argc, argv, &classify_opts);
+    classify_opts.validate();
+
+    // The reference sketches are built once, the first one is for normal records
+    std::vector<std::string> ref_files (1, classify_opts.normal_file);
+    ref_files.insert(ref_files.end(), classify_opts.attack_files.begin(), classify_opts.attack_files.end());
+
+    if (classify_opts.curr_sketch == MINHASH) {
+        StageTimer reference_timer ("build_reference_sketches");
+        std::vector<MinHash> ref_sketches;
+        for (const std::string& file_path: ref_files) {ref_sketches.push_back(get_cached_minhash(file_path, classify_opts.k_size, PACKET));}
+        reference_timer.stop();
+
+        MinHash window_sketch (classify_opts.k_size, PACKET);
+        ScratchArena window_scratch;
+        classify_windows(classify_opts, ref_sketches, window_sketch, window_scratch);
+    } else if (classify_opts.curr_sketch == HLL) {
+        StageTimer reference_timer ("build_reference_sketches");
+        std::vector<HyperLogLog> ref_sketches;
+        for (const std::string& file_path: ref_files) {ref_sketches.push_back(get_cached_hll(file_path, classify_opts.bit_prefix, PACKET));}
+        reference_timer.stop();
+
+        HyperLogLog window_sketch (classify_opts.bit_prefix, PACKET);
+        HLLWindowScratch window_scratch (ref_sketches, classify_opts.bit_prefix);
+        classify_windows(classify_opts, ref_sketches, window_sketch, window_scratch);
+    }
+    return 1;
+}
+
+int convert_main(int argc, char** argv) {
+    /* main method for convert sub-command */
+    if (argc == 1) {return pacsketch_convert_usage();}
+
+    PacsketchConvertOptions convert_opts;
+    parse_convert_options(argc, argv, &convert_opts);
+    convert_opts.validate();
+
+    StageTimer load_timer ("load_input");
+    size_t input_size = 0;
+    char* input_data = map_input_file(convert_opts.input_file.data(), &input_size);
+    std::vector<RecordSpan> input_records = index_records(input_data, input_size);
+    load_timer.stop();
+
+    StageTimer convert_timer ("write_columnar");
+    write_columnar_file(input_records, convert_opts.output_file);
+    convert_timer.stop();
+
+    LOG("converted %lu records into %s", input_records.size(), convert_opts.output_file.data());
+    unmap_input_file(input_data, input_size);
+    return 1;
+}
+
+int merge_main(int argc, char** argv) {
+    /* main method for merge sub-command */
+    if (argc == 1) {return pacsketch_merge_usage();}
+
+    PacsketchMergeOptions merge_opts;
+    parse_merge_options(argc, argv, &merge_opts);
+    merge_opts.validate();
+
+    StageTimer list_timer ("list_inputs");
+    std::vector<std::string> sketch_files = list_sketch_files(merge_opts.input_paths);
+    if (sketch_files.empty()) {FATAL_WARNING("No sketch files were found in the given paths.");}
+    SketchFileHeader first_header = read_sketch_header(sketch_files[0]);
+    STATS_ADD(bytes_read, sketch_files.size() * (sizeof(SketchFileHeader) + first_header.payload_size));
+    list_timer.stop();
+
+    STATS_TIME_STAGE("merge_sketches");
+    uint64_t cardinality = 0;
+    if (first_header.sketch == MINHASH) {
+        MinHash union_sketch = merge_minhash_files(sketch_files, merge_opts.num_threads);
+        if (merge_opts.output_file != "") {union_sketch.write_to_file(merge_opts.output_file);}
+        cardinality = union_sketch.get_cardinality();
+    } else if (first_header.sketch == FRAC_MINHASH) {
+        FracMinHash union_sketch = merge_frac_minhash_files(sketch_files, merge_opts.num_threads);
+        if (merge_opts.output_file != "") {union_sketch.write_to_file(merge_opts.output_file);}
+        cardinality = union_sketch.get_cardinality();
+    } else {
+        HyperLogLog union_sketch = merge_hll_files(sketch_files, merge_opts.num_threads);
+        if (merge_opts.output_file != "") {union_sketch.write_to_file(merge_opts.output_file);}
+        cardinality = union_sketch.compute_cardinality();
+    }
+
+    if (merge_opts.print_cardinality) {std::fprintf(stdout, "Estimated_Cardinality: %llu\n", (unsigned long long) cardinality);}
+    LOG("merged %lu %s sketches", sketch_files.size(), (first_header.sketch == MINHASH) ? "MinHash" : 
+                                                        (first_header.sketch == FRAC_MINHASH) ? "FracMinHash" : "HyperLogLog");
+    return 1;
+}
+
+static void build_pyramid(const PacsketchPyramidOptions& pyramid_opts) {
+    /*
+     * Streams the input into the finest windows of the pyramid, which merges the coarser levels as
+     * they complete. Record windows close after every n records, and time windows are aligned to
+     * multiples of their duration. The windows of a gap in a capture are still closed (empty), so
+     * window i of a level always covers the same span, and packets that go back in time are kept
+     * in the open window. A jump of more than MAX_PYRAMID_GAP_WINDOWS windows is rejected, since
+     * it would write an empty sketch file for each of them.
+     */
+    std::unique_ptr<PcapReader> pcap_input;
+    std::unique_ptr<ColumnarFile> columnar_input;
+    std::unique_ptr<RecordReader> input_reader;
+    if (pyramid_opts.input_pcap) {
+        pcap_input.reset(new PcapReader(pyramid_opts.input_file));
+    } else if (pyramid_opts.input_file != "-" && is_columnar_file(pyramid_opts.input_file.data())) {
+        columnar_input.reset(new ColumnarFile(pyramid_opts.input_file));
+    } else {
+        input_reader.reset(new RecordReader(pyramid_opts.input_file));
+    }
+
+    // Packets come with their timestamp, records are hashed here or come straight from the hashes of a columnar file
+    PacketHeaders headers;
+    size_t next_columnar_record = 0;
+    auto next_hash = [&](uint64_t* hash_val) {
+        if (pcap_input) {
+            if (!pcap_input->next_packet(&headers)) {return false;}
+            *hash_val = hash_packet_key(headers, pyramid_opts.pcap_key);
+            return true;
+        }
+        if (columnar_input) {
+            if (next_columnar_record == columnar_input->get_num_records()) {return false;}
+            *hash_val = columnar_input->get_record_hashes()[next_columnar_record++];
+            return true;
+        }
+        RecordSpan record;
+        if (!input_reader->next_record(&record)) {return false;}
+        *hash_val = hash_record(record.start, record.length);
+        return true;
+    };
+
+    PyramidLayout layout;
+    layout.prefix_bits = pyramid_opts.bit_prefix;
+    layout.input_type = pyramid_opts.input_data_type;
+    layout.window_unit = (pyramid_opts.window_ns) ? TIME_WINDOWS : RECORD_WINDOWS;
+    layout.window_size = (pyramid_opts.window_ns) ? pyramid_opts.window_ns : pyramid_opts.num_records;
+    layout.level_factors = pyramid_opts.level_factors;
+
+    uint64_t hash_val = 0;
+    bool has_record = next_hash(&hash_val);
+    if (has_record && layout.window_unit == TIME_WINDOWS) {layout.first_window_start = headers.timestamp_ns - headers.timestamp_ns % layout.window_size;}
+
+    std::fprintf(stdout, "level,window,start,end,estimated_cardinality\n");
+    auto print_window = [&](size_t level, uint64_t window_num, const HyperLogLog& window_sketch) {
+        uint64_t window_span = layout.get_level_span(level) * layout.window_size;
+        uint64_t window_start = layout.first_window_start + window_num * window_span;
+        std::fprintf(stdout, "%zu,%llu,%llu,%llu,%llu\n", level, (unsigned long long) window_num, (unsigned long long) window_start,
+                     (unsigned long long) (window_start + window_span), (unsigned long long) window_sketch.compute_cardinality());
+        if (level + 1 == layout.level_factors.size()) {std::fflush(stdout);}
+    };
+
+    STATS_TIME_STAGE("build_pyramid");
+    HLLPyramid pyramid (pyramid_opts.pyramid_dir, layout, pyramid_opts.pcap_key, print_window);
+    uint64_t window_end = layout.first_window_start + layout.window_size;
+    uint64_t window_records = 0, total_records = 0;
+    for (; has_record; has_record = next_hash(&hash_val)) {
+        if (layout.window_unit == TIME_WINDOWS) {
+            if (headers.timestamp_ns >= window_end && (headers.timestamp_ns - window_end) / layout.window_size >= MAX_PYRAMID_GAP_WINDOWS) {
+                FATAL_WARNING(("Packet " + std::to_string(total_records + 1) + " has a timestamp of " + std::to_string(headers.timestamp_ns) +
+                               " ns, more than " + std::to_string(MAX_PYRAMID_GAP_WINDOWS) + " windows after the open window (which ends at " +
+                               std::to_string(window_end) + " ns). The capture has a bogus timestamp, or starts with frames that have none " +
+                               "(simple packet blocks), or the window duration (-s) is too short for its gaps.").data());
+            }
+            for (; headers.timestamp_ns >= window_end; window_end += layout.window_size) {pyramid.close_window(); window_records = 0;}
+        }
+        pyramid.add_hash(hash_val);
+        window_records++;
+        total_records++;
+        if (layout.window_unit == RECORD_WINDOWS && window_records == layout.window_size) {pyramid.close_window(); window_records = 0;}
+    }
+    if (window_records) {pyramid.close_window();} // the last finest window is partial
+    std::fflush(stdout);
+
+    if (pcap_input && pcap_input->get_num_skipped()) {LOG("%lu frames were not IPv4/IPv6, and were skipped", pcap_input->get_num_skipped());}
+    LOG("built a pyramid of %lu windows (%lu levels) from %lu %s", pyramid.get_layout().num_windows[0], layout.level_factors.size(),
+        total_records, (pcap_input) ? "packets" : "records");
+}
+
+int pyramid_main(int argc, char** argv) {
+    /* main method for pyramid sub-command */
+    if (argc == 1) {return pacsketch_pyramid_usage();}
+
+    PacsketchPyramidOptions pyramid_opts;
+    parse_pyramid_options(argc, argv, &pyramid_opts);
+    pyramid_opts.validate();
+
+    if (pyramid_opts.input_file != "") {build_pyramid(pyramid_opts);}
+    if (pyramid_opts.parsed_ranges.empty()) {return 1;}
+
+    // Each range is answered from the stored windows alone, the input is not read again
+    STATS_TIME_STAGE("query_pyramid");
+    PyramidLayout layout = read_pyramid_layout(pyramid_opts.pyramid_dir);
+    std::fprintf(stdout, "range_start,range_end,sketches_merged,estimated_cardinality\n");
+    for (const std::pair<uint64_t, uint64_t>& range: pyramid_opts.parsed_ranges) {
+        size_t num_sketches = 0;
+        HyperLogLog range_sketch = HLLPyramid::query_range(pyramid_opts.pyramid_dir, layout, range.first, range.second, &num_sketches);
+        std::fprintf(stdout, "%llu,%llu,%zu,%llu\n", (unsigned long long) range.first, (unsigned long long) range.second,
+                     num_sketches, (unsigned long long) range_sketch.compute_cardinality());
+    }
+    return 1;
+}
+
+static double compare_windows(const MinHash& op1, const MinHash& op2, ScratchArena& scratch) {
+    /* Similarity of two simulated windows of the same size, for MinHash it is the jaccard */
+    return MinHash::compute_jaccard(op1, op2, scratch);
+}
+
+static double compare_windows(const FracMinHash& op1, const FracMinHash& op2, ScratchArena&) {
+    /* Similarity of two simulated windows of the same size, for FracMinHash it is the jaccard */
+    return FracMinHash::compute_jaccard(op1, op2);
+}
+
+static double compare_to_reference(const MinHash& window, const MinHash& reference, ScratchArena& scratch) {
+    /* Similarity of a window to a reference sketch of the whole training set, for MinHash it is the jaccard */
+    return MinHash::compute_jaccard(window, reference, scratch);
+}
+
+static double compare_to_reference(const FracMinHash& window, const FracMinHash& reference, ScratchArena&) {
+    /* 
+     * Similarity of a window to a reference sketch of the whole training set, for FracMinHash it is the
+     * containment of the window in the reference, which does not shrink as the reference grows
+     */
+    return FracMinHash::compute_containment(window, reference);
+}
+
+static bool has_records(const std::string& file_path) {
+    /* Checks that an input holds at least one record (blank lines are not records), without reading all of it */
+    if (is_columnar_file(file_path.data())) {return ColumnarFile(file_path).get_num_records() > 0;}
+    RecordReader input_reader (file_path);
+    RecordSpan record;
+    return input_reader.next_record(&record);
+}
+
 int simulate_main(int argc, char** argv) {
     /* main method for simulate sub-command */
     if (argc == 1) {return pacsketch_simulate_usage();}
@@ -259,147 +1325,125 @@ int simulate_main(int argc, char** argv) {
     parse_simulate_options(argc, argv, &sim_opts);
     sim_opts.validate();
 
-    // Memory-map the two input files, and checks for errors
-    size_t pagesize = getpagesize();
-    size_t input_1_fd = open(sim_opts.input_files[0].data(), O_RDONLY);
-    size_t input_2_fd = open(sim_opts.input_files[1].data(), O_RDONLY);
-
-    struct stat s1, s2;
-    if (fstat(input_1_fd, &s1) < 0 || fstat(input_2_fd, &s2) < 0) {THROW_EXCEPTION("Error occurred when getting file stats.");}
+    if (sim_opts.curr_sketch == HLL) {NOT_IMPL("still working on using HLL for simulation ...");}
 
-    char* input_1_data = static_cast<char*>(mmap((caddr_t)0, s1.st_size, PROT_READ, MAP_SHARED, input_1_fd, 0));
-    char* input_2_data = static_cast<char*>(mmap((caddr_t)0, s2.st_size, PROT_READ, MAP_SHARED, input_2_fd, 0));
-
-    if (input_1_data == (caddr_t)(-1) || input_2_data == (caddr_t)(-1)) {
-        THROW_EXCEPTION("Error occurred, while memory-mapping the input files.");
+    // In test mode, the input files are only used for the reference sketches, so they can come from the sketch cache
+    if (sim_opts.test_mode) {
+        if (!has_records(sim_opts.input_files[0]) || !has_records(sim_opts.input_files[1])) {
+            FATAL_WARNING("Both of the input files need to contain at least one record.");
+        }
+        StageTimer reference_timer ("build_reference_sketches");
+        if (sim_opts.curr_sketch == MINHASH) {
+            MinHash normal_sketch = get_cached_minhash(sim_opts.input_files[0], sim_opts.k_size, PACKET);
+            MinHash attack_sketch = get_cached_minhash(sim_opts.input_files[1], sim_opts.k_size, PACKET);
+            reference_timer.stop();
+            return simulate_test_main(normal_sketch, attack_sketch, sim_opts, MinHash(sim_opts.k_size, PACKET));
+        }
+        FracMinHash normal_sketch = get_cached_frac_minhash(sim_opts.input_files[0], sim_opts.scale, PACKET);
+        FracMinHash attack_sketch = get_cached_frac_minhash(sim_opts.input_files[1], sim_opts.scale, PACKET);
+        reference_timer.stop();
+        return simulate_test_main(normal_sketch, attack_sketch, sim_opts, FracMinHash(sim_opts.scale, PACKET));
     }
 
-    // Will hold the files in a vector form for direct access to records
-    std::vector<std::string> input_1_feature_vecs;
-    std::vector<std::string> input_2_feature_vecs;
-
-    // Determine the number of records in each dataset to simulate from
-    char buf[128]; // Assumption: we know each line is less than 128 characters    
-    size_t input_1_records = 0;
-    size_t input_2_records = 0;
+    // Hash every record of the two input files once, the windows only sample the hashes
+    StageTimer load_timer ("load_input");
+    std::vector<uint64_t> input_1_hashes = load_record_hashes(sim_opts.input_files[0].data(), NULL);
+    std::vector<uint64_t> input_2_hashes = load_record_hashes(sim_opts.input_files[1].data(), NULL);
+    if (input_1_hashes.empty() || input_2_hashes.empty()) {FATAL_WARNING("Both of the input files need to contain at least one record.");}
+    load_timer.stop();
 
-    char* input_1_copy = input_1_data;
-    char* input_2_copy = input_2_data;
-    while(cgets(buf, sizeof(buf), &input_1_copy) != NULL) {input_1_records++; input_1_feature_vecs.push_back(std::string(buf));}
-    while(cgets(buf, sizeof(buf), &input_2_copy) != NULL) {input_2_records++; input_2_feature_vecs.push_back(std::string(buf));}
+    // The sketches of each window are copies of an empty sketch of the requested type
+    if (sim_opts.curr_sketch == MINHASH) {
+        return simulate_windows_main(input_1_hashes, input_2_hashes, sim_opts, MinHash(sim_opts.k_size, sim_opts.input_data_type));
+    }
+    return simulate_windows_main(input_1_hashes, input_2_hashes, sim_opts, FracMinHash(sim_opts.scale, sim_opts.input_data_type));
+}
 
-    // If in test mode, will call a certain function
-    // TO DO: when HLL is implemented, make that method templated ...
-    if (sim_opts.test_mode && sim_opts.use_minhash) {return simulate_test_main(input_1_feature_vecs, input_2_feature_vecs, sim_opts);}
-    if (sim_opts.test_mode && sim_opts.use_hll) {NOT_IMPL("still working on using HLL for simulation mode.");}
+template <typename Sketch>
+int simulate_windows_main(const std::vector<uint64_t>& input_1_hashes, const std::vector<uint64_t>& input_2_hashes,
+                          const PacsketchSimulateOptions& sim_opts, const Sketch& empty_sketch) {
+    /* Simulates windows from the two input files, and compares a "mixed" window with a "pure" window of each file */
 
     // Build range, that will be shuffled to get random samples
-    std::vector<size_t> input_1_range (input_1_records);
-    std::vector<size_t> input_2_range (input_2_records);
+    std::vector<size_t> input_1_range (input_1_hashes.size());
+    std::vector<size_t> input_2_range (input_2_hashes.size());
 
     std::iota(input_1_range.begin(), input_1_range.end(), 0);
     std::iota(input_2_range.begin(), input_2_range.end(), 0);
 
+    if (sim_opts.num_records > std::min(input_1_hashes.size(), input_2_hashes.size())) {
+        LOG("window size is larger than one of the input datasets, so records will be sampled with replacement.");
+    }
+
     // Determine the number of each record type in "mixed" window
     size_t num_normal_records, num_attack_records;
     std::tie(num_normal_records, num_attack_records) = determine_window_breakdown(sim_opts.num_records, sim_opts.attack_percent);
 
     // Simulate various windows of packets, and compute the jaccard scores
-    std::vector<size_t> input_1_subset, input_2_subset, input_mixed_subset;
+    std::mt19937 rng {std::random_device{}()};
     std::fprintf(stdout, "type,attack_ratio,jaccard\n");
 
-    for (size_t curr_window = 0; curr_window < sim_opts.num_windows; curr_window++) {
+    // The window sketches and scratch space are created once, and reset for each window
+    Sketch data_sketch_1 (empty_sketch);
+    Sketch data_sketch_2 (empty_sketch);
+    Sketch data_sketch_mixed (empty_sketch);
+    ScratchArena window_scratch;
 
-        // Generate the random shuffles to extract samples
-        std::shuffle(input_1_range.begin(), input_1_range.end(), std::mt19937{std::random_device{}()});
-        std::shuffle(input_2_range.begin(), input_2_range.end(), std::mt19937{std::random_device{}()});
-
-        // Generates the pure "normal" and "attack" sketches, the indexes at least ...
-        std::for_each(input_1_range.begin(), input_1_range.begin()+sim_opts.num_records, 
-                     [&](size_t val) {input_1_subset.push_back(val);});
-        std::for_each(input_2_range.begin(), input_2_range.begin()+sim_opts.num_records, 
-                     [&](size_t val) {input_2_subset.push_back(val);});
-
-        // Shuffle again before sampling indexes for mixed window ...
-        std::shuffle(input_1_range.begin(), input_1_range.end(), std::mt19937{std::random_device{}()});
-        std::shuffle(input_2_range.begin(), input_2_range.end(), std::mt19937{std::random_device{}()});
-        
-        // Generates the "mixed" skectch, some normal and some attack records ...
-        std::for_each(input_1_range.begin(), input_1_range.begin()+num_normal_records, 
-                     [&](size_t val) {input_mixed_subset.push_back(val);});
-        std::for_each(input_2_range.begin(), input_2_range.begin()+num_attack_records, 
-                     [&](size_t val) {input_mixed_subset.push_back(val);});
-                
-        auto file_1_records = sample_records_at_indexes(input_1_feature_vecs, input_1_subset);
-        auto file_2_records = sample_records_at_indexes(input_2_feature_vecs, input_2_subset);
-        auto file_mixed_records = sample_mixed_records_at_indexes(input_1_feature_vecs, num_normal_records,
-                                                                  input_2_feature_vecs, num_attack_records,
-                                                                  input_mixed_subset);
-                                                                  
-        // At this point, we have 3 different random samples: 1 "pure" normal, 1 "pure" attack, and 1 "mixed" window
-        std::vector<std::string> window_dataset;
-        if (sim_opts.curr_sketch == MINHASH) {
-            MinHash data_sketch_1 (file_1_records, sim_opts.k_size, sim_opts.input_data_type);
-            MinHash data_sketch_2 (file_2_records, sim_opts.k_size, sim_opts.input_data_type);
-            MinHash data_sketch_mixed (file_mixed_records, sim_opts.k_size, sim_opts.input_data_type);
-
-            auto jaccard_1_mixed = MinHash::compute_jaccard(data_sketch_1, data_sketch_mixed);
-            auto jaccard_2_mixed = MinHash::compute_jaccard(data_sketch_2, data_sketch_mixed);
-            double estimated_attack_records = (jaccard_2_mixed + 0.0)/(jaccard_1_mixed + jaccard_2_mixed);
-        
-            std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "normal_attack", sim_opts.attack_percent, jaccard_1_mixed);
-            std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "attack_attack", sim_opts.attack_percent, jaccard_2_mixed);
-            std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "est_attack_ratio", sim_opts.attack_percent, estimated_attack_records);
-        }
-        else if (sim_opts.curr_sketch == HLL) {
-            NOT_IMPL("still working on using HLL for simulation ...");
-        }
-
-        input_1_subset.clear();
-        input_2_subset.clear();
-        input_mixed_subset.clear();
-    }
-
-       
-    if (munmap(input_1_data, s1.st_size) < 0 || munmap(input_2_data, s2.st_size) < 0) {
-        perror("Error occurred while unmapping the input files");
-        std::exit(1);
+    STATS_TIME_STAGE("simulate_windows");
+    for (size_t curr_window = 0; curr_window < sim_opts.num_windows; curr_window++) {
+        STATS_TIME_WINDOW();
+
+        // We build 3 different random samples: 1 "pure" normal, 1 "pure" attack, and 1 "mixed" window,
+        // and each sampled record goes straight into its sketch
+        data_sketch_1.reset();
+        data_sketch_2.reset();
+        data_sketch_mixed.reset();
+        window_scratch.reset();
+
+        for_each_sampled_record(input_1_range, sim_opts.num_records, rng, [&](size_t index) {
+            data_sketch_1.add_hash(input_1_hashes[index]);});
+        for_each_sampled_record(input_2_range, sim_opts.num_records, rng, [&](size_t index) {
+            data_sketch_2.add_hash(input_2_hashes[index]);});
+
+        // Sample again for the "mixed" sketch, some normal and some attack records ...
+        for_each_sampled_record(input_1_range, num_normal_records, rng, [&](size_t index) {
+            data_sketch_mixed.add_hash(input_1_hashes[index]);});
+        for_each_sampled_record(input_2_range, num_attack_records, rng, [&](size_t index) {
+            data_sketch_mixed.add_hash(input_2_hashes[index]);});
+
+        auto jaccard_1_mixed = compare_windows(data_sketch_1, data_sketch_mixed, window_scratch);
+        auto jaccard_2_mixed = compare_windows(data_sketch_2, data_sketch_mixed, window_scratch);
+        double estimated_attack_records = (jaccard_2_mixed + 0.0)/(jaccard_1_mixed + jaccard_2_mixed);
+    
+        std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "normal_attack", sim_opts.attack_percent, jaccard_1_mixed);
+        std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "attack_attack", sim_opts.attack_percent, jaccard_2_mixed);
+        std::fprintf(stdout, "%s,%3.2f,%6.4f\n", "est_attack_ratio", sim_opts.attack_percent, estimated_attack_records);
     }
     return 1;
 }
 
-int simulate_test_main(std::vector<std::string> normal_records, std::vector<std::string> attack_records, PacsketchSimulateOptions sim_opts) {
-    /* main method of simulate sub-command when test-mode is turned on */
-
-    // Open test files, and memory map them
-    struct stat s1, s2;
-    size_t test_normal_fd = open(sim_opts.test_files[0].data(), O_RDONLY);
-    size_t test_attack_fd = open(sim_opts.test_files[1].data(), O_RDONLY);
-
-    if (fstat(test_normal_fd, &s1) < 0) {THROW_EXCEPTION("Error occurred when getting test file stats.");}
-    if (fstat(test_attack_fd, &s2) < 0) {THROW_EXCEPTION("Error occurred when getting test file stats.");}
-    char* test_normal_data = static_cast<char*>(mmap((caddr_t)0, s1.st_size, PROT_READ, MAP_SHARED, test_normal_fd, 0));
-    char* test_attack_data = static_cast<char*>(mmap((caddr_t)0, s2.st_size, PROT_READ, MAP_SHARED, test_attack_fd, 0));
+template <typename Sketch>
+int simulate_test_main(const Sketch& normal_sketch, const Sketch& attack_sketch, const PacsketchSimulateOptions& sim_opts,
+                       const Sketch& empty_sketch) {
+    /* main method of simulate sub-command when test-mode is turned on, the reference sketches are built from the training set */
 
-    // Parse the both test files into feature vectors
-    char buf[128];
-    std::vector<std::string> test_normal_feature_vecs, test_attack_feature_vecs;
-
-    char* test_normal_copy = test_normal_data;
-    char* test_attack_copy = test_attack_data;
-    while(cgets(buf, sizeof(buf), &test_normal_copy) != NULL) {test_normal_feature_vecs.push_back(std::string(buf));}
-    while(cgets(buf, sizeof(buf), &test_attack_copy) != NULL) {test_attack_feature_vecs.push_back(std::string(buf));}
+    // Hash the records of the test files, and keep their labels
+    StageTimer load_timer ("load_test_input");
+    std::vector<uint8_t> test_normal_labels, test_attack_labels;
+    std::vector<uint64_t> test_normal_hashes = load_record_hashes(sim_opts.test_files[0].data(), &test_normal_labels);
+    std::vector<uint64_t> test_attack_hashes = load_record_hashes(sim_opts.test_files[1].data(), &test_attack_labels);
+    if (test_normal_hashes.empty() || test_attack_hashes.empty()) {FATAL_WARNING("Both of the test files need to contain at least one record.");}
+    load_timer.stop();
 
     // Build a range of indexes that could be selected from test set
-    std::vector<size_t> test_normal_set_range (test_normal_feature_vecs.size());
-    std::vector<size_t> test_attack_set_range (test_attack_feature_vecs.size());
+    std::vector<size_t> test_normal_set_range (test_normal_hashes.size());
+    std::vector<size_t> test_attack_set_range (test_attack_hashes.size());
     std::iota(test_normal_set_range.begin(), test_normal_set_range.end(), 0);
     std::iota(test_attack_set_range.begin(), test_attack_set_range.end(), 0);
 
-    // Build the overall "normal" and "attack" sketches, based on training set
-    // IMPORTANT: when this function is templated, the "MinHash" will be "T"
-    MinHash normal_sketch (normal_records, sim_opts.k_size, sim_opts.input_data_type);
-    MinHash attack_sketch (attack_records, sim_opts.k_size, sim_opts.input_data_type);
+    if (sim_opts.num_records > std::min(test_normal_hashes.size(), test_attack_hashes.size())) {
+        LOG("window size is larger than one of the test datasets, so records will be sampled with replacement.");
+    }
 
     // Set up the confusion matrix, to be able to compute classification metrics
     std::array<size_t, 2> true_normal_row = {0, 0}; // TP, FN
@@ -415,115 +1459,101 @@ int simulate_test_main(std::vector<std::string> normal_records, std::vector<std:
 
     // Simulate the requested number of windows
     std::srand(time(NULL));
-    std::vector<size_t> test_set_subset;
-    std::fprintf(stdout, "approach,true_attack_ratio,jaccard_normal,jaccard_attack,est_attack_ratio\n");
+    std::mt19937 rng {std::random_device{}()};
+    std::uniform_real_distribution<double> uniform_prob (0.0, 1.0);
+    if (sim_opts.curr_sketch == FRAC_MINHASH) {
+        std::fprintf(stdout, "approach,true_attack_ratio,containment_normal,containment_attack,est_attack_ratio\n");
+    } else {
+        std::fprintf(stdout, "approach,true_attack_ratio,jaccard_normal,jaccard_attack,est_attack_ratio\n");
+    }
 
-    for (size_t curr_window = 0; curr_window < sim_opts.num_windows; curr_window++) {
+    // The test window sketch and scratch space are created once, and reset for each window
+    Sketch test_sketch (empty_sketch);
+    ScratchArena window_scratch;
 
-        // Generate the random shuffles, and extract the random indexes
-        std::shuffle(test_normal_set_range.begin(), test_normal_set_range.end(), std::mt19937{std::random_device{}()});
-        std::shuffle(test_attack_set_range.begin(), test_attack_set_range.end(), std::mt19937{std::random_device{}()});
+    StageTimer windows_timer ("simulate_windows");
+    for (size_t curr_window = 0; curr_window < sim_opts.num_windows; curr_window++) {
+        STATS_TIME_WINDOW();
 
         // Randomly decide what percentage of attack records do you want
         double attack_ratio = ((double) std::rand())/RAND_MAX;
         attack_ratio = std::round(attack_ratio * 1000.0)/1000.0;
-        double normal_ratio = 1 - attack_ratio;
 
         size_t num_normal_records, num_attack_records;
         std::tie(num_normal_records, num_attack_records) = determine_window_breakdown(sim_opts.num_records, attack_ratio);
 
-        // Generates the "test window" sketch, some normal and some attack records ...
-        std::for_each(test_normal_set_range.begin(), test_normal_set_range.begin()+num_normal_records, 
-                     [&](size_t val) {test_set_subset.push_back(val);});
-        std::for_each(test_attack_set_range.begin(), test_attack_set_range.begin()+num_attack_records, 
-                     [&](size_t val) {test_set_subset.push_back(val);});
+        test_sketch.reset();
+        window_scratch.reset();
 
-        auto test_mixed_records = sample_mixed_records_at_indexes(test_normal_feature_vecs, num_normal_records,
-                                                                  test_attack_feature_vecs, num_attack_records,
-                                                                  test_set_subset);
+        // The sampler is an Oracle that sees a uniform random subset of the window, it is drawn
+        // while streaming with selection sampling so the window records are never stored
+        size_t num_samples = (size_t) (sim_opts.num_records * SAMPLING_RATE);
+        size_t records_seen = 0, window_normal = 0, samples_taken = 0, sample_normal = 0;
 
-        // Extracts the true ratios (rounding could have affected it)
-        double true_normal_percent, true_attack_percent;
-        std::tie(true_normal_percent, true_attack_percent) = analyze_record_labels_in_window(test_mixed_records);
+        auto process_record = [&](uint64_t hash_val, bool normal_label) {
+            test_sketch.add_hash(hash_val);
+            window_normal += normal_label;
 
-        if (sim_opts.curr_sketch == MINHASH) {
-            MinHash test_sketch (test_mixed_records, sim_opts.k_size, sim_opts.input_data_type);
+            if ((sim_opts.num_records - records_seen) * uniform_prob(rng) < (num_samples - samples_taken)) {
+                samples_taken++;
+                sample_normal += normal_label;
+            }
+            records_seen++;
+        };
 
-            auto jaccard_normal = MinHash::compute_jaccard(test_sketch, normal_sketch);
-            auto jaccard_attack = MinHash::compute_jaccard(test_sketch, attack_sketch);
+        // Generates the "test window" sketch, some normal and some attack records ...
+        for_each_sampled_record(test_normal_set_range, num_normal_records, rng, [&](size_t index) {
+            process_record(test_normal_hashes[index], test_normal_labels[index]);});
+        for_each_sampled_record(test_attack_set_range, num_attack_records, rng, [&](size_t index) {
+            process_record(test_attack_hashes[index], test_attack_labels[index]);});
 
-            double estimated_attack_jaccard = (jaccard_attack + 0.0)/(jaccard_attack + jaccard_normal);
-            double estimated_attack_sampler = estimate_attack_ratio_with_sampling(test_mixed_records);
-            increment_confusion(estimated_attack_jaccard, true_attack_percent);
+        // Extracts the true ratios (rounding could have affected it)
+        double true_normal_percent, true_attack_percent;
+        std::tie(true_normal_percent, true_attack_percent) = compute_label_ratios(window_normal, records_seen);
 
-            std::fprintf(stdout, "%s,%6.4f,%6.4f,%6.4f,%6.4f\n",
-                                "pacsketch", true_attack_percent, jaccard_normal, 
-                                jaccard_attack, estimated_attack_jaccard);
-            std::fprintf(stdout, "%s,%6.4f,%6.4f,%6.4f,%6.4f\n",
-                                "sampling", true_attack_percent, jaccard_normal, 
-                                jaccard_attack, estimated_attack_sampler);
+        auto score_normal = compare_to_reference(test_sketch, normal_sketch, window_scratch);
+        auto score_attack = compare_to_reference(test_sketch, attack_sketch, window_scratch);
 
-        }
-        else if (sim_opts.curr_sketch == HLL) {
-            NOT_IMPL("still working on implementing this method for HLLs ...");
-        }
-        
-        test_set_subset.clear();
+        double estimated_attack_score = (score_attack + 0.0)/(score_attack + score_normal);
+        double estimated_attack_sampler = std::get<1>(compute_label_ratios(sample_normal, samples_taken));
+        increment_confusion(estimated_attack_score, true_attack_percent);
+
+        std::fprintf(stdout, "%s,%6.4f,%6.4f,%6.4f,%6.4f\n",
+                            "pacsketch", true_attack_percent, score_normal, 
+                            score_attack, estimated_attack_score);
+        std::fprintf(stdout, "%s,%6.4f,%6.4f,%6.4f,%6.4f\n",
+                            "sampling", true_attack_percent, score_normal, 
+                            score_attack, estimated_attack_sampler);
     }
     
+    windows_timer.stop();
+
     // Print confusion matrix to stderr ...
     std::fprintf(stderr, "Pacsketch Confusion Matrix on Test-Data ...\n");
     std::fprintf(stderr, "\tTP = %d, FN = %d\n", true_normal_row[0], true_normal_row[1]);
     std::fprintf(stderr, "\tFP = %d, TN = %d\n", true_attack_row[0], true_attack_row[1]);
-
-   if (munmap(test_normal_data, s1.st_size) < 0 || munmap(test_attack_data, s2.st_size) < 0) {
-        perror("Error occurred while unmapping the input files");
-        std::exit(1);
-    }
     return 1;
 }
 
-double estimate_attack_ratio_with_sampling(std::vector<std::string> window_records) {
-    /* 
-     * Assuming the sampler is an Oracle, meaning that it can 100% accurately
-     * predict whether a certain connection record is anomalous or not. Then,
-     * what would be the percentage of this sample that is actually
-     * attack records.
-     */
-    size_t num_samples = (size_t) (window_records.size() * SAMPLING_RATE);
-    
-    std::vector<size_t> sample_range (window_records.size());
-    std::iota(sample_range.begin(), sample_range.end(), 0);
-    std::shuffle(sample_range.begin(), sample_range.end(), std::mt19937{std::random_device{}()});
+bool is_normal_record(const RecordSpan& record) {
+    /* Checks whether the label of a record (its last field, ignoring whitespace) is "normal" */
+    const char* label_end = record.start + record.length;
+    while (label_end > record.start && (std::isspace(label_end[-1]) || label_end[-1] == ',')) {label_end--;}
 
-    std::vector<size_t> sample_subset;
-    std::for_each(sample_range.begin(), sample_range.begin()+num_samples, 
-                     [&](size_t val) {sample_subset.push_back(val);});
-    auto sample_records = sample_records_at_indexes(window_records, sample_subset);
+    const char* label_start = label_end;
+    while (label_start > record.start && label_start[-1] != ',') {label_start--;}
+    while (label_start < label_end && std::isspace(*label_start)) {label_start++;}
 
-    double sample_normal_percent, sample_attack_percent;
-    std::tie(sample_normal_percent, sample_attack_percent) = analyze_record_labels_in_window(sample_records);
-    return sample_attack_percent;
+    return (label_end - label_start) == 6 && !std::memcmp(label_start, "normal", 6);
 }
 
-std::tuple<double, double> analyze_record_labels_in_window(std::vector<std::string> window_records) {
+std::tuple<double, double> compute_label_ratios(size_t num_normal, size_t num_records) {
     /* 
-     * Returns the following tuple: <normal percent, attack percent> of the provided
-     * window of data records, the two values should add up to 1.
+     * Returns the following tuple: <normal percent, attack percent> for a window
+     * of data records, the two values should add up to 1.
      */
-    
-    size_t num_normal = 0;
-    for (auto record: window_records) {
-        // Grab label, trim whitespace, and check it
-        auto word_list = split(record, ',');
-        std::string label = word_list.back();
-        label.erase(std::remove_if(label.begin(), label.end(), isspace), label.end());
-
-        if (!label.compare("normal")) {num_normal++; }
-    }
-
     double normal_ratio, attack_ratio;
-    normal_ratio = (num_normal+0.0)/window_records.size();
+    normal_ratio = (num_normal+0.0)/num_records;
 
     normal_ratio = std::round(normal_ratio * 1000.0)/1000.0;
     attack_ratio = 1.0 - normal_ratio;
@@ -540,52 +1570,133 @@ inline std::tuple<size_t, size_t> determine_window_breakdown(size_t total_num, d
     return std::make_tuple(num_normal, num_attack);
 }
 
-std::vector<std::string> sample_mixed_records_at_indexes(std::vector<std::string> dataset_1_vecs, size_t num_dataset_1,
-                                                         std::vector<std::string> dataset_2_vecs, size_t num_dataset_2,
-                                                         std::vector<size_t> index_list) {
-    /* Extract the data records from the two input datasets, it is a mixture of normal and attack records */
-    std::vector<std::string> dataset_sample;
-    size_t total_num_records = num_dataset_1 + num_dataset_2;
-    for (size_t i = 0; i < num_dataset_1; i++) {dataset_sample.push_back(dataset_1_vecs.at(index_list.at(i)));}
-    for (size_t i = num_dataset_1; i < total_num_records; i++) {dataset_sample.push_back(dataset_2_vecs.at(index_list.at(i)));}
-    return dataset_sample;
+char* map_input_file(const char* file_path, size_t* file_size) {
+    /* 
+     * Memory-maps an input file as read-only, and returns the start of the data (NULL if it is empty).
+     * A columnar file is turned back into its text records, in an anonymous mapping.
+     */
+    if (is_columnar_file(file_path)) {
+        std::string records_text = ColumnarFile(file_path).build_text();
+        *file_size = records_text.length();
+        if (*file_size == 0) {return NULL;}
+
+        void* text_data = mmap(NULL, *file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (text_data == MAP_FAILED) {THROW_EXCEPTION("Error occurred, while allocating the records of a columnar file.");}
+        std::memcpy(text_data, records_text.data(), *file_size);
+        return static_cast<char*>(text_data);
+    }
+    int input_fd = open(file_path, O_RDONLY);
+
+    struct stat s;
+    if (input_fd < 0 || fstat(input_fd, &s) < 0) {THROW_EXCEPTION("Error occurred when getting file stats.");}
+    *file_size = s.st_size;
+    if (*file_size == 0) {close(input_fd); return NULL;}
+
+    char* input_data = static_cast<char*>(mmap((caddr_t)0, *file_size, PROT_READ, MAP_SHARED, input_fd, 0));
+    close(input_fd);
+
+    if (input_data == (caddr_t)(-1)) {THROW_EXCEPTION("Error occurred, while memory-mapping the input files.");}
+    STATS_ADD(bytes_read, *file_size);
+    return input_data;
+}
+
+void unmap_input_file(char* data, size_t file_size) {
+    /* Releases a file mapped with map_input_file */
+    if (data != NULL && munmap(data, file_size) < 0) {
+        perror("Error occurred while unmapping the input files");
+        std::exit(1);
+    }
 }
 
-std::vector<std::string> sample_records_at_indexes(std::vector<std::string> dataset_vecs, std::vector<size_t> index_list) {
-    /* Extracts the data records at provided indexes */
-    std::vector<std::string> dataset_sample;
-    for (size_t curr_index: index_list) {dataset_sample.push_back(dataset_vecs.at(curr_index));}
-    return dataset_sample;
+std::vector<RecordSpan> index_records(const char* data, size_t data_size) {
+    /* 
+     * Finds every line in the mapped data, and returns where it starts and how long it
+     * is (without the newline). Empty lines are skipped, and lines can be any length.
+     */
+    std::vector<RecordSpan> records;
+    const char* curr_pos = data;
+    const char* data_end = data + data_size;
+
+    while (curr_pos < data_end) {
+        const char* newline = static_cast<const char*>(std::memchr(curr_pos, '\n', data_end - curr_pos));
+        const char* line_end = (newline != NULL) ? newline : data_end;
+
+        size_t length = line_end - curr_pos;
+        if (length && curr_pos[length-1] == '\r') {length--;}
+        if (length) {records.push_back({curr_pos, length});}
+        curr_pos = line_end + 1;
+    }
+    return records;
 }
 
-char* cgets(char* buf, int max, char** data) {
+std::vector<uint64_t> load_record_hashes(const char* file_path, std::vector<uint8_t>* normal_labels) {
     /* 
-     * Fills a c-string buffer until newline is encountered or max characters read 
-     * This method is adapted from this code: https://stackoverflow.com/questions/20299987/loop-through-char-array-line-by-line
+     * Returns the hash_record() value of every record in a file, and whether each one is normal
+     * (if normal_labels is given). A columnar file already holds the hashes, and a text file is
+     * hashed once here, so records that are sampled many times are never parsed again.
      */
-    size_t i = 0;
-    if(**data == '\0') {return NULL;}
+    std::vector<uint64_t> record_hashes;
+    if (is_columnar_file(file_path)) {
+        ColumnarFile columnar_input (file_path);
+        const uint64_t* hashes = columnar_input.get_record_hashes();
+        record_hashes.assign(hashes, hashes + columnar_input.get_num_records());
+
+        if (normal_labels != NULL) {
+            normal_labels->resize(record_hashes.size());
+            for (size_t i = 0; i < record_hashes.size(); i++) {(*normal_labels)[i] = is_normal_record(columnar_input.get_label(i));}
+        }
+        return record_hashes;
+    }
 
-    for(i = 0; i < max-1; ++i, ++(*data)){
-        buf[i] = **data;
-        if(**data == '\n') {buf[i+1]='\0'; ++(*data); break;} // Hit newline
-        if(**data == '\0') {break;} // input data has ended
+    size_t input_size = 0;
+    char* input_data = map_input_file(file_path, &input_size);
+    std::vector<RecordSpan> records = index_records(input_data, input_size);
+
+    record_hashes.resize(records.size());
+    for (size_t i = 0; i < records.size(); i++) {record_hashes[i] = hash_record(records[i].start, records[i].length);}
+    if (normal_labels != NULL) {
+        normal_labels->resize(records.size());
+        for (size_t i = 0; i < records.size(); i++) {(*normal_labels)[i] = is_normal_record(records[i]);}
     }
-    if(i == max-1) {buf[i] = '\0';}
-    return buf;
+    unmap_input_file(input_data, input_size);
+    return record_hashes;
 }
 
 
+int run_sub_command(int argc, char** argv) {
+    /* Runs the requested sub-command, argv[0] is the name of the sub-command */
+    if (std::strcmp(argv[0], "build") == 0)
+        return build_main(argc, argv);
+    if (std::strcmp(argv[0], "dist") == 0)
+        return dist_main(argc, argv);
+    if (std::strcmp(argv[0], "simulate") == 0)
+        return simulate_main(argc, argv);
+    if (std::strcmp(argv[0], "discretize") == 0)
+        return discretize_main(argc, argv);
+    if (std::strcmp(argv[0], "topn") == 0)
+        return topn_main(argc, argv);
+    if (std::strcmp(argv[0], "classify") == 0)
+        return classify_main(argc, argv);
+    if (std::strcmp(argv[0], "convert") == 0)
+        return convert_main(argc, argv);
+    if (std::strcmp(argv[0], "merge") == 0)
+        return merge_main(argc, argv);
+    if (std::strcmp(argv[0], "pyramid") == 0)
+        return pyramid_main(argc, argv);
+    return pacsketch_usage();
+}
+
 int main(int argc, char** argv){
     /* main method for pacsketch package */
+    extract_stats_option(&argc, argv);
+    extract_cache_option(&argc, argv);
     
     if (argc > 1) {
-        if (std::strcmp(argv[1], "build") == 0)
-            return build_main(argc-1, argv+1);
-        if (std::strcmp(argv[1], "dist") == 0)
-            return dist_main(argc-1, argv+1);
-        if (std::strcmp(argv[1], "simulate") == 0)
-            return simulate_main(argc-1, argv+1);
+        pacsketch_stats.command.assign(argv[1]);
+        int exit_code = run_sub_command(argc-1, argv+1);
+
+        if (STATS_ENABLED()) {pacsketch_stats.write_json();}
+        return exit_code;
     }
     return pacsketch_usage();
 }
@@ -0,0 +1,288 @@
+/*
+ * Name: pacsketch_c.cpp
+ * Description: Contains the C interface of libpacsketch, it wraps the MinHash and HyperLogLog
+ *              classes in opaque handles and turns every failure into a status code.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <pacsketch_c.h>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+#include <hash.h>
+#include <minhash.h>
+#include <hll.h>
+
+struct pacsketch_minhash {
+    MinHash sketch;
+    explicit pacsketch_minhash(MinHash&& loaded_sketch): sketch(std::move(loaded_sketch)) {}
+};
+
+struct pacsketch_hll {
+    HyperLogLog sketch;
+    explicit pacsketch_hll(HyperLogLog&& loaded_sketch): sketch(std::move(loaded_sketch)) {}
+};
+
+template <typename Function>
+static int run_guarded(Function body) {
+    /*
+     * Runs the body of an interface function, an exception must not unwind into C code so it is
+     * turned into a status code. The arguments are checked before the body, since the internal
+     * checks stop the program rather than throwing.
+     */
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        return PACSKETCH_ERROR_NO_MEMORY;
+    } catch (...) {
+        return PACSKETCH_ERROR_INTERNAL;
+    }
+}
+
+template <typename Sketch>
+static int copy_serialized(const Sketch& sketch, void* buffer, size_t capacity, size_t* size) {
+    /* Serializes a sketch into the caller's buffer, with a NULL buffer only the size it needs is returned */
+    std::vector<char> serialized;
+    sketch.serialize(&serialized);
+    *size = serialized.size();
+    if (buffer == NULL) {return PACSKETCH_OK;}
+    if (capacity < serialized.size()) {return PACSKETCH_ERROR_BUFFER_TOO_SMALL;}
+    std::memcpy(buffer, serialized.data(), serialized.size());
+    return PACSKETCH_OK;
+}
+
+int pacsketch_api_version(void) {
+    /* Returns the version of the interface the library was built with */
+    return PACSKETCH_API_VERSION;
+}
+
+const char* pacsketch_status_string(int status) {
+    /* Returns a description of a status code */
+    switch (status) {
+        case PACSKETCH_OK: return "success";
+        case PACSKETCH_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case PACSKETCH_ERROR_INCOMPATIBLE: return "the sketches have different parameters or input hashes";
+        case PACSKETCH_ERROR_CORRUPT: return "the buffer does not hold a valid sketch";
+        case PACSKETCH_ERROR_NO_MEMORY: return "out of memory";
+        case PACSKETCH_ERROR_BUFFER_TOO_SMALL: return "the buffer is too small";
+        case PACSKETCH_ERROR_INTERNAL: return "internal error";
+        default: return "unknown status";
+    }
+}
+
+uint64_t pacsketch_hash_bytes(const void* data, size_t length) {
+    /* Hashes an arbitrary item, the same value pacsketch_*_insert_bytes() inserts */
+    return hash_bytes(data, length, 0);
+}
+
+uint64_t pacsketch_hash_record(const char* record, size_t length) {
+    /* Hashes the feature vector of a connection record (every field but the label), as the command-line does */
+    return hash_record(record, length);
+}
+
+/* MinHash sketch */
+
+int pacsketch_minhash_create(size_t k, pacsketch_minhash_t** sketch) {
+    /* Creates an empty MinHash sketch that keeps the k smallest hashes */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *sketch = NULL;
+    if (k == 0 || k > std::numeric_limits<uint32_t>::max()) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        *sketch = new pacsketch_minhash(MinHash(k, PACKET));
+        return PACSKETCH_OK;
+    });
+}
+
+void pacsketch_minhash_free(pacsketch_minhash_t* sketch) {
+    /* Frees a sketch, NULL is ignored */
+    delete sketch;
+}
+
+int pacsketch_minhash_reset(pacsketch_minhash_t* sketch) {
+    /* Empties a sketch so it can be reused for the next window, no memory is allocated */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.reset();
+    return PACSKETCH_OK;
+}
+
+int pacsketch_minhash_insert_bytes(pacsketch_minhash_t* sketch, const void* data, size_t length) {
+    /* Inserts an arbitrary item (e.g. a flow key) */
+    if (sketch == NULL || (data == NULL && length > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.add_hash(hash_bytes(data, length, 0));
+    return PACSKETCH_OK;
+}
+
+int pacsketch_minhash_insert_record(pacsketch_minhash_t* sketch, const char* record, size_t length) {
+    /* Inserts a connection record (one line of packet data, without the newline) */
+    if (sketch == NULL || (record == NULL && length > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        sketch->sketch.add_record(record, length);
+        return PACSKETCH_OK;
+    });
+}
+
+int pacsketch_minhash_insert_hash(pacsketch_minhash_t* sketch, uint64_t hash_val) {
+    /* Inserts a hash that the caller computed */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.add_hash(hash_val);
+    return PACSKETCH_OK;
+}
+
+int pacsketch_minhash_insert_hashes(pacsketch_minhash_t* sketch, const uint64_t* hash_vals, size_t num_hashes) {
+    /* Inserts an array of hashes that the caller computed */
+    if (sketch == NULL || (hash_vals == NULL && num_hashes > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    for (size_t i = 0; i < num_hashes; i++) {sketch->sketch.add_hash(hash_vals[i]);}
+    return PACSKETCH_OK;
+}
+
+int pacsketch_minhash_merge(pacsketch_minhash_t* dest, const pacsketch_minhash_t* src) {
+    /* Unions src into dest */
+    if (dest == NULL || src == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    if (!dest->sketch.is_compatible(src->sketch)) {return PACSKETCH_ERROR_INCOMPATIBLE;}
+    return run_guarded([&] {
+        dest->sketch += src->sketch;
+        return PACSKETCH_OK;
+    });
+}
+
+int pacsketch_minhash_cardinality(const pacsketch_minhash_t* sketch, uint64_t* cardinality) {
+    /* Estimates the number of distinct items inserted into a sketch */
+    if (sketch == NULL || cardinality == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *cardinality = sketch->sketch.get_cardinality();
+    return PACSKETCH_OK;
+}
+
+int pacsketch_minhash_jaccard(const pacsketch_minhash_t* sketch_1, const pacsketch_minhash_t* sketch_2, double* jaccard) {
+    /* Estimates the jaccard similarity of the items inserted into two sketches */
+    if (sketch_1 == NULL || sketch_2 == NULL || jaccard == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    if (!sketch_1->sketch.is_compatible(sketch_2->sketch)) {return PACSKETCH_ERROR_INCOMPATIBLE;}
+    return run_guarded([&] {
+        *jaccard = MinHash::compute_jaccard(sketch_1->sketch, sketch_2->sketch);
+        return PACSKETCH_OK;
+    });
+}
+
+int pacsketch_minhash_serialize(const pacsketch_minhash_t* sketch, void* buffer, size_t capacity, size_t* size) {
+    /* Writes a sketch into buffer in the sketch file format, size is set to the bytes that are (or would be) needed */
+    if (sketch == NULL || size == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {return copy_serialized(sketch->sketch, buffer, capacity, size);});
+}
+
+int pacsketch_minhash_deserialize(const void* buffer, size_t size, pacsketch_minhash_t** sketch) {
+    /* Creates a sketch from serialized bytes, or the contents of a MinHash sketch file */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *sketch = NULL;
+    if (buffer == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        std::unique_ptr<MinHash> loaded_sketch = MinHash::deserialize(buffer, size);
+        if (!loaded_sketch) {return PACSKETCH_ERROR_CORRUPT;}
+        *sketch = new pacsketch_minhash(std::move(*loaded_sketch));
+        return PACSKETCH_OK;
+    });
+}
+
+/* HyperLogLog sketch */
+
+int pacsketch_hll_create(unsigned int b, pacsketch_hll_t** sketch) {
+    /* Creates an empty HyperLogLog sketch with 2^b registers */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *sketch = NULL;
+    if (b < PACSKETCH_HLL_MIN_PREFIX || b > PACSKETCH_HLL_MAX_PREFIX) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        *sketch = new pacsketch_hll(HyperLogLog(b, PACKET));
+        return PACSKETCH_OK;
+    });
+}
+
+void pacsketch_hll_free(pacsketch_hll_t* sketch) {
+    /* Frees a sketch, NULL is ignored */
+    delete sketch;
+}
+
+int pacsketch_hll_reset(pacsketch_hll_t* sketch) {
+    /* Empties a sketch so it can be reused for the next window, no memory is allocated */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.reset();
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_insert_bytes(pacsketch_hll_t* sketch, const void* data, size_t length) {
+    /* Inserts an arbitrary item (e.g. a flow key) */
+    if (sketch == NULL || (data == NULL && length > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.add_hash(hash_bytes(data, length, 0));
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_insert_record(pacsketch_hll_t* sketch, const char* record, size_t length) {
+    /* Inserts a connection record (one line of packet data, without the newline) */
+    if (sketch == NULL || (record == NULL && length > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        sketch->sketch.add_record(record, length);
+        return PACSKETCH_OK;
+    });
+}
+
+int pacsketch_hll_insert_hash(pacsketch_hll_t* sketch, uint64_t hash_val) {
+    /* Inserts a hash that the caller computed */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.add_hash(hash_val);
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_insert_hashes(pacsketch_hll_t* sketch, const uint64_t* hash_vals, size_t num_hashes) {
+    /* Inserts an array of hashes that the caller computed, it goes through the batched (prefetching) insert */
+    if (sketch == NULL || (hash_vals == NULL && num_hashes > 0)) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    sketch->sketch.add_hashes(hash_vals, num_hashes);
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_merge(pacsketch_hll_t* dest, const pacsketch_hll_t* src) {
+    /* Unions src into dest */
+    if (dest == NULL || src == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    if (!dest->sketch.is_compatible(src->sketch)) {return PACSKETCH_ERROR_INCOMPATIBLE;}
+    dest->sketch += src->sketch;
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_cardinality(const pacsketch_hll_t* sketch, uint64_t* cardinality) {
+    /* Estimates the number of distinct items inserted into a sketch */
+    if (sketch == NULL || cardinality == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *cardinality = sketch->sketch.compute_cardinality();
+    return PACSKETCH_OK;
+}
+
+int pacsketch_hll_jaccard(const pacsketch_hll_t* sketch_1, const pacsketch_hll_t* sketch_2, double* jaccard) {
+    /* Estimates the jaccard similarity of the items inserted into two sketches, from their cardinalities and that of their union */
+    if (sketch_1 == NULL || sketch_2 == NULL || jaccard == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    if (!sketch_1->sketch.is_compatible(sketch_2->sketch)) {return PACSKETCH_ERROR_INCOMPATIBLE;}
+    return run_guarded([&] {
+        uint64_t card_a = sketch_1->sketch.compute_cardinality(), card_b = sketch_2->sketch.compute_cardinality();
+        uint64_t card_union = (sketch_1->sketch + sketch_2->sketch).compute_cardinality();
+        *jaccard = (card_union) ? HyperLogLog::compute_jaccard(card_a, card_b, card_union) : 0.0;
+        return PACSKETCH_OK;
+    });
+}
+
+int pacsketch_hll_serialize(const pacsketch_hll_t* sketch, void* buffer, size_t capacity, size_t* size) {
+    /* Writes a sketch into buffer in the sketch file format, size is set to the bytes that are (or would be) needed */
+    if (sketch == NULL || size == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {return copy_serialized(sketch->sketch, buffer, capacity, size);});
+}
+
+int pacsketch_hll_deserialize(const void* buffer, size_t size, pacsketch_hll_t** sketch) {
+    /* Creates a sketch from serialized bytes, or the contents of a HyperLogLog sketch file */
+    if (sketch == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    *sketch = NULL;
+    if (buffer == NULL) {return PACSKETCH_ERROR_INVALID_ARGUMENT;}
+    return run_guarded([&] {
+        std::unique_ptr<HyperLogLog> loaded_sketch = HyperLogLog::deserialize(buffer, size);
+        if (!loaded_sketch) {return PACSKETCH_ERROR_CORRUPT;}
+        *sketch = new pacsketch_hll(std::move(*loaded_sketch));
+        return PACSKETCH_OK;
+    });
+}
@@ -0,0 +1,386 @@
+/*
+ * Name: pcap_reader.cpp
+ * Description: Contains a self-contained (no libpcap) reader for classic pcap and pcapng
+ *              files, and the decoding of the Ethernet/IPv4/IPv6/TCP/UDP headers that
+ *              make up the keys inserted into the sketches.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pcap_reader.h>
+#include <hash.h>
+#include <stats.h>
+
+/* Helpers for loading the big-endian fields of the network headers */
+
+static inline uint16_t load_be16(const uint8_t* data) {return (uint16_t) ((data[0] << 8) | data[1]);}
+static inline uint32_t load_be32(const uint8_t* data) {return ((uint32_t) load_be16(data) << 16) | load_be16(data + 2);}
+static inline uint64_t load_be64(const uint8_t* data) {return ((uint64_t) load_be32(data) << 32) | load_be32(data + 4);}
+
+PcapReader::PcapReader(const std::string& file_path) {
+    /* Constructor for the reader - memory-maps the file, and reads its header to find the format */
+    int input_fd = open(file_path.data(), O_RDONLY);
+    struct stat s;
+    if (input_fd < 0 || fstat(input_fd, &s) < 0) {THROW_EXCEPTION(("The following path could not be opened: " + file_path).data());}
+    file_size = s.st_size;
+    if (file_size < 24) {THROW_EXCEPTION(("The following file is too small to be a pcap/pcapng file: " + file_path).data());}
+
+    void* mapped_data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, input_fd, 0);
+    close(input_fd);
+    if (mapped_data == MAP_FAILED) {THROW_EXCEPTION("Error occurred, while memory-mapping the pcap file.");}
+    file_data = static_cast<const uint8_t*>(mapped_data);
+    madvise(mapped_data, file_size, MADV_SEQUENTIAL);
+    STATS_ADD(bytes_read, file_size);
+
+    uint32_t magic;
+    std::memcpy(&magic, file_data, sizeof(magic));
+    if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC) {
+        swap_bytes = false;
+        nanosecond_timestamps = (magic == PCAP_MAGIC_NSEC);
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_USEC || __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+        swap_bytes = true;
+        nanosecond_timestamps = (__builtin_bswap32(magic) == PCAP_MAGIC_NSEC);
+    } else if (magic == PCAPNG_BLOCK_SHB) {
+        is_pcapng = true;
+    } else {
+        THROW_EXCEPTION(("The following file is not a pcap or pcapng file: " + file_path).data());
+    }
+
+    // The pcapng sections (and their byte order) are handled as the blocks are read
+    if (!is_pcapng) {
+        link_type = read_u32(20) & 0xFFFF; // the upper bits hold the FCS length, if any
+        curr_offset = 24;
+    }
+}
+
+PcapReader::~PcapReader() {
+    /* Deconstructor for the reader - unmaps the file */
+    munmap((void*) file_data, file_size);
+}
+
+uint32_t PcapReader::read_u32(size_t offset) const {
+    /* Reads a 32-bit field of the file (or current section), in its byte order */
+    uint32_t value;
+    std::memcpy(&value, file_data + offset, sizeof(value));
+    return swap_bytes ? __builtin_bswap32(value) : value;
+}
+
+uint16_t PcapReader::read_u16(size_t offset) const {
+    /* Reads a 16-bit field of the file (or current section), in its byte order */
+    uint16_t value;
+    std::memcpy(&value, file_data + offset, sizeof(value));
+    return swap_bytes ? __builtin_bswap16(value) : value;
+}
+
+uint8_t PcapReader::read_ts_resolution(size_t options_offset, size_t options_end) const {
+    /* Finds the if_tsresol option among the options of an interface block, or returns the default (microseconds) */
+    while (options_offset + 4 <= options_end) {
+        uint16_t option_code = read_u16(options_offset);
+        uint16_t option_length = read_u16(options_offset + 2);
+        if (option_code == 0 || option_length > options_end - options_offset - 4) {break;} // end of options
+        if (option_code == PCAPNG_OPTION_TSRESOL && option_length >= 1) {return file_data[options_offset + 4];}
+        options_offset += 4 + ((option_length + 3) & ~3); // values are padded to 32 bits
+    }
+    return PCAPNG_DEFAULT_TSRESOL;
+}
+
+static uint64_t pcapng_timestamp_ns(uint64_t timestamp, uint8_t ts_resolution) {
+    /* Converts a pcapng timestamp into nanoseconds, the resolution is 10^-x seconds, or 2^-x if the top bit is set */
+    if (ts_resolution & 0x80) {
+        uint8_t shift = ts_resolution & 0x7F;
+        if (shift >= 64) {return 0;}
+        uint64_t fraction = timestamp & (((uint64_t) 1 << shift) - 1);
+        return (timestamp >> shift) * 1000000000ULL + (uint64_t) (((unsigned __int128) fraction * 1000000000ULL) >> shift);
+    }
+    uint64_t scale = 1;
+    for (uint8_t i = std::min(ts_resolution, (uint8_t) 9); i < 9; i++) {scale *= 10;}
+    for (uint8_t i = 9; i < std::min(ts_resolution, (uint8_t) 29); i++) {timestamp /= 10;} // 20 divisions leave 0
+    return timestamp * scale;
+}
+
+bool PcapReader::next_pcap_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type) {
+    /* Returns the next frame of a classic pcap file, each one has a 16-byte record header */
+    if (curr_offset + 16 > file_size) {
+        if (curr_offset != file_size) {LOG("the pcap file ends with a truncated record header, it was ignored.");}
+        curr_offset = file_size;
+        return false;
+    }
+    uint32_t captured_length = read_u32(curr_offset + 8);
+    size_t data_offset = curr_offset + 16;
+    if (captured_length > file_size - data_offset) {
+        LOG("the pcap file ends with a truncated packet, it was ignored.");
+        curr_offset = file_size;
+        return false;
+    }
+
+    uint32_t ts_fraction = read_u32(curr_offset + 4);
+    frame_timestamp = read_u32(curr_offset) * 1000000000ULL + (nanosecond_timestamps ? ts_fraction : ts_fraction * 1000ULL);
+    *frame = file_data + data_offset;
+    *frame_length = captured_length;
+    *frame_link_type = link_type;
+    curr_offset = data_offset + captured_length;
+    return true;
+}
+
+bool PcapReader::next_pcapng_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type) {
+    /*
+     * Returns the next frame of a pcapng file. Section header blocks set the byte order, and reset
+     * the interfaces, interface blocks give the link type of the packet blocks that refer to them.
+     */
+    while (curr_offset + 12 <= file_size) {
+        uint32_t block_type;
+        std::memcpy(&block_type, file_data + curr_offset, sizeof(block_type));
+
+        // The block type of a section header reads the same in both byte orders
+        if (block_type == PCAPNG_BLOCK_SHB) {
+            uint32_t byte_order;
+            std::memcpy(&byte_order, file_data + curr_offset + 8, sizeof(byte_order));
+            if (byte_order != PCAPNG_BYTE_ORDER_MAGIC && __builtin_bswap32(byte_order) != PCAPNG_BYTE_ORDER_MAGIC) {
+                LOG("the pcapng file has a section header with an unknown byte order, the rest was ignored.");
+                break;
+            }
+            swap_bytes = (byte_order != PCAPNG_BYTE_ORDER_MAGIC);
+            interface_link_types.clear();
+            interface_snap_lengths.clear();
+            interface_ts_resolutions.clear();
+        } else {
+            block_type = swap_bytes ? __builtin_bswap32(block_type) : block_type;
+        }
+
+        uint32_t block_length = read_u32(curr_offset + 4);
+        if (block_length < 12 || block_length % 4 || block_length > file_size - curr_offset) {
+            LOG("the pcapng file ends with a truncated (or invalid) block, it was ignored.");
+            break;
+        }
+        size_t body_offset = curr_offset + 8;
+        size_t body_end = curr_offset + block_length - 4; // the block length is repeated at the end
+        curr_offset += block_length;
+
+        size_t data_offset = 0;
+        uint32_t captured_length = 0, interface_id = 0;
+        switch (block_type) {
+            case PCAPNG_BLOCK_IDB:
+                if (body_end - body_offset < 8) {continue;}
+                interface_link_types.push_back(read_u16(body_offset));
+                interface_snap_lengths.push_back(read_u32(body_offset + 4));
+                interface_ts_resolutions.push_back(read_ts_resolution(body_offset + 8, body_end));
+                continue;
+            case PCAPNG_BLOCK_EPB:
+                if (body_end - body_offset < 20) {num_skipped++; continue;}
+                interface_id = read_u32(body_offset);
+                captured_length = read_u32(body_offset + 12);
+                data_offset = body_offset + 20;
+                break;
+            case PCAPNG_BLOCK_PB:
+                if (body_end - body_offset < 20) {num_skipped++; continue;}
+                interface_id = read_u16(body_offset);
+                captured_length = read_u32(body_offset + 12);
+                data_offset = body_offset + 20;
+                break;
+            case PCAPNG_BLOCK_SPB:
+                // Simple packet blocks only store the original length, the data is cut at the snap length
+                if (body_end - body_offset < 4 || interface_link_types.empty()) {num_skipped++; continue;}
+                captured_length = std::min((size_t) read_u32(body_offset), body_end - body_offset - 4);
+                if (interface_snap_lengths[0]) {captured_length = std::min(captured_length, interface_snap_lengths[0]);}
+                data_offset = body_offset + 4;
+                break;
+            default:
+                continue;
+        }
+
+        if (interface_id >= interface_link_types.size() || captured_length > body_end - data_offset) {num_skipped++; continue;}
+        if (block_type != PCAPNG_BLOCK_SPB) {
+            uint64_t timestamp = ((uint64_t) read_u32(body_offset + 4) << 32) | read_u32(body_offset + 8);
+            frame_timestamp = pcapng_timestamp_ns(timestamp, interface_ts_resolutions[interface_id]);
+        }
+        *frame = file_data + data_offset;
+        *frame_length = captured_length;
+        *frame_link_type = interface_link_types[interface_id];
+        return true;
+    }
+    curr_offset = file_size;
+    return false;
+}
+
+bool PcapReader::next_frame(const uint8_t** frame, uint32_t* frame_length, uint32_t* frame_link_type) {
+    /* Returns the next frame of the file, whatever its format is */
+    return is_pcapng ? next_pcapng_frame(frame, frame_length, frame_link_type)
+                     : next_pcap_frame(frame, frame_length, frame_link_type);
+}
+
+bool PcapReader::next_packet(PacketHeaders* headers) {
+    /* Decodes the next IPv4/IPv6 packet of the file, and returns false once the file has ended */
+    const uint8_t* frame;
+    uint32_t frame_length, frame_link_type;
+    while (next_frame(&frame, &frame_length, &frame_link_type)) {
+        if (decode_packet(frame, frame_length, frame_link_type, headers)) {
+            headers->timestamp_ns = frame_timestamp;
+            num_packets++;
+            STATS_ADD(records_parsed, 1);
+            return true;
+        }
+        num_skipped++;
+    }
+    return false;
+}
+
+static inline bool has_ports(uint8_t protocol) {
+    /* Checks whether a transport protocol starts with source and destination ports (TCP, UDP, SCTP, UDP-Lite) */
+    return protocol == 6 || protocol == 17 || protocol == 132 || protocol == 136;
+}
+
+static bool decode_ipv4(const uint8_t* packet, size_t length, PacketHeaders* headers) {
+    /* Decodes an IPv4 header, the ports are only read from the first fragment */
+    if (length < 20) {return false;}
+    size_t header_length = (packet[0] & 0x0F) * 4;
+    if (header_length < 20 || header_length > length) {return false;}
+
+    headers->ip_version = 4;
+    headers->protocol = packet[9];
+    headers->src_addr[0] = load_be32(packet + 12);
+    headers->dst_addr[0] = load_be32(packet + 16);
+
+    bool first_fragment = (load_be16(packet + 6) & 0x1FFF) == 0;
+    const uint8_t* transport = packet + header_length;
+    if (first_fragment && has_ports(headers->protocol) && length - header_length >= 4) {
+        headers->src_port = load_be16(transport);
+        headers->dst_port = load_be16(transport + 2);
+    }
+    return true;
+}
+
+static bool decode_ipv6(const uint8_t* packet, size_t length, PacketHeaders* headers) {
+    /* Decodes an IPv6 header, and skips the extension headers to find the transport protocol */
+    if (length < 40) {return false;}
+    headers->ip_version = 6;
+    headers->src_addr[0] = load_be64(packet + 8);
+    headers->src_addr[1] = load_be64(packet + 16);
+    headers->dst_addr[0] = load_be64(packet + 24);
+    headers->dst_addr[1] = load_be64(packet + 32);
+
+    uint8_t next_header = packet[6];
+    size_t offset = 40;
+    bool first_fragment = true;
+    for (size_t i = 0; i < MAX_IPV6_EXT_HEADERS && offset + 8 <= length; i++) {
+        if (next_header == 0 || next_header == 43 || next_header == 60) { // hop-by-hop, routing, destination options
+            next_header = packet[offset];
+            offset += (packet[offset + 1] + 1) * 8;
+        } else if (next_header == 44) { // fragment
+            first_fragment = (load_be16(packet + offset + 2) & 0xFFF8) == 0;
+            next_header = packet[offset];
+            offset += 8;
+        } else if (next_header == 51) { // authentication header
+            next_header = packet[offset];
+            offset += (packet[offset + 1] + 2) * 4;
+        } else {
+            break;
+        }
+    }
+    headers->protocol = next_header;
+
+    if (first_fragment && has_ports(next_header) && offset + 4 <= length) {
+        headers->src_port = load_be16(packet + offset);
+        headers->dst_port = load_be16(packet + offset + 2);
+    }
+    return true;
+}
+
+bool decode_packet(const uint8_t* frame, uint32_t frame_length, uint32_t frame_link_type, PacketHeaders* headers) {
+    /* Finds the IP header behind the link-layer header, and decodes it along with the ports */
+    *headers = PacketHeaders();
+    size_t offset = 0;
+
+    switch (frame_link_type) {
+        case LINKTYPE_ETHERNET: {
+            if (frame_length < 14) {return false;}
+            uint16_t ether_type = load_be16(frame + 12);
+            offset = 14;
+            while ((ether_type == ETHERTYPE_VLAN || ether_type == ETHERTYPE_QINQ) && offset + 4 <= frame_length) {
+                ether_type = load_be16(frame + offset + 2);
+                offset += 4;
+            }
+            if (ether_type != ETHERTYPE_IPV4 && ether_type != ETHERTYPE_IPV6) {return false;}
+            break;
+        }
+        case LINKTYPE_LINUX_SLL:
+            if (frame_length < 16) {return false;}
+            offset = 16;
+            if (load_be16(frame + 14) != ETHERTYPE_IPV4 && load_be16(frame + 14) != ETHERTYPE_IPV6) {return false;}
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            if (frame_length < 20) {return false;}
+            offset = 20;
+            if (load_be16(frame) != ETHERTYPE_IPV4 && load_be16(frame) != ETHERTYPE_IPV6) {return false;}
+            break;
+        case LINKTYPE_NULL:
+            // The address family is in the byte order of the capturing host, the IP version is checked below
+            if (frame_length < 4) {return false;}
+            offset = 4;
+            break;
+        case LINKTYPE_RAW: case LINKTYPE_IPV4: case LINKTYPE_IPV6:
+            break;
+        default:
+            return false;
+    }
+
+    if (offset >= frame_length) {return false;}
+    const uint8_t* packet = frame + offset;
+    switch (packet[0] >> 4) {
+        case 4: return decode_ipv4(packet, frame_length - offset, headers);
+        case 6: return decode_ipv6(packet, frame_length - offset, headers);
+        default: return false;
+    }
+}
+
+uint64_t hash_packet_key(const PacketHeaders& headers, pcap_key_type pcap_key) {
+    /* Hashes the header fields that make up the requested key, each word is mixed in with MurmurHash3 */
+    uint64_t hash_val = 0x9E3779B97F4A7C15 * ((uint64_t) pcap_key + 1);
+    auto mix_word = [&](uint64_t word) {hash_val = MurmurHash3(hash_val + word);};
+
+    uint64_t version_word = (uint64_t) headers.ip_version << 40;
+    switch (pcap_key) {
+        case FIVE_TUPLE_KEY:
+            mix_word(headers.src_addr[0]); mix_word(headers.src_addr[1]);
+            mix_word(headers.dst_addr[0]); mix_word(headers.dst_addr[1]);
+            mix_word(version_word | ((uint64_t) headers.protocol << 32) | ((uint64_t) headers.src_port << 16) | headers.dst_port);
+            break;
+        case SRC_DST_KEY:
+            mix_word(headers.src_addr[0]); mix_word(headers.src_addr[1]);
+            mix_word(headers.dst_addr[0]); mix_word(headers.dst_addr[1]);
+            mix_word(version_word);
+            break;
+        case SRC_KEY:
+            mix_word(headers.src_addr[0]); mix_word(headers.src_addr[1]);
+            mix_word(version_word);
+            break;
+        case DST_KEY:
+            mix_word(headers.dst_addr[0]); mix_word(headers.dst_addr[1]);
+            mix_word(version_word);
+            break;
+        case DST_SERVICE_KEY:
+            mix_word(headers.dst_addr[0]); mix_word(headers.dst_addr[1]);
+            mix_word(version_word | ((uint64_t) headers.protocol << 32) | headers.dst_port);
+            break;
+    }
+    return hash_val;
+}
+
+bool parse_pcap_key(const std::string& key_name, pcap_key_type* pcap_key) {
+    /* Converts the name of a packet key (as given on the command-line) into its type */
+    if (key_name == "5tuple") {*pcap_key = FIVE_TUPLE_KEY;}
+    else if (key_name == "srcdst") {*pcap_key = SRC_DST_KEY;}
+    else if (key_name == "src") {*pcap_key = SRC_KEY;}
+    else if (key_name == "dst") {*pcap_key = DST_KEY;}
+    else if (key_name == "dstport") {*pcap_key = DST_SERVICE_KEY;}
+    else {return false;}
+    return true;
+}
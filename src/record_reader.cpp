@@ -0,0 +1,80 @@
+/*
+ * Name: record_reader.cpp
+ * Description: Contains the implementation of the reader used for streams of connection
+ *              records, such as the input of the classify sub-command.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <record_reader.h>
+#include <stats.h>
+
+RecordReader::RecordReader(const std::string& file_path) {
+    /* Constructor for the reader, "-" reads the records from stdin */
+    if (file_path == "-") {
+        input_fd = STDIN_FILENO;
+    } else {
+        input_fd = open(file_path.data(), O_RDONLY);
+        if (input_fd < 0) {THROW_EXCEPTION(("The following path could not be opened: " + file_path).data());}
+        owns_fd = true;
+    }
+    buffer.resize(RECORD_READER_BUFFER_SIZE);
+}
+
+RecordReader::~RecordReader() {
+    /* Deconstructor for the reader - closes the input file */
+    if (owns_fd) {close(input_fd);}
+}
+
+bool RecordReader::fill_buffer() {
+    /*
+     * Moves the data that has not been returned to the front of the buffer, and reads
+     * more data after it. The buffer is doubled if a single line fills all of it.
+     */
+    if (data_start > 0) {
+        std::memmove(buffer.data(), buffer.data() + data_start, data_end - data_start);
+        data_end -= data_start;
+        data_start = 0;
+    }
+    if (data_end == buffer.size()) {buffer.resize(buffer.size() * 2);}
+
+    ssize_t bytes_read = 0;
+    do {
+        bytes_read = read(input_fd, buffer.data() + data_end, buffer.size() - data_end);
+    } while (bytes_read < 0 && errno == EINTR);
+
+    if (bytes_read < 0) {THROW_EXCEPTION("Error occurred while reading the input records.");}
+    if (bytes_read == 0) {at_eof = true; return false;}
+
+    STATS_ADD(bytes_read, bytes_read);
+    data_end += bytes_read;
+    return true;
+}
+
+bool RecordReader::next_record(RecordSpan* record) {
+    /* Finds the next non-empty line, and returns false once the input has ended */
+    while (true) {
+        const char* curr_pos = buffer.data() + data_start;
+        const char* newline = static_cast<const char*>(std::memchr(curr_pos, '\n', data_end - data_start));
+
+        // The last line of the input does not need to end with a newline
+        if (newline == NULL && !at_eof) {fill_buffer(); continue;}
+        if (newline == NULL && data_start == data_end) {return false;}
+
+        size_t length = (newline != NULL) ? (size_t) (newline - curr_pos) : data_end - data_start;
+        data_start += length + (newline != NULL);
+
+        if (length && curr_pos[length-1] == '\r') {length--;}
+        if (length) {
+            *record = {curr_pos, length};
+            return true;
+        }
+    }
+}
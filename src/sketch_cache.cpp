@@ -0,0 +1,184 @@
+/*
+ * Name: sketch_cache.cpp
+ * Description: Contains the on-disk cache of input sketches, keyed by the content of the
+ *              input and the options of the sketch, so repeated runs skip parsing the input.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sketch_cache.h>
+#include <sketch_file.h>
+#include <hash.h>
+#include <stats.h>
+#include <hll.h>
+#include <minhash.h>
+#include <frac_minhash.h>
+
+static std::string sketch_cache_dir = ""; // empty when the cache is not used
+
+void extract_cache_option(int* argc, char** argv) {
+    /*
+     * Looks for "--cache <dir>" anywhere on the command-line (or the PACSKETCH_CACHE_DIR variable),
+     * creates the directory if needed, and removes the two arguments so the sub-command parsers never see them.
+     */
+    const char* env_dir = std::getenv(SKETCH_CACHE_ENV);
+    if (env_dir != NULL) {sketch_cache_dir.assign(env_dir);}
+
+    for (int i = 1; i < *argc; i++) {
+        if (std::strcmp(argv[i], "--cache") != 0) {continue;}
+        if (i + 1 >= *argc) {FATAL_WARNING("The --cache option needs a directory to keep the sketches in.");}
+        sketch_cache_dir.assign(argv[i+1]);
+
+        for (int j = i; j + 2 <= *argc; j++) {argv[j] = argv[j+2];}
+        *argc -= 2;
+        break;
+    }
+
+    if (sketch_cache_dir == "") {return;}
+    mkdir(sketch_cache_dir.data(), 0755);
+    struct stat s;
+    if (stat(sketch_cache_dir.data(), &s) < 0 || !S_ISDIR(s.st_mode) || access(sketch_cache_dir.data(), W_OK) < 0) {
+        FATAL_WARNING(("The sketch cache directory could not be created, or is not writable: " + sketch_cache_dir).data());
+    }
+}
+
+bool is_sketch_cache_enabled() {
+    /* Checks whether sketches of input files go through the cache */
+    return sketch_cache_dir != "";
+}
+
+static bool fingerprint_file(const std::string& file_path, uint64_t file_size, uint64_t* fingerprint) {
+    /*
+     * Hashes evenly spaced blocks of a file (the whole file if it is small), so a change in the content
+     * is caught even when the size and mtime were kept, without reading all of a large input
+     */
+    int input_fd = open(file_path.data(), O_RDONLY);
+    if (input_fd < 0) {return false;}
+
+    std::vector<char> block (SKETCH_CACHE_SAMPLE_SIZE);
+    uint64_t num_blocks = (file_size + SKETCH_CACHE_SAMPLE_SIZE - 1) / SKETCH_CACHE_SAMPLE_SIZE;
+    uint64_t num_samples = std::min(num_blocks, (uint64_t) SKETCH_CACHE_NUM_SAMPLES);
+    *fingerprint = file_size;
+
+    for (uint64_t i = 0; i < num_samples; i++) {
+        // A large file is sampled from its first block to its last one
+        uint64_t offset = (num_blocks <= SKETCH_CACHE_NUM_SAMPLES) ? i * SKETCH_CACHE_SAMPLE_SIZE :
+                          i * (file_size - SKETCH_CACHE_SAMPLE_SIZE) / (SKETCH_CACHE_NUM_SAMPLES - 1);
+
+        ssize_t bytes_read = pread(input_fd, block.data(), block.size(), offset);
+        if (bytes_read < 0) {close(input_fd); return false;}
+        *fingerprint = hash_bytes(block.data(), bytes_read, *fingerprint ^ offset);
+    }
+    close(input_fd);
+    return true;
+}
+
+static bool find_cache_entry(const std::string& file_path, const SketchFileHeader& sketch_header,
+                             const char* extension, std::string* entry_path) {
+    /*
+     * Names the cache entry of a sketch from its input file and options, returns false if the
+     * input is not a regular file (e.g. standard input), in which case it is not cached
+     */
+    char real_path[PATH_MAX];
+    struct stat s;
+    if (realpath(file_path.data(), real_path) == NULL || stat(real_path, &s) < 0 || !S_ISREG(s.st_mode)) {return false;}
+
+    uint64_t fingerprint = 0;
+    if (!fingerprint_file(real_path, s.st_size, &fingerprint)) {return false;}
+
+    // Everything the sketch depends on goes into the key, the entry name is two 64-bit hashes of it
+    uint64_t key_fields[] = {(uint64_t) s.st_size, (uint64_t) s.st_mtim.tv_sec, (uint64_t) s.st_mtim.tv_nsec, fingerprint,
+                             sketch_header.version, sketch_header.sketch, sketch_header.input_type,
+                             sketch_header.hash_id, sketch_header.parameter};
+    uint64_t path_hash = hash_bytes(real_path, std::strlen(real_path), 0);
+    uint64_t key_hash_1 = hash_bytes(key_fields, sizeof(key_fields), path_hash);
+    uint64_t key_hash_2 = hash_bytes(key_fields, sizeof(key_fields), ~path_hash);
+
+    char entry_name[64];
+    std::snprintf(entry_name, sizeof(entry_name), "%016llx%016llx.%s", (unsigned long long) key_hash_1,
+                  (unsigned long long) key_hash_2, extension);
+    entry_path->assign(sketch_cache_dir + "/" + entry_name);
+    return true;
+}
+
+template <typename Sketch>
+static std::unique_ptr<Sketch> load_cache_entry(const std::string& entry_path, const SketchFileHeader& sketch_header) {
+    /*
+     * Loads an entry if it holds the expected sketch. An entry that is missing, or does not (e.g. it
+     * was cut short or damaged), gives an empty pointer without stopping the run, so it is rebuilt.
+     * The header is checked and the sketch deserialized in place in the mapped entry, so the only
+     * copy of the payload is the one into the sketch itself.
+     */
+    const char* entry_data = NULL;
+    size_t entry_size = 0;
+    if (!map_sketch_file(entry_path, &entry_data, &entry_size)) {return nullptr;}
+
+    SketchFileHeader header;
+    std::unique_ptr<Sketch> cached_sketch;
+    if (parse_sketch_buffer(entry_data, entry_size, (sketch_type) sketch_header.sketch, &header) != NULL &&
+        header.version == SKETCH_FILE_VERSION && header.input_type == sketch_header.input_type &&
+        header.hash_id == sketch_header.hash_id && header.parameter == sketch_header.parameter) {
+        cached_sketch = Sketch::deserialize(entry_data, entry_size);
+    }
+    unmap_sketch_file(entry_data, entry_size);
+    return cached_sketch;
+}
+
+template <typename Sketch>
+static Sketch load_or_build_sketch(const std::string& file_path, sketch_type sketch, uint64_t parameter,
+                                   data_type input_type, pcap_key_type pcap_key, const char* extension) {
+    /*
+     * Loads the sketch of an input file from the cache, or builds it and adds it to the cache. A new
+     * entry is written to a temporary file and renamed, so concurrent runs never see a partial entry.
+     */
+    SketchFileHeader sketch_header = SketchFileHeader();
+    sketch_header.version = SKETCH_FILE_VERSION;
+    sketch_header.sketch = sketch;
+    sketch_header.input_type = input_type;
+    sketch_header.hash_id = compute_hash_id(input_type, pcap_key);
+    sketch_header.parameter = parameter;
+
+    std::string entry_path;
+    if (!is_sketch_cache_enabled() || !find_cache_entry(file_path, sketch_header, extension, &entry_path)) {
+        return Sketch(file_path, parameter, input_type, pcap_key);
+    }
+    std::unique_ptr<Sketch> cached_sketch = load_cache_entry<Sketch>(entry_path, sketch_header);
+    if (cached_sketch) {
+        STATS_ADD(sketch_cache_hits, 1);
+        return std::move(*cached_sketch);
+    }
+
+    STATS_ADD(sketch_cache_misses, 1);
+    Sketch input_sketch (file_path, parameter, input_type, pcap_key);
+    std::string temp_path = entry_path + ".tmp." + std::to_string(getpid());
+    input_sketch.write_to_file(temp_path);
+    if (std::rename(temp_path.data(), entry_path.data()) != 0) {unlink(temp_path.data());}
+    return input_sketch;
+}
+
+MinHash get_cached_minhash(const std::string& file_path, size_t k_size, data_type input_type, pcap_key_type pcap_key) {
+    /* Returns the MinHash sketch of an input file, through the cache if it is enabled */
+    return load_or_build_sketch<MinHash>(file_path, MINHASH, k_size, input_type, pcap_key, "mh");
+}
+
+HyperLogLog get_cached_hll(const std::string& file_path, uint8_t bit_prefix, data_type input_type, pcap_key_type pcap_key) {
+    /* Returns the HyperLogLog sketch of an input file, through the cache if it is enabled */
+    return load_or_build_sketch<HyperLogLog>(file_path, HLL, bit_prefix, input_type, pcap_key, "hll");
+}
+
+FracMinHash get_cached_frac_minhash(const std::string& file_path, uint64_t scale, data_type input_type, pcap_key_type pcap_key) {
+    /* Returns the FracMinHash sketch of an input file, through the cache if it is enabled */
+    return load_or_build_sketch<FracMinHash>(file_path, FRAC_MINHASH, scale, input_type, pcap_key, "fmh");
+}
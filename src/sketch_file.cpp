@@ -0,0 +1,312 @@
+/*
+ * Name: sketch_file.cpp
+ * Description: Contains the binary file format of serialized sketches (written by
+ *              build -o), and the parallel tree merge used by the merge sub-command.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sketch_file.h>
+#include <hll.h>
+#include <minhash.h>
+#include <frac_minhash.h>
+#include <parallel.h>
+
+uint32_t compute_hash_id(data_type input_type, pcap_key_type pcap_key) {
+    /* Returns the id of the function that hashes an input type, captures also depend on the packet key */
+    switch (input_type) {
+        case PACKET: return RECORD_HASH_ID;
+        case FASTA: return KMER_HASH_ID;
+        case PCAP: return PACKET_KEY_HASH_ID + pcap_key;
+        default: THROW_EXCEPTION("There appears to be a bug in the code in compute_hash_id.");
+    }
+}
+
+static_assert(offsetof(SketchFileHeader, input_offset) == SKETCH_FILE_V1_HEADER_SIZE, "The version 1 fields need to stay at the start of the header");
+
+size_t get_sketch_header_size(uint32_t version) {
+    /* Returns the size of the header of a given version, the fields added since version 1 are at the end */
+    return (version == 1) ? SKETCH_FILE_V1_HEADER_SIZE : sizeof(SketchFileHeader);
+}
+
+static const char* check_sketch_header(const SketchFileHeader& header, uint64_t total_size) {
+    /* Returns why a header was not written by a supported version of pacsketch, or does not match the size of the sketch (NULL if it is valid) */
+    if (std::memcmp(header.magic, SKETCH_FILE_MAGIC, sizeof(header.magic))) {return "The following file is not a sketch file: ";}
+    if (header.version < 1 || header.version > SKETCH_FILE_VERSION) {return "The following sketch file has an unsupported version: ";}
+    if (header.byte_order != SKETCH_FILE_BYTE_ORDER) {return "The following sketch file was written on a host with another byte order: ";}
+    if ((header.sketch != MINHASH && header.sketch != HLL && header.sketch != FRAC_MINHASH) || header.input_type > PCAP ||
+        total_size < get_sketch_header_size(header.version) || header.payload_size != total_size - get_sketch_header_size(header.version)) {
+        return "The following sketch file is truncated or corrupt: ";
+    }
+    return NULL;
+}
+
+static void validate_sketch_header(const SketchFileHeader& header, const std::string& file_path, uint64_t file_size) {
+    /* Stops if the header was not written by a supported version of pacsketch, or does not match the size of the file */
+    const char* header_error = check_sketch_header(header, file_size);
+    if (header_error != NULL) {THROW_EXCEPTION((header_error + file_path).data());}
+}
+
+static SketchFileHeader finalize_sketch_header(const SketchFileHeader& header) {
+    /* Fills in the magic number, version and byte order of a header that is about to be written */
+    SketchFileHeader full_header = header;
+    std::memcpy(full_header.magic, SKETCH_FILE_MAGIC, sizeof(full_header.magic));
+    full_header.version = SKETCH_FILE_VERSION;
+    full_header.byte_order = SKETCH_FILE_BYTE_ORDER;
+    return full_header;
+}
+
+bool is_sketch_file(const char* file_path) {
+    /* Checks whether a file starts with the magic number of the sketch format */
+    int input_fd = open(file_path, O_RDONLY);
+    if (input_fd < 0) {return false;}
+
+    char magic[sizeof(SKETCH_FILE_MAGIC) - 1];
+    bool is_sketch = (read(input_fd, magic, sizeof(magic)) == (ssize_t) sizeof(magic) && !std::memcmp(magic, SKETCH_FILE_MAGIC, sizeof(magic)));
+    close(input_fd);
+    return is_sketch;
+}
+
+int open_sketch_file(const std::string& file_path, sketch_type expected_sketch, SketchFileHeader* header) {
+    /* 
+     * Opens a sketch file and reads its header, the file is left at the start of the payload. The fields
+     * that a version 1 header does not have are set to 0.
+     */
+    int input_fd = open(file_path.data(), O_RDONLY);
+    struct stat s;
+    if (input_fd < 0 || fstat(input_fd, &s) < 0) {THROW_EXCEPTION(("The following path could not be opened: " + file_path).data());}
+
+    *header = SketchFileHeader();
+    if ((uint64_t) s.st_size < SKETCH_FILE_V1_HEADER_SIZE || read(input_fd, header, SKETCH_FILE_V1_HEADER_SIZE) != SKETCH_FILE_V1_HEADER_SIZE) {
+        THROW_EXCEPTION(("The following file is too small to be a sketch file: " + file_path).data());
+    }
+    size_t remaining_size = get_sketch_header_size(header->version) - SKETCH_FILE_V1_HEADER_SIZE;
+    if (header->version > 1 && read(input_fd, reinterpret_cast<char*>(header) + SKETCH_FILE_V1_HEADER_SIZE, remaining_size) != (ssize_t) remaining_size) {
+        THROW_EXCEPTION(("The following file is too small to be a sketch file: " + file_path).data());
+    }
+
+    validate_sketch_header(*header, file_path, s.st_size);
+    if (header->sketch != (uint32_t) expected_sketch && expected_sketch != NOT_CHOSEN) {
+        THROW_EXCEPTION(("The following sketch file holds a different type of sketch: " + file_path).data());
+    }
+    return input_fd;
+}
+
+SketchFileHeader read_sketch_header(const std::string& file_path) {
+    /* Reads and validates the header of a sketch file, without loading the sketch */
+    SketchFileHeader header;
+    close(open_sketch_file(file_path, NOT_CHOSEN, &header));
+    return header;
+}
+
+void read_sketch_payload(int input_fd, const std::string& file_path, void* payload, size_t payload_size) {
+    /* Reads the payload of a file from open_sketch_file(), and closes it */
+    size_t bytes_read = 0;
+    while (bytes_read < payload_size) {
+        ssize_t curr_read = read(input_fd, static_cast<char*>(payload) + bytes_read, payload_size - bytes_read);
+        if (curr_read <= 0) {THROW_EXCEPTION(("The following sketch file is truncated or corrupt: " + file_path).data());}
+        bytes_read += curr_read;
+    }
+    close(input_fd);
+}
+
+void write_sketch_file(const std::string& file_path, const SketchFileHeader& header, const void* payload) {
+    /* Writes a sketch file, the magic number, version and byte order are filled in here */
+    SketchFileHeader file_header = finalize_sketch_header(header);
+
+    FILE* output_file = std::fopen(file_path.data(), "wb");
+    if (output_file == NULL) {THROW_EXCEPTION(("The following path could not be opened for writing: " + file_path).data());}
+    bool write_failed = std::fwrite(&file_header, sizeof(file_header), 1, output_file) != 1 ||
+                        std::fwrite(payload, 1, header.payload_size, output_file) != header.payload_size;
+    if (std::fclose(output_file) != 0 || write_failed) {THROW_EXCEPTION(("Error occurred while writing the sketch file: " + file_path).data());}
+}
+
+void write_sketch_buffer(const SketchFileHeader& header, const void* payload, std::vector<char>* buffer) {
+    /* Serializes a sketch into memory, the bytes are the same as the file write_sketch_file() writes */
+    SketchFileHeader full_header = finalize_sketch_header(header);
+    buffer->resize(sizeof(full_header) + header.payload_size);
+    std::memcpy(buffer->data(), &full_header, sizeof(full_header));
+    if (header.payload_size) {std::memcpy(buffer->data() + sizeof(full_header), payload, header.payload_size);}
+}
+
+static const char* check_sketch_buffer(const void* buffer, size_t buffer_size, sketch_type expected_sketch, SketchFileHeader* header) {
+    /* Reads the header of a sketch serialized in memory, and returns why it cannot be loaded (NULL if it is valid) */
+    *header = SketchFileHeader();
+    if (buffer == NULL || buffer_size < SKETCH_FILE_V1_HEADER_SIZE) {return "The following file is too small to be a sketch file: ";}
+    std::memcpy(header, buffer, SKETCH_FILE_V1_HEADER_SIZE);
+    size_t header_size = get_sketch_header_size(header->version);
+    if (buffer_size < header_size) {return "The following file is too small to be a sketch file: ";}
+    std::memcpy(header, buffer, header_size);
+
+    const char* header_error = check_sketch_header(*header, buffer_size);
+    if (header_error != NULL) {return header_error;}
+    if (header->sketch != (uint32_t) expected_sketch && expected_sketch != NOT_CHOSEN) {return "The following sketch file holds a different type of sketch: ";}
+    return NULL;
+}
+
+const char* parse_sketch_buffer(const void* buffer, size_t buffer_size, sketch_type expected_sketch, SketchFileHeader* header) {
+    /* 
+     * Reads the header of a sketch serialized in memory, and returns its payload. Unlike the files, a buffer
+     * that is not a valid sketch does not stop the program, NULL is returned so the caller can report it.
+     */
+    if (check_sketch_buffer(buffer, buffer_size, expected_sketch, header) != NULL) {return NULL;}
+    return static_cast<const char*>(buffer) + get_sketch_header_size(header->version);
+}
+
+bool map_sketch_file(const std::string& file_path, const char** file_data, size_t* file_size) {
+    /* Memory-maps a whole sketch file as read-only (for deserialize()), it returns false instead of stopping the program if it cannot be opened */
+    int input_fd = open(file_path.data(), O_RDONLY);
+    struct stat s;
+    if (input_fd < 0 || fstat(input_fd, &s) < 0) {
+        if (input_fd >= 0) {close(input_fd);}
+        return false;
+    }
+
+    *file_data = NULL;
+    *file_size = s.st_size;
+    if (*file_size) {
+        void* mapped_data = mmap(NULL, *file_size, PROT_READ, MAP_PRIVATE, input_fd, 0);
+        if (mapped_data != MAP_FAILED) {*file_data = static_cast<const char*>(mapped_data);}
+    }
+    close(input_fd);
+    return *file_size == 0 || *file_data != NULL;
+}
+
+void unmap_sketch_file(const char* file_data, size_t file_size) {
+    /* Releases a file mapped with map_sketch_file */
+    if (file_data != NULL) {munmap(const_cast<char*>(file_data), file_size);}
+}
+
+template <typename Sketch>
+std::unique_ptr<Sketch> load_sketch_file(const std::string& file_path, sketch_type expected_sketch, std::string* error_message) {
+    /*
+     * Loads a sketch file without stopping the program, so a worker thread (or a cache lookup) can
+     * report or recover from a bad file. The sketch is deserialized straight from the mapped file.
+     * An empty pointer is returned if the file is not a valid sketch, and error_message says why.
+     */
+    const char* file_data = NULL;
+    size_t file_size = 0;
+    if (!map_sketch_file(file_path, &file_data, &file_size)) {
+        *error_message = "The following path could not be opened: " + file_path;
+        return nullptr;
+    }
+
+    SketchFileHeader header;
+    const char* load_error = check_sketch_buffer(file_data, file_size, expected_sketch, &header);
+    std::unique_ptr<Sketch> loaded_sketch;
+    if (load_error == NULL) {loaded_sketch = Sketch::deserialize(file_data, file_size);}
+    unmap_sketch_file(file_data, file_size);
+
+    if (!loaded_sketch) {*error_message = std::string((load_error) ? load_error : "The following sketch file is truncated or corrupt: ") + file_path;}
+    return loaded_sketch;
+}
+
+template std::unique_ptr<HyperLogLog> load_sketch_file<HyperLogLog>(const std::string&, sketch_type, std::string*);
+template std::unique_ptr<MinHash> load_sketch_file<MinHash>(const std::string&, sketch_type, std::string*);
+template std::unique_ptr<FracMinHash> load_sketch_file<FracMinHash>(const std::string&, sketch_type, std::string*);
+
+std::vector<std::string> list_sketch_files(const std::vector<std::string>& input_paths) {
+    /* Expands the input paths into sketch files, every sketch file in a directory is used (sorted by name) */
+    std::vector<std::string> file_paths;
+    for (const std::string& input_path: input_paths) {
+        struct stat s;
+        if (stat(input_path.data(), &s) < 0) {THROW_EXCEPTION(("The following path is not valid: " + input_path).data());}
+        if (!S_ISDIR(s.st_mode)) {file_paths.push_back(input_path); continue;}
+
+        DIR* input_dir = opendir(input_path.data());
+        if (input_dir == NULL) {THROW_EXCEPTION(("The following directory could not be opened: " + input_path).data());}
+        std::vector<std::string> dir_files;
+        for (struct dirent* entry = readdir(input_dir); entry != NULL; entry = readdir(input_dir)) {
+            std::string entry_path = input_path + "/" + entry->d_name;
+            if (stat(entry_path.data(), &s) == 0 && S_ISREG(s.st_mode) && is_sketch_file(entry_path.data())) {dir_files.push_back(entry_path);}
+        }
+        closedir(input_dir);
+
+        std::sort(dir_files.begin(), dir_files.end());
+        file_paths.insert(file_paths.end(), dir_files.begin(), dir_files.end());
+    }
+    return file_paths;
+}
+
+template <typename Sketch>
+static Sketch merge_sketch_files(const std::vector<std::string>& file_paths, sketch_type expected_sketch, size_t num_threads) {
+    /*
+     * Unions the sketch files in a parallel tree. Each thread first folds a contiguous chunk of
+     * the files into a partial union, so only two sketches per thread are in memory at a time,
+     * and then the partial unions are merged in pairs, halving their number at each level.
+     */
+    size_t num_partials = std::max((size_t) 1, std::min(num_threads, file_paths.size()));
+    std::vector<std::unique_ptr<Sketch>> partials (num_partials);
+
+    // The first file starts the partial union of chunk 0, and every other file is checked against it as it is loaded
+    std::string load_error;
+    partials[0] = load_sketch_file<Sketch>(file_paths[0], expected_sketch, &load_error);
+    if (!partials[0]) {THROW_EXCEPTION(load_error.data());}
+    const Sketch& first_sketch = *partials[0]; // only its k/b/scale and input hash are read, which merging never changes
+
+    // Workers do not stop the program on a bad file, the one that comes first in the list is reported after they join
+    std::mutex error_mutex;
+    size_t error_index = file_paths.size();
+    std::string error_message;
+    auto load_sketch = [&](size_t file_num) {
+        std::string file_error;
+        std::unique_ptr<Sketch> loaded_sketch = load_sketch_file<Sketch>(file_paths[file_num], expected_sketch, &file_error);
+        if (loaded_sketch && !first_sketch.is_compatible(*loaded_sketch)) {
+            file_error = "The following sketch does not match the k/b/scale or input hashes of " + file_paths[0] + ": " + file_paths[file_num];
+            loaded_sketch.reset();
+        }
+        if (!loaded_sketch) {
+            std::lock_guard<std::mutex> error_lock (error_mutex);
+            if (file_num < error_index) {error_index = file_num; error_message = file_error;}
+        }
+        return loaded_sketch;
+    };
+
+    for_each_chunk(file_paths.size(), num_partials, [&](size_t thread_num, size_t start, size_t end) {
+        if (thread_num > 0) {partials[thread_num] = load_sketch(start);}
+        for (size_t i = start + 1; i < end && partials[thread_num]; i++) {
+            std::unique_ptr<Sketch> loaded_sketch = load_sketch(i);
+            if (!loaded_sketch) {break;}
+            *partials[thread_num] += *loaded_sketch;
+        }
+    });
+    if (error_index < file_paths.size()) {THROW_EXCEPTION(error_message.data());}
+
+    for (size_t stride = 1; stride < num_partials; stride *= 2) {
+        size_t num_pairs = (num_partials - stride + 2 * stride - 1) / (2 * stride);
+        for_each_chunk(num_pairs, num_pairs, [&](size_t pair_num, size_t, size_t) {
+            size_t dest = pair_num * 2 * stride;
+            *partials[dest] += *partials[dest + stride];
+            partials[dest + stride].reset();
+        });
+    }
+    return std::move(*partials[0]);
+}
+
+HyperLogLog merge_hll_files(const std::vector<std::string>& file_paths, size_t num_threads) {
+    /* Unions HyperLogLog sketch files */
+    return merge_sketch_files<HyperLogLog>(file_paths, HLL, num_threads);
+}
+
+MinHash merge_minhash_files(const std::vector<std::string>& file_paths, size_t num_threads) {
+    /* Unions MinHash sketch files */
+    return merge_sketch_files<MinHash>(file_paths, MINHASH, num_threads);
+}
+
+FracMinHash merge_frac_minhash_files(const std::vector<std::string>& file_paths, size_t num_threads) {
+    /* Unions FracMinHash sketch files */
+    return merge_sketch_files<FracMinHash>(file_paths, FRAC_MINHASH, num_threads);
+}
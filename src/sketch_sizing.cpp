@@ -0,0 +1,137 @@
+/*
+ * Name: sketch_sizing.cpp
+ * Description: Chooses the type and precision of a sketch from a memory budget or a target
+ *              error, using the analytic error bounds of each sketch, so many sketches can be
+ *              sized to fit in memory without picking k/b by hand.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+#include <pacsketch.h>
+#include <hll.h>
+
+bool parse_memory_size(const std::string& value, uint64_t* num_bytes) {
+    /* Parses a number of bytes, with an optional K, M or G suffix (powers of 1024) */
+    char* suffix = NULL;
+    unsigned long long parsed_value = std::strtoull(value.data(), &suffix, 10);
+    if (suffix == value.data() || value[0] == '-' || parsed_value == 0) {return false;}
+
+    uint64_t multiplier = 1;
+    switch (std::toupper(*suffix)) {
+        case '\0': break;
+        case 'K': multiplier = (uint64_t) 1 << 10; suffix++; break;
+        case 'M': multiplier = (uint64_t) 1 << 20; suffix++; break;
+        case 'G': multiplier = (uint64_t) 1 << 30; suffix++; break;
+        default: return false;
+    }
+    if (*suffix != '\0' || parsed_value > UINT64_MAX / multiplier) {return false;}
+    *num_bytes = parsed_value * multiplier;
+    return true;
+}
+
+static double expected_sketch_error(sizing_goal goal, sketch_type sketch, uint64_t parameter) {
+    /*
+     * Returns the standard error of a sketch: 1.04/sqrt(2^b) of the cardinality for a HLL, and
+     * 1/sqrt(k-2) for a MinHash. The jaccard of two HLLs comes from three cardinalities
+     * (inclusion-exclusion), which is at most sqrt(3) times that error, and the jaccard of two
+     * MinHashes is at most 0.5/sqrt(k) (sqrt(J(1-J)/k) at J = 0.5).
+     */
+    if (sketch == HLL) {
+        double cardinality_error = 1.04 / std::sqrt((double) ((uint64_t) 1 << parameter));
+        return (goal == CARDINALITY_ERROR) ? cardinality_error : std::sqrt(3.0) * cardinality_error;
+    }
+    return (goal == CARDINALITY_ERROR) ? 1.0 / std::sqrt(parameter - 2.0) : 0.5 / std::sqrt((double) parameter);
+}
+
+static uint64_t expected_sketch_bytes(sketch_type sketch, uint64_t parameter) {
+    /* Returns the memory a sketch allocates, the same as get_memory_usage() reports once it is built */
+    if (sketch == HLL) {
+        uint64_t register_bytes = TOTAL_REGISTER_SPACE((uint64_t) 1 << parameter);
+        return ((register_bytes + HLL_REGISTER_ALIGNMENT - 1) / HLL_REGISTER_ALIGNMENT) * HLL_REGISTER_ALIGNMENT;
+    }
+    return (2 * parameter + 1) * sizeof(uint64_t); // the max-heap of k hashes, and up to k+1 hashes that are checked for repeats
+}
+
+static bool size_minhash(sizing_goal goal, uint64_t memory_budget, double target_error, uint64_t* k_size) {
+    /* Finds the largest k that fits in the memory budget, or the smallest k that meets the target error */
+    if (memory_budget != 0) {
+        if (memory_budget < expected_sketch_bytes(MINHASH, MIN_AUTO_K)) {return false;}
+        *k_size = std::min((memory_budget / sizeof(uint64_t) - 1) / 2, (uint64_t) MAX_AUTO_K);
+        return true;
+    }
+    double needed_k = (goal == CARDINALITY_ERROR) ? 2.0 + 1.0 / (target_error * target_error) : 0.25 / (target_error * target_error);
+    if (needed_k > MAX_AUTO_K) {return false;}
+    *k_size = std::max((uint64_t) std::ceil(needed_k), (uint64_t) MIN_AUTO_K);
+    while (*k_size < MAX_AUTO_K && expected_sketch_error(goal, MINHASH, *k_size) > target_error) {(*k_size)++;} // rounding in the division
+    return expected_sketch_error(goal, MINHASH, *k_size) <= target_error;
+}
+
+static bool size_hll(sizing_goal goal, uint64_t memory_budget, double target_error, uint64_t* bit_prefix) {
+    /* Finds the largest b that fits in the memory budget, or the smallest b that meets the target error */
+    bool found = false;
+    for (uint64_t b = MIN_AUTO_PREFIX; b <= MAX_AUTO_PREFIX; b++) {
+        if (memory_budget != 0 && expected_sketch_bytes(HLL, b) <= memory_budget) {*bit_prefix = b; found = true;}
+        if (memory_budget == 0 && expected_sketch_error(goal, HLL, b) <= target_error) {*bit_prefix = b; return true;}
+    }
+    return found;
+}
+
+bool choose_sketch_size(sizing_goal goal, sketch_type allowed_sketch, uint64_t memory_budget, double target_error, SketchSizing* sizing) {
+    /*
+     * Sizes each allowed sketch type (NOT_CHOSEN allows MinHash and HLL), and keeps the one with the
+     * lowest expected error within a memory budget, or the fewest bytes that meet a target error.
+     * It returns false if no sketch fits the budget, or meets the error.
+     */
+    *sizing = SketchSizing();
+    sizing->is_automatic = true;
+
+    for (sketch_type sketch: {HLL, MINHASH}) {
+        if (allowed_sketch != NOT_CHOSEN && allowed_sketch != sketch) {continue;}
+        uint64_t parameter = 0;
+        bool is_sized = (sketch == HLL) ? size_hll(goal, memory_budget, target_error, &parameter) :
+                                          size_minhash(goal, memory_budget, target_error, &parameter);
+        if (!is_sized) {continue;}
+
+        double error = expected_sketch_error(goal, sketch, parameter);
+        uint64_t num_bytes = expected_sketch_bytes(sketch, parameter);
+        bool is_better = (sizing->sketch == NOT_CHOSEN) ||
+                         ((memory_budget != 0) ? error < sizing->expected_error : num_bytes < sizing->expected_bytes);
+        if (is_better) {
+            sizing->sketch = sketch;
+            sizing->parameter = parameter;
+            sizing->expected_error = error;
+            sizing->expected_bytes = num_bytes;
+        }
+    }
+    return sizing->sketch != NOT_CHOSEN;
+}
+
+void choose_automatic_size(sizing_goal goal, const std::string& memory_budget_name, double target_error, bool use_frac_minhash,
+                           bool* use_minhash, bool* use_hll, size_t* k_size, uint8_t* bit_prefix, uint64_t* memory_budget, SketchSizing* sizing) {
+    /* Checks the -m/-e options of build and dist, then picks the sketch type (unless -M/-H was given) and its k/b from them */
+    if (memory_budget_name != "" && target_error != 0.0) {FATAL_WARNING("Only one of a memory budget (-m) and a target error (-e) can be specified.");}
+    if (*k_size != 0 || *bit_prefix != 0) {FATAL_WARNING("The values of k and b are chosen from the memory budget (-m) or target error (-e), so -k/-b cannot be used with them.");}
+    if (use_frac_minhash) {FATAL_WARNING("A FracMinHash sketch grows with its input, so it cannot be sized by a memory budget (-m) or target error (-e).");}
+    if (*use_minhash && *use_hll) {FATAL_WARNING("Only one of -M, -H and -F can be specified at a time, please re-run with a single one of those options.\n");}
+    if (memory_budget_name != "" && !parse_memory_size(memory_budget_name, memory_budget)) {
+        FATAL_WARNING("The memory budget (-m) needs to be a number of bytes, optionally followed by K, M or G.");
+    }
+    if (memory_budget_name == "" && (target_error <= 0.0 || target_error >= 1.0)) {FATAL_WARNING("The target error (-e) needs to be between 0 and 1.");}
+
+    sketch_type allowed_sketch = (*use_minhash) ? MINHASH : (*use_hll) ? HLL : NOT_CHOSEN;
+    if (!choose_sketch_size(goal, allowed_sketch, *memory_budget, target_error, sizing)) {
+        if (memory_budget_name != "") {FATAL_WARNING("The memory budget (-m) is too small for the smallest sketch that is considered (a HLL with b=4, or a MinHash with k=16).");}
+        FATAL_WARNING("The target error (-e) cannot be met within the largest sketch that is considered (HLL with b=24, or MinHash with k=65536).");
+    }
+    *use_minhash = (sizing->sketch == MINHASH);
+    *use_hll = (sizing->sketch == HLL);
+    if (*use_minhash) {*k_size = sizing->parameter;}
+    if (*use_hll) {*bit_prefix = sizing->parameter;}
+}
@@ -0,0 +1,95 @@
+/*
+ * Name: stats.cpp
+ * Description: Collects the performance counters and stage timings of a 
+ *              pacsketch run, and writes them as a JSON report when the
+ *              --stats option is used.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stats.h>
+#include <pacsketch.h>
+
+PacsketchStats pacsketch_stats;
+
+void extract_stats_option(int* argc, char** argv) {
+    /* 
+     * Looks for "--stats <file>" anywhere on the command-line, turns on the counters, and 
+     * removes the two arguments so the sub-command parsers never see them.
+     */
+    for (int i = 1; i < *argc; i++) {
+        if (std::strcmp(argv[i], "--stats") != 0) {continue;}
+        if (i + 1 >= *argc) {FATAL_WARNING("The --stats option needs a path for the JSON report (or - for stderr).");}
+
+        pacsketch_stats.enabled = true;
+        pacsketch_stats.output_path.assign(argv[i+1]);
+        pacsketch_stats.start_time = stats_clock::now();
+
+        for (int j = i; j + 2 <= *argc; j++) {argv[j] = argv[j+2];}
+        *argc -= 2;
+        return;
+    }
+}
+
+void PacsketchStats::add_stage_time(const char* stage_name, double seconds) {
+    /* Adds time to a stage, stages that run more than once (e.g. per window) are summed */
+    for (std::pair<std::string, double>& stage: stage_seconds) {
+        if (stage.first == stage_name) {stage.second += seconds; return;}
+    }
+    stage_seconds.push_back(std::make_pair(std::string(stage_name), seconds));
+}
+
+double compute_percentile(std::vector<double> values, double percentile) {
+    /* Returns the value at a given percentile (0-100) using the nearest-rank method */
+    if (values.empty()) {return 0.0;}
+    size_t rank = (size_t) std::ceil(percentile/100.0 * values.size());
+    rank = std::min(std::max(rank, (size_t) 1), values.size());
+
+    std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+    return values[rank - 1];
+}
+
+void PacsketchStats::write_json() const {
+    /* Writes all the counters and timings as a single JSON object */
+    FILE* output_file = (output_path == "-") ? stderr : std::fopen(output_path.data(), "w");
+    if (output_file == NULL) {THROW_EXCEPTION(("Unable to open stats file: " + output_path).data());}
+
+    double total_seconds = std::chrono::duration<double>(stats_clock::now() - start_time).count();
+    uint64_t hashes_inserted = register_updates_accepted + register_updates_rejected + 
+                               heap_updates_accepted + heap_updates_rejected;
+
+    std::fprintf(output_file, "{\n");
+    std::fprintf(output_file, "  \"command\": \"%s\",\n", command.data());
+    std::fprintf(output_file, "  \"total_seconds\": %.6f,\n", total_seconds);
+
+    std::fprintf(output_file, "  \"stages\": {");
+    for (size_t i = 0; i < stage_seconds.size(); i++) {
+        std::fprintf(output_file, "%s\n    \"%s\": %.6f", (i ? "," : ""), stage_seconds[i].first.data(), stage_seconds[i].second);
+    }
+    std::fprintf(output_file, "%s},\n", (stage_seconds.empty() ? "" : "\n  "));
+
+    std::fprintf(output_file, "  \"bytes_read\": %lu,\n", bytes_read);
+    std::fprintf(output_file, "  \"records_parsed\": %lu,\n", records_parsed);
+    std::fprintf(output_file, "  \"kmers_parsed\": %lu,\n", kmers_parsed);
+    std::fprintf(output_file, "  \"hashes_inserted\": %lu,\n", hashes_inserted);
+    std::fprintf(output_file, "  \"hashes_per_sec\": %.1f,\n", (total_seconds > 0) ? hashes_inserted/total_seconds : 0.0);
+    std::fprintf(output_file, "  \"hll_register_updates\": {\"accepted\": %lu, \"rejected\": %lu},\n", 
+                              register_updates_accepted, register_updates_rejected);
+    std::fprintf(output_file, "  \"minhash_heap_updates\": {\"accepted\": %lu, \"rejected\": %lu, \"threshold_rejected\": %lu},\n", 
+                              heap_updates_accepted, heap_updates_rejected, heap_threshold_rejections);
+    std::fprintf(output_file, "  \"sketch_cache\": {\"hits\": %lu, \"misses\": %lu},\n", 
+                              sketch_cache_hits, sketch_cache_misses);
+    std::fprintf(output_file, "  \"udp_datagrams\": {\"received\": %lu, \"dropped\": %lu},\n", 
+                              udp_datagrams_received, udp_datagrams_dropped);
+    std::fprintf(output_file, "  \"window_latency_us\": {\"count\": %zu, \"p50\": %.2f, \"p99\": %.2f, \"max\": %.2f}\n",
+                              window_micros.size(), compute_percentile(window_micros, 50.0), compute_percentile(window_micros, 99.0),
+                              compute_percentile(window_micros, 100.0));
+    std::fprintf(output_file, "}\n");
+
+    if (output_file != stderr) {std::fclose(output_file);}
+}
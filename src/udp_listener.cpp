@@ -0,0 +1,150 @@
+/*
+ * Name: udp_listener.cpp
+ * Description: Contains the listener that receives connection records over UDP, and
+ *              passes them from its receive thread to the sketches through a ring.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <udp_listener.h>
+
+bool parse_udp_endpoint(const std::string& endpoint, std::string* address, uint16_t* port) {
+    /* Parses [address:]port, the address is 127.0.0.1 if it is left out */
+    size_t split_pos = endpoint.rfind(':');
+    std::string port_str = (split_pos == std::string::npos) ? endpoint : endpoint.substr(split_pos + 1);
+    *address = (split_pos == std::string::npos) ? "127.0.0.1" : endpoint.substr(0, split_pos);
+
+    if (port_str.empty() || port_str.find_first_not_of("0123456789") != std::string::npos || port_str.length() > 5) {return false;}
+    long port_val = std::atol(port_str.data());
+    if (port_val < 1 || port_val > 65535) {return false;}
+    *port = (uint16_t) port_val;
+
+    struct in_addr parsed_address;
+    return inet_pton(AF_INET, address->data(), &parsed_address) == 1;
+}
+
+UDPListener::UDPListener(const std::string& address, uint16_t port): ring(UDP_RING_SLOTS), stop_requested(false),
+                         receiver_done(false), datagrams_received(0), datagrams_dropped(0), datagrams_truncated(0),
+                         kernel_drops(0) {
+    /* Constructor for the listener - binds the socket, and starts the receive thread */
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_fd < 0) {THROW_EXCEPTION("Error occurred while creating the UDP socket.");}
+
+    int buffer_size = UDP_SOCKET_BUFFER;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+#ifdef SO_RXQ_OVFL
+    int report_drops = 1;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RXQ_OVFL, &report_drops, sizeof(report_drops));
+#endif
+
+    // The timeout lets the receive thread notice a stop request when no datagrams are arriving
+    struct timeval timeout = {0, UDP_RECEIVE_TIMEOUT_MS * 1000};
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in socket_address;
+    std::memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.data(), &socket_address.sin_addr) != 1) {THROW_EXCEPTION(("The following address is not valid: " + address).data());}
+    if (bind(socket_fd, (struct sockaddr*) &socket_address, sizeof(socket_address)) < 0) {
+        THROW_EXCEPTION(("Unable to bind the UDP socket to " + address + ":" + std::to_string(port)).data());
+    }
+    receive_thread = std::thread(&UDPListener::receive_loop, this);
+}
+
+UDPListener::~UDPListener() {
+    /* Deconstructor for the listener - stops the receive thread, and closes the socket */
+    stop();
+    if (receive_thread.joinable()) {receive_thread.join();}
+    close(socket_fd);
+}
+
+void UDPListener::receive_loop() {
+    /* Reads datagrams into the ring until a stop is requested (runs on the receive thread) */
+    static char overflow_buffer[UDP_MAX_DATAGRAM]; // receives the datagrams that do not fit in the ring
+    char control_buffer[CMSG_SPACE(sizeof(uint32_t))];
+
+    while (!stop_requested.load(std::memory_order_relaxed)) {
+        Datagram* slot = ring.begin_write();
+        struct iovec buffer = {(slot != NULL) ? slot->data : overflow_buffer, UDP_MAX_DATAGRAM};
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &buffer;
+        message.msg_iovlen = 1;
+        message.msg_control = control_buffer;
+        message.msg_controllen = sizeof(control_buffer);
+
+        ssize_t length = recvmsg(socket_fd, &message, 0);
+        if (length < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {continue;}
+            THROW_EXCEPTION("Error occurred while receiving from the UDP socket.");
+        }
+        datagrams_received.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef SO_RXQ_OVFL
+        // The kernel reports how many datagrams the socket has dropped so far
+        for (struct cmsghdr* control = CMSG_FIRSTHDR(&message); control != NULL; control = CMSG_NXTHDR(&message, control)) {
+            if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t num_drops = 0;
+                std::memcpy(&num_drops, CMSG_DATA(control), sizeof(num_drops));
+                kernel_drops.store(num_drops, std::memory_order_relaxed);
+            }
+        }
+#endif
+
+        // A truncated datagram would end with a partial record, so it is not used
+        if (message.msg_flags & MSG_TRUNC) {datagrams_truncated.fetch_add(1, std::memory_order_relaxed); continue;}
+        if (slot == NULL) {datagrams_dropped.fetch_add(1, std::memory_order_relaxed); continue;}
+
+        slot->length = length;
+        ring.end_write();
+    }
+    receiver_done.store(true, std::memory_order_release);
+}
+
+bool UDPListener::next_record(RecordSpan* record) {
+    /*
+     * Returns the next non-empty record, waiting for datagrams if the ring is empty. It returns
+     * false once a stop was requested and every datagram in the ring has been read. The record
+     * points into the ring, and is only valid until the next call to next_record().
+     */
+    while (true) {
+        if (curr_datagram != NULL) {
+            while (curr_offset < curr_datagram->length) {
+                const char* curr_pos = curr_datagram->data + curr_offset;
+                size_t remaining = curr_datagram->length - curr_offset;
+                const char* newline = static_cast<const char*>(std::memchr(curr_pos, '\n', remaining));
+
+                size_t length = (newline != NULL) ? (size_t) (newline - curr_pos) : remaining;
+                curr_offset += length + 1;
+                if (length && curr_pos[length-1] == '\r') {length--;}
+                if (length) {*record = {curr_pos, length}; return true;}
+            }
+            ring.end_read();
+            curr_datagram = NULL;
+        }
+
+        curr_datagram = ring.begin_read();
+        curr_offset = 0;
+        if (curr_datagram != NULL) {continue;}
+
+        // The ring is checked once more after the receive thread exits, since it may have added a datagram
+        if (receiver_done.load(std::memory_order_acquire)) {
+            curr_datagram = ring.begin_read();
+            if (curr_datagram == NULL) {return false;}
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(UDP_IDLE_SLEEP_US));
+    }
+}
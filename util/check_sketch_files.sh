@@ -0,0 +1,110 @@
+#!/bin/bash
+
+#####################################################################################
+#
+# check_sketch_files.sh - Checks the sketch files written and read by pacsketch: a
+#                         sketch written with build -o is read back by merge with the
+#                         same estimate, growing a sketch with build -a matches building
+#                         it at once, merging the sketches of parts of an input (with
+#                         threads) matches the sketch of the whole input, and a text
+#                         input with blank lines gives the same sketch as its columnar
+#                         conversion and as build -t.
+#
+#                         Usage: ./check_sketch_files.sh <path to pacsketch>
+#
+#                         It is run by ctest, and exits with 1 if any check fails.
+#
+# Author: Omar Ahmed
+# Date: October 18, 2026
+#
+#####################################################################################
+
+## Load definitions, and make sure paths are valid
+pacsketch="$1"
+
+if [ ! -x "$pacsketch" ]; then
+    printf "Error: pacsketch cannot be found, pass the path of the built executable.\n"
+    exit 1
+fi
+
+work_dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$work_dir"' EXIT
+num_failed=0
+
+## Prints the cardinality estimated by a pacsketch command
+estimate() {
+    "$pacsketch" "$@" 2> /dev/null | awk '/Estimated_Cardinality/ {print $2}'
+}
+
+## Compares an estimate with the expected one, and counts the failures
+check_equal() {
+    if [ -n "$2" ] && [ "$2" == "$3" ]; then
+        printf "[LOG] %-36s ok (%s)\n" "$1" "$2"
+    else
+        printf "Error: %s gave '%s', expected '%s'.\n" "$1" "$3" "$2"
+        num_failed=$((num_failed + 1))
+    fi
+}
+
+## Compares two sketch files byte for byte, and counts the failures
+check_same_file() {
+    if cmp -s "$2" "$3"; then
+        printf "[LOG] %-36s ok\n" "$1"
+    else
+        printf "Error: %s wrote different sketches (%s and %s).\n" "$1" "$(basename $2)" "$(basename $3)"
+        num_failed=$((num_failed + 1))
+    fi
+}
+
+## Synthetic records that look like the discretized NSL-KDD records, about 4000 of them are distinct
+awk 'BEGIN {srand(7); for (i = 0; i < 20000; i++) {
+        r = int(rand() * 4000); line = (r % 5) "," ((r % 3) ? "tcp" : "udp") ",private,SF";
+        for (j = 4; j < 41; j++) {line = line "," (int(r / (j + 1)) % 4)}
+        print line "," ((r % 2) ? "normal" : "neptune")}}' > "$work_dir/records.csv"
+awk '{print > ("'"$work_dir"'/part_" (NR % 4) ".csv")}' "$work_dir/records.csv"
+awk '{print} NR % 100 == 0 {print ""}' "$work_dir/records.csv" > "$work_dir/blank.csv"
+"$pacsketch" convert -i "$work_dir/blank.csv" -o "$work_dir/blank.col" > /dev/null 2>&1
+
+for sketch in "hll:-H -b 12" "mh:-M -k 200" "fmh:-F -s 4"; do
+    ext=${sketch%%:*}
+    sketch_opts=${sketch#*:}
+    full_estimate=$(estimate build -i "$work_dir/records.csv" $sketch_opts -c)
+
+    # Round-trip through a sketch file
+    "$pacsketch" build -i "$work_dir/records.csv" $sketch_opts -o "$work_dir/full.$ext" > /dev/null 2>&1
+    check_equal "$ext: build -o, merge -c" "$full_estimate" "$(estimate merge -i "$work_dir/full.$ext" -c)"
+
+    # Appending the second half of the input to the sketch of the first half
+    head -n 10000 "$work_dir/records.csv" > "$work_dir/grow.csv"
+    "$pacsketch" build -i "$work_dir/grow.csv" $sketch_opts -a -o "$work_dir/grow.$ext" > /dev/null 2>&1
+    tail -n +10001 "$work_dir/records.csv" >> "$work_dir/grow.csv"
+    append_log=$("$pacsketch" build -i "$work_dir/grow.csv" $sketch_opts -a -o "$work_dir/grow.$ext" 2>&1 > /dev/null)
+    if [[ "$append_log" == *"added bytes 0 to"* ]]; then
+        printf "Error: %s: build -a rebuilt the sketch instead of adding the new records.\n" "$ext"
+        num_failed=$((num_failed + 1))
+    fi
+    check_equal "$ext: build -a twice" "$full_estimate" "$(estimate merge -i "$work_dir/grow.$ext" -c)"
+    rm -f "$work_dir/grow.csv"
+
+    # Merging the sketches of four parts of the input
+    for part in 0 1 2 3; do
+        "$pacsketch" build -i "$work_dir/part_$part.csv" $sketch_opts -o "$work_dir/part_$part.$ext" > /dev/null 2>&1
+    done
+    check_equal "$ext: merge -t 3 of 4 parts" "$full_estimate" "$(estimate merge -i "$work_dir"/part_0.$ext -i "$work_dir"/part_1.$ext \
+                                                                            -i "$work_dir"/part_2.$ext -i "$work_dir"/part_3.$ext -t 3 -c)"
+
+    # Blank lines are skipped the same way by every path that reads records
+    "$pacsketch" build -i "$work_dir/blank.csv" $sketch_opts -o "$work_dir/blank_text.$ext" > /dev/null 2>&1
+    "$pacsketch" build -i "$work_dir/blank.col" $sketch_opts -o "$work_dir/blank_col.$ext" > /dev/null 2>&1
+    check_same_file "$ext: text vs columnar" "$work_dir/blank_text.$ext" "$work_dir/blank_col.$ext"
+    if [ "$ext" != "fmh" ]; then
+        "$pacsketch" build -i "$work_dir/blank.csv" $sketch_opts -t 2 -o "$work_dir/blank_threads.$ext" > /dev/null 2>&1
+        check_same_file "$ext: text vs build -t 2" "$work_dir/blank_text.$ext" "$work_dir/blank_threads.$ext"
+    fi
+done
+
+if [ $num_failed -gt 0 ]; then
+    printf "Error: %d of the sketch file checks failed.\n" $num_failed
+    exit 1
+fi
+printf "[LOG] all of the sketch file checks passed.\n"
@@ -0,0 +1,112 @@
+/* 
+ * Name: exact_kmer_set.cpp
+ * Description: Contains the exact k-mer set used by generate_fasta and 
+ *              generate_pair to compute the true cardinalities. The k-mers
+ *              are 2-bit encoded as the sequence is generated, so the memory
+ *              only grows with the number of distinct k-mers.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */ 
+
+#include <exact_kmer_set.h>
+#include <algorithm>
+
+ExactKmerSet::ExactKmerSet(size_t k): k(k) {
+    /* Constructor - picks the bitmap for small k, and the sorted array otherwise */
+    kmer_mask = (k == 32) ? UINT64_MAX : (((uint64_t) 1 << (2 * k)) - 1);
+    if (k <= MAX_BITMAP_KMER_LENGTH) {kmer_bitmap.assign(((uint64_t) 1 << (2 * k)) / 64 + 1, 0);}
+}
+
+void ExactKmerSet::add_base(char base) {
+    /* Adds the next base of the sequence, and inserts the k-mer ending at it */
+    uint64_t encoding = 0;
+    switch (base) {
+        case 'C': case 'c': encoding = 1; break;
+        case 'G': case 'g': encoding = 2; break;
+        case 'T': case 't': encoding = 3; break;
+        default: encoding = 0; break;
+    }
+    curr_kmer = ((curr_kmer << 2) | encoding) & kmer_mask;
+    if (++curr_length >= k) {insert_kmer(curr_kmer);}
+}
+
+void ExactKmerSet::end_sequence() {
+    /* Marks the end of a sequence, so k-mers do not span two sequences */
+    curr_kmer = 0;
+    curr_length = 0;
+}
+
+void ExactKmerSet::insert_kmer(uint64_t kmer) {
+    /* Marks the k-mer in the bitmap, or buffers it to be sorted in later */
+    if (!kmer_bitmap.empty()) {
+        kmer_bitmap[kmer >> 6] |= (uint64_t) 1 << (kmer & 63);
+        return;
+    }
+    kmers.push_back(kmer);
+    if (kmers.size() - num_sorted >= std::max(num_sorted, KMER_COMPACT_THRESHOLD)) {compact();}
+}
+
+void ExactKmerSet::radix_sort(uint64_t* start, size_t num_kmers) {
+    /* LSD radix sort of the k-mers, only looking at the 2k bits that can be set */
+    std::vector<uint64_t> scratch (num_kmers);
+    uint64_t* src = start;
+    uint64_t* dest = scratch.data();
+
+    for (size_t shift = 0; shift < 2 * k; shift += RADIX_BITS) {
+        size_t bucket_starts[RADIX_BUCKETS] = {0};
+        for (size_t i = 0; i < num_kmers; i++) {bucket_starts[(src[i] >> shift) & (RADIX_BUCKETS - 1)]++;}
+
+        size_t total = 0;
+        for (size_t i = 0; i < RADIX_BUCKETS; i++) {
+            size_t bucket_size = bucket_starts[i];
+            bucket_starts[i] = total;
+            total += bucket_size;
+        }
+        for (size_t i = 0; i < num_kmers; i++) {dest[bucket_starts[(src[i] >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];}
+        std::swap(src, dest);
+    }
+    if (src != start) {std::copy(src, src + num_kmers, start);}
+}
+
+void ExactKmerSet::compact() {
+    /* Sorts the buffered k-mers, merges them into the sorted prefix, and removes duplicates */
+    radix_sort(kmers.data() + num_sorted, kmers.size() - num_sorted);
+    std::inplace_merge(kmers.begin(), kmers.begin() + num_sorted, kmers.end());
+    kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+    num_sorted = kmers.size();
+}
+
+uint64_t ExactKmerSet::cardinality() {
+    /* Returns the number of distinct k-mers in the set */
+    if (!kmer_bitmap.empty()) {
+        uint64_t num_set = 0;
+        for (uint64_t word: kmer_bitmap) {num_set += __builtin_popcountll(word);}
+        return num_set;
+    }
+    compact();
+    return kmers.size();
+}
+
+uint64_t ExactKmerSet::union_cardinality(ExactKmerSet& set_a, ExactKmerSet& set_b) {
+    /* Returns the number of distinct k-mers in the union of two sets, both must use the same k */
+    if (!set_a.kmer_bitmap.empty()) {
+        uint64_t num_set = 0;
+        for (size_t i = 0; i < set_a.kmer_bitmap.size(); i++) {
+            num_set += __builtin_popcountll(set_a.kmer_bitmap[i] | set_b.kmer_bitmap[i]);
+        }
+        return num_set;
+    }
+
+    // Walk the two sorted arrays to count the shared k-mers
+    set_a.compact(); set_b.compact();
+    uint64_t num_shared = 0;
+    auto iter_a = set_a.kmers.begin(), iter_b = set_b.kmers.begin();
+    while (iter_a != set_a.kmers.end() && iter_b != set_b.kmers.end()) {
+        if (*iter_a < *iter_b) {++iter_a;}
+        else if (*iter_b < *iter_a) {++iter_b;}
+        else {num_shared++; ++iter_a; ++iter_b;}
+    }
+    return set_a.kmers.size() + set_b.kmers.size() - num_shared;
+}
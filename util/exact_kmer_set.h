@@ -0,0 +1,55 @@
+/* 
+ * Name: exact_kmer_set.h
+ * Description: Header file for exact_kmer_set.cpp
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */ 
+
+#ifndef _EXACT_KMER_SET_H
+#define _EXACT_KMER_SET_H
+
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Values of k up to this length use a bitmap over every possible k-mer (4^14 bits = 32 MB)
+#define MAX_BITMAP_KMER_LENGTH 14
+
+// Number of unsorted k-mers that are buffered before being sorted into the distinct set
+#define KMER_COMPACT_THRESHOLD ((size_t) 1 << 22)
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+class ExactKmerSet {
+    /*
+     * Exact set of the k-mers seen in a stream of bases. Each k-mer is 2-bit encoded
+     * into a uint64_t as the bases arrive, so the sequence itself is never stored.
+     * Small values of k mark a bitmap, larger ones keep a sorted array of distinct
+     * k-mers that new k-mers are periodically radix sorted and merged into.
+     */
+private:
+    size_t k = 0; // length of the k-mers
+    uint64_t kmer_mask = 0; // keeps the lowest 2k bits of the rolling k-mer
+    uint64_t curr_kmer = 0; // encoding of the last k bases
+    size_t curr_length = 0; // number of bases seen since the start of the sequence
+    std::vector<uint64_t> kmer_bitmap; // bit per possible k-mer, when k <= MAX_BITMAP_KMER_LENGTH
+    std::vector<uint64_t> kmers; // sorted distinct k-mers followed by unsorted new ones
+    size_t num_sorted = 0; // length of the sorted distinct prefix of kmers
+
+public:
+    ExactKmerSet(size_t k);
+    void add_base(char base);
+    void end_sequence();
+    uint64_t cardinality();
+    static uint64_t union_cardinality(ExactKmerSet& set_a, ExactKmerSet& set_b);
+
+private:
+    void insert_kmer(uint64_t kmer);
+    void compact();
+    void radix_sort(uint64_t* start, size_t num_kmers);
+};
+
+#endif /* end of _EXACT_KMER_SET_H include */
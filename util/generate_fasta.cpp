@@ -16,16 +16,7 @@
 #include <stdlib.h>
 #include <time.h>  
 #include <array>
-#include <set>
-
-size_t compute_cardinality(size_t k, std::string curr_seq) {
-    /* Computes the kmer cardinality of the DNA sequence */
-    std::set<std::string> kmer_set;
-    for (size_t pos = 0; pos <= curr_seq.length()-k; pos++) {
-        kmer_set.insert(curr_seq.substr(pos, k));
-    }
-    return kmer_set.size();
-}
+#include <exact_kmer_set.h>
 
 void produce_fasta(size_t k, size_t num_seqs, size_t seq_length) {
     /* Produces the FASTA file, and cardinality measurements to stdout */
@@ -34,20 +25,21 @@ void produce_fasta(size_t k, size_t num_seqs, size_t seq_length) {
 
     for (size_t i = 0; i < num_seqs; i++) {
         std::fprintf(stdout, ">seq%ld\n", i);
-        std::string total_seq = "";
+        ExactKmerSet kmer_set (k);
         std::string curr_str = "";
 
+        // Bases are added to the k-mer set as they are generated, so the full sequence is never kept
         for (size_t j = 0; j < seq_length; j++) {
             if (j % FASTA_WIDTH == 0 && j) {
                 std::fprintf(stdout, "%s\n", curr_str.data()); 
-                total_seq += curr_str;
-                curr_str = ""; 
+                curr_str.clear();
             }
             curr_str += alphabet[GET_RANDOM_INDEX(4)];
+            kmer_set.add_base(curr_str.back());
         }
-        if (curr_str.length()) {std::fprintf(stdout, "%s\n", curr_str.data()); total_seq += curr_str;}
+        if (curr_str.length()) {std::fprintf(stdout, "%s\n", curr_str.data());}
         
-        size_t cardinality = compute_cardinality(k, total_seq);
+        size_t cardinality = kmer_set.cardinality();
         std::fprintf(stderr, "CARDINALITY_seq%ld = %ld\n", i, cardinality);
     }
 }
@@ -59,7 +51,7 @@ void parse_generate_fasta_run_options(int argc, char** argv, GenerateFastaOption
             case 'h': generate_fasta_usage(); std::exit(1);
             case 'k': opts->k = std::max(std::atoi(optarg), 0); break;
             case 'n': opts->num_seqs = std::max(std::atoi(optarg), 0); break;
-            case 'l': opts->seq_length = std::max(std::atoi(optarg), 0); break;
+            case 'l': opts->seq_length = std::max(std::atol(optarg), 0L); break;
             default: generate_fasta_usage(); std::exit(1);
         }
     }
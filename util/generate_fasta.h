@@ -37,6 +37,5 @@ public:
 void parse_generate_fasta_run_options(int argc, char** argv, GenerateFastaOptions* opts);
 int generate_fasta_usage ();
 void produce_fasta(size_t k, size_t num_seqs, size_t seq_length);
-size_t compute_cardinality(size_t k, std::string curr_seq);
 
 #endif /* end of _GEN_FASTA include */
\ No newline at end of file
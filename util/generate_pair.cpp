@@ -15,31 +15,36 @@
 #include <generate_pair.h>
 #include <unistd.h>
 #include <array>
-#include <filesystem>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
+#include <sys/stat.h>
 #include <tuple>
-#include <set>
 #include <vector>
+#include <cmath>
+#include <exact_kmer_set.h>
 
 /* Makes sure the output prefix has a valid parent path */
 bool is_valid_path(const char* output_prefix) {
-    std::__fs::filesystem::path out_prefix_path = output_prefix;
     if (output_prefix[strlen(output_prefix)-1] == '/') {FATAL_WARNING("Need a output prefix, not a directory.");}
-    if (std::__fs::filesystem::exists(out_prefix_path.parent_path())) {return true;}
-    return false;
+    const char* last_slash = std::strrchr(output_prefix, '/');
+    std::string parent_path = (last_slash != NULL) ? std::string(output_prefix, last_slash - output_prefix + 1) : ".";
+    struct stat s;
+    return stat(parent_path.data(), &s) == 0 && S_ISDIR(s.st_mode);
 }
 
-/* Computes the kmer cardinality of the DNA sequence */
-size_t compute_single_cardinality(size_t k, std::string curr_seq) {
-    std::set<std::string> kmer_set;
-    for (size_t pos = 0; pos <= curr_seq.length()-k; pos++) {
-        kmer_set.insert(curr_seq.substr(pos, k));
-    }
-    return kmer_set.size();
+double mutation_rate_for_jaccard(size_t k, double target_jaccard) {
+    /* 
+     * Returns the substitution rate that gives the target jaccard on average. A k-mer
+     * survives with probability q = (1-r)^k, and J = q/(2-q) for random sequences, so
+     * q = 2J/(1+J) and r = 1 - q^(1/k).
+     */
+    double shared_fraction = (2.0 * target_jaccard)/(1.0 + target_jaccard);
+    return 1.0 - std::pow(shared_fraction, 1.0/k);
 }
 
 /* Takes in command-line arguments, and produces a pair of FASTA files */
-void produce_pair(size_t k, size_t seq_length, const char* output_file_prefix) {
+void produce_pair(size_t k, size_t seq_length, double target_jaccard, const char* output_file_prefix) {
     // Validate command-line path variable, and open first FASTA
     if (!is_valid_path(output_file_prefix)) {FATAL_WARNING("output prefix given does not exist.");}
 
@@ -56,38 +61,38 @@ void produce_pair(size_t k, size_t seq_length, const char* output_file_prefix) {
     srand(time(NULL));
 
     size_t num_seqs = 2;
-    std::set<std::string> union_kmer_set;
-    std::vector<size_t> cardinalities;
-
-    // Creates each of FASTA files while computing cardinality of each individuallly
-    for (size_t i = 0; i < num_seqs; i++) {
-        out_streams[i] << ">seq" << i << std::endl;
-        std::string total_seq = "";
-        std::string curr_str = "";
-
-        for (size_t j = 0; j < seq_length; j++) {
-            if (j % FASTA_WIDTH == 0 && j) {
-                out_streams[i] << curr_str.data() << std::endl;
-                total_seq += curr_str;
-                curr_str = ""; 
-            }
-            curr_str += alphabet[GET_RANDOM_INDEX(4)];
+    std::array<ExactKmerSet, 2> kmer_sets = {ExactKmerSet(k), ExactKmerSet(k)};
+    std::array<std::string, 2> curr_strs;
+    double mutation_rate = (target_jaccard > 0.0) ? mutation_rate_for_jaccard(k, target_jaccard) : 0.0;
+
+    // Generates both FASTA files together, the second sequence is either independent
+    // or a mutated copy of the first when a target jaccard is given
+    for (size_t i = 0; i < num_seqs; i++) {out_streams[i] << ">seq" << i << std::endl;}
+    for (size_t j = 0; j < seq_length; j++) {
+        if (j % FASTA_WIDTH == 0 && j) {
+            for (size_t i = 0; i < num_seqs; i++) {out_streams[i] << curr_strs[i].data() << std::endl; curr_strs[i].clear();}
         }
-        if (curr_str.length()) {out_streams[i] << curr_str.data() << std::endl; total_seq += curr_str;}
-        
-        size_t cardinality = compute_single_cardinality(k, total_seq);
-        cardinalities.push_back(cardinality);
-
-        // Inserted current FASTA into union sketch
-        for (size_t pos = 0; pos <= total_seq.length()-k; pos++) {
-            union_kmer_set.insert(total_seq.substr(pos, k));
+        size_t base_a = GET_RANDOM_INDEX(4);
+        size_t base_b = GET_RANDOM_INDEX(4);
+        if (target_jaccard > 0.0) {
+            base_b = base_a;
+            if (GET_RANDOM_FRACTION() < mutation_rate) {base_b = (base_a + 1 + GET_RANDOM_INDEX(3)) % 4;}
         }
+        curr_strs[0] += alphabet[base_a];
+        curr_strs[1] += alphabet[base_b];
+        kmer_sets[0].add_base(alphabet[base_a]);
+        kmer_sets[1].add_base(alphabet[base_b]);
+    }
+    for (size_t i = 0; i < num_seqs; i++) {
+        if (curr_strs[i].length()) {out_streams[i] << curr_strs[i].data() << std::endl;}
     }
     out_streams[0].close();
     out_streams[1].close();
 
+    std::vector<size_t> cardinalities = {kmer_sets[0].cardinality(), kmer_sets[1].cardinality()};
+
     // Gather stats into stats output file
-    cardinalities.push_back(union_kmer_set.size());
+    cardinalities.push_back(ExactKmerSet::union_cardinality(kmer_sets[0], kmer_sets[1]));
     auto jaccard = (cardinalities[0] + cardinalities[1] - cardinalities[2] + 0.0)/(cardinalities[2]);
 
     out_streams[2] << std::right << std::setw(10) << "|SET(A)|" <<
@@ -103,12 +108,13 @@ void produce_pair(size_t k, size_t seq_length, const char* output_file_prefix) {
 
 void parse_generate_pair_run_options(int argc, char** argv, GeneratePairOptions* opts) {
     /* Parses the command-line arguments */
-    for (int c; (c = getopt(argc, argv, "hk:l:o:")) >= 0;){
+    for (int c; (c = getopt(argc, argv, "hk:l:o:j:")) >= 0;){
         switch (c) {
             case 'h': generate_pair_usage(); std::exit(1);
             case 'k': opts->k = std::max(std::atoi(optarg), 0); break;
             case 'o': opts->output_file_prefix.assign(optarg); break;
-            case 'l': opts->seq_length = std::max(std::atoi(optarg), 0); break;
+            case 'l': opts->seq_length = std::max(std::atol(optarg), 0L); break;
+            case 'j': opts->target_jaccard = std::atof(optarg); break;
             default:  FATAL_WARNING("Use -h option to see valid command-line options");
         }
     }
@@ -126,6 +132,7 @@ int generate_pair_usage () {
     std::fprintf(stderr, "\t%-10slength of k-mer to use for sketch\n", "-k [arg]");
     std::fprintf(stderr, "\t%-10slength of each sequence.\n", "-l [arg]");
     std::fprintf(stderr, "\t%-10soutput file prefix for FASTA files\n", "-o [arg]");
+    std::fprintf(stderr, "\t%-10starget jaccard, the second sequence is a mutated copy of the first\n", "-j [arg]");
     return 0;
 }
 
@@ -136,7 +143,7 @@ int main (int argc, char ** argv) {
         parse_generate_pair_run_options(argc, argv, &run_opts);
         run_opts.validate();
 
-        produce_pair(run_opts.k, run_opts.seq_length, run_opts.output_file_prefix.data());
+        produce_pair(run_opts.k, run_opts.seq_length, run_opts.target_jaccard, run_opts.output_file_prefix.data());
         return 0;
     } 
     else {return generate_pair_usage();}
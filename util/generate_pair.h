@@ -12,17 +12,19 @@
 
 #define FASTA_WIDTH 60
 #define GET_RANDOM_INDEX(x) (rand()%(x))
+#define GET_RANDOM_FRACTION() (rand()/(RAND_MAX + 1.0))
 #define FATAL_WARNING(x) do {std::fprintf(stderr, "\nWarning: %s\n\n", x); std::exit(1);} while (0)
 #define THROW_EXCEPTION(x) do { throw x;} while (0)
 
 /* Function Declarations */
 bool is_valid_path(const char* output_prefix);
-size_t compute_single_cardinality(size_t k, std::string curr_seq); 
+double mutation_rate_for_jaccard(size_t k, double target_jaccard);
 
 struct GeneratePairOptions {
     size_t k = 0; // kmer to check cardinality
     std::string output_file_prefix = ""; // output file prefix is valid
     size_t seq_length = 0; // length of FASTA sequence
+    double target_jaccard = 0.0; // jaccard to aim for by mutating the first sequence (0 = independent)
 
 public:
     void validate() {
@@ -30,13 +32,14 @@ public:
         if (seq_length <= 0) {FATAL_WARNING("The length of the sequence (-l) needs to be set as a positive number.");}
         if (k > seq_length) {FATAL_WARNING("The length of the text is too small for the given kmer value.");}
         if (output_file_prefix == "") {FATAL_WARNING("Need to specify an output file prefix.");}
+        if (target_jaccard < 0.0 || target_jaccard > 1.0) {FATAL_WARNING("The target jaccard (-j) needs to be between 0 and 1.");}
     }
 };
 
 /* Function Declarations */
 void parse_generate_pair_run_options(int argc, char** argv, GeneratePairOptions* opts);
 int generate_pair_usage ();
-void produce_pair(size_t k, size_t seq_length, const char* output_file_prefix);
+void produce_pair(size_t k, size_t seq_length, double target_jaccard, const char* output_file_prefix);
 
 
 #endif /* end of _GEN_FASTA_PAIR include */
\ No newline at end of file
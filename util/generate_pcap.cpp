@@ -0,0 +1,239 @@
+/*
+ * Name: generate_pcap.cpp
+ * Description: Contains code to generate synthetic packet captures (classic pcap or pcapng)
+ *              to be used as test input for pacsketch. The packets are drawn from a set of
+ *              random flows, and the exact number of distinct keys is written to stderr in
+ *              order to check the cardinality estimates.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <cstring>
+#include <random>
+#include <set>
+#include <unistd.h>
+#include <generate_pcap.h>
+
+static void put_be16(std::vector<uint8_t>& frame, uint16_t value) {
+    /* Appends a 16-bit field in network byte order */
+    frame.push_back(value >> 8);
+    frame.push_back(value & 0xFF);
+}
+
+void build_frame(const Flow& flow, std::vector<uint8_t>& frame, uint16_t icmp_sequence) {
+    /*
+     * Builds an Ethernet frame holding an IPv4/IPv6 packet, with a TCP or UDP header and no payload,
+     * or an ICMP echo request whose sequence number (and so checksum) changes with every packet.
+     */
+    frame.clear();
+    const uint8_t macs[12] = {0x02, 0, 0, 0, 0, 0x01, 0x02, 0, 0, 0, 0, 0x02};
+    frame.insert(frame.end(), macs, macs + 12);
+    put_be16(frame, (flow.ip_version == 4) ? 0x0800 : 0x86DD);
+
+    uint16_t transport_length = (flow.protocol == 6) ? 20 : 8; // UDP and ICMP echo headers are both 8 bytes
+    if (flow.ip_version == 4) {
+        frame.push_back(0x45); frame.push_back(0);
+        put_be16(frame, 20 + transport_length);
+        put_be16(frame, 0); put_be16(frame, 0x4000); // id, don't fragment
+        frame.push_back(64); frame.push_back(flow.protocol);
+        put_be16(frame, 0); // checksum is not checked by the reader
+        frame.insert(frame.end(), flow.src_addr, flow.src_addr + 4);
+        frame.insert(frame.end(), flow.dst_addr, flow.dst_addr + 4);
+    } else {
+        put_be16(frame, 0x6000); put_be16(frame, 0);
+        put_be16(frame, transport_length);
+        frame.push_back(flow.protocol); frame.push_back(64);
+        frame.insert(frame.end(), flow.src_addr, flow.src_addr + 16);
+        frame.insert(frame.end(), flow.dst_addr, flow.dst_addr + 16);
+    }
+
+    if (flow.protocol == PROTOCOL_ICMP || flow.protocol == PROTOCOL_ICMPV6) {
+        uint8_t echo_type = (flow.protocol == PROTOCOL_ICMP) ? 8 : 128;
+        uint32_t checksum = ((uint32_t) echo_type << 8) + flow.icmp_id + icmp_sequence; // one's complement sum of the header
+        checksum = (checksum & 0xFFFF) + (checksum >> 16);
+        frame.push_back(echo_type); frame.push_back(0);
+        put_be16(frame, ~checksum & 0xFFFF);
+        put_be16(frame, flow.icmp_id);
+        put_be16(frame, icmp_sequence);
+        return;
+    }
+
+    put_be16(frame, flow.src_port);
+    put_be16(frame, flow.dst_port);
+    if (flow.protocol == 6) {
+        const uint8_t tcp_rest[16] = {0, 0, 0, 1, 0, 0, 0, 0, 0x50, 0x18, 0xFF, 0xFF, 0, 0, 0, 0};
+        frame.insert(frame.end(), tcp_rest, tcp_rest + 16);
+    } else {
+        put_be16(frame, 8); put_be16(frame, 0);
+    }
+}
+
+static void build_arp_frame(std::vector<uint8_t>& frame) {
+    /* Builds an ARP request, it is not an IP packet so the reader should skip it */
+    frame.assign(12, 0xFF);
+    put_be16(frame, 0x0806);
+    const uint8_t arp_body[28] = {0, 1, 8, 0, 6, 4, 0, 1};
+    frame.insert(frame.end(), arp_body, arp_body + 28);
+}
+
+static void write_u32(FILE* output, uint32_t value) {std::fwrite(&value, sizeof(value), 1, output);}
+static void write_u16(FILE* output, uint16_t value) {std::fwrite(&value, sizeof(value), 1, output);}
+
+static void write_header(FILE* output, bool write_pcapng) {
+    /* Writes the file header (classic), or the section header and interface blocks (pcapng) */
+    if (!write_pcapng) {
+        write_u32(output, 0xa1b2c3d4); write_u16(output, 2); write_u16(output, 4);
+        write_u32(output, 0); write_u32(output, 0); write_u32(output, SNAP_LENGTH); write_u32(output, 1);
+        return;
+    }
+    write_u32(output, 0x0A0D0D0A); write_u32(output, 28); write_u32(output, 0x1A2B3C4D);
+    write_u16(output, 1); write_u16(output, 0);
+    write_u32(output, 0xFFFFFFFF); write_u32(output, 0xFFFFFFFF); // section length is not specified
+    write_u32(output, 28);
+
+    write_u32(output, 1); write_u32(output, 20); write_u16(output, 1); write_u16(output, 0);
+    write_u32(output, SNAP_LENGTH); write_u32(output, 20);
+}
+
+static void write_frame(FILE* output, bool write_pcapng, uint64_t timestamp_us, const std::vector<uint8_t>& frame) {
+    /* Writes one frame as a pcap record, or as a pcapng enhanced packet block */
+    if (!write_pcapng) {
+        write_u32(output, timestamp_us / 1000000); write_u32(output, timestamp_us % 1000000);
+        write_u32(output, frame.size()); write_u32(output, frame.size());
+        std::fwrite(frame.data(), 1, frame.size(), output);
+        return;
+    }
+    uint32_t padding = (4 - frame.size() % 4) % 4;
+    uint32_t block_length = 32 + frame.size() + padding;
+    write_u32(output, 6); write_u32(output, block_length); write_u32(output, 0);
+    write_u32(output, timestamp_us >> 32); write_u32(output, timestamp_us & 0xFFFFFFFF);
+    write_u32(output, frame.size()); write_u32(output, frame.size());
+    std::fwrite(frame.data(), 1, frame.size(), output);
+    const uint8_t zeros[4] = {0, 0, 0, 0};
+    std::fwrite(zeros, 1, padding, output);
+    write_u32(output, block_length);
+}
+
+void produce_pcap(const GeneratePcapOptions& opts) {
+    /* Writes the capture, and the exact number of distinct keys (for the keys pacsketch supports) to stderr */
+    std::mt19937_64 rng (opts.seed);
+    std::uniform_real_distribution<double> uniform_prob (0.0, 1.0);
+
+    // Flows share hosts and services, so each packet key has a different cardinality
+    size_t num_hosts = std::max(opts.num_flows / HOSTS_PER_FLOW_RATIO, (size_t) 1);
+    std::vector<std::vector<uint8_t>> hosts[2];
+    for (size_t version = 0; version < 2; version++) {
+        hosts[version].resize(num_hosts, std::vector<uint8_t>(16, 0));
+        for (auto& host: hosts[version]) {
+            for (size_t i = 0; i < ((version == 0) ? 4 : 16); i++) {host[i] = rng();}
+        }
+    }
+
+    std::vector<Flow> flows (opts.num_flows);
+    for (Flow& flow: flows) {
+        flow.ip_version = (uniform_prob(rng) < opts.ipv6_ratio) ? 6 : 4;
+        flow.protocol = (rng() % 2) ? 6 : 17;
+        const auto& version_hosts = hosts[flow.ip_version == 6];
+        std::memcpy(flow.src_addr, version_hosts[rng() % num_hosts].data(), 16);
+        std::memcpy(flow.dst_addr, version_hosts[rng() % num_hosts].data(), 16);
+        flow.src_port = 1024 + rng() % 64512;
+        flow.dst_port = rng() % NUM_SERVICE_PORTS;
+        flow.icmp_id = 0;
+
+        // ICMP flows are keyed without ports, however many echo requests they send
+        if (rng() % ICMP_FLOW_RATIO == 0) {
+            flow.protocol = (flow.ip_version == 4) ? PROTOCOL_ICMP : PROTOCOL_ICMPV6;
+            flow.icmp_id = flow.src_port;
+            flow.src_port = flow.dst_port = 0;
+        }
+    }
+
+    FILE* output = std::fopen(opts.output_file.data(), "wb");
+    if (output == NULL) {FATAL_WARNING("The output file could not be created.");}
+    write_header(output, opts.write_pcapng);
+
+    // Keys are stored as the bytes of their fields, and counted for the flows that were used
+    std::set<std::string> five_tuples, src_dst_pairs, srcs, dsts, dst_services;
+    std::vector<uint8_t> frame;
+    size_t num_arp = 0;
+    uint64_t timestamp_us = 1600000000ULL * 1000000;
+
+    for (size_t i = 0; i < opts.num_packets; i++) {
+        if (i % ARP_FRAME_INTERVAL == ARP_FRAME_INTERVAL - 1) {
+            build_arp_frame(frame);
+            write_frame(output, opts.write_pcapng, timestamp_us++, frame);
+            num_arp++;
+        }
+        const Flow& flow = flows[rng() % flows.size()];
+        build_frame(flow, frame, (uint16_t) i);
+        write_frame(output, opts.write_pcapng, timestamp_us++, frame);
+
+        std::string src ((const char*) flow.src_addr, 16), dst ((const char*) flow.dst_addr, 16);
+        std::string version (1, (char) flow.ip_version), protocol (1, (char) flow.protocol);
+        std::string src_port ((const char*) &flow.src_port, 2), dst_port ((const char*) &flow.dst_port, 2);
+        five_tuples.insert(version + protocol + src + dst + src_port + dst_port);
+        src_dst_pairs.insert(version + src + dst);
+        srcs.insert(version + src);
+        dsts.insert(version + dst);
+        dst_services.insert(version + protocol + dst + dst_port);
+    }
+    std::fclose(output);
+
+    std::fprintf(stderr, "PACKETS = %zu\n", opts.num_packets);
+    std::fprintf(stderr, "SKIPPED_FRAMES = %zu\n", num_arp);
+    std::fprintf(stderr, "CARDINALITY_5tuple = %zu\n", five_tuples.size());
+    std::fprintf(stderr, "CARDINALITY_srcdst = %zu\n", src_dst_pairs.size());
+    std::fprintf(stderr, "CARDINALITY_src = %zu\n", srcs.size());
+    std::fprintf(stderr, "CARDINALITY_dst = %zu\n", dsts.size());
+    std::fprintf(stderr, "CARDINALITY_dstport = %zu\n", dst_services.size());
+}
+
+void parse_generate_pcap_options(int argc, char** argv, GeneratePcapOptions* opts) {
+    /* Parses the command-line arguments */
+    for (int c; (c = getopt(argc, argv, "ho:n:f:6:gs:")) >= 0;) {
+        switch (c) {
+            case 'h': generate_pcap_usage(); std::exit(1);
+            case 'o': opts->output_file.assign(optarg); break;
+            case 'n': opts->num_packets = std::max(std::atol(optarg), 0L); break;
+            case 'f': opts->num_flows = std::max(std::atol(optarg), 0L); break;
+            case '6': opts->ipv6_ratio = std::atof(optarg); break;
+            case 'g': opts->write_pcapng = true; break;
+            case 's': opts->seed = std::strtoull(optarg, NULL, 10); break;
+            default: generate_pcap_usage(); std::exit(1);
+        }
+    }
+}
+
+int generate_pcap_usage() {
+    /* prints out the usage information for generate_pcap utility */
+    std::fprintf(stderr, "generate_pcap - outputs a synthetic packet capture, where the packets\n");
+    std::fprintf(stderr, "                are drawn from random flows, along with the exact\n");
+    std::fprintf(stderr, "                number of distinct keys (to stderr).\n");
+    std::fprintf(stderr, "Usage: generate_pcap -o output.pcap [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10spath of the capture to write\n", "-o [FILE]");
+    std::fprintf(stderr, "\t%-10snumber of IP packets in the capture\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10snumber of random flows to draw packets from\n", "-f [arg]");
+    std::fprintf(stderr, "\t%-10sfraction of the flows that are IPv6 (default: 0.0)\n", "-6 [arg]");
+    std::fprintf(stderr, "\t%-10swrite pcapng instead of classic pcap\n", "-g");
+    std::fprintf(stderr, "\t%-10sseed for the random flows (default: current time)\n", "-s [arg]");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    /* main method of generate_pcap utility */
+    if (argc > 1) {
+        GeneratePcapOptions run_opts;
+        parse_generate_pcap_options(argc, argv, &run_opts);
+        run_opts.validate();
+
+        produce_pcap(run_opts);
+        return 0;
+    }
+    else {return generate_pcap_usage();}
+}
@@ -0,0 +1,63 @@
+/*
+ * Name: generate_pcap.h
+ * Description: Header file for generate_pcap.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _GEN_PCAP
+#define _GEN_PCAP
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define FATAL_WARNING(x) do {std::fprintf(stderr, "Warning: %s\n", x); std::exit(1);} while (0)
+
+#define ARP_FRAME_INTERVAL 100 // every 100th frame is an ARP frame, which the reader has to skip
+#define SNAP_LENGTH 65535
+#define HOSTS_PER_FLOW_RATIO 4 // flows are between hosts from a pool 4x smaller than the number of flows
+#define NUM_SERVICE_PORTS 64 // destination ports are drawn from the first 64 ports
+#define ICMP_FLOW_RATIO 10 // 1 in 10 flows is an ICMP echo flow, which has no ports
+#define PROTOCOL_ICMP 1
+#define PROTOCOL_ICMPV6 58
+
+struct GeneratePcapOptions {
+    std::string output_file = ""; // path of the capture to write
+    size_t num_packets = 0; // number of IP packets in the capture
+    size_t num_flows = 0; // number of random 5-tuples the packets are drawn from
+    double ipv6_ratio = 0.0; // fraction of the flows that are IPv6
+    bool write_pcapng = false; // write pcapng instead of classic pcap
+    uint64_t seed = time(NULL); // seed for the random flows
+public:
+    void validate() {
+        if (output_file == "") {FATAL_WARNING("The output file (-o) needs to be specified.");}
+        if (num_packets == 0) {FATAL_WARNING("The number of packets (-n) needs to be set as a positive number.");}
+        if (num_flows == 0) {FATAL_WARNING("The number of flows (-f) needs to be set as a positive number.");}
+        if (ipv6_ratio < 0.0 || ipv6_ratio > 1.0) {FATAL_WARNING("The ratio of IPv6 flows (-6) needs to be between 0.0 and 1.0.");}
+    }
+};
+
+struct Flow {
+    /* Header fields of a flow, IPv4 addresses only use the first 4 bytes */
+    uint8_t ip_version;
+    uint8_t protocol;
+    uint8_t src_addr[16];
+    uint8_t dst_addr[16];
+    uint16_t src_port; // 0 for ICMP flows
+    uint16_t dst_port;
+    uint16_t icmp_id; // identifier of an ICMP echo flow
+};
+
+/* Function Declarations */
+void parse_generate_pcap_options(int argc, char** argv, GeneratePcapOptions* opts);
+int generate_pcap_usage();
+void build_frame(const Flow& flow, std::vector<uint8_t>& frame, uint16_t icmp_sequence = 0);
+void produce_pcap(const GeneratePcapOptions& opts);
+
+#endif /* end of _GEN_PCAP include */
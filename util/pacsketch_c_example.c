@@ -0,0 +1,244 @@
+/*
+ * Name: pacsketch_c_example.c
+ * Description: Exercises the C interface of libpacsketch: it builds MinHash and HyperLogLog
+ *              sketches of synthetic connection records, checks the estimates, merges and
+ *              round-trips them (including a MinHash of fewer records than k) through the
+ *              serialized format, and checks that misuse is reported with the right status
+ *              codes. It exits with 1 if any check fails.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pacsketch_c.h>
+
+#define NUM_RECORDS_A 20000 // set A is records [0, 20000), set B is [10000, 30000), so J(A,B) = 1/3
+#define OFFSET_B 10000
+#define EXPECTED_JACCARD (1.0/3.0)
+#define UNDERFILLED_K 100 // a MinHash of fewer records than k keeps empty slots, and must still load
+#define UNDERFILLED_RECORDS 10
+
+static int num_failed = 0;
+
+#define CHECK(cond, ...) do {if (!(cond)) {fprintf(stderr, "FAILED: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); num_failed++;}} while (0)
+#define CHECK_STATUS(call, expected) do {int status = (call); CHECK(status == (expected), "%s returned \"%s\"", #call, pacsketch_status_string(status));} while (0)
+
+static size_t make_record(size_t record_num, char* record, size_t capacity) {
+    /* Writes a connection record in the format of the discretized dataset, the label is the last field and is not hashed */
+    int length = snprintf(record, capacity, "tcp,http,SF,%zu,%zu,normal", record_num % 7919, record_num / 7919);
+    return (size_t) length;
+}
+
+static double relative_error(uint64_t estimate, uint64_t truth) {
+    /* Returns the error of an estimate as a fraction of the true value */
+    return fabs((double) estimate - (double) truth) / (double) truth;
+}
+
+static void check_hll(void) {
+    /* Builds, compares, merges and round-trips HyperLogLog sketches */
+    pacsketch_hll_t *sketch_a = NULL, *sketch_b = NULL, *loaded = NULL, *other_b = NULL;
+    CHECK_STATUS(pacsketch_hll_create(12, &sketch_a), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_create(12, &sketch_b), PACSKETCH_OK);
+    if (sketch_a == NULL || sketch_b == NULL) {return;}
+
+    // A is inserted one record at a time, B from hashes computed up-front in one batch
+    char record[128];
+    uint64_t* hashes_b = malloc(NUM_RECORDS_A * sizeof(uint64_t));
+    for (size_t i = 0; i < NUM_RECORDS_A; i++) {
+        CHECK_STATUS(pacsketch_hll_insert_record(sketch_a, record, make_record(i, record, sizeof(record))), PACSKETCH_OK);
+        hashes_b[i] = pacsketch_hash_record(record, make_record(i + OFFSET_B, record, sizeof(record)));
+    }
+    CHECK_STATUS(pacsketch_hll_insert_hashes(sketch_b, hashes_b, NUM_RECORDS_A), PACSKETCH_OK);
+    free(hashes_b);
+
+    uint64_t card_a = 0, card_b = 0;
+    double jaccard = 0.0;
+    CHECK_STATUS(pacsketch_hll_cardinality(sketch_a, &card_a), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_cardinality(sketch_b, &card_b), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_jaccard(sketch_a, sketch_b, &jaccard), PACSKETCH_OK);
+    CHECK(relative_error(card_a, NUM_RECORDS_A) < 0.1, "HLL cardinality of A is %llu, expected about %d", (unsigned long long) card_a, NUM_RECORDS_A);
+    CHECK(relative_error(card_b, NUM_RECORDS_A) < 0.1, "HLL cardinality of B is %llu, expected about %d", (unsigned long long) card_b, NUM_RECORDS_A);
+    CHECK(fabs(jaccard - EXPECTED_JACCARD) < 0.1, "HLL jaccard is %.4f, expected about %.4f", jaccard, EXPECTED_JACCARD);
+    printf("HyperLogLog (b=12): card(A) = %llu, card(B) = %llu, J(A,B) = %.4f\n", (unsigned long long) card_a, (unsigned long long) card_b, jaccard);
+
+    // The size is asked for first, a sketch loaded from the bytes has to serialize to the same bytes
+    size_t serialized_size = 0, reserialized_size = 0;
+    CHECK_STATUS(pacsketch_hll_serialize(sketch_a, NULL, 0, &serialized_size), PACSKETCH_OK);
+    char* serialized = malloc(serialized_size);
+    char* reserialized = malloc(serialized_size);
+    CHECK_STATUS(pacsketch_hll_serialize(sketch_a, serialized, serialized_size - 1, &serialized_size), PACSKETCH_ERROR_BUFFER_TOO_SMALL);
+    CHECK_STATUS(pacsketch_hll_serialize(sketch_a, serialized, serialized_size, &serialized_size), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_deserialize(serialized, serialized_size, &loaded), PACSKETCH_OK);
+    if (loaded != NULL) {
+        CHECK_STATUS(pacsketch_hll_serialize(loaded, reserialized, serialized_size, &reserialized_size), PACSKETCH_OK);
+        CHECK(reserialized_size == serialized_size && !memcmp(serialized, reserialized, serialized_size), "HLL did not round-trip through serialize/deserialize");
+        pacsketch_hll_free(loaded);
+    }
+
+    // Truncated and damaged bytes are rejected, and so are the bytes of the other sketch type
+    pacsketch_minhash_t* wrong_type = NULL;
+    CHECK_STATUS(pacsketch_hll_deserialize(serialized, serialized_size - 1, &loaded), PACSKETCH_ERROR_CORRUPT);
+    CHECK_STATUS(pacsketch_minhash_deserialize(serialized, serialized_size, &wrong_type), PACSKETCH_ERROR_CORRUPT);
+    serialized[0] ^= 0xFF;
+    CHECK_STATUS(pacsketch_hll_deserialize(serialized, serialized_size, &loaded), PACSKETCH_ERROR_CORRUPT);
+    CHECK(loaded == NULL && wrong_type == NULL, "a failed deserialize did not set the handle to NULL");
+    free(serialized);
+    free(reserialized);
+
+    CHECK_STATUS(pacsketch_hll_create(10, &other_b), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_merge(sketch_a, other_b), PACSKETCH_ERROR_INCOMPATIBLE);
+    CHECK_STATUS(pacsketch_hll_create(0, &loaded), PACSKETCH_ERROR_INVALID_ARGUMENT);
+    pacsketch_hll_free(other_b);
+
+    uint64_t card_union = 0;
+    CHECK_STATUS(pacsketch_hll_merge(sketch_a, sketch_b), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_cardinality(sketch_a, &card_union), PACSKETCH_OK);
+    CHECK(relative_error(card_union, NUM_RECORDS_A + OFFSET_B) < 0.1, "HLL cardinality of the union is %llu, expected about %d",
+          (unsigned long long) card_union, NUM_RECORDS_A + OFFSET_B);
+
+    CHECK_STATUS(pacsketch_hll_reset(sketch_a), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_hll_cardinality(sketch_a, &card_a), PACSKETCH_OK);
+    CHECK(card_a == 0, "HLL cardinality after a reset is %llu", (unsigned long long) card_a);
+    pacsketch_hll_free(sketch_a);
+    pacsketch_hll_free(sketch_b);
+}
+
+static void check_minhash(void) {
+    /* Builds, compares, merges and round-trips MinHash sketches */
+    pacsketch_minhash_t *sketch_a = NULL, *sketch_b = NULL, *loaded = NULL, *other_k = NULL;
+    CHECK_STATUS(pacsketch_minhash_create(400, &sketch_a), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_create(400, &sketch_b), PACSKETCH_OK);
+    if (sketch_a == NULL || sketch_b == NULL) {return;}
+
+    char record[128];
+    for (size_t i = 0; i < NUM_RECORDS_A; i++) {
+        CHECK_STATUS(pacsketch_minhash_insert_record(sketch_a, record, make_record(i, record, sizeof(record))), PACSKETCH_OK);
+        uint64_t hash_val = pacsketch_hash_record(record, make_record(i + OFFSET_B, record, sizeof(record)));
+        CHECK_STATUS(pacsketch_minhash_insert_hashes(sketch_b, &hash_val, 1), PACSKETCH_OK);
+    }
+
+    uint64_t card_a = 0;
+    double jaccard = 0.0, self_jaccard = 0.0;
+    CHECK_STATUS(pacsketch_minhash_cardinality(sketch_a, &card_a), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_jaccard(sketch_a, sketch_b, &jaccard), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_jaccard(sketch_a, sketch_a, &self_jaccard), PACSKETCH_OK);
+    CHECK(relative_error(card_a, NUM_RECORDS_A) < 0.2, "MinHash cardinality of A is %llu, expected about %d", (unsigned long long) card_a, NUM_RECORDS_A);
+    CHECK(fabs(jaccard - EXPECTED_JACCARD) < 0.1, "MinHash jaccard is %.4f, expected about %.4f", jaccard, EXPECTED_JACCARD);
+    CHECK(self_jaccard == 1.0, "MinHash jaccard of a sketch with itself is %.4f", self_jaccard);
+    printf("MinHash (k=400): card(A) = %llu, J(A,B) = %.4f\n", (unsigned long long) card_a, jaccard);
+
+    size_t serialized_size = 0, reserialized_size = 0;
+    CHECK_STATUS(pacsketch_minhash_serialize(sketch_b, NULL, 0, &serialized_size), PACSKETCH_OK);
+    char* serialized = malloc(serialized_size);
+    char* reserialized = malloc(serialized_size);
+    CHECK_STATUS(pacsketch_minhash_serialize(sketch_b, serialized, serialized_size, &serialized_size), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_deserialize(serialized, serialized_size, &loaded), PACSKETCH_OK);
+    if (loaded != NULL) {
+        double loaded_jaccard = 0.0;
+        CHECK_STATUS(pacsketch_minhash_serialize(loaded, reserialized, serialized_size, &reserialized_size), PACSKETCH_OK);
+        CHECK(reserialized_size == serialized_size && !memcmp(serialized, reserialized, serialized_size), "MinHash did not round-trip through serialize/deserialize");
+        CHECK_STATUS(pacsketch_minhash_jaccard(sketch_a, loaded, &loaded_jaccard), PACSKETCH_OK);
+        CHECK(loaded_jaccard == jaccard, "MinHash jaccard changed after a round-trip: %.4f vs %.4f", loaded_jaccard, jaccard);
+        pacsketch_minhash_free(loaded);
+    }
+    CHECK_STATUS(pacsketch_minhash_deserialize(serialized, serialized_size / 2, &loaded), PACSKETCH_ERROR_CORRUPT);
+    free(serialized);
+    free(reserialized);
+
+    CHECK_STATUS(pacsketch_minhash_create(100, &other_k), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_merge(sketch_a, other_k), PACSKETCH_ERROR_INCOMPATIBLE);
+    CHECK_STATUS(pacsketch_minhash_jaccard(sketch_a, other_k, &jaccard), PACSKETCH_ERROR_INCOMPATIBLE);
+    CHECK_STATUS(pacsketch_minhash_create(0, &loaded), PACSKETCH_ERROR_INVALID_ARGUMENT);
+    CHECK_STATUS(pacsketch_minhash_insert_bytes(NULL, "x", 1), PACSKETCH_ERROR_INVALID_ARGUMENT);
+    pacsketch_minhash_free(other_k);
+
+    uint64_t card_union = 0;
+    CHECK_STATUS(pacsketch_minhash_merge(sketch_a, sketch_b), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_cardinality(sketch_a, &card_union), PACSKETCH_OK);
+    CHECK(relative_error(card_union, NUM_RECORDS_A + OFFSET_B) < 0.2, "MinHash cardinality of the union is %llu, expected about %d",
+          (unsigned long long) card_union, NUM_RECORDS_A + OFFSET_B);
+    pacsketch_minhash_free(sketch_a);
+    pacsketch_minhash_free(sketch_b);
+}
+
+static void check_underfilled_minhash(void) {
+    /* Round-trips a MinHash that holds fewer than k items, so part of its k slots are still empty */
+    pacsketch_minhash_t *sketch = NULL, *loaded = NULL;
+    CHECK_STATUS(pacsketch_minhash_create(UNDERFILLED_K, &sketch), PACSKETCH_OK);
+    if (sketch == NULL) {return;}
+
+    char record[128];
+    for (size_t i = 0; i < UNDERFILLED_RECORDS; i++) {
+        CHECK_STATUS(pacsketch_minhash_insert_record(sketch, record, make_record(i, record, sizeof(record))), PACSKETCH_OK);
+    }
+
+    uint64_t card = 0, loaded_card = 0;
+    size_t serialized_size = 0, reserialized_size = 0;
+    CHECK_STATUS(pacsketch_minhash_cardinality(sketch, &card), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_serialize(sketch, NULL, 0, &serialized_size), PACSKETCH_OK);
+    char* serialized = malloc(serialized_size);
+    char* reserialized = malloc(serialized_size);
+    CHECK_STATUS(pacsketch_minhash_serialize(sketch, serialized, serialized_size, &serialized_size), PACSKETCH_OK);
+    CHECK_STATUS(pacsketch_minhash_deserialize(serialized, serialized_size, &loaded), PACSKETCH_OK);
+    if (loaded != NULL) {
+        CHECK_STATUS(pacsketch_minhash_serialize(loaded, reserialized, serialized_size, &reserialized_size), PACSKETCH_OK);
+        CHECK(reserialized_size == serialized_size && !memcmp(serialized, reserialized, serialized_size),
+              "MinHash with %d of %d slots filled did not round-trip through serialize/deserialize", UNDERFILLED_RECORDS, UNDERFILLED_K);
+        CHECK_STATUS(pacsketch_minhash_cardinality(loaded, &loaded_card), PACSKETCH_OK);
+        CHECK(loaded_card == card, "MinHash cardinality changed after a round-trip: %llu vs %llu", (unsigned long long) loaded_card, (unsigned long long) card);
+        pacsketch_minhash_free(loaded);
+    }
+    printf("MinHash (k=%d): serialized and loaded a sketch of %d records\n", UNDERFILLED_K, UNDERFILLED_RECORDS);
+    free(serialized);
+    free(reserialized);
+    pacsketch_minhash_free(sketch);
+}
+
+static void print_sketch_file(const char* file_path) {
+    /* Loads a sketch file written by pacsketch build -o (or merge), and prints its cardinality */
+    FILE* input_file = fopen(file_path, "rb");
+    if (input_file == NULL) {CHECK(0, "the following file could not be opened: %s", file_path); return;}
+    fseek(input_file, 0, SEEK_END);
+    long file_size = ftell(input_file);
+    fseek(input_file, 0, SEEK_SET);
+    char* file_bytes = malloc(file_size > 0 ? file_size : 1);
+    size_t bytes_read = fread(file_bytes, 1, file_size > 0 ? file_size : 0, input_file);
+    fclose(input_file);
+
+    pacsketch_hll_t* hll_sketch = NULL;
+    pacsketch_minhash_t* minhash_sketch = NULL;
+    uint64_t cardinality = 0;
+    if (pacsketch_hll_deserialize(file_bytes, bytes_read, &hll_sketch) == PACSKETCH_OK) {
+        pacsketch_hll_cardinality(hll_sketch, &cardinality);
+        printf("%s: HyperLogLog with cardinality %llu\n", file_path, (unsigned long long) cardinality);
+    } else if (pacsketch_minhash_deserialize(file_bytes, bytes_read, &minhash_sketch) == PACSKETCH_OK) {
+        pacsketch_minhash_cardinality(minhash_sketch, &cardinality);
+        printf("%s: MinHash with cardinality %llu\n", file_path, (unsigned long long) cardinality);
+    } else {
+        CHECK(0, "the following file is not a HyperLogLog or MinHash sketch file: %s", file_path);
+    }
+    pacsketch_hll_free(hll_sketch);
+    pacsketch_minhash_free(minhash_sketch);
+    free(file_bytes);
+}
+
+int main(int argc, char** argv) {
+    /* Runs the checks, any sketch files given as arguments are loaded and printed as well */
+    CHECK(pacsketch_api_version() == PACSKETCH_API_VERSION, "the library was built with version %d of the interface", pacsketch_api_version());
+    check_hll();
+    check_minhash();
+    check_underfilled_minhash();
+    for (int i = 1; i < argc; i++) {print_sketch_file(argv[i]);}
+
+    if (num_failed) {
+        fprintf(stderr, "%d check(s) failed.\n", num_failed);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+/* 
+ * Name: pacsketch_exp.cpp
+ * Description: Runs the cardinality and jaccard accuracy experiments in-process. The
+ *              random sequences are generated in memory, the exact k-mer cardinalities
+ *              are computed with bitmaps, and every value of k and b is evaluated on the
+ *              same pass over each sequence. Datasets are spread across a pool of threads,
+ *              and the output files have the same format as the ones produced by the
+ *              cardinality_exp.sh and jaccard_exp.sh scripts.
+ * Project: This file is part of pacsketch repo.
+ * 
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <pacsketch_exp.h>
+#include <hash.h>
+#include <minhash.h>
+#include <hll.h>
+#include <parallel.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <cmath>
+
+template <typename Task>
+void run_in_parallel(size_t num_tasks, size_t num_threads, Task run_task) {
+    /* Runs run_task(i) for every task, worker threads grab the next task until none are left (the datasets differ in length) */
+    std::atomic<size_t> next_task (0);
+    for_each_chunk(std::min(num_threads, num_tasks), num_threads, [&](size_t, size_t, size_t) {
+        for (size_t curr_task; (curr_task = next_task++) < num_tasks;) {run_task(curr_task);}
+    });
+}
+
+std::string generate_random_sequence(size_t seq_length, uint64_t seed) {
+    /* Generates a random DNA sequence, each 64-bit random value gives 32 bases */
+    std::array<char, 4> alphabet = {'A', 'C', 'G', 'T'};
+    std::mt19937_64 rng (seed);
+    std::string curr_seq (seq_length, 'A');
+
+    uint64_t random_bits = 0;
+    for (size_t i = 0; i < seq_length; i++) {
+        if (i % 32 == 0) {random_bits = rng();}
+        curr_seq[i] = alphabet[random_bits & 0x3];
+        random_bits >>= 2;
+    }
+    return curr_seq;
+}
+
+static uint64_t count_bits(const std::vector<uint64_t>& bitmap) {
+    /* Counts the number of k-mers marked in a bitmap */
+    uint64_t num_set = 0;
+    for (uint64_t word: bitmap) {num_set += __builtin_popcountll(word);}
+    return num_set;
+}
+
+DatasetResult evaluate_dataset(const PacsketchExpOptions& opts, size_t dataset_num) {
+    /* Generates one dataset (or pair of datasets), and computes the exact and estimated values */
+    std::mt19937_64 rng (opts.seed + dataset_num);
+    std::uniform_int_distribution<size_t> pick_length (opts.min_length, opts.max_length);
+    size_t seq_length = pick_length(rng);
+    size_t num_seqs = (opts.curr_exp == JACCARD_EXP) ? 2 : 1;
+
+    std::vector<std::vector<uint64_t>> kmer_bitmaps (num_seqs, std::vector<uint64_t>(BITMAP_WORDS, 0));
+    std::vector<std::vector<MinHash>> minhash_sketches (num_seqs);
+    std::vector<std::vector<HyperLogLog>> hll_sketches (num_seqs);
+    DatasetResult result;
+
+    for (size_t i = 0; i < num_seqs; i++) {
+        std::string curr_seq = generate_random_sequence(seq_length, rng());
+        for (size_t k: opts.k_values) {minhash_sketches[i].emplace_back(k, FASTA);}
+        for (uint8_t b: opts.b_values) {hll_sketches[i].emplace_back(b, FASTA);}
+
+        // One pass over the sequence marks the exact k-mers, and feeds each sketch the same hash
+        std::vector<uint64_t>& curr_bitmap = kmer_bitmaps[i];
+        for_each_kmer(curr_seq.data(), curr_seq.length(), FASTA_KMER_LENGTH, [&](uint64_t encoded_kmer) {
+            curr_bitmap[encoded_kmer >> 6] |= (uint64_t) 1 << (encoded_kmer & 63);
+
+            uint64_t hash_val = MurmurHash3(encoded_kmer);
+            for (MinHash& sketch: minhash_sketches[i]) {sketch.add_hash(hash_val);}
+            for (HyperLogLog& sketch: hll_sketches[i]) {sketch.add_hash(hash_val);}
+        });
+        result.true_cards.push_back(count_bits(curr_bitmap));
+    }
+
+    // The union of the pair is the bitwise-or of their bitmaps
+    if (num_seqs == 2) {
+        for (size_t i = 0; i < BITMAP_WORDS; i++) {kmer_bitmaps[0][i] |= kmer_bitmaps[1][i];}
+        result.true_cards.push_back(count_bits(kmer_bitmaps[0]));
+    }
+
+    for (size_t i = 0; i < opts.k_values.size(); i++) {
+        std::vector<uint64_t> est_cards;
+        for (size_t j = 0; j < num_seqs; j++) {est_cards.push_back(minhash_sketches[j][i].get_cardinality());}
+        result.minhash_cards.push_back(est_cards);
+        if (num_seqs == 2) {result.minhash_jaccards.push_back(MinHash::compute_jaccard(minhash_sketches[0][i], minhash_sketches[1][i]));}
+    }
+
+    for (size_t i = 0; i < opts.b_values.size(); i++) {
+        std::vector<uint64_t> est_cards;
+        for (size_t j = 0; j < num_seqs; j++) {est_cards.push_back(hll_sketches[j][i].compute_cardinality());}
+        if (num_seqs == 2) {
+            HyperLogLog union_sketch = hll_sketches[0][i] + hll_sketches[1][i];
+            est_cards.push_back(union_sketch.compute_cardinality());
+            result.hll_jaccards.push_back(HyperLogLog::compute_jaccard(est_cards[0], est_cards[1], est_cards[2]));
+        }
+        result.hll_cards.push_back(est_cards);
+    }
+    return result;
+}
+
+static FILE* open_output_file(const std::string& file_path) {
+    /* Opens an output file, and exits if it cannot be created */
+    FILE* output_file = std::fopen(file_path.data(), "w");
+    if (output_file == NULL) {THROW_EXCEPTION(("Unable to open output file: " + file_path).data());}
+    return output_file;
+}
+
+static std::string format_jaccard(double jaccard) {
+    /* Formats a jaccard the same way the stats files and dist sub-command do (4 significant digits) */
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.4g", jaccard);
+    return std::string(buf);
+}
+
+void write_cardinality_results(const PacsketchExpOptions& opts, const std::vector<DatasetResult>& results) {
+    /* Writes final_output_file.csv and final_averages_file.csv, used by cardinality_exp_analysis.R */
+    FILE* output_file = open_output_file(opts.output_dir + "final_output_file.csv");
+    std::vector<std::string> names;
+    std::vector<double> total_errors;
+
+    auto write_rows = [&](const std::string& name, size_t param_index, bool use_minhash) {
+        double total_error = 0.0;
+        for (size_t i = 0; i < results.size(); i++) {
+            uint64_t true_card = results[i].true_cards[0];
+            uint64_t est_card = use_minhash ? results[i].minhash_cards[param_index][0] : results[i].hll_cards[param_index][0];
+            double percent_error = ((est_card + 0.0) - true_card)/true_card * 100;
+            total_error += std::abs(percent_error);
+            std::fprintf(output_file, "%zu,%lu,%s,%lu,%f\n", i+1, true_card, name.data(), est_card, percent_error);
+        }
+        names.push_back(name);
+        total_errors.push_back(total_error);
+    };
+
+    for (size_t i = 0; i < opts.k_values.size(); i++) {write_rows("minhash_k" + std::to_string(opts.k_values[i]), i, true);}
+    for (size_t i = 0; i < opts.b_values.size(); i++) {write_rows("hll_b" + std::to_string(opts.b_values[i]), i, false);}
+    std::fclose(output_file);
+
+    // Average absolute error for each data-structure
+    output_file = open_output_file(opts.output_dir + "final_averages_file.csv");
+    for (size_t i = 0; i < names.size(); i++) {
+        std::fprintf(output_file, "%s,%zu,%f,%f\n", names[i].data(), results.size(), total_errors[i], total_errors[i]/results.size());
+    }
+    std::fclose(output_file);
+}
+
+void write_jaccard_results(const PacsketchExpOptions& opts, const std::vector<DatasetResult>& results) {
+    /* Writes the summary, cardinality and jaccard files for each data-structure, used by jaccard_exp_analysis.R */
+    for (const std::string data_structure: {"hll", "minhash"}) {
+        bool use_minhash = (data_structure == "minhash");
+        size_t num_params = use_minhash ? opts.k_values.size() : opts.b_values.size();
+
+        FILE* summary_file = open_output_file(opts.output_dir + "total_" + data_structure + "_summary.txt");
+        FILE* card_file = open_output_file(opts.output_dir + "total_" + data_structure + "_cardinality_results.csv");
+        FILE* jaccard_file = open_output_file(opts.output_dir + "total_" + data_structure + "_jaccard_results.csv");
+
+        std::fprintf(summary_file, "%s,dataset_num,true_card_a,true_card_b,true_card_union,true_jaccard,"
+                                   "est_card_a,est_card_b,est_card_union,est_jaccard\n", use_minhash ? "k" : "b");
+        std::fprintf(card_file, "k_or_b,dataset_num,true_card,est_card,percent_error\n");
+        std::fprintf(jaccard_file, "k_or_b,dataset_num,true_jaccard,est_jaccard,jaccard_error\n");
+
+        for (size_t p = 0; p < num_params; p++) {
+            size_t param = use_minhash ? opts.k_values[p] : opts.b_values[p];
+
+            for (size_t i = 0; i < results.size(); i++) {
+                const std::vector<uint64_t>& true_cards = results[i].true_cards;
+                const std::vector<uint64_t>& est_cards = use_minhash ? results[i].minhash_cards[p] : results[i].hll_cards[p];
+
+                std::string true_jaccard = format_jaccard((true_cards[0] + true_cards[1] - true_cards[2] + 0.0)/true_cards[2]);
+                std::string est_jaccard = format_jaccard(use_minhash ? results[i].minhash_jaccards[p] : results[i].hll_jaccards[p]);
+                std::string est_union = use_minhash ? "N/A" : std::to_string(est_cards[2]);
+
+                std::fprintf(summary_file, "%zu,%zu,%lu,%lu,%lu,%s,%lu,%lu,%s,%s\n", param, i+1,
+                             true_cards[0], true_cards[1], true_cards[2], true_jaccard.data(),
+                             est_cards[0], est_cards[1], est_union.data(), est_jaccard.data());
+
+                // Each pair gives two cardinality data-points
+                for (size_t j = 0; j < 2; j++) {
+                    double percent_error = ((est_cards[j] + 0.0) - true_cards[j])/true_cards[j] * 100.0;
+                    std::fprintf(card_file, "%zu,%zu,%lu,%lu,%.4f\n", param, 2*i+j+1, true_cards[j], est_cards[j], percent_error);
+                }
+                std::fprintf(jaccard_file, "%zu,%zu,%s,%s,%.4f\n", param, i+1, true_jaccard.data(), est_jaccard.data(),
+                             std::atof(est_jaccard.data()) - std::atof(true_jaccard.data()));
+            }
+        }
+        std::fclose(summary_file);
+        std::fclose(card_file);
+        std::fclose(jaccard_file);
+    }
+}
+
+void parse_pacsketch_exp_options(int argc, char** argv, PacsketchExpOptions* opts) {
+    /* Parses the command-line arguments */
+    if (std::strcmp(argv[0], "cardinality") == 0) {opts->curr_exp = CARDINALITY_EXP;}
+    else if (std::strcmp(argv[0], "jaccard") == 0) {opts->curr_exp = JACCARD_EXP;}
+
+    for (int c; (c = getopt(argc, argv, "ho:n:t:s:l:m:K:B:")) >= 0;){
+        switch (c) {
+            case 'h': pacsketch_exp_usage(); std::exit(1);
+            case 'o': opts->output_dir.assign(optarg); break;
+            case 'n': opts->num_datasets = std::max(std::atoi(optarg), 0); break;
+            case 't': opts->num_threads = std::max(std::atoi(optarg), 0); break;
+            case 's': opts->seed = std::strtoull(optarg, NULL, 10); break;
+            case 'l': opts->min_length = std::max(std::atol(optarg), 0L); break;
+            case 'm': opts->max_length = std::max(std::atol(optarg), 0L); break;
+            case 'K': for (auto& val: split(optarg, ',')) {opts->k_values.push_back(std::max(std::atoi(val.data()), 0));} break;
+            case 'B': for (auto& val: split(optarg, ',')) {opts->b_values.push_back(std::max(std::atoi(val.data()), 0));} break;
+            default: pacsketch_exp_usage(); std::exit(1);
+        }
+    }
+}
+
+int pacsketch_exp_usage() {
+    /* prints out the usage information for the experiment driver */
+    std::fprintf(stderr, "pacsketch_exp - runs the cardinality or jaccard accuracy experiment in-process,\n");
+    std::fprintf(stderr, "                and writes the same output files as cardinality_exp.sh and\n");
+    std::fprintf(stderr, "                jaccard_exp.sh to the output directory.\n");
+    std::fprintf(stderr, "Usage: pacsketch_exp <cardinality|jaccard> -o output_dir [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10soutput directory for the results\n", "-o [arg]");
+    std::fprintf(stderr, "\t%-10snumber of datasets (default: 1000 for cardinality, 500 for jaccard)\n", "-n [arg]");
+    std::fprintf(stderr, "\t%-10snumber of threads to use (default: all cores)\n", "-t [arg]");
+    std::fprintf(stderr, "\t%-10sseed for the random sequences (default: current time)\n", "-s [arg]");
+    std::fprintf(stderr, "\t%-10sminimum length of each sequence\n", "-l [arg]");
+    std::fprintf(stderr, "\t%-10smaximum length of each sequence\n", "-m [arg]");
+    std::fprintf(stderr, "\t%-10scomma-separated values of k to use for MinHash\n", "-K [arg]");
+    std::fprintf(stderr, "\t%-10scomma-separated values of b to use for HLL\n", "-B [arg]");
+    return 0;
+}
+
+int main (int argc, char ** argv) {
+    /* main method of the experiment driver */
+    if (argc > 2) {
+        PacsketchExpOptions run_opts;
+        parse_pacsketch_exp_options(argc-1, argv+1, &run_opts);
+        run_opts.validate();
+
+        LOG("running %s experiment on %zu datasets with %zu threads (seed = %lu)",
+            (run_opts.curr_exp == CARDINALITY_EXP) ? "cardinality" : "jaccard", 
+            run_opts.num_datasets, run_opts.num_threads, run_opts.seed);
+
+        std::vector<DatasetResult> results (run_opts.num_datasets);
+        run_in_parallel(run_opts.num_datasets, run_opts.num_threads, [&](size_t dataset_num) {
+            results[dataset_num] = evaluate_dataset(run_opts, dataset_num);
+        });
+        LOG("finished evaluating all the datasets.");
+
+        if (run_opts.curr_exp == CARDINALITY_EXP) {write_cardinality_results(run_opts, results);}
+        else {write_jaccard_results(run_opts, results);}
+        return 0;
+    } 
+    else {return pacsketch_exp_usage();}
+}
@@ -0,0 +1,82 @@
+/*
+ * Name: pacsketch_exp.h
+ * Description: Header file for pacsketch_exp.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _PACSKETCH_EXP_H
+#define _PACSKETCH_EXP_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdint.h>
+#include <time.h>
+#include <pacsketch.h>
+
+#define EXACT_KMER_SPACE ((uint64_t) 1 << (2 * FASTA_KMER_LENGTH)) // number of possible k-mers
+#define BITMAP_WORDS (EXACT_KMER_SPACE / 64) // 64-bit words needed for a k-mer bitmap
+
+enum experiment_type {CARDINALITY_EXP, JACCARD_EXP, NO_EXP};
+
+struct PacsketchExpOptions {
+    experiment_type curr_exp = NO_EXP; // experiment to run
+    std::string output_dir = ""; // directory to write results into
+    size_t num_datasets = 0; // number of random datasets (or pairs of datasets)
+    size_t num_threads = std::thread::hardware_concurrency(); // number of worker threads
+    uint64_t seed = time(NULL); // seed for generating the random sequences
+    std::vector<size_t> k_values; // values of k to use for MinHash
+    std::vector<uint8_t> b_values; // values of b to use for HLL
+    size_t min_length = 0; // smallest length of a random sequence
+    size_t max_length = 0; // largest length of a random sequence
+
+public:
+    void validate() {
+        /* Fills in the defaults of each experiment (the same as the scripts in exp/), and checks the options */
+        if (curr_exp == NO_EXP) {FATAL_WARNING("Please specify which experiment to run, either cardinality or jaccard.");}
+        if (output_dir == "") {FATAL_WARNING("Need to specify an output directory (-o).");}
+        if (output_dir.back() != '/') {output_dir += "/";}
+        if (num_threads == 0) {num_threads = 1;}
+
+        if (curr_exp == CARDINALITY_EXP) {
+            if (num_datasets == 0) {num_datasets = 1000;}
+            if (min_length == 0) {min_length = 1000000;}
+            if (max_length == 0) {max_length = min_length;}
+            if (k_values.empty()) {k_values = {1, 10, 100, 400};}
+            if (b_values.empty()) {b_values = {3, 6, 9, 12};}
+        } else {
+            if (num_datasets == 0) {num_datasets = 500;}
+            if (min_length == 0) {min_length = 1000000;}
+            if (max_length == 0) {max_length = std::max(min_length, (size_t) 12000000);}
+            if (k_values.empty()) {k_values = {5, 20, 60, 100};}
+            if (b_values.empty()) {b_values = {5, 7, 9, 11};}
+        }
+        if (max_length < min_length) {FATAL_WARNING("The maximum length (-m) cannot be smaller than the minimum length (-l).");}
+        if (min_length < FASTA_KMER_LENGTH) {FATAL_WARNING("The length of the sequences (-l) is too small for the k-mer length.");}
+        for (uint8_t b: b_values) {if (b == 0 || b > 32) {FATAL_WARNING("The values of b (-B) need to be between 1 and 32.");}}
+        for (size_t k: k_values) {if (k == 0) {FATAL_WARNING("The values of k (-K) need to be positive numbers.");}}
+    }
+};
+
+struct DatasetResult {
+    /* Exact and estimated values for one dataset (or pair), for every k and b */
+    std::vector<uint64_t> true_cards; // |A|, |B|, |AUB| (only |A| for cardinality experiment)
+    std::vector<std::vector<uint64_t>> minhash_cards; // per k: |A|, |B|
+    std::vector<double> minhash_jaccards; // per k
+    std::vector<std::vector<uint64_t>> hll_cards; // per b: |A|, |B|, |AUB|
+    std::vector<double> hll_jaccards; // per b
+};
+
+/* Function Declarations */
+void parse_pacsketch_exp_options(int argc, char** argv, PacsketchExpOptions* opts);
+int pacsketch_exp_usage();
+std::string generate_random_sequence(size_t seq_length, uint64_t seed);
+DatasetResult evaluate_dataset(const PacsketchExpOptions& opts, size_t dataset_num);
+void write_cardinality_results(const PacsketchExpOptions& opts, const std::vector<DatasetResult>& results);
+void write_jaccard_results(const PacsketchExpOptions& opts, const std::vector<DatasetResult>& results);
+
+#endif /* end of _PACSKETCH_EXP_H include */
@@ -0,0 +1,121 @@
+/*
+ * Name: send_records.cpp
+ * Description: Sends the records of a file as UDP datagrams, the same way a collector
+ *              would push them to pacsketch classify -u. It is used to test the listener
+ *              with a local sender on the loopback interface.
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <send_records.h>
+
+void send_records(const SendRecordsOptions& opts) {
+    /* Packs whole records (newline-terminated) into datagrams, and sends them at the requested rate */
+    std::ifstream input_data (opts.input_file, std::ifstream::in);
+    if (input_data.fail()) {FATAL_WARNING("The input file could not be opened.");}
+    std::vector<std::string> records;
+    for (std::string line; std::getline(input_data, line);) {
+        if (!line.empty()) {records.push_back(line + "\n");}
+    }
+
+    int socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in destination;
+    std::memset(&destination, 0, sizeof(destination));
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(opts.port);
+    if (socket_fd < 0 || inet_pton(AF_INET, opts.address.data(), &destination.sin_addr) != 1) {FATAL_WARNING("The destination address is not valid.");}
+
+    std::string datagram;
+    size_t num_datagrams = 0, num_records = 0, num_skipped = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    auto flush_datagram = [&]() {
+        if (datagram.empty()) {return;}
+        if (sendto(socket_fd, datagram.data(), datagram.length(), 0, (struct sockaddr*) &destination, sizeof(destination)) < 0) {
+            perror("Error occurred while sending a datagram");
+            std::exit(1);
+        }
+        num_datagrams++;
+        datagram.clear();
+    };
+
+    for (size_t curr_loop = 0; curr_loop < opts.num_loops; curr_loop++) {
+        for (const std::string& record: records) {
+            if (record.length() > opts.datagram_size) {num_skipped++; continue;}
+            if (datagram.length() + record.length() > opts.datagram_size) {flush_datagram();}
+            datagram += record;
+            num_records++;
+
+            // Waits until the records sent so far are within the rate
+            if (opts.records_per_sec > 0.0) {
+                auto send_time = start_time + std::chrono::duration<double>(num_records / opts.records_per_sec);
+                if (send_time > std::chrono::steady_clock::now()) {flush_datagram(); std::this_thread::sleep_until(send_time);}
+            }
+        }
+    }
+    flush_datagram();
+    close(socket_fd);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::fprintf(stderr, "DATAGRAMS = %zu\n", num_datagrams);
+    std::fprintf(stderr, "RECORDS = %zu\n", num_records);
+    std::fprintf(stderr, "SKIPPED_RECORDS = %zu\n", num_skipped);
+    std::fprintf(stderr, "RECORDS_PER_SEC = %.0f\n", (seconds > 0.0) ? num_records / seconds : 0.0);
+}
+
+void parse_send_records_options(int argc, char** argv, SendRecordsOptions* opts) {
+    /* Parses the command-line arguments */
+    for (int c; (c = getopt(argc, argv, "hi:a:p:s:r:l:")) >= 0;) {
+        switch (c) {
+            case 'h': send_records_usage(); std::exit(1);
+            case 'i': opts->input_file.assign(optarg); break;
+            case 'a': opts->address.assign(optarg); break;
+            case 'p': opts->port = std::min(std::max(std::atol(optarg), 0L), 65535L); break;
+            case 's': opts->datagram_size = std::max(std::atol(optarg), 0L); break;
+            case 'r': opts->records_per_sec = std::atof(optarg); break;
+            case 'l': opts->num_loops = std::max(std::atol(optarg), 0L); break;
+            default: send_records_usage(); std::exit(1);
+        }
+    }
+}
+
+int send_records_usage() {
+    /* prints out the usage information for send_records utility */
+    std::fprintf(stderr, "send_records - sends the records of a file as UDP datagrams, to test\n");
+    std::fprintf(stderr, "               pacsketch classify -u with a local sender.\n");
+    std::fprintf(stderr, "Usage: send_records -i records.csv -p port [options]\n\n");
+
+    std::fprintf(stderr, "Options:\n");
+    std::fprintf(stderr, "\t%-10sprints this usage message\n", "-h");
+    std::fprintf(stderr, "\t%-10spath of the records to send\n", "-i [FILE]");
+    std::fprintf(stderr, "\t%-10sdestination address (default: 127.0.0.1)\n", "-a [arg]");
+    std::fprintf(stderr, "\t%-10sdestination port\n", "-p [arg]");
+    std::fprintf(stderr, "\t%-10smaximum datagram size in bytes (default: 1400)\n", "-s [arg]");
+    std::fprintf(stderr, "\t%-10srecords per second (default: 0, as fast as possible)\n", "-r [arg]");
+    std::fprintf(stderr, "\t%-10snumber of times the file is sent (default: 1)\n", "-l [arg]");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    /* main method of send_records utility */
+    if (argc > 1) {
+        SendRecordsOptions run_opts;
+        parse_send_records_options(argc, argv, &run_opts);
+        run_opts.validate();
+
+        send_records(run_opts);
+        return 0;
+    }
+    else {return send_records_usage();}
+}
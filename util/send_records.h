@@ -0,0 +1,42 @@
+/*
+ * Name: send_records.h
+ * Description: Header file for send_records.cpp
+ * Project: This file is part of pacsketch repo.
+ *
+ * Author: Omar Ahmed
+ * Date: October 18, 2026
+ */
+
+#ifndef _SEND_RECORDS
+#define _SEND_RECORDS
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+
+#define FATAL_WARNING(x) do {std::fprintf(stderr, "Warning: %s\n", x); std::exit(1);} while (0)
+
+#define MAX_DATAGRAM_SIZE 9216 // same as the largest datagram the listener keeps
+
+struct SendRecordsOptions {
+    std::string input_file = ""; // records to send, one per line
+    std::string address = "127.0.0.1"; // destination of the datagrams
+    uint16_t port = 0;
+    size_t datagram_size = 1400; // records are packed into datagrams up to this size
+    double records_per_sec = 0.0; // rate limit (0 sends as fast as possible)
+    size_t num_loops = 1; // number of times the file is sent
+public:
+    void validate() {
+        if (input_file == "") {FATAL_WARNING("The input file (-i) needs to be specified.");}
+        if (port == 0) {FATAL_WARNING("The destination port (-p) needs to be between 1 and 65535.");}
+        if (datagram_size == 0 || datagram_size > MAX_DATAGRAM_SIZE) {FATAL_WARNING("The datagram size (-s) needs to be between 1 and 9216 bytes.");}
+        if (records_per_sec < 0.0) {FATAL_WARNING("The rate (-r) cannot be negative.");}
+    }
+};
+
+/* Function Declarations */
+void parse_send_records_options(int argc, char** argv, SendRecordsOptions* opts);
+int send_records_usage();
+void send_records(const SendRecordsOptions& opts);
+
+#endif /* end of _SEND_RECORDS include */